@@ -7,9 +7,10 @@
 layout(std140, set = 0, binding = 0) uniform block {CameraData camera;};
 
 
-layout(push_constant) uniform PushConsts {
-    mat4 model;
-} pushConsts;
+// Written every frame in draw order, an instanced draw selects its transforms through the first instance
+layout(std430, set = 3, binding = 0) readonly buffer Instances {
+    mat4 instanceTransforms[];
+};
 
 layout(location = 0) out vec2 outTexCoord;
 layout(location = 1) out vec3 outNormal;
@@ -28,14 +29,16 @@ layout(std140, set = 2, binding = 0) uniform lightMatrix {mat4 directionalLightM
 
 
 void main() {
-    fragPos = vec3(pushConsts.model * vec4(inPosition, 1.0));
-    gl_Position = camera.proj * camera.view * pushConsts.model * vec4(inPosition, 1.0);
+    mat4 model = instanceTransforms[gl_InstanceIndex];
+
+    fragPos = vec3(model * vec4(inPosition, 1.0));
+    gl_Position = camera.proj * camera.view * model * vec4(inPosition, 1.0);
     outTexCoord = texCoord;
     outNormal = normal;
 
-   vec3 T = normalize(vec3(pushConsts.model * vec4(tangent,   0.0)));
-   vec3 B = normalize(vec3(pushConsts.model * vec4(bitangent, 0.0)));
-   vec3 N = normalize(vec3(pushConsts.model * vec4(normal,    0.0)));
+   vec3 T = normalize(vec3(model * vec4(tangent,   0.0)));
+   vec3 B = normalize(vec3(model * vec4(bitangent, 0.0)));
+   vec3 N = normalize(vec3(model * vec4(normal,    0.0)));
 
    TBN = mat3(T, B, N);
 
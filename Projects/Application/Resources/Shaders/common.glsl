@@ -29,3 +29,42 @@ struct Light
 	// 16 bytes
 	vec4 pad;
 };
+
+// 80 bytes, per object data for the bindless path, indexed with the instance index
+struct ObjectData
+{
+	mat4 model;
+	uint meshIndex; // Into the GPU scene meshes, ~0 when the object is not drawn by the GPU-driven path
+	uint materialIndex;
+	uint pad0;
+	uint pad1;
+};
+
+// 32 bytes, a range of the merged GPU scene geometry
+struct MeshData
+{
+	uint firstIndex;
+	uint indexCount;
+	int vertexOffset;
+	uint pad;
+	vec4 boundingSphere; // Object space center in xyz, radius in w
+};
+
+// 16 bytes, indices into the bindless texture array
+struct MaterialData
+{
+	uint albedoIndex;
+	uint specularIndex;
+	uint normalIndex;
+	uint pad;
+};
+
+// 20 bytes, VkDrawIndexedIndirectCommand
+struct DrawIndexedIndirectCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
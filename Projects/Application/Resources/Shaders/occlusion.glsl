@@ -0,0 +1,69 @@
+// Occlusion test against a depth pyramid, the same test as DepthPyramid in Common/Culling/OcclusionCulling.cpp
+// Every texel of the pyramid holds the furthest depth of the texels it covers, level 0 has power of two sizes
+
+// Screen rectangle of the sphere in [0, 1] uv coordinates and the depth of its closest point
+// False when the sphere crosses the camera or near plane, such spheres can not be tested
+bool ProjectSphere(vec4 sphere, mat4 viewProjection, out vec2 minUv, out vec2 maxUv, out float nearestDepth)
+{
+	minUv = vec2(1.0);
+	maxUv = vec2(0.0);
+	nearestDepth = 1.0;
+
+	// Corners of the box around the sphere, the rectangle of the box contains the one of the sphere
+	for (int i = 0; i < 8; ++i)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = viewProjection * vec4(corner, 1.0);
+
+		if (clip.w <= 0.0)
+		{
+			return false;
+		}
+
+		vec3 ndc = clip.xyz / clip.w;
+		if (ndc.z < 0.0)
+		{
+			return false;
+		}
+
+		vec2 uv = ndc.xy * 0.5 + 0.5;
+		minUv = min(minUv, uv);
+		maxUv = max(maxUv, uv);
+		nearestDepth = min(nearestDepth, ndc.z);
+	}
+
+	minUv = clamp(minUv, vec2(0.0), vec2(1.0));
+	maxUv = clamp(maxUv, vec2(0.0), vec2(1.0));
+	return true;
+}
+
+// viewProjection is the matrix the pyramid was built with, pyramidSize is the size of level 0
+// Reads the level where the rectangle of the sphere covers at most 2x2 texels
+bool IsSphereOccluded(vec4 sphere, mat4 viewProjection, texture2D pyramid, sampler pointSampler, vec2 pyramidSize, uint pyramidLevels)
+{
+	vec2 minUv;
+	vec2 maxUv;
+	float nearestDepth;
+	if (!ProjectSphere(sphere, viewProjection, minUv, maxUv, nearestDepth))
+	{
+		return false;
+	}
+
+	vec2 extent = (maxUv - minUv) * pyramidSize;
+	int level = min(int(ceil(log2(max(max(extent.x, extent.y), 1.0)))), int(pyramidLevels) - 1);
+
+	ivec2 levelSize = textureSize(sampler2D(pyramid, pointSampler), level);
+	ivec2 minTexel = min(ivec2(minUv * vec2(levelSize)), levelSize - 1);
+	ivec2 maxTexel = min(ivec2(maxUv * vec2(levelSize)), levelSize - 1);
+
+	float furthestDepth = 0.0;
+	for (int y = minTexel.y; y <= maxTexel.y; ++y)
+	{
+		for (int x = minTexel.x; x <= maxTexel.x; ++x)
+		{
+			furthestDepth = max(furthestDepth, texelFetch(sampler2D(pyramid, pointSampler), ivec2(x, y), level).r);
+		}
+	}
+
+	return nearestDepth > furthestDepth;
+}
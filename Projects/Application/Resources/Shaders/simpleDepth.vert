@@ -12,10 +12,11 @@ layout(location = 4) in vec3 bitangent;
 
 layout(std140, set = 0, binding = 0) uniform lightMatrix {mat4 directionalLightMatrix;};
 
-layout(push_constant) uniform PushConsts {
-    mat4 model;
-} pushConsts;
+// Shares the instance buffer of the scene pass, an instanced draw selects its transforms through the first instance
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+    mat4 instanceTransforms[];
+};
 
 void main() {
-	gl_Position = directionalLightMatrix * pushConsts.model * vec4(inPosition, 1.0);
+	gl_Position = directionalLightMatrix * instanceTransforms[gl_InstanceIndex] * vec4(inPosition, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "Common/Benchmark/BenchmarkReport.h"
+
+#include <sstream>
+
+using namespace Flux;
+
+namespace
+{
+	MetricSummary MakeSummary(const std::string& aName, double aP50, double aP95)
+	{
+		MetricSummary tSummary;
+		tSummary.mName = aName;
+		tSummary.mSamples = 100;
+		tSummary.mP50 = aP50;
+		tSummary.mP95 = aP95;
+		return tSummary;
+	}
+}
+
+TEST(BenchmarkReportTest, SummarizesWithNearestRankPercentiles) {
+	BenchmarkReport tReport;
+	for (int i = 1; i <= 100; ++i)
+	{
+		tReport.BeginFrame();
+		tReport.AddSample("cpu/frame", static_cast<double>(i));
+	}
+
+	const std::vector<MetricSummary> tSummaries = tReport.Summarize();
+	ASSERT_EQ(tSummaries.size(), 1u);
+	EXPECT_EQ(tSummaries[0].mSamples, 100u);
+	EXPECT_DOUBLE_EQ(tSummaries[0].mAverage, 50.5);
+	EXPECT_DOUBLE_EQ(tSummaries[0].mP50, 50.0);
+	EXPECT_DOUBLE_EQ(tSummaries[0].mP95, 95.0);
+	EXPECT_DOUBLE_EQ(tSummaries[0].mP99, 99.0);
+	EXPECT_DOUBLE_EQ(tSummaries[0].mMax, 100.0);
+}
+
+TEST(BenchmarkReportTest, SumsSamplesOfAFrameAndSkipsFramesWithout) {
+	BenchmarkReport tReport;
+	tReport.BeginFrame();
+	tReport.AddSample("cpu/frame", 10.0);
+	tReport.BeginFrame();
+	tReport.AddSample("cpu/frame", 12.0);
+	tReport.AddSample("gpu/Scene", 1.0);
+	tReport.AddSample("gpu/Scene", 2.0);
+
+	const std::vector<MetricSummary> tSummaries = tReport.Summarize();
+	ASSERT_EQ(tSummaries.size(), 2u);
+	EXPECT_EQ(tSummaries[1].mName, "gpu/Scene");
+	EXPECT_EQ(tSummaries[1].mSamples, 1u);
+	EXPECT_DOUBLE_EQ(tSummaries[1].mMax, 3.0);
+
+	std::ostringstream tCsv;
+	tReport.WriteCsv(tCsv);
+	EXPECT_EQ(tCsv.str(), "frame,\"cpu/frame\",\"gpu/Scene\"\n0,10.0000,\n1,12.0000,3.0000\n");
+}
+
+TEST(BenchmarkReportTest, LoadsTheSummariesItWrites) {
+	BenchmarkReport tReport;
+	tReport.SetInfo("scene", "Sponza \"flythrough\"");
+	tReport.SetInfo("resolution", "1280x720");
+	for (int i = 0; i < 20; ++i)
+	{
+		tReport.BeginFrame();
+		tReport.AddSample("cpu/frame", 4.0 + i * 0.25);
+		tReport.AddSample("memory/block MB", 512.0);
+	}
+
+	std::stringstream tJson;
+	tReport.WriteJson(tJson);
+
+	std::vector<MetricSummary> tLoaded;
+	ASSERT_TRUE(BenchmarkReport::LoadSummaries(tJson, tLoaded));
+
+	const std::vector<MetricSummary> tExpected = tReport.Summarize();
+	ASSERT_EQ(tLoaded.size(), tExpected.size());
+	for (size_t i = 0; i < tLoaded.size(); ++i)
+	{
+		EXPECT_EQ(tLoaded[i].mName, tExpected[i].mName);
+		EXPECT_EQ(tLoaded[i].mSamples, tExpected[i].mSamples);
+		EXPECT_NEAR(tLoaded[i].mAverage, tExpected[i].mAverage, 1e-4);
+		EXPECT_NEAR(tLoaded[i].mP95, tExpected[i].mP95, 1e-4);
+		EXPECT_NEAR(tLoaded[i].mMax, tExpected[i].mMax, 1e-4);
+	}
+}
+
+TEST(BenchmarkReportTest, RejectsMalformedJson) {
+	std::vector<MetricSummary> tLoaded;
+	std::istringstream tTruncated("{\"frames\":10,\"metrics\":[{\"name\":\"cpu/frame\",\"p50\":");
+	EXPECT_FALSE(BenchmarkReport::LoadSummaries(tTruncated, tLoaded));
+	EXPECT_TRUE(tLoaded.empty());
+
+	std::istringstream tNoMetrics("{\"frames\":10}");
+	EXPECT_FALSE(BenchmarkReport::LoadSummaries(tNoMetrics, tLoaded));
+}
+
+TEST(BenchmarkReportTest, FlagsRegressionsAboveThreshold) {
+	const std::vector<MetricSummary> tBaseline = { MakeSummary("cpu/frame", 10.0, 12.0), MakeSummary("gpu/Scene", 2.0, 2.5), MakeSummary("gpu/Bloom", 0.01, 0.02) };
+	const std::vector<MetricSummary> tCurrent = { MakeSummary("cpu/frame", 10.5, 14.0), MakeSummary("gpu/Scene", 2.1, 2.6), MakeSummary("gpu/Bloom", 0.03, 0.04), MakeSummary("gpu/Taa", 1.0, 1.0) };
+
+	RegressionThreshold tGpu;
+	tGpu.mRelative = 0.1;
+	tGpu.mAbsolute = 0.05;
+
+	const std::vector<MetricComparison> tComparisons = BenchmarkReport::Compare(tBaseline, tCurrent, RegressionThreshold(), { { "gpu/", tGpu } });
+	ASSERT_EQ(tComparisons.size(), 4u);
+
+	// p95 went from 12 to 14, more than 10%
+	EXPECT_TRUE(tComparisons[0].mRegressed);
+	EXPECT_FALSE(tComparisons[1].mRegressed);
+	// Tripled, but within the absolute threshold
+	EXPECT_FALSE(tComparisons[2].mRegressed);
+	EXPECT_TRUE(tComparisons[3].mNew);
+	EXPECT_FALSE(tComparisons[3].mRegressed);
+}
+
+TEST(BenchmarkReportTest, LongestPrefixThresholdWinsAndMissingMetricsAreReported) {
+	const std::vector<MetricSummary> tBaseline = { MakeSummary("gpu/Scene", 2.0, 2.0), MakeSummary("gpu/Shadows", 1.0, 1.0) };
+	const std::vector<MetricSummary> tCurrent = { MakeSummary("gpu/Scene", 2.5, 2.5) };
+
+	RegressionThreshold tLoose;
+	tLoose.mRelative = 0.5;
+	RegressionThreshold tStrict;
+	tStrict.mRelative = 0.01;
+
+	const std::vector<MetricComparison> tComparisons = BenchmarkReport::Compare(tBaseline, tCurrent, tStrict, { { "gpu/", tStrict }, { "gpu/Sc", tLoose } });
+	ASSERT_EQ(tComparisons.size(), 2u);
+	EXPECT_FALSE(tComparisons[0].mRegressed);
+	EXPECT_TRUE(tComparisons[1].mMissing);
+	EXPECT_FALSE(tComparisons[1].mRegressed);
+}
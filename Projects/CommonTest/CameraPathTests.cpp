@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "Common/Benchmark/CameraPath.h"
+
+#include <cstdio>
+#include <fstream>
+
+using namespace Flux;
+
+namespace
+{
+	CameraPathKey MakeKey(float aX, float aYaw)
+	{
+		CameraPathKey tKey;
+		tKey.mPosition = glm::vec3(aX, 1.0f, -aX);
+		tKey.mYaw = aYaw;
+		tKey.mPitch = -10.0f;
+		return tKey;
+	}
+}
+
+TEST(CameraPathTest, SingleKeyIsConstant) {
+	CameraPath tPath;
+	tPath.AddKey(MakeKey(3.0f, 45.0f));
+
+	const CameraPathKey tKey = tPath.Evaluate(0.7f);
+	EXPECT_FLOAT_EQ(tKey.mPosition.x, 3.0f);
+	EXPECT_FLOAT_EQ(tKey.mYaw, 45.0f);
+}
+
+TEST(CameraPathTest, PassesThroughEveryKey) {
+	CameraPath tPath;
+	tPath.AddKey(MakeKey(0.0f, 0.0f));
+	tPath.AddKey(MakeKey(2.0f, 90.0f));
+	tPath.AddKey(MakeKey(10.0f, 30.0f));
+
+	EXPECT_FLOAT_EQ(tPath.Evaluate(0.0f).mPosition.x, 0.0f);
+	EXPECT_FLOAT_EQ(tPath.Evaluate(0.5f).mPosition.x, 2.0f);
+	EXPECT_FLOAT_EQ(tPath.Evaluate(0.5f).mYaw, 90.0f);
+	EXPECT_FLOAT_EQ(tPath.Evaluate(1.0f).mPosition.x, 10.0f);
+	EXPECT_FLOAT_EQ(tPath.Evaluate(1.0f).mPitch, -10.0f);
+
+	// Outside [0, 1] stays at the ends
+	EXPECT_FLOAT_EQ(tPath.Evaluate(-1.0f).mPosition.x, 0.0f);
+	EXPECT_FLOAT_EQ(tPath.Evaluate(2.0f).mPosition.z, -10.0f);
+}
+
+TEST(CameraPathTest, EvenlySpacedKeysGiveLinearMotion) {
+	CameraPath tPath;
+	for (int i = 0; i < 5; ++i)
+	{
+		tPath.AddKey(MakeKey(static_cast<float>(i), 0.0f));
+	}
+
+	// Catmull-Rom reproduces a line between the inner keys
+	EXPECT_NEAR(tPath.Evaluate(0.375f).mPosition.x, 1.5f, 1e-5f);
+	EXPECT_NEAR(tPath.Evaluate(0.625f).mPosition.x, 2.5f, 1e-5f);
+}
+
+TEST(CameraPathTest, SavesAndLoadsKeys) {
+	CameraPath tPath;
+	tPath.AddKey(MakeKey(1.5f, 12.0f));
+	tPath.AddKey(MakeKey(-4.25f, -170.0f));
+
+	const std::string tFile = "CameraPathTest.path";
+	ASSERT_TRUE(tPath.Save(tFile));
+
+	CameraPath tLoaded;
+	ASSERT_TRUE(tLoaded.Load(tFile));
+	ASSERT_EQ(tLoaded.GetKeys().size(), 2u);
+	EXPECT_FLOAT_EQ(tLoaded.GetKeys()[1].mPosition.x, -4.25f);
+	EXPECT_FLOAT_EQ(tLoaded.GetKeys()[1].mPosition.z, 4.25f);
+	EXPECT_FLOAT_EQ(tLoaded.GetKeys()[1].mYaw, -170.0f);
+	EXPECT_FLOAT_EQ(tLoaded.GetKeys()[0].mPitch, -10.0f);
+
+	std::remove(tFile.c_str());
+}
+
+TEST(CameraPathTest, RejectsMalformedFiles) {
+	const std::string tFile = "CameraPathTestMalformed.path";
+	{
+		std::ofstream tStream(tFile);
+		tStream << "# comment\n\n1 2 3 4 5\n1 2 three\n";
+	}
+
+	CameraPath tPath;
+	EXPECT_FALSE(tPath.Load(tFile));
+	EXPECT_TRUE(tPath.IsEmpty());
+	EXPECT_FALSE(tPath.Load("DoesNotExist.path"));
+
+	std::remove(tFile.c_str());
+}
@@ -0,0 +1,45 @@
+#include "pch.h"
+#include "Common/Profiling/ChromeTrace.h"
+
+#include <sstream>
+
+using namespace Flux;
+
+TEST(ChromeTraceTest, EscapesJsonStrings) {
+	EXPECT_EQ(ChromeTrace::Escape("Scene"), "Scene");
+	EXPECT_EQ(ChromeTrace::Escape("a\"b\\c"), "a\\\"b\\\\c");
+	EXPECT_EQ(ChromeTrace::Escape("line\nbreak\t"), "line\\nbreak\\t");
+	EXPECT_EQ(ChromeTrace::Escape(std::string(1, '\x01')), "\\u0001");
+}
+
+TEST(ChromeTraceTest, WritesTrackNamesAndCompleteEvents) {
+	ChromeTrace tTrace;
+	tTrace.SetTrackName(2, "GPU");
+
+	TraceEvent tEvent;
+	tEvent.mName = "Depth";
+	tEvent.mCategory = "gpu";
+	tEvent.mTrack = 2;
+	tEvent.mStartMicroseconds = 1500.25;
+	tEvent.mDurationMicroseconds = 12.5;
+	tTrace.AddEvent(tEvent);
+
+	std::ostringstream tStream;
+	tTrace.Write(tStream);
+	const std::string tJson = tStream.str();
+
+	EXPECT_EQ(tJson.find("{\"traceEvents\":["), 0u);
+	EXPECT_NE(tJson.find("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}"), std::string::npos);
+	EXPECT_NE(tJson.find("{\"name\":\"Depth\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":1500.250,\"dur\":12.500}"), std::string::npos);
+	EXPECT_NE(tJson.find("\"displayTimeUnit\":\"ms\"}"), std::string::npos);
+}
+
+TEST(ChromeTraceTest, EmptyTraceIsValid) {
+	ChromeTrace tTrace;
+
+	std::ostringstream tStream;
+	tTrace.Write(tStream);
+
+	EXPECT_EQ(tStream.str(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ms\"}\n");
+	EXPECT_EQ(tTrace.GetEventCount(), 0u);
+}
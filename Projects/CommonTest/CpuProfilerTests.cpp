@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "Common/Profiling/CpuProfiler.h"
+
+#include <thread>
+
+using namespace Flux;
+
+static void SpinFor(std::chrono::microseconds aDuration)
+{
+	const auto tEnd = CpuProfiler::Clock::now() + aDuration;
+	while (CpuProfiler::Clock::now() < tEnd)
+	{
+	}
+}
+
+TEST(CpuProfilerTest, NestedZonesAreMeasuredPerFrame) {
+	CpuProfiler tProfiler;
+
+	{
+		CpuProfiler::Zone tOuter("Outer", tProfiler);
+		for (int i = 0; i < 2; ++i)
+		{
+			CpuProfiler::Zone tInner("Inner", tProfiler);
+			SpinFor(std::chrono::microseconds(100));
+		}
+	}
+	tProfiler.EndFrame();
+
+	const auto& tZones = tProfiler.GetZones();
+	ASSERT_EQ(tZones.size(), 2u);
+
+	// Inner zones end first
+	EXPECT_EQ(tZones[0].mName, "Inner");
+	EXPECT_EQ(tZones[0].mDepth, 1u);
+	EXPECT_EQ(tZones[0].mCalls, 2u);
+	EXPECT_EQ(tZones[1].mName, "Outer");
+	EXPECT_EQ(tZones[1].mDepth, 0u);
+	EXPECT_EQ(tZones[1].mCalls, 1u);
+
+	// Sub millisecond zones keep their precision
+	EXPECT_GT(tZones[0].mMilliseconds.GetLast(), 0.15);
+	EXPECT_GE(tZones[1].mMilliseconds.GetLast(), tZones[0].mMilliseconds.GetLast());
+
+	// Nothing ran the next frame, the samples stay
+	tProfiler.EndFrame();
+	EXPECT_EQ(tZones[0].mCalls, 0u);
+	EXPECT_EQ(tZones[0].mMilliseconds.GetCount(), 1u);
+	EXPECT_EQ(tProfiler.GetFrameTimes().GetCount(), 1u);
+}
+
+TEST(CpuProfilerTest, DrainsZonesOfOtherThreads) {
+	CpuProfiler tProfiler;
+
+	std::thread tWorker([&tProfiler]
+	{
+		CpuProfiler::Zone tZone("Worker", tProfiler);
+	});
+	tWorker.join();
+
+	tProfiler.EndFrame();
+
+	ASSERT_EQ(tProfiler.GetZones().size(), 1u);
+	EXPECT_EQ(tProfiler.GetZones()[0].mName, "Worker");
+	EXPECT_EQ(tProfiler.GetZones()[0].mCalls, 1u);
+}
+
+TEST(CpuProfilerTest, ExitedThreadsHandTheirBufferOn) {
+	CpuProfiler tProfiler;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		std::thread tWorker([&tProfiler]
+		{
+			CpuProfiler::Zone tZone("Worker", tProfiler);
+		});
+		tWorker.join();
+
+		// The zones of the exited thread are still drained before its buffer is reused
+		tProfiler.EndFrame();
+		ASSERT_EQ(tProfiler.GetZones().size(), 1u);
+		EXPECT_EQ(tProfiler.GetZones()[0].mCalls, 1u);
+	}
+
+	EXPECT_EQ(tProfiler.GetThreadBufferCount(), 1u);
+}
+
+TEST(CpuProfilerTest, BuffersAreOnlyReusedAfterTheyWereDrained) {
+	CpuProfiler tProfiler;
+
+	std::thread tFirst([&tProfiler]
+	{
+		CpuProfiler::Zone tZone("Worker", tProfiler);
+	});
+	tFirst.join();
+
+	// No frame ended in between, so the second thread can't take over the buffer yet
+	std::thread tSecond([&tProfiler]
+	{
+		CpuProfiler::Zone tZone("Worker", tProfiler);
+	});
+	tSecond.join();
+
+	tProfiler.EndFrame();
+	EXPECT_EQ(tProfiler.GetThreadBufferCount(), 2u);
+	EXPECT_EQ(tProfiler.GetZones()[0].mCalls, 2u);
+}
+
+TEST(CpuProfilerTest, ThreadsKeepTheirBufferAcrossProfilers) {
+	CpuProfiler tFirst;
+	CpuProfiler tSecond;
+
+	{
+		CpuProfiler::Zone tZone("First", tFirst);
+	}
+	{
+		CpuProfiler::Zone tZone("Second", tSecond);
+	}
+	{
+		CpuProfiler::Zone tZone("First", tFirst);
+	}
+
+	tFirst.EndFrame();
+	EXPECT_EQ(tFirst.GetThreadBufferCount(), 1u);
+	EXPECT_EQ(tFirst.GetZones()[0].mCalls, 2u);
+}
+
+TEST(CpuProfilerTest, WritesEveryThreadOnItsOwnTrack) {
+	CpuProfiler tProfiler;
+	ChromeTrace tTrace;
+	tProfiler.SetTrace(&tTrace, 4, CpuProfiler::Clock::now());
+
+	{
+		CpuProfiler::Zone tZone("Main", tProfiler);
+	}
+
+	std::thread tWorker([&tProfiler]
+	{
+		CpuProfiler::Zone tZone("Worker", tProfiler);
+	});
+	tWorker.join();
+
+	tProfiler.EndFrame();
+
+	ASSERT_EQ(tTrace.GetEventCount(), 2u);
+	EXPECT_EQ(tTrace.GetEvents()[0].mName, "Main");
+	EXPECT_EQ(tTrace.GetEvents()[0].mTrack, 4u);
+	EXPECT_EQ(tTrace.GetEvents()[1].mName, "Worker");
+	EXPECT_EQ(tTrace.GetEvents()[1].mTrack, 5u);
+	EXPECT_GE(tTrace.GetEvents()[0].mStartMicroseconds, 0.0);
+
+	// Stopped traces get nothing
+	tProfiler.SetTrace(nullptr, 0, CpuProfiler::Clock::time_point{});
+	{
+		CpuProfiler::Zone tZone("Main", tProfiler);
+	}
+	tProfiler.EndFrame();
+	EXPECT_EQ(tTrace.GetEventCount(), 2u);
+}
+
+TEST(CpuProfilerTest, DropsZonesWhenTheBufferIsFull) {
+	CpuProfiler tProfiler;
+
+	for (size_t i = 0; i < CpuProfiler::THREAD_BUFFER_CAPACITY + 10; ++i)
+	{
+		CpuProfiler::Zone tZone("Zone", tProfiler);
+	}
+	tProfiler.EndFrame();
+
+	EXPECT_EQ(tProfiler.GetZones()[0].mCalls, CpuProfiler::THREAD_BUFFER_CAPACITY);
+	EXPECT_EQ(tProfiler.GetDroppedZones(), 10u);
+
+	// Draining made room again
+	{
+		CpuProfiler::Zone tZone("Zone", tProfiler);
+	}
+	tProfiler.EndFrame();
+	EXPECT_EQ(tProfiler.GetZones()[0].mCalls, 1u);
+}
@@ -0,0 +1,80 @@
+#include "pch.h"
+#include "Common/Time/FramePacer.h"
+
+using namespace Flux;
+
+TEST(RollingStatisticsTest, EmptyReturnsZero) {
+	RollingStatistics tStats(4);
+
+	EXPECT_EQ(tStats.GetCount(), 0u);
+	EXPECT_DOUBLE_EQ(tStats.GetAverage(), 0.0);
+	EXPECT_DOUBLE_EQ(tStats.GetMax(), 0.0);
+	EXPECT_DOUBLE_EQ(tStats.GetPercentile(0.99), 0.0);
+}
+
+TEST(RollingStatisticsTest, KeepsOnlyTheLastSamples) {
+	RollingStatistics tStats(4);
+	for (int i = 1; i <= 6; ++i)
+	{
+		tStats.Add(static_cast<double>(i));
+	}
+
+	// 3, 4, 5 and 6 are left
+	EXPECT_EQ(tStats.GetCount(), 4u);
+	EXPECT_DOUBLE_EQ(tStats.GetLast(), 6.0);
+	EXPECT_DOUBLE_EQ(tStats.GetAverage(), 4.5);
+	EXPECT_DOUBLE_EQ(tStats.GetMax(), 6.0);
+
+	tStats.Clear();
+	EXPECT_EQ(tStats.GetCount(), 0u);
+}
+
+TEST(RollingStatisticsTest, PercentileUsesNearestRank) {
+	RollingStatistics tStats(100);
+	for (int i = 100; i >= 1; --i)
+	{
+		tStats.Add(static_cast<double>(i));
+	}
+
+	EXPECT_DOUBLE_EQ(tStats.GetPercentile(0.5), 50.0);
+	EXPECT_DOUBLE_EQ(tStats.GetPercentile(0.99), 99.0);
+	EXPECT_DOUBLE_EQ(tStats.GetPercentile(1.0), 100.0);
+	EXPECT_DOUBLE_EQ(tStats.GetPercentile(0.0), 1.0);
+}
+
+TEST(FramePacerTest, KeepsCadenceWhenOnTime) {
+	const FramePacer::Clock::time_point tStart{};
+	const FramePacer::Clock::duration tInterval = std::chrono::milliseconds(10);
+
+	// Started on time and a little late, the next frame stays on the grid
+	EXPECT_EQ(FramePacer::NextDeadline(tStart, tStart, tInterval), tStart + tInterval);
+	EXPECT_EQ(FramePacer::NextDeadline(tStart, tStart + std::chrono::milliseconds(4), tInterval), tStart + tInterval);
+}
+
+TEST(FramePacerTest, RestartsCadenceAfterLongFrame) {
+	const FramePacer::Clock::time_point tStart{};
+	const FramePacer::Clock::duration tInterval = std::chrono::milliseconds(10);
+	const FramePacer::Clock::time_point tLate = tStart + std::chrono::milliseconds(25);
+
+	// A full interval apart, so the frames after a hitch are not rushed
+	EXPECT_EQ(FramePacer::NextDeadline(tStart, tLate, tInterval), tLate + tInterval);
+}
+
+TEST(FramePacerTest, WaitWithoutLimitReturnsImmediately) {
+	FramePacer tPacer;
+	EXPECT_DOUBLE_EQ(tPacer.Wait(), 0.0);
+}
+
+TEST(FramePacerTest, WaitLimitsFrameRate) {
+	FramePacer tPacer;
+	tPacer.SetFrameRateLimit(200.0f);
+
+	// The first frame is due right away, the others 5 ms apart
+	const FramePacer::Clock::time_point tStart = FramePacer::Clock::now();
+	for (int i = 0; i < 5; ++i)
+	{
+		tPacer.Wait();
+	}
+
+	EXPECT_GE(FramePacer::Clock::now() - tStart, std::chrono::milliseconds(20));
+}
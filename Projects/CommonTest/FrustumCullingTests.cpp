@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "Common/Culling/FrustumCulling.h"
+#include "Common/AssetProcessing/AssetObjects.h"
+
+#include <random>
+#include <glm/gtc/matrix_transform.hpp>
+
+static glm::mat4 TestViewProjection()
+{
+	const glm::mat4 tProjection = glm::perspective(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+	const glm::mat4 tView = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	return tProjection * tView;
+}
+
+TEST(FrustumCullingTest, PlanesPointInwards) {
+	const Flux::Frustum tFrustum = Flux::Frustum::FromMatrix(TestViewProjection());
+	const glm::vec3 tInside(0.0f, 0.0f, -10.0f);
+
+	for (const auto& plane : tFrustum.mPlanes)
+	{
+		EXPECT_NEAR(glm::length(glm::vec3(plane)), 1.0f, 1e-5f);
+		EXPECT_GT(glm::dot(glm::vec3(plane), tInside) + plane.w, 0.0f);
+	}
+}
+
+TEST(FrustumCullingTest, CullsSpheresOutsideEachPlane) {
+	const Flux::Frustum tFrustum = Flux::Frustum::FromMatrix(TestViewProjection());
+
+	Flux::BoundingSphereSoA tSpheres;
+	tSpheres.Add(glm::vec4(0.0f, 0.0f, -10.0f, 1.0f)); // Inside
+	tSpheres.Add(glm::vec4(0.0f, 0.0f, 10.0f, 1.0f)); // Behind the camera
+	tSpheres.Add(glm::vec4(-100.0f, 0.0f, -10.0f, 1.0f)); // Left
+	tSpheres.Add(glm::vec4(100.0f, 0.0f, -10.0f, 1.0f)); // Right
+	tSpheres.Add(glm::vec4(0.0f, -100.0f, -10.0f, 1.0f)); // Below
+	tSpheres.Add(glm::vec4(0.0f, 100.0f, -10.0f, 1.0f)); // Above
+	tSpheres.Add(glm::vec4(0.0f, 0.0f, -200.0f, 1.0f)); // Past the far plane
+	tSpheres.Add(glm::vec4(0.0f, 0.0f, -101.0f, 2.0f)); // Intersects the far plane
+	tSpheres.Add(glm::vec4(0.0f, 0.0f, 1.0f, 1000.0f)); // Contains the frustum
+
+	std::vector<uint8_t> tVisible;
+	const size_t tVisibleCount = Flux::CullSpheres(tFrustum, tSpheres, tVisible);
+
+	const std::vector<uint8_t> tExpected = { 1, 0, 0, 0, 0, 0, 0, 1, 1 };
+	EXPECT_EQ(tVisible, tExpected);
+	EXPECT_EQ(tVisibleCount, 3);
+}
+
+TEST(FrustumCullingTest, OrthographicVolume) {
+	const glm::mat4 tProjection = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 1.0f, 50.0f);
+	const Flux::Frustum tFrustum = Flux::Frustum::FromMatrix(tProjection);
+
+	Flux::BoundingSphereSoA tSpheres;
+	tSpheres.Add(glm::vec4(9.0f, -9.0f, -25.0f, 0.5f));
+	tSpheres.Add(glm::vec4(12.0f, 0.0f, -25.0f, 1.0f));
+	tSpheres.Add(glm::vec4(11.0f, 0.0f, -25.0f, 1.5f));
+
+	std::vector<uint8_t> tVisible;
+	Flux::CullSpheres(tFrustum, tSpheres, tVisible);
+
+	const std::vector<uint8_t> tExpected = { 1, 0, 1 };
+	EXPECT_EQ(tVisible, tExpected);
+}
+
+TEST(FrustumCullingTest, MatchesScalarForEveryRemainder) {
+	const Flux::Frustum tFrustum = Flux::Frustum::FromMatrix(TestViewProjection());
+
+	std::mt19937 tRandom(42);
+	std::uniform_real_distribution<float> tPosition(-120.0f, 120.0f);
+	std::uniform_real_distribution<float> tRadius(0.0f, 10.0f);
+
+	// Counts that do not fill the last SIMD register take the scalar tail
+	for (size_t count = 0; count < 67; ++count)
+	{
+		Flux::BoundingSphereSoA tSpheres;
+		for (size_t i = 0; i < count; ++i)
+		{
+			tSpheres.Add(glm::vec4(tPosition(tRandom), tPosition(tRandom), tPosition(tRandom), tRadius(tRandom)));
+		}
+
+		std::vector<uint8_t> tVisible;
+		std::vector<uint8_t> tVisibleScalar;
+		const size_t tVisibleCount = Flux::CullSpheres(tFrustum, tSpheres, tVisible);
+		const size_t tVisibleCountScalar = Flux::CullSpheresScalar(tFrustum, tSpheres, tVisibleScalar);
+
+		EXPECT_EQ(tVisible, tVisibleScalar);
+		EXPECT_EQ(tVisibleCount, tVisibleCountScalar);
+	}
+}
+
+TEST(FrustumCullingTest, TransformedSphereUsesLargestScale) {
+	glm::mat4 tTransform = glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+	tTransform = glm::scale(tTransform, glm::vec3(1.0f, 4.0f, 2.0f));
+
+	const glm::vec4 tSphere = Flux::TransformBoundingSphere(glm::vec4(1.0f, 1.0f, 0.0f, 0.5f), tTransform);
+
+	EXPECT_FLOAT_EQ(tSphere.x, 2.0f);
+	EXPECT_FLOAT_EQ(tSphere.y, 6.0f);
+	EXPECT_FLOAT_EQ(tSphere.z, 3.0f);
+	EXPECT_FLOAT_EQ(tSphere.w, 2.0f);
+}
+
+TEST(FrustumCullingTest, MeshAssetComputesBounds) {
+	std::vector<Flux::VertexData> tVertices(3);
+	tVertices[0].position = glm::vec3(-1.0f, 0.0f, 0.0f);
+	tVertices[1].position = glm::vec3(3.0f, 2.0f, 0.0f);
+	tVertices[2].position = glm::vec3(1.0f, 0.0f, 4.0f);
+	std::vector<uint32_t> tIndices = { 0, 1, 2 };
+	Flux::MaterialAsset tMaterial;
+
+	const Flux::MeshAsset tMesh(tVertices, tIndices, tMaterial);
+
+	EXPECT_EQ(tMesh.mBoundsMin, glm::vec3(-1.0f, 0.0f, 0.0f));
+	EXPECT_EQ(tMesh.mBoundsMax, glm::vec3(3.0f, 2.0f, 4.0f));
+	EXPECT_EQ(glm::vec3(tMesh.mBoundingSphere), glm::vec3(1.0f, 1.0f, 2.0f));
+
+	// Every vertex is inside the sphere
+	for (const auto& vertex : tVertices)
+	{
+		EXPECT_LE(glm::distance(vertex.position, glm::vec3(tMesh.mBoundingSphere)), tMesh.mBoundingSphere.w + 1e-5f);
+	}
+}
@@ -0,0 +1,184 @@
+#include "pch.h"
+#include "Common/Jobs/JobSystem.h"
+
+#include <atomic>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+
+using namespace Flux;
+
+TEST(JobSystemTest, RunsEveryTaskOfAGroup) {
+	JobSystem tJobs(3);
+	TaskGroup tGroup;
+	std::atomic<int> tCount{ 0 };
+
+	for (int i = 0; i < 1000; ++i)
+	{
+		tJobs.Run(tGroup, [&]() { tCount.fetch_add(1); });
+	}
+	tJobs.Wait(tGroup);
+
+	EXPECT_TRUE(tGroup.IsDone());
+	EXPECT_EQ(tCount.load(), 1000);
+}
+
+TEST(JobSystemTest, WithoutWorkersTheWaitingThreadRunsTasks) {
+	JobSystem tJobs(0);
+	TaskGroup tGroup;
+	int tCount = 0;
+
+	for (int i = 0; i < 10; ++i)
+	{
+		tJobs.Run(tGroup, [&]() { tCount++; });
+	}
+	tJobs.Wait(tGroup);
+
+	EXPECT_EQ(tCount, 10);
+}
+
+TEST(JobSystemTest, TasksCanSpawnAndWaitForTasks) {
+	JobSystem tJobs(2);
+	TaskGroup tGroup;
+	std::atomic<int> tCount{ 0 };
+
+	for (int i = 0; i < 8; ++i)
+	{
+		tJobs.Run(tGroup, [&]() {
+			TaskGroup tInner;
+			for (int j = 0; j < 8; ++j)
+			{
+				tJobs.Run(tInner, [&]() { tCount.fetch_add(1); });
+			}
+			tJobs.Wait(tInner);
+		});
+	}
+	tJobs.Wait(tGroup);
+
+	EXPECT_EQ(tCount.load(), 64);
+}
+
+TEST(JobSystemTest, TasksRunAfterTheirPrerequisites) {
+	JobSystem tJobs(3);
+
+	for (int repeat = 0; repeat < 50; ++repeat)
+	{
+		TaskGroup tGroup;
+		std::atomic<int> tStep{ 0 };
+		std::atomic<bool> tOrdered{ true };
+
+		// A diamond, the last task needs both middle ones, which need the first
+		Task* tFirst = tJobs.Create(tGroup, [&]() { tStep.store(1); });
+		Task* tLeft = tJobs.Create(tGroup, [&]() { if (tStep.load() < 1) tOrdered.store(false); tStep.fetch_add(1); });
+		Task* tRight = tJobs.Create(tGroup, [&]() { if (tStep.load() < 1) tOrdered.store(false); tStep.fetch_add(1); });
+		Task* tLast = tJobs.Create(tGroup, [&]() { if (tStep.load() != 3) tOrdered.store(false); });
+
+		tJobs.AddDependency(tLeft, tFirst);
+		tJobs.AddDependency(tRight, tFirst);
+		tJobs.AddDependency(tLast, tLeft);
+		tJobs.AddDependency(tLast, tRight);
+
+		// Submitted in reverse, nothing may start before its prerequisites
+		tJobs.Submit(tLast);
+		tJobs.Submit(tRight);
+		tJobs.Submit(tLeft);
+		tJobs.Submit(tFirst);
+		tJobs.Wait(tGroup);
+
+		EXPECT_TRUE(tOrdered.load());
+	}
+}
+
+TEST(JobSystemTest, DependencyOnAFinishedTaskDoesNotBlock) {
+	JobSystem tJobs(1);
+	TaskGroup tFirstGroup;
+	TaskGroup tSecondGroup;
+	bool tRan = false;
+
+	// The handle stays valid until its group is waited for, so it can be depended on after it finished
+	Task* tFirst = tJobs.Create(tFirstGroup, []() {});
+	tJobs.Submit(tFirst);
+	while (!tFirstGroup.IsDone()) {}
+
+	Task* tSecond = tJobs.Create(tSecondGroup, [&]() { tRan = true; });
+	tJobs.AddDependency(tSecond, tFirst);
+	tJobs.Submit(tSecond);
+	tJobs.Wait(tSecondGroup);
+	tJobs.Wait(tFirstGroup);
+
+	EXPECT_TRUE(tRan);
+}
+
+TEST(JobSystemTest, ParallelForCoversTheRangeOnce) {
+	JobSystem tJobs(3);
+	std::vector<std::atomic<int>> tVisits(10007);
+
+	tJobs.ParallelFor(0, tVisits.size(), [&](size_t aBegin, size_t aEnd) {
+		for (size_t i = aBegin; i < aEnd; ++i)
+		{
+			tVisits[i].fetch_add(1);
+		}
+	});
+
+	int tWrong = 0;
+	for (const auto& visits : tVisits)
+	{
+		tWrong += visits.load() != 1 ? 1 : 0;
+	}
+	EXPECT_EQ(tWrong, 0);
+}
+
+TEST(JobSystemTest, ParallelForKeepsRangesAtLeastTheMinimumGrain) {
+	JobSystem tJobs(3);
+	std::atomic<size_t> tSmallest{ SIZE_MAX };
+	std::atomic<size_t> tTotal{ 0 };
+
+	tJobs.ParallelFor(5, 1005, [&](size_t aBegin, size_t aEnd) {
+		size_t tSmall = tSmallest.load();
+		while (aEnd - aBegin < tSmall && !tSmallest.compare_exchange_weak(tSmall, aEnd - aBegin)) {}
+		tTotal.fetch_add(aEnd - aBegin);
+	}, 64);
+
+	EXPECT_GE(tSmallest.load(), 64u);
+	EXPECT_EQ(tTotal.load(), 1000u);
+
+	// Empty ranges call nothing
+	bool tCalled = false;
+	tJobs.ParallelFor(10, 10, [&](size_t, size_t) { tCalled = true; });
+	EXPECT_FALSE(tCalled);
+}
+
+TEST(JobSystemTest, WaitRethrowsTheExceptionOfATask) {
+	JobSystem tJobs(2);
+	TaskGroup tGroup;
+	std::atomic<int> tCount{ 0 };
+
+	tJobs.Run(tGroup, []() { throw std::runtime_error("task failed"); });
+	for (int i = 0; i < 10; ++i)
+	{
+		tJobs.Run(tGroup, [&]() { tCount.fetch_add(1); });
+	}
+
+	EXPECT_THROW(tJobs.Wait(tGroup), std::runtime_error);
+	EXPECT_TRUE(tGroup.IsDone());
+	EXPECT_EQ(tCount.load(), 10);
+
+	EXPECT_THROW(tJobs.ParallelFor(0, 100, [](size_t aBegin, size_t) { if (aBegin == 0) throw std::runtime_error("range failed"); }), std::runtime_error);
+}
+
+TEST(JobSystemTest, OtherThreadsCanSpawnAndWait) {
+	JobSystem tJobs(2);
+	std::atomic<int> tCount{ 0 };
+
+	std::thread tOther([&]() {
+		TaskGroup tGroup;
+		for (int i = 0; i < 100; ++i)
+		{
+			tJobs.Run(tGroup, [&]() { tCount.fetch_add(1); });
+		}
+		tJobs.Wait(tGroup);
+	});
+	tOther.join();
+
+	EXPECT_EQ(tCount.load(), 100);
+}
@@ -0,0 +1,88 @@
+#include "pch.h"
+#include "Common/Culling/OcclusionCulling.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// Camera at the origin looking down -z with a [0, 1] depth range like the renderer
+static glm::mat4 TestViewProjection()
+{
+	return glm::perspectiveRH_ZO(glm::radians(60.0f), 1.0f, 0.1f, 100.0f);
+}
+
+static float DepthAt(float aViewDistance)
+{
+	const glm::vec4 tClip = TestViewProjection() * glm::vec4(0.0f, 0.0f, -aViewDistance, 1.0f);
+	return tClip.z / tClip.w;
+}
+
+TEST(OcclusionCullingTest, BuildKeepsFurthestDepth) {
+	const std::vector<float> tDepth =
+	{
+		0.1f, 0.2f, 0.3f, 0.4f,
+		0.5f, 0.6f, 0.1f, 0.1f,
+		0.1f, 0.1f, 0.1f, 0.1f,
+		0.1f, 0.9f, 0.1f, 0.1f,
+	};
+
+	Flux::DepthPyramid tPyramid;
+	tPyramid.Build(tDepth.data(), 4, 4);
+
+	ASSERT_EQ(tPyramid.GetLevelCount(), 3);
+	EXPECT_EQ(tPyramid.GetWidth(1), 2);
+	EXPECT_FLOAT_EQ(tPyramid.GetDepth(1, 0, 0), 0.6f);
+	EXPECT_FLOAT_EQ(tPyramid.GetDepth(1, 1, 0), 0.4f);
+	EXPECT_FLOAT_EQ(tPyramid.GetDepth(1, 0, 1), 0.9f);
+	EXPECT_FLOAT_EQ(tPyramid.GetDepth(1, 1, 1), 0.1f);
+	EXPECT_FLOAT_EQ(tPyramid.GetDepth(2, 0, 0), 0.9f);
+}
+
+TEST(OcclusionCullingTest, LevelSizes) {
+	EXPECT_EQ(Flux::DepthPyramid::PreviousPowerOfTwo(1), 1);
+	EXPECT_EQ(Flux::DepthPyramid::PreviousPowerOfTwo(1080), 1024);
+	EXPECT_EQ(Flux::DepthPyramid::PreviousPowerOfTwo(2048), 2048);
+	EXPECT_EQ(Flux::DepthPyramid::CountLevels(1024, 512), 11);
+	EXPECT_EQ(Flux::DepthPyramid::CountLevels(1, 1), 1);
+}
+
+TEST(OcclusionCullingTest, SphereBehindWallIsOccluded) {
+	const std::vector<float> tDepth(64 * 64, DepthAt(10.0f));
+
+	Flux::DepthPyramid tPyramid;
+	tPyramid.Build(tDepth.data(), 64, 64);
+
+	EXPECT_TRUE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, -20.0f, 1.0f), TestViewProjection()));
+	EXPECT_TRUE(tPyramid.IsSphereOccluded(glm::vec4(3.0f, -2.0f, -50.0f, 0.1f), TestViewProjection()));
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, -5.0f, 1.0f), TestViewProjection()));
+
+	// Reaches through the wall
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, -12.0f, 3.0f), TestViewProjection()));
+
+	// Crosses the near plane, can not be projected
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), TestViewProjection()));
+}
+
+TEST(OcclusionCullingTest, PartialWallOnlyOccludesBehindIt) {
+	// Wall on the left half of the screen, nothing on the right
+	std::vector<float> tDepth(64 * 64, 1.0f);
+	for (uint32_t y = 0; y < 64; ++y)
+	{
+		for (uint32_t x = 0; x < 32; ++x)
+		{
+			tDepth[y * 64 + x] = DepthAt(10.0f);
+		}
+	}
+
+	Flux::DepthPyramid tPyramid;
+	tPyramid.Build(tDepth.data(), 64, 64);
+
+	EXPECT_TRUE(tPyramid.IsSphereOccluded(glm::vec4(-10.0f, 0.0f, -30.0f, 1.0f), TestViewProjection()));
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(10.0f, 0.0f, -30.0f, 1.0f), TestViewProjection()));
+
+	// Straddles the edge of the wall
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, -30.0f, 2.0f), TestViewProjection()));
+}
+
+TEST(OcclusionCullingTest, EmptyPyramidOccludesNothing) {
+	Flux::DepthPyramid tPyramid;
+	EXPECT_FALSE(tPyramid.IsSphereOccluded(glm::vec4(0.0f, 0.0f, -20.0f, 1.0f), TestViewProjection()));
+}
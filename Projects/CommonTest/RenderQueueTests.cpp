@@ -0,0 +1,165 @@
+#include "pch.h"
+#include "Common/Rendering/RenderQueue.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace Flux;
+
+// Reference order of the items, the radix sort has to match a stable comparison sort
+static std::vector<RenderQueue::DrawItem> StableSorted(std::vector<RenderQueue::DrawItem> aItems)
+{
+	std::stable_sort(aItems.begin(), aItems.end(), [](const RenderQueue::DrawItem& aLeft, const RenderQueue::DrawItem& aRight) { return aLeft.mKey < aRight.mKey; });
+	return aItems;
+}
+
+static std::pair<size_t, size_t> Range(size_t aBegin, size_t aEnd)
+{
+	return { aBegin, aEnd };
+}
+
+static void ExpectSameOrder(const std::vector<RenderQueue::DrawItem>& aItems, const std::vector<RenderQueue::DrawItem>& aExpected)
+{
+	ASSERT_EQ(aItems.size(), aExpected.size());
+	for (size_t i = 0; i < aItems.size(); i++)
+	{
+		EXPECT_EQ(aItems[i].mKey, aExpected[i].mKey);
+		EXPECT_EQ(aItems[i].mObjectIndex, aExpected[i].mObjectIndex);
+	}
+}
+
+TEST(RenderQueueTest, SortsByPassThenPipelineMaterialMeshAndDepth) {
+	RenderQueue tQueue;
+	tQueue.Add(RenderQueue::MakeKey(1, 0, 0, 0, 0.0f), 0);
+	tQueue.Add(RenderQueue::MakeKey(0, 2, 0, 0, 0.0f), 1);
+	tQueue.Add(RenderQueue::MakeKey(0, 1, 5, 0, 0.0f), 2);
+	tQueue.Add(RenderQueue::MakeKey(0, 1, 3, 7, 0.0f), 3);
+	tQueue.Add(RenderQueue::MakeKey(0, 1, 3, 2, 0.9f), 4);
+	tQueue.Add(RenderQueue::MakeKey(0, 1, 3, 2, 0.1f), 5);
+
+	tQueue.Sort();
+
+	const std::vector<uint32_t> tExpected = { 5, 4, 3, 2, 1, 0 };
+	ASSERT_EQ(tQueue.GetItems().size(), tExpected.size());
+	for (size_t i = 0; i < tExpected.size(); i++)
+	{
+		EXPECT_EQ(tQueue.GetItems()[i].mObjectIndex, tExpected[i]);
+	}
+}
+
+TEST(RenderQueueTest, EqualKeysKeepTheirOrderAcrossPasses) {
+	RenderQueue tQueue;
+	for (uint32_t i = 0; i < 30; i++)
+	{
+		// Three passes with two distinct keys each, added interleaved
+		tQueue.Add(RenderQueue::MakeKey(2 - i % 3, i % 2, 0, 0, 0.5f), i);
+	}
+
+	const std::vector<RenderQueue::DrawItem> tExpected = StableSorted(tQueue.GetItems());
+	tQueue.Sort();
+
+	ExpectSameOrder(tQueue.GetItems(), tExpected);
+}
+
+TEST(RenderQueueTest, MatchesStableSortOfRandomKeys) {
+	std::mt19937 tRandom(7);
+	std::uniform_int_distribution<uint32_t> tId(0, 70000);
+	std::uniform_real_distribution<float> tDepth(0.0f, 1.0f);
+
+	RenderQueue tQueue;
+	for (uint32_t i = 0; i < 5000; i++)
+	{
+		tQueue.Add(RenderQueue::MakeKey(tId(tRandom) % 3, tId(tRandom) % 8, tId(tRandom) % 64, tId(tRandom), tDepth(tRandom)), i);
+	}
+
+	const std::vector<RenderQueue::DrawItem> tExpected = StableSorted(tQueue.GetItems());
+	tQueue.Sort();
+
+	ExpectSameOrder(tQueue.GetItems(), tExpected);
+}
+
+TEST(RenderQueueTest, PassRanges) {
+	RenderQueue tQueue;
+	tQueue.Add(RenderQueue::MakeKey(2, 0, 0, 0, 0.0f), 0);
+	tQueue.Add(RenderQueue::MakeKey(0, 3, 0, 0, 0.0f), 1);
+	tQueue.Add(RenderQueue::MakeKey(2, 1, 0, 0, 0.0f), 2);
+	tQueue.Add(RenderQueue::MakeKey(0, 1, 0, 0, 0.0f), 3);
+	tQueue.Add(RenderQueue::MakeKey(2, 2, 0, 0, 0.0f), 4);
+	tQueue.Sort();
+
+	EXPECT_EQ(tQueue.GetPassRange(0), Range(0, 2));
+	EXPECT_EQ(tQueue.GetPassRange(2), Range(2, 5));
+
+	// Empty passes give an empty range where the pass would be
+	EXPECT_EQ(tQueue.GetPassRange(1), Range(2, 2));
+	EXPECT_EQ(tQueue.GetPassRange(3), Range(5, 5));
+
+	RenderQueue tEmpty;
+	tEmpty.Sort();
+	EXPECT_EQ(tEmpty.GetPassRange(0), Range(0, 0));
+}
+
+TEST(RenderQueueTest, DepthIsClamped) {
+	const uint64_t tDepthMask = (1ull << RenderQueue::DEPTH_BITS) - 1;
+
+	EXPECT_EQ(RenderQueue::MakeKey(1, 2, 3, 4, -5.0f), RenderQueue::MakeKey(1, 2, 3, 4, 0.0f));
+	EXPECT_EQ(RenderQueue::MakeKey(1, 2, 3, 4, 5.0f), RenderQueue::MakeKey(1, 2, 3, 4, 1.0f));
+	EXPECT_EQ(RenderQueue::MakeKey(1, 2, 3, 4, 0.0f) & tDepthMask, 0);
+	EXPECT_EQ(RenderQueue::MakeKey(1, 2, 3, 4, 1.0f) & tDepthMask, tDepthMask);
+
+	// A far depth never carries into the mesh field
+	EXPECT_LT(RenderQueue::MakeKey(1, 2, 3, 4, 5.0f), RenderQueue::MakeKey(1, 2, 3, 5, 0.0f));
+}
+
+TEST(RenderQueueTest, IdsWrapPastTheirFieldWidths) {
+	const uint32_t tPipelineWrap = 1u << RenderQueue::PIPELINE_BITS;
+	const uint32_t tMaterialWrap = 1u << RenderQueue::MATERIAL_BITS;
+	const uint32_t tMeshWrap = 1u << RenderQueue::MESH_BITS;
+
+	EXPECT_EQ(RenderQueue::MakeKey(1, tPipelineWrap + 2, 0, 0, 0.0f), RenderQueue::MakeKey(1, 2, 0, 0, 0.0f));
+	EXPECT_EQ(RenderQueue::MakeKey(1, 0, tMaterialWrap + 3, 0, 0.0f), RenderQueue::MakeKey(1, 0, 3, 0, 0.0f));
+	EXPECT_EQ(RenderQueue::MakeKey(1, 0, 0, tMeshWrap + 4, 0.0f), RenderQueue::MakeKey(1, 0, 0, 4, 0.0f));
+
+	// Wrapped ids stay inside their field, the pass is never touched
+	const uint64_t tKey = RenderQueue::MakeKey(1, UINT32_MAX, UINT32_MAX, UINT32_MAX, 1.0f);
+	EXPECT_EQ(RenderQueue::GetPass(tKey), 1);
+	EXPECT_EQ(tKey, (2ull << (64 - RenderQueue::PASS_BITS)) - 1);
+}
+
+TEST(RenderQueueTest, SortsWhenBytesAreEqualForEveryKey) {
+	// Only the pass differs, every other byte is skipped and the items are scattered a single time
+	RenderQueue tPassOnly;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		tPassOnly.Add(RenderQueue::MakeKey(15 - i % 4, 7, 9, 11, 0.25f), i);
+	}
+
+	std::vector<RenderQueue::DrawItem> tExpected = StableSorted(tPassOnly.GetItems());
+	tPassOnly.Sort();
+	ExpectSameOrder(tPassOnly.GetItems(), tExpected);
+
+	// Only the low depth byte differs
+	RenderQueue tDepthOnly;
+	for (uint32_t i = 0; i < 16; i++)
+	{
+		tDepthOnly.Add(RenderQueue::MakeKey(0, 0, 0, 0, static_cast<float>(15 - i) / ((1 << RenderQueue::DEPTH_BITS) - 1)), i);
+	}
+
+	tExpected = StableSorted(tDepthOnly.GetItems());
+	tDepthOnly.Sort();
+	ExpectSameOrder(tDepthOnly.GetItems(), tExpected);
+	EXPECT_EQ(tDepthOnly.GetItems().front().mObjectIndex, 15);
+
+	// Identical keys skip every byte and keep the order they were added in
+	RenderQueue tIdentical;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		tIdentical.Add(RenderQueue::MakeKey(3, 1, 2, 3, 0.5f), i);
+	}
+
+	tIdentical.Sort();
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		EXPECT_EQ(tIdentical.GetItems()[i].mObjectIndex, i);
+	}
+}
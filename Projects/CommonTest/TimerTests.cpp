@@ -0,0 +1,17 @@
+#include "pch.h"
+#include "Common/Time/Timer.h"
+
+TEST(TimerTest, DeltaKeepsSubMillisecondPrecision) {
+	Timer tTimer;
+	tTimer.Reset();
+
+	const auto tEnd = std::chrono::steady_clock::now() + std::chrono::microseconds(300);
+	while (std::chrono::steady_clock::now() < tEnd)
+	{
+	}
+
+	// Truncated to whole milliseconds this would read 0
+	const double tDelta = tTimer.GetDelta();
+	EXPECT_GE(tDelta, 0.3);
+	EXPECT_LT(tDelta, 1000.0);
+}
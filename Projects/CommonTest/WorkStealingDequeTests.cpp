@@ -0,0 +1,99 @@
+#include "pch.h"
+#include "Common/Jobs/WorkStealingDeque.h"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+
+using namespace Flux;
+
+TEST(WorkStealingDequeTest, OwnerPopsLastPushedAndThievesStealFirstPushed) {
+	WorkStealingDeque<int> tDeque;
+	tDeque.Push(1);
+	tDeque.Push(2);
+	tDeque.Push(3);
+
+	int tItem = 0;
+	ASSERT_TRUE(tDeque.Steal(tItem));
+	EXPECT_EQ(tItem, 1);
+	ASSERT_TRUE(tDeque.Pop(tItem));
+	EXPECT_EQ(tItem, 3);
+	ASSERT_TRUE(tDeque.Pop(tItem));
+	EXPECT_EQ(tItem, 2);
+
+	EXPECT_FALSE(tDeque.Pop(tItem));
+	EXPECT_FALSE(tDeque.Steal(tItem));
+	EXPECT_TRUE(tDeque.IsEmpty());
+}
+
+TEST(WorkStealingDequeTest, GrowsWhenFull) {
+	WorkStealingDeque<int> tDeque(4);
+	EXPECT_EQ(tDeque.GetCapacity(), 4u);
+
+	for (int i = 0; i < 100; ++i)
+	{
+		tDeque.Push(i);
+	}
+	EXPECT_EQ(tDeque.GetSize(), 100u);
+	EXPECT_GE(tDeque.GetCapacity(), 100u);
+
+	int tItem = 0;
+	for (int i = 99; i >= 0; --i)
+	{
+		ASSERT_TRUE(tDeque.Pop(tItem));
+		EXPECT_EQ(tItem, i);
+	}
+}
+
+TEST(WorkStealingDequeTest, EveryItemIsTakenExactlyOnceUnderContention) {
+	const int tItemCount = 200000;
+	const int tThiefCount = 3;
+
+	WorkStealingDeque<int> tDeque(16);
+	std::vector<std::atomic<int>> tTaken(tItemCount);
+	std::atomic<bool> tDone{ false };
+
+	std::vector<std::thread> tThieves;
+	for (int thief = 0; thief < tThiefCount; ++thief)
+	{
+		tThieves.emplace_back([&]() {
+			int tItem = 0;
+			while (!tDone.load())
+			{
+				if (tDeque.Steal(tItem))
+				{
+					tTaken[tItem].fetch_add(1);
+				}
+			}
+		});
+	}
+
+	// The owner alternates pushing and popping so pops race thieves for the last item
+	int tItem = 0;
+	for (int i = 0; i < tItemCount; ++i)
+	{
+		tDeque.Push(i);
+		if (i % 3 == 0 && tDeque.Pop(tItem))
+		{
+			tTaken[tItem].fetch_add(1);
+		}
+	}
+
+	while (tDeque.Pop(tItem))
+	{
+		tTaken[tItem].fetch_add(1);
+	}
+
+	tDone.store(true);
+	for (auto& thief : tThieves)
+	{
+		thief.join();
+	}
+
+	int tWrong = 0;
+	for (int i = 0; i < tItemCount; ++i)
+	{
+		tWrong += tTaken[i].load() != 1 ? 1 : 0;
+	}
+	EXPECT_EQ(tWrong, 0);
+}
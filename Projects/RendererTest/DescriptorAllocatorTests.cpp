@@ -0,0 +1,225 @@
+#include "pch.h"
+
+#include "Renderer/DescriptorAllocator.h"
+
+#include <cstring>
+#include <set>
+
+using namespace Flux::Gfx;
+
+namespace
+{
+	// Handles are pointers on 64 bit and integers on 32 bit, both are 8 bytes
+	template<typename T>
+	T MakeHandle(uint64_t aValue)
+	{
+		static_assert(sizeof(T) == sizeof(uint64_t), "handles are 8 bytes");
+
+		T tHandle;
+		std::memcpy(&tHandle, &aValue, sizeof(T));
+		return tHandle;
+	}
+
+	template<typename T>
+	uint64_t GetHandleValue(T aHandle)
+	{
+		uint64_t tValue;
+		std::memcpy(&tValue, &aHandle, sizeof(T));
+		return tValue;
+	}
+
+	// Pools that hold a fixed amount of sets, handles are one based indices
+	struct FakePools
+	{
+		uint32_t mCapacity = 2;
+		VkResult mExhaustedResult = VK_ERROR_OUT_OF_POOL_MEMORY;
+
+		std::vector<uint32_t> mUsed;
+		uint32_t mResets = 0;
+		uint32_t mDestroyed = 0;
+		uint64_t mNextSet = 1;
+
+		DescriptorPoolBackend GetBackend()
+		{
+			DescriptorPoolBackend tBackend;
+			tBackend.mCreatePool = [this]()
+			{
+				mUsed.push_back(0);
+				return MakeHandle<VkDescriptorPool>(mUsed.size());
+			};
+			tBackend.mAllocateSet = [this](VkDescriptorPool aPool, VkDescriptorSetLayout, VkDescriptorSet& aOutSet)
+			{
+				uint32_t& tUsed = mUsed[GetHandleValue(aPool) - 1];
+				if (tUsed == mCapacity)
+				{
+					return mExhaustedResult;
+				}
+
+				tUsed++;
+				aOutSet = MakeHandle<VkDescriptorSet>(mNextSet++);
+				return VK_SUCCESS;
+			};
+			tBackend.mResetPool = [this](VkDescriptorPool aPool)
+			{
+				mUsed[GetHandleValue(aPool) - 1] = 0;
+				mResets++;
+			};
+			tBackend.mDestroyPool = [this](VkDescriptorPool) { mDestroyed++; };
+
+			return tBackend;
+		}
+	};
+
+	void Initialize(DescriptorAllocator& aAllocator, uint32_t aFrameCount)
+	{
+		DescriptorAllocatorCreateDesc tDesc{};
+		tDesc.mSetsPerPool = 2;
+		tDesc.mFrameCount = aFrameCount;
+		InitializeDescriptorAllocator(aAllocator, tDesc);
+	}
+}
+
+TEST(DescriptorAllocatorTest, PersistentPoolsChainWhenFull) {
+	FakePools tPools;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+	const VkDescriptorSetLayout tLayout = MakeHandle<VkDescriptorSetLayout>(1);
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 1);
+
+	std::set<VkDescriptorSet> tSets;
+	for (int i = 0; i < 5; i++)
+	{
+		tSets.insert(AllocatePersistentSet(tAllocator, tBackend, tLayout));
+	}
+
+	EXPECT_EQ(tSets.size(), 5);
+	EXPECT_EQ(tAllocator.mPersistentPools.size(), 3);
+	EXPECT_EQ(tAllocator.mStats.mPersistentPools, 3);
+	EXPECT_EQ(tAllocator.mStats.mPoolExhaustions, 2);
+	EXPECT_EQ(tAllocator.mStats.mFragmentedPools, 0);
+	EXPECT_EQ(tAllocator.mStats.mPersistentSetsLive, 5);
+}
+
+TEST(DescriptorAllocatorTest, FragmentedPoolsAreCounted) {
+	FakePools tPools;
+	tPools.mExhaustedResult = VK_ERROR_FRAGMENTED_POOL;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+	const VkDescriptorSetLayout tLayout = MakeHandle<VkDescriptorSetLayout>(1);
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 1);
+
+	for (int i = 0; i < 3; i++)
+	{
+		AllocatePersistentSet(tAllocator, tBackend, tLayout);
+	}
+
+	EXPECT_EQ(tAllocator.mStats.mPoolExhaustions, 1);
+	EXPECT_EQ(tAllocator.mStats.mFragmentedPools, 1);
+}
+
+TEST(DescriptorAllocatorTest, FreedSetsAreReusedForTheirLayout) {
+	FakePools tPools;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+	const VkDescriptorSetLayout tLayoutA = MakeHandle<VkDescriptorSetLayout>(1);
+	const VkDescriptorSetLayout tLayoutB = MakeHandle<VkDescriptorSetLayout>(2);
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 1);
+
+	const VkDescriptorSet tFirst = AllocatePersistentSet(tAllocator, tBackend, tLayoutA);
+	FreePersistentSet(tAllocator, tLayoutA, tFirst);
+
+	EXPECT_EQ(tAllocator.mStats.mPersistentSetsLive, 0);
+	EXPECT_EQ(tAllocator.mStats.mPersistentSetsFree, 1);
+
+	// A set of another layout is never handed out
+	const VkDescriptorSet tOther = AllocatePersistentSet(tAllocator, tBackend, tLayoutB);
+	EXPECT_NE(tOther, tFirst);
+	EXPECT_EQ(tAllocator.mStats.mFreeListReuses, 0);
+
+	const VkDescriptorSet tReused = AllocatePersistentSet(tAllocator, tBackend, tLayoutA);
+	EXPECT_EQ(tReused, tFirst);
+	EXPECT_EQ(tAllocator.mStats.mFreeListReuses, 1);
+	EXPECT_EQ(tAllocator.mStats.mPersistentSetsFree, 0);
+	EXPECT_EQ(tAllocator.mStats.mPersistentSetsLive, 2);
+
+	// Reuse does not touch the pools
+	EXPECT_EQ(tAllocator.mStats.mPersistentPools, 1);
+}
+
+TEST(DescriptorAllocatorTest, TransientPoolsAreResetWithTheirFrame) {
+	FakePools tPools;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+	const VkDescriptorSetLayout tLayout = MakeHandle<VkDescriptorSetLayout>(1);
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 2);
+
+	ResetFramePools(tAllocator, tBackend, 0);
+	for (int i = 0; i < 3; i++)
+	{
+		AllocateFrameSet(tAllocator, tBackend, tLayout);
+	}
+
+	EXPECT_EQ(tAllocator.mFramePools[0].mPools.size(), 2);
+	EXPECT_EQ(tAllocator.mStats.mTransientSetsThisFrame, 3);
+
+	// The other frame has pools of its own
+	ResetFramePools(tAllocator, tBackend, 1);
+	EXPECT_EQ(tPools.mResets, 0);
+	EXPECT_EQ(tAllocator.mStats.mTransientSetsThisFrame, 0);
+
+	AllocateFrameSet(tAllocator, tBackend, tLayout);
+	EXPECT_EQ(tAllocator.mFramePools[1].mPools.size(), 1);
+	EXPECT_EQ(tAllocator.mStats.mTransientPools, 3);
+
+	// Coming back around resets the chain of the first frame, which then holds the same sets again without growing
+	ResetFramePools(tAllocator, tBackend, 2);
+	EXPECT_EQ(tAllocator.mCurrentFrame, 0);
+	EXPECT_EQ(tPools.mResets, 2);
+
+	for (int i = 0; i < 4; i++)
+	{
+		AllocateFrameSet(tAllocator, tBackend, tLayout);
+	}
+
+	EXPECT_EQ(tAllocator.mFramePools[0].mPools.size(), 2);
+	EXPECT_EQ(tAllocator.mStats.mTransientPools, 3);
+	EXPECT_EQ(tAllocator.mStats.mTransientSetsThisFrame, 4);
+}
+
+TEST(DescriptorAllocatorTest, TransientSetThatNeverFitsThrows) {
+	FakePools tPools;
+	tPools.mCapacity = 0;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 1);
+
+	EXPECT_THROW(AllocateFrameSet(tAllocator, tBackend, MakeHandle<VkDescriptorSetLayout>(1)), std::runtime_error);
+	EXPECT_EQ(tAllocator.mFramePools[0].mPools.size(), 1);
+}
+
+TEST(DescriptorAllocatorTest, DestroyReleasesEveryPool) {
+	FakePools tPools;
+	const DescriptorPoolBackend tBackend = tPools.GetBackend();
+	const VkDescriptorSetLayout tLayout = MakeHandle<VkDescriptorSetLayout>(1);
+
+	DescriptorAllocator tAllocator;
+	Initialize(tAllocator, 2);
+
+	for (int i = 0; i < 3; i++)
+	{
+		AllocatePersistentSet(tAllocator, tBackend, tLayout);
+		AllocateFrameSet(tAllocator, tBackend, tLayout);
+	}
+
+	DestroyDescriptorAllocatorPools(tAllocator, tBackend);
+
+	EXPECT_EQ(tPools.mDestroyed, tPools.mUsed.size());
+	EXPECT_TRUE(tAllocator.mPersistentPools.empty());
+	EXPECT_TRUE(tAllocator.mFramePools.empty());
+	EXPECT_EQ(tAllocator.mStats.mPersistentPools, 0);
+}
@@ -0,0 +1,69 @@
+#include "pch.h"
+
+#include "Renderer/FileUtility.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace Flux::Gfx;
+
+namespace
+{
+	void WriteText(const std::string& aPath, const std::string& aText)
+	{
+		std::ofstream tFile(aPath, std::ios::binary | std::ios::trunc);
+		tFile << aText;
+	}
+
+	std::string ReadText(const std::string& aPath)
+	{
+		std::ifstream tFile(aPath, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(tFile), std::istreambuf_iterator<char>());
+	}
+
+	bool Exists(const std::string& aPath)
+	{
+		return std::ifstream(aPath).is_open();
+	}
+}
+
+TEST(FileUtilityTest, ReplacesExistingFile) {
+	const std::string tSource = "FileUtilityTest_Replace.tmp";
+	const std::string tDestination = "FileUtilityTest_Replace.bin";
+
+	WriteText(tDestination, "old");
+	WriteText(tSource, "new");
+
+	EXPECT_TRUE(AtomicReplaceFile(tSource, tDestination));
+	EXPECT_EQ(ReadText(tDestination), "new");
+	EXPECT_FALSE(Exists(tSource));
+
+	std::remove(tDestination.c_str());
+}
+
+TEST(FileUtilityTest, CreatesMissingDestination) {
+	const std::string tSource = "FileUtilityTest_Create.tmp";
+	const std::string tDestination = "FileUtilityTest_Create.bin";
+	std::remove(tDestination.c_str());
+
+	WriteText(tSource, "data");
+
+	EXPECT_TRUE(AtomicReplaceFile(tSource, tDestination));
+	EXPECT_EQ(ReadText(tDestination), "data");
+
+	std::remove(tDestination.c_str());
+}
+
+TEST(FileUtilityTest, MissingSourceKeepsDestination) {
+	const std::string tSource = "FileUtilityTest_Missing.tmp";
+	const std::string tDestination = "FileUtilityTest_Missing.bin";
+	std::remove(tSource.c_str());
+
+	WriteText(tDestination, "old");
+
+	EXPECT_FALSE(AtomicReplaceFile(tSource, tDestination));
+	EXPECT_EQ(ReadText(tDestination), "old");
+
+	std::remove(tDestination.c_str());
+}
@@ -0,0 +1,217 @@
+#include "pch.h"
+
+#include "Renderer/FrameGraph.h"
+
+#include <algorithm>
+
+using namespace Flux::Gfx;
+
+// Compile never touches the images, so any unique handle works
+static VkImage FakeImage(uintptr_t aValue)
+{
+	return reinterpret_cast<VkImage>(aValue);
+}
+
+TEST(FrameGraphTest, CullsPassesWithoutOutput) {
+	FrameGraph graph;
+
+	FrameGraphImageDesc unused{};
+	unused.mImage = FakeImage(1);
+	graph.ImportImage("Unused", unused);
+
+	FrameGraphImageDesc output{};
+	output.mImage = FakeImage(2);
+	output.mFinalAccess = ResourceAccess::eTransferRead;
+	graph.ImportImage("Output", output);
+
+	FrameGraphImageDesc intermediate{};
+	intermediate.mImage = FakeImage(3);
+	graph.ImportImage("Intermediate", intermediate);
+
+	graph.AddPass("WritesUnused", nullptr).Write("Unused", ResourceAccess::eComputeStorageWrite);
+	graph.AddPass("WritesIntermediate", nullptr).Write("Intermediate", ResourceAccess::eColorAttachment);
+	graph.AddPass("WritesOutput", nullptr).Read("Intermediate", ResourceAccess::eComputeStorageRead).Write("Output", ResourceAccess::eComputeStorageWrite);
+
+	graph.Compile();
+
+	EXPECT_TRUE(graph.IsCulled("WritesUnused"));
+	EXPECT_FALSE(graph.IsCulled("WritesIntermediate"));
+	EXPECT_FALSE(graph.IsCulled("WritesOutput"));
+	EXPECT_EQ(graph.GetStats().mCulledPasses, 1);
+}
+
+TEST(FrameGraphTest, OverwrittenContentsCullEarlierWriter) {
+	FrameGraph graph;
+
+	FrameGraphImageDesc output{};
+	output.mImage = FakeImage(1);
+	output.mFinalAccess = ResourceAccess::ePresent;
+	graph.ImportImage("Output", output);
+
+	graph.AddPass("First", nullptr).Write("Output", ResourceAccess::eTransferWrite);
+	graph.AddPass("Second", nullptr).Write("Output", ResourceAccess::eTransferWrite);
+	graph.AddPass("Overlay", nullptr).Modify("Output", ResourceAccess::eColorAttachment);
+
+	graph.Compile();
+
+	EXPECT_TRUE(graph.IsCulled("First"));
+	EXPECT_FALSE(graph.IsCulled("Second"));
+	EXPECT_FALSE(graph.IsCulled("Overlay"));
+}
+
+TEST(FrameGraphTest, DepthWriteToFragmentRead) {
+	FrameGraph graph;
+
+	FrameGraphImageDesc depth{};
+	depth.mImage = FakeImage(1);
+	depth.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	graph.ImportImage("Depth", depth);
+
+	FrameGraphImageDesc color{};
+	color.mImage = FakeImage(2);
+	color.mFinalAccess = ResourceAccess::eTransferRead;
+	graph.ImportImage("Color", color);
+
+	graph.AddPass("Depth", nullptr).Write("Depth", ResourceAccess::eDepthAttachment);
+	graph.AddPass("Scene", nullptr).Read("Depth", ResourceAccess::eFragmentShaderRead).Write("Color", ResourceAccess::eColorAttachment);
+
+	graph.Compile();
+
+	const auto& barriers = graph.GetBarriers("Scene");
+	const auto depthBarrier = std::find_if(barriers.begin(), barriers.end(), [](const VkImageMemoryBarrier2KHR& x) { return x.image == FakeImage(1); });
+	ASSERT_NE(depthBarrier, barriers.end());
+
+	EXPECT_EQ(depthBarrier->oldLayout, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+	EXPECT_EQ(depthBarrier->newLayout, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	EXPECT_EQ(depthBarrier->srcAccessMask, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR);
+	EXPECT_EQ(depthBarrier->dstStageMask, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR);
+	EXPECT_EQ(depthBarrier->dstAccessMask, VK_ACCESS_2_SHADER_READ_BIT_KHR);
+	EXPECT_EQ(depthBarrier->subresourceRange.aspectMask, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+	// Both images are batched before the scene pass
+	EXPECT_EQ(barriers.size(), 2);
+}
+
+TEST(FrameGraphTest, RepeatedReadsNeedNoBarrier) {
+	FrameGraph graph;
+
+	FrameGraphImageDesc image{};
+	image.mImage = FakeImage(1);
+	graph.ImportImage("Image", image);
+
+	FrameGraphImageDesc output{};
+	output.mImage = FakeImage(2);
+	output.mFinalAccess = ResourceAccess::eTransferRead;
+	graph.ImportImage("Output", output);
+
+	graph.AddPass("Write", nullptr).Write("Image", ResourceAccess::eComputeStorageWrite);
+	graph.AddPass("ReadA", nullptr).Read("Image", ResourceAccess::eComputeStorageRead).SetSideEffects();
+	graph.AddPass("ReadB", nullptr).Read("Image", ResourceAccess::eComputeStorageRead).Write("Output", ResourceAccess::eComputeStorageWrite);
+
+	graph.Compile();
+
+	EXPECT_EQ(graph.GetBarriers("ReadA").size(), 1);
+
+	for (const auto& barrier : graph.GetBarriers("ReadB"))
+	{
+		EXPECT_NE(barrier.image, FakeImage(1));
+	}
+}
+
+TEST(FrameGraphTest, SwapchainAcquireCopyPresent) {
+	FrameGraph graph;
+
+	FrameGraphImageDesc swapchain{};
+	swapchain.mImage = FakeImage(1);
+	swapchain.mInitialAccess = ResourceAccess::eAcquire;
+	swapchain.mFinalAccess = ResourceAccess::ePresent;
+	graph.ImportImage("Swapchain", swapchain);
+
+	graph.AddPass("Copy", nullptr).Write("Swapchain", ResourceAccess::eTransferWrite);
+
+	graph.Compile();
+
+	const auto& copyBarriers = graph.GetBarriers("Copy");
+	ASSERT_EQ(copyBarriers.size(), 1);
+	EXPECT_EQ(copyBarriers[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+	EXPECT_EQ(copyBarriers[0].newLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+	// Has to chain with the acquire semaphore wait
+	EXPECT_EQ(copyBarriers[0].srcStageMask, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR);
+
+	const auto& finalBarriers = graph.GetFinalBarriers();
+	ASSERT_EQ(finalBarriers.size(), 1);
+	EXPECT_EQ(finalBarriers[0].oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	EXPECT_EQ(finalBarriers[0].newLayout, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+	EXPECT_EQ(finalBarriers[0].srcAccessMask, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR);
+}
+
+TEST(FrameGraphTest, StateCarriesOverBetweenFrames) {
+	FrameGraph graph;
+
+	for (int frame = 0; frame < 2; ++frame)
+	{
+		graph.Reset();
+
+		FrameGraphImageDesc image{};
+		image.mImage = FakeImage(1);
+		image.mFinalAccess = ResourceAccess::eComputeStorageRead;
+		graph.ImportImage("Image", image);
+
+		graph.AddPass("Write", nullptr).Write("Image", ResourceAccess::eComputeStorageWrite);
+
+		graph.Compile();
+	}
+
+	// The write of the second frame waits for the read the first frame ended with
+	const auto& barriers = graph.GetBarriers("Write");
+	ASSERT_EQ(barriers.size(), 1);
+	EXPECT_EQ(barriers[0].srcStageMask, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR);
+	EXPECT_EQ(barriers[0].oldLayout, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+TEST(FrameGraphTest, AliasedImageWaitsForPreviousOwner) {
+	FrameGraph graph;
+
+	int memory = 0;
+
+	FrameGraphImageDesc shadow{};
+	shadow.mImage = FakeImage(1);
+	shadow.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	shadow.mMemory = &memory;
+	graph.ImportImage("Shadow", shadow);
+
+	FrameGraphImageDesc finalImage{};
+	finalImage.mImage = FakeImage(2);
+	finalImage.mMemory = &memory;
+	graph.ImportImage("Final", finalImage);
+
+	FrameGraphImageDesc swapchain{};
+	swapchain.mImage = FakeImage(3);
+	swapchain.mFinalAccess = ResourceAccess::ePresent;
+	graph.ImportImage("Swapchain", swapchain);
+
+	graph.AddPass("Depth", nullptr).Write("Shadow", ResourceAccess::eDepthAttachment);
+	graph.AddPass("Scene", nullptr).Read("Shadow", ResourceAccess::eFragmentShaderRead).SetSideEffects();
+	graph.AddPass("PostFx", nullptr).Write("Final", ResourceAccess::eComputeStorageWrite);
+	graph.AddPass("Copy", nullptr).Read("Final", ResourceAccess::eTransferRead).Write("Swapchain", ResourceAccess::eTransferWrite);
+
+	graph.Compile();
+
+	const auto& barriers = graph.GetBarriers("PostFx");
+	ASSERT_EQ(barriers.size(), 1);
+	EXPECT_EQ(barriers[0].image, FakeImage(2));
+	EXPECT_EQ(barriers[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+	EXPECT_EQ(barriers[0].srcStageMask & VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR);
+
+	// The next frame the shadow map takes the memory back from the final image
+	graph.Reset();
+	graph.ImportImage("Shadow", shadow);
+	graph.AddPass("Depth", nullptr).Write("Shadow", ResourceAccess::eDepthAttachment).SetSideEffects();
+	graph.Compile();
+
+	const auto& depthBarriers = graph.GetBarriers("Depth");
+	ASSERT_EQ(depthBarriers.size(), 1);
+	EXPECT_EQ(depthBarriers[0].oldLayout, VK_IMAGE_LAYOUT_UNDEFINED);
+	EXPECT_EQ(depthBarriers[0].srcStageMask & VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR);
+}
@@ -0,0 +1,30 @@
+#include "pch.h"
+
+#include "Renderer/PresentPolicy.h"
+
+using namespace Flux::Gfx;
+
+TEST(PresentPolicyTest, PicksRequestedModeWhenSupported) {
+	const std::vector<VkPresentModeKHR> tAvailable = { VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR };
+
+	EXPECT_EQ(ChoosePresentMode(tAvailable, PresentMode::eFifo), VK_PRESENT_MODE_FIFO_KHR);
+	EXPECT_EQ(ChoosePresentMode(tAvailable, PresentMode::eFifoRelaxed), VK_PRESENT_MODE_FIFO_RELAXED_KHR);
+	EXPECT_EQ(ChoosePresentMode(tAvailable, PresentMode::eMailbox), VK_PRESENT_MODE_MAILBOX_KHR);
+	EXPECT_EQ(ChoosePresentMode(tAvailable, PresentMode::eImmediate), VK_PRESENT_MODE_IMMEDIATE_KHR);
+}
+
+TEST(PresentPolicyTest, NonBlockingModesFallBackOnEachOther) {
+	EXPECT_EQ(ChoosePresentMode({ VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }, PresentMode::eMailbox), VK_PRESENT_MODE_IMMEDIATE_KHR);
+	EXPECT_EQ(ChoosePresentMode({ VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR }, PresentMode::eImmediate), VK_PRESENT_MODE_MAILBOX_KHR);
+}
+
+TEST(PresentPolicyTest, FallsBackToFifo) {
+	const std::vector<VkPresentModeKHR> tFifoOnly = { VK_PRESENT_MODE_FIFO_KHR };
+
+	EXPECT_EQ(ChoosePresentMode(tFifoOnly, PresentMode::eFifoRelaxed), VK_PRESENT_MODE_FIFO_KHR);
+	EXPECT_EQ(ChoosePresentMode(tFifoOnly, PresentMode::eMailbox), VK_PRESENT_MODE_FIFO_KHR);
+	EXPECT_EQ(ChoosePresentMode(tFifoOnly, PresentMode::eImmediate), VK_PRESENT_MODE_FIFO_KHR);
+
+	// Relaxed FIFO may tear, it is not picked for a strict FIFO request
+	EXPECT_EQ(ChoosePresentMode({ VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR }, PresentMode::eFifo), VK_PRESENT_MODE_FIFO_KHR);
+}
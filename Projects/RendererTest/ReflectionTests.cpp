@@ -56,4 +56,42 @@ TEST(ShaderReflectionTest, ValidationAndRetrieval) {
 		std::cout << shaderResource.mName << " Set " << shaderResource.mSetNumber << " Binding " << shaderResource.mBindingNumber << std::endl;
 	}
 
-}
\ No newline at end of file
+}
+
+TEST(ShaderReflectionTest, CacheRoundTrip) {
+	std::vector<char> code;
+	ASSERT_NO_THROW(code = Flux::Common::ReadFile<char>("Resources/Shaders/basicModel.frag.spv"));
+
+	const std::string cachePath = "ReflectionCacheRoundTrip.reflectioncache";
+	std::remove(cachePath.c_str());
+
+	ShaderReflectionData reflected{};
+	{
+		auto cache = LoadReflectionCache(cachePath);
+		ASSERT_EQ(cache->mEntries.size(), 0);
+
+		ASSERT_NO_THROW(reflected = ReflectCached(*cache, code));
+		EXPECT_EQ(cache->mMisses.load(), 1);
+		EXPECT_TRUE(SaveReflectionCache(*cache));
+	}
+
+	auto cache = LoadReflectionCache(cachePath);
+	ASSERT_EQ(cache->mEntries.size(), 1);
+
+	ShaderReflectionData cached = ReflectCached(*cache, code);
+	EXPECT_EQ(cache->mHits.load(), 1);
+	EXPECT_EQ(cache->mMisses.load(), 0);
+
+	EXPECT_EQ(cached.mEntryPoint, reflected.mEntryPoint);
+	ASSERT_EQ(cached.mResources.size(), reflected.mResources.size());
+	for (size_t i = 0; i < cached.mResources.size(); ++i)
+	{
+		EXPECT_EQ(cached.mResources[i].mName, reflected.mResources[i].mName);
+		EXPECT_EQ(cached.mResources[i].mSetNumber, reflected.mResources[i].mSetNumber);
+		EXPECT_EQ(cached.mResources[i].mBindingNumber, reflected.mResources[i].mBindingNumber);
+		EXPECT_EQ(cached.mResources[i].mType, reflected.mResources[i].mType);
+	}
+	ASSERT_EQ(cached.mPushConstants.size(), reflected.mPushConstants.size());
+
+	std::remove(cachePath.c_str());
+}
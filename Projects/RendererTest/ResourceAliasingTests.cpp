@@ -0,0 +1,63 @@
+#include "pch.h"
+
+#include "Renderer/ResourceAliasing.h"
+
+using namespace Flux::Gfx;
+
+TEST(ResourceAliasingTest, DisjointLifetimesShareBlock) {
+	// Shadow map, scene color, scene depth and final image of a frame
+	const std::vector<AliasingRequest> requests =
+	{
+		{ 256, 16, 0xF, 0, 1 },
+		{ 64, 16, 0xF, 1, 2 },
+		{ 32, 16, 0xF, 1, 1 },
+		{ 32, 64, 0x3, 2, 3 },
+	};
+
+	const AliasingPlan plan = PlanResourceAliasing(requests);
+
+	ASSERT_EQ(plan.mRequestBlocks.size(), requests.size());
+	ASSERT_EQ(plan.mBlocks.size(), 3);
+
+	// The final image only starts after the last read of the shadow map
+	EXPECT_EQ(plan.mRequestBlocks[3], plan.mRequestBlocks[0]);
+	EXPECT_NE(plan.mRequestBlocks[1], plan.mRequestBlocks[0]);
+	EXPECT_NE(plan.mRequestBlocks[2], plan.mRequestBlocks[0]);
+	EXPECT_NE(plan.mRequestBlocks[2], plan.mRequestBlocks[1]);
+
+	const AliasingBlock& shared = plan.mBlocks[plan.mRequestBlocks[0]];
+	EXPECT_EQ(shared.mSize, 256);
+	EXPECT_EQ(shared.mAlignment, 64);
+	EXPECT_EQ(shared.mMemoryTypeBits, 0x3);
+}
+
+TEST(ResourceAliasingTest, IncompatibleMemoryTypesNeverShare) {
+	const std::vector<AliasingRequest> requests =
+	{
+		{ 128, 1, 0x1, 0, 0 },
+		{ 64, 1, 0x2, 1, 1 },
+		{ 64, 1, 0x1, 2, 2 },
+	};
+
+	const AliasingPlan plan = PlanResourceAliasing(requests);
+
+	ASSERT_EQ(plan.mBlocks.size(), 2);
+	EXPECT_NE(plan.mRequestBlocks[1], plan.mRequestBlocks[0]);
+	EXPECT_EQ(plan.mRequestBlocks[2], plan.mRequestBlocks[0]);
+}
+
+TEST(ResourceAliasingTest, OverlappingLifetimesGetOwnBlocks) {
+	const std::vector<AliasingRequest> requests =
+	{
+		{ 64, 1, 0x1, 0, 2 },
+		{ 64, 1, 0x1, 2, 3 },
+		{ 64, 1, 0x1, 1, 1 },
+	};
+
+	const AliasingPlan plan = PlanResourceAliasing(requests);
+
+	EXPECT_EQ(plan.mBlocks.size(), 2);
+	EXPECT_NE(plan.mRequestBlocks[1], plan.mRequestBlocks[0]);
+	EXPECT_NE(plan.mRequestBlocks[2], plan.mRequestBlocks[0]);
+	EXPECT_EQ(plan.mRequestBlocks[2], plan.mRequestBlocks[1]);
+}
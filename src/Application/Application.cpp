@@ -8,8 +8,12 @@
 #include "Application/Scene/FirstScene.h"
 
 #include "Common/Time/Timer.h"
+#include "Common/Profiling/CpuProfiler.h"
+#include "Common/Benchmark/CameraPath.h"
 #include "Application/Rendering/ImguiRenderingHelper.h"
 
+#include <iostream>
+
 const uint32_t WIDTH = 1920;
 const uint32_t HEIGHT = 1080;
 
@@ -20,6 +24,10 @@ std::shared_ptr<Input> mInput;
 static bool pauseInput = false;
 static int32_t pauseKey = GLFW_KEY_TAB;
 
+// Appends the camera pose to the recorded path, the Benchmark project plays such paths back
+static int32_t recordPathKey = GLFW_KEY_K;
+const std::string cRecordedPathFile = "Resources/Benchmarks/recorded.path";
+
 void cursorpos_callback(GLFWwindow* window, double xpos, double ypos)
 {
 	static bool firstFrame = true;
@@ -80,6 +88,8 @@ void character_callback(GLFWwindow* window, unsigned int codepoint)
 
 void Flux::Application::Run()
 {
+	FLUX_PROFILE_THREAD("Main thread");
+
 	glfwInit();
 
 	glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -104,11 +114,21 @@ void Flux::Application::Run()
 
 
 	mScene->Init();
+	mRenderer->PrewarmPipelines(mScene, true);
+
+	CameraPath tRecordedPath;
+
 	while (!glfwWindowShouldClose(mWindow)) {
 
+		// Frame limiter and low latency wait, input is sampled right after
+		mRenderer->BeginFrame();
+
 		tDeltaTime = static_cast<float>(tTimer->GetDelta() * 0.001);
 
-		glfwPollEvents();
+		{
+			FLUX_PROFILE_ZONE("Poll events");
+			glfwPollEvents();
+		}
 
 		if (mInput->GetKeyHeld(GLFW_KEY_ESCAPE))
 		{
@@ -120,11 +140,26 @@ void Flux::Application::Run()
 			pauseInput = !pauseInput;
 		}
 
-		mScene->Update(tDeltaTime);
+		if (mInput->GetKeyUp(recordPathKey))
+		{
+			const std::shared_ptr<Camera> tCamera = mScene->GetCamera();
+			tRecordedPath.AddKey(CameraPathKey{ tCamera->Position, tCamera->Yaw, tCamera->Pitch });
+			if (!tRecordedPath.Save(cRecordedPathFile))
+			{
+				std::cerr << "failed to save " << cRecordedPathFile << std::endl;
+			}
+		}
+
+		{
+			FLUX_PROFILE_ZONE("Scene update");
+			mScene->Update(tDeltaTime);
+		}
 		mRenderer->Draw(mScene);
 
 
 		mInput->Update(pauseInput);
+
+		FLUX_PROFILE_FRAME();
 	}
 	mScene->Cleanup();
 
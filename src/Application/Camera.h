@@ -9,6 +9,8 @@
 
 #include <vector>
 
+#include "Common/Culling/FrustumCulling.h"
+
 namespace Flux
 {
 	// Defines several possible options for camera movement. Used as abstraction to stay away from window-system specific input methods
@@ -92,6 +94,12 @@ namespace Flux
 
 			return projection;
 		}
+
+		// World space planes of the view volume, normals point inwards
+		Frustum GetFrustum()
+		{
+			return Frustum::FromMatrix(GetProjectionMatrix() * GetViewMatrix());
+		}
 		// processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
 		void ProcessKeyboard(Camera_Movement direction, float deltaTime)
 		{
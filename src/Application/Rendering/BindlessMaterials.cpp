@@ -0,0 +1,121 @@
+#include "BindlessMaterials.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "Renderer/Renderer.h"
+
+using namespace Flux::Gfx;
+
+Flux::BindlessMaterials::BindlessMaterials(std::shared_ptr<Gfx::RenderContext> aContext, std::shared_ptr<Gfx::RootSignature> aRootSignature, uint32_t aSetIndex, VkSampler aSampler, VkSampler aShadowSampler) :
+	mContext(aContext), mDescriptorSet(VK_NULL_HANDLE), mTextureCount(0), mMaterialCount(0)
+{
+	assert(aRootSignature);
+	assert(aSetIndex < aRootSignature->mDescriptorSetLayouts.size());
+
+	// The set layout is update after bind, so it has to come from a pool created with that flag
+	DescriptorPoolCreateDesc tPoolDesc{};
+	tPoolDesc.maxDescriptorSets = 1;
+	tPoolDesc.mUpdateAfterBind = true;
+	mPool = Renderer::CreateDescriptorPool(mContext, &tPoolDesc);
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = mPool->mPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &aRootSignature->mDescriptorSetLayouts[aSetIndex];
+
+	if (vkAllocateDescriptorSets(mContext->mDevice->mDevice, &allocInfo, &mDescriptorSet) != VK_SUCCESS)
+	{
+		throw std::runtime_error("Failed to allocate bindless descriptor set!");
+	}
+
+	mMaterialBuffer = std::make_shared<BufferGPU>();
+	Renderer::CreateBuffer(mContext->mDevice->mDevice, mContext->memoryAllocator, sizeof(BindlessMaterialData) * MAX_BINDLESS_MATERIALS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, mMaterialBuffer->mBuffer, mMaterialBuffer->mAllocation);
+
+	// The texture array is written per texture as they are registered, the template covers the other bindings
+	const std::array<DescriptorInfo, 3> tDescriptors =
+	{
+		DescriptorInfo(aSampler),
+		DescriptorInfo(aShadowSampler),
+		DescriptorInfo(mMaterialBuffer->mBuffer),
+	};
+
+	Renderer::UpdateDescriptorSet(mContext, aRootSignature, aSetIndex, mDescriptorSet, tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+}
+
+Flux::BindlessMaterials::~BindlessMaterials()
+{
+	vkDestroyBuffer(mContext->mDevice->mDevice, mMaterialBuffer->mBuffer, nullptr);
+	vmaFreeMemory(mContext->memoryAllocator, mMaterialBuffer->mAllocation);
+
+	// Frees the set as well
+	Renderer::DestroyDescriptorPool(mContext, mPool);
+}
+
+uint32_t Flux::BindlessMaterials::RegisterTexture(const std::shared_ptr<Gfx::Texture>& aTexture)
+{
+	assert(aTexture);
+
+	auto tExisting = mTextureIndices.find(aTexture->mView);
+	if (tExisting != mTextureIndices.end())
+	{
+		return tExisting->second;
+	}
+
+	if (mTextureCount >= MAX_BINDLESS_RESOURCES)
+	{
+		throw std::runtime_error("Ran out of bindless texture slots!");
+	}
+
+	const uint32_t tIndex = mTextureCount++;
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = aTexture->mView;
+	imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet = mDescriptorSet;
+	descriptorWrite.dstBinding = 0;
+	descriptorWrite.dstArrayElement = tIndex;
+	descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+	descriptorWrite.descriptorCount = 1;
+	descriptorWrite.pImageInfo = &imageInfo;
+
+	// Update after bind, the set may already be bound in a recorded command buffer
+	vkUpdateDescriptorSets(mContext->mDevice->mDevice, 1, &descriptorWrite, 0, nullptr);
+
+	mTextureIndices[aTexture->mView] = tIndex;
+	return tIndex;
+}
+
+uint32_t Flux::BindlessMaterials::RegisterMaterial(Material& aMaterial)
+{
+	if (aMaterial.mBindlessIndex.has_value())
+	{
+		return aMaterial.mBindlessIndex.value();
+	}
+
+	if (mMaterialCount >= MAX_BINDLESS_MATERIALS)
+	{
+		throw std::runtime_error("Ran out of bindless material slots!");
+	}
+
+	BindlessMaterialData tData{};
+	tData.mAlbedoIndex = RegisterTexture(aMaterial.mTextureAlbedo);
+	tData.mSpecularIndex = RegisterTexture(aMaterial.mTextureSpecular);
+	tData.mNormalIndex = RegisterTexture(aMaterial.mTextureNormal);
+
+	const uint32_t tIndex = mMaterialCount++;
+
+	void* data;
+	vmaMapMemory(mContext->memoryAllocator, mMaterialBuffer->mAllocation, &data);
+	memcpy(static_cast<char*>(data) + sizeof(BindlessMaterialData) * tIndex, &tData, sizeof(BindlessMaterialData));
+	vmaUnmapMemory(mContext->memoryAllocator, mMaterialBuffer->mAllocation);
+
+	aMaterial.mBindlessIndex = tIndex;
+	return tIndex;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Renderer/RenderContext.h"
+#include "Renderer/RootSignature.h"
+#include "Renderer/DescriptorPool.h"
+#include "Renderer/BufferGPU.h"
+#include "Renderer/TextureVK.h"
+
+#include "Application/Rendering/Material.h"
+
+namespace Flux
+{
+
+constexpr uint32_t MAX_BINDLESS_MATERIALS = 4096;
+constexpr uint32_t INVALID_GPU_SCENE_MESH = 0xFFFFFFFF;
+
+// Matches MaterialData in common.glsl
+struct BindlessMaterialData
+{
+	uint32_t mAlbedoIndex;
+	uint32_t mSpecularIndex;
+	uint32_t mNormalIndex;
+	uint32_t mPadding;
+};
+
+// Matches ObjectData in common.glsl, one per scene object, the object index is passed as the first instance
+struct BindlessObjectData
+{
+	glm::mat4 mModel;
+	uint32_t mMeshIndex; // INVALID_GPU_SCENE_MESH unless the object is drawn by the GPU-driven path
+	uint32_t mMaterialIndex;
+	uint32_t mPadding[2];
+};
+
+// Owns the bindless material set (set 1 of basicModelBindless): one runtime sized texture array, the samplers and a storage buffer with per material texture indices
+// Materials are registered once and then only referenced by index, so drawing any material needs no descriptor set changes
+// Textures and materials are only ever appended, slots in use by frames in flight are never rewritten
+class BindlessMaterials
+{
+public:
+	BindlessMaterials(std::shared_ptr<Gfx::RenderContext> aContext, std::shared_ptr<Gfx::RootSignature> aRootSignature, uint32_t aSetIndex, VkSampler aSampler, VkSampler aShadowSampler);
+	~BindlessMaterials();
+
+	// Returns the index of the material in the material buffer, registers its textures when needed
+	uint32_t RegisterMaterial(Material& aMaterial);
+
+	VkDescriptorSet GetDescriptorSet() const { return mDescriptorSet; }
+	uint32_t GetTextureCount() const { return mTextureCount; }
+	uint32_t GetMaterialCount() const { return mMaterialCount; }
+
+private:
+	BindlessMaterials(const BindlessMaterials&) = delete;
+	BindlessMaterials& operator= (const BindlessMaterials&) = delete;
+
+	uint32_t RegisterTexture(const std::shared_ptr<Gfx::Texture>& aTexture);
+
+	std::shared_ptr<Gfx::RenderContext> mContext;
+	std::shared_ptr<Gfx::DescriptorPool> mPool;
+	VkDescriptorSet mDescriptorSet;
+
+	std::shared_ptr<Gfx::BufferGPU> mMaterialBuffer;
+
+	std::unordered_map<VkImageView, uint32_t> mTextureIndices;
+	uint32_t mTextureCount;
+	uint32_t mMaterialCount;
+};
+
+}
@@ -13,6 +13,9 @@
 
 #include "ImguiRenderingHelper.h"
 
+#include <thread>
+#include <limits>
+
 using namespace Flux;
 using namespace Flux::Gfx;
 
@@ -63,11 +66,91 @@ static std::vector<VkVertexInputAttributeDescription> CreateSceneVertexAttribute
     return vertexAttrDescriptions;
 }
 
-Flux::CustomRenderer::CustomRenderer(GLFWwindow* aWindow) : mVsync(false), mWindow(aWindow)
+// Collected per frame-graph pass, with one query per measured pass for every frame in flight
+static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+// Pipeline statistics query of every measured pass within the queries of a frame in flight, same order as passNames
+static constexpr uint32_t STATISTICS_PASS_SHADOW = 0;
+static constexpr uint32_t STATISTICS_PASS_SCENE = 1;
+static constexpr uint32_t STATISTICS_PASS_SCENE_LATE = 2;
+static constexpr uint32_t STATISTICS_PASS_POSTFX = 3;
+static constexpr uint32_t STATISTICS_PASS_COUNT = 4;
+
+// Pass field of the render queue sort key, the depth pass is recorded first
+static constexpr uint32_t RENDER_QUEUE_PASS_DEPTH = 0;
+static constexpr uint32_t RENDER_QUEUE_PASS_SCENE = 1;
+static constexpr uint32_t RENDER_QUEUE_PASS_SCENE_LATE = 2;
+
+// Order of the frame graph passes, the transient render targets only have to exist between the passes that use them
+static constexpr uint32_t FRAME_PASS_DEPTH = 0;
+static constexpr uint32_t FRAME_PASS_SCENE = 1;
+static constexpr uint32_t FRAME_PASS_HIZ = 2;
+static constexpr uint32_t FRAME_PASS_SCENE_LATE = 3;
+static constexpr uint32_t FRAME_PASS_POSTFX = 4;
+static constexpr uint32_t FRAME_PASS_COPY = 5;
+
+// Late candidates of the objects recorded on the CPU, the rest go to the scene pass
+static constexpr uint32_t MAX_OCCLUSION_CANDIDATES = 4096;
+static constexpr uint32_t INVALID_CANDIDATE_SLOT = ~0u;
+
+// Transforms per instance buffer before the first frame grows it
+static constexpr size_t INITIAL_INSTANCE_CAPACITY = 4096;
+
+static constexpr uint32_t SHADOW_MAP_SIZE = 8096;
+
+// A trace capture records this many frames, written next to the executable
+static constexpr uint32_t TRACE_CAPTURE_FRAMES = 120;
+static constexpr const char* TRACE_FILE_NAME = "flux_trace.json";
+static constexpr uint32_t TRACE_TRACK_GPU = 1;
+static constexpr uint32_t TRACE_TRACK_CPU_FIRST = 2; // Every profiled thread gets the next one
+
+static void SetViewportAndScissor(VkCommandBuffer aCommandBuffer, uint32_t aWidth, uint32_t aHeight)
+{
+    VkViewport viewport{};
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = static_cast<float>(aWidth);
+    viewport.height = static_cast<float>(aHeight);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor{};
+    scissor.offset = { 0, 0 };
+    scissor.extent = { aWidth, aHeight };
+
+    vkCmdSetViewport(aCommandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(aCommandBuffer, 0, 1, &scissor);
+}
+
+Flux::CustomRenderer::CustomRenderer(GLFWwindow* aWindow) : mWindow(aWindow)
 {
     mRenderContext = Renderer::CreateRenderContext("Flux", true, mWindow);
     mSwapchain = Renderer::CreateSwapChain(mRenderContext, mWindow );
 
+    InitDevice();
+}
+
+Flux::CustomRenderer::CustomRenderer(const HeadlessRendererDesc& aDesc) : mWindow(nullptr)
+{
+    mRenderContext = Renderer::CreateRenderContext("Flux", aDesc.mEnableValidation, nullptr);
+
+    // One image per frame in flight, the fence of a frame guards its image so no acquire is needed
+    mSwapchain = Renderer::CreateOffscreenSwapChain(mRenderContext, aDesc.mWidth, aDesc.mHeight, MAX_FRAMES_IN_FLIGHT);
+
+    InitDevice();
+}
+
+void Flux::CustomRenderer::InitDevice()
+{
     Flux::Gfx::QueueCreateDesc QueueDesc{};
 
     QueueDesc.mType = Flux::Gfx::eQueueType::QUEUE_TYPE_GRAPHICS;
@@ -78,14 +161,27 @@ Flux::CustomRenderer::CustomRenderer(GLFWwindow* aWindow) : mVsync(false), mWind
 
     mResourceManager = std::unique_ptr<RenderingResourceManager>(new RenderingResourceManager());
 
+    // Only used by ImGui, which frees its own sets
     Flux::Gfx::DescriptorPoolCreateDesc DescriptorPoolCDesc{};
-    DescriptorPoolCDesc.maxDescriptorSets = 1024;
+    DescriptorPoolCDesc.maxDescriptorSets = 64;
 
     mDescriptorPool = Renderer::CreateDescriptorPool(mRenderContext, &DescriptorPoolCDesc);
 
-    mRenderDataPipeline.pipelineStats.resize(mRenderDataPipeline.pipelineStatNames.size());
+    Flux::Gfx::DescriptorAllocatorCreateDesc DescriptorAllocatorCDesc{};
+    DescriptorAllocatorCDesc.mSetsPerPool = 256;
+    DescriptorAllocatorCDesc.mFrameCount = MAX_FRAMES_IN_FLIGHT;
+
+    mDescriptorAllocator = Renderer::CreateDescriptorAllocator(mRenderContext, &DescriptorAllocatorCDesc);
+
+    mRenderDataPipeline.pipelineStats.assign(STATISTICS_PASS_COUNT, std::vector<uint64_t>(mRenderDataPipeline.pipelineStatNames.size(), 0));
 
     SetupQueryPool();
+
+    // Every pass of the frame graph is a GPU zone within the zone of the frame
+    mProfiling.mGpu = std::make_unique<GpuProfiler>(mRenderContext, mQueueGraphics->mQueueIndex, MAX_FRAMES_IN_FLIGHT);
+    mFrameGraph.SetPassCallbacks(
+        [this](VkCommandBuffer aCommandBuffer, const std::string& aPass) { mProfiling.mGpu->BeginZone(aCommandBuffer, aPass); },
+        [this](VkCommandBuffer aCommandBuffer, const std::string&) { mProfiling.mGpu->EndZone(aCommandBuffer); });
 }
 
 void Flux::CustomRenderer::Init()
@@ -112,7 +208,15 @@ void Flux::CustomRenderer::Init()
 
         ImGui::StyleColorsDark();
 
-        ImGui_ImplGlfw_InitForVulkan(mWindow, true);
+        // Headless frames have no input and no overlay, the UI is still built so Draw works the same
+        if (IsHeadless())
+        {
+            io.DisplaySize = ImVec2(static_cast<float>(mSwapchain->mExtent.width), static_cast<float>(mSwapchain->mExtent.height));
+        }
+        else
+        {
+            ImGui_ImplGlfw_InitForVulkan(mWindow, true);
+        }
         ImGui_ImplVulkan_Init(&imguiInitInfo, mSwapchain->mRenderPass);
 
         // Upload fonts texture
@@ -140,7 +244,7 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
         auto codeFrag = Flux::Common::ReadFile<char>(filepath);
 
         ShaderCreateDesc fragShaderCD{};
-        fragShaderCD.mCode = codeFrag;
+        fragShaderCD.mCode = std::move(codeFrag);
         fragShaderCD.mFilePath = filepath;
         fragShaderCD.mType = ShaderTypes::eFragment;
         tFragShader = Renderer::CreateShader(mRenderContext, &fragShaderCD);
@@ -153,7 +257,7 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
         auto codeVert = Flux::Common::ReadFile<char>(filepath);
 
         ShaderCreateDesc vertShaderCD{};
-        vertShaderCD.mCode = codeVert;
+        vertShaderCD.mCode = std::move(codeVert);
         vertShaderCD.mFilePath = filepath;
         vertShaderCD.mType = ShaderTypes::eVertex;
         tVertShader = Renderer::CreateShader(mRenderContext, &vertShaderCD);
@@ -164,16 +268,10 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
     sceneRootSigDesc.mShaders = { tFragShader, tVertShader };
     mRootSignatureScene = Renderer::CreateRootSignature(mRenderContext, &sceneRootSigDesc);
 
-    mRootSignaturesAll.push_back(mRootSignatureScene);
+    AddRootSignature(mRootSignatureScene);
 
-    {
-        Flux::Gfx::RenderTargetCreateDesc RTCreateDescScene{};
-        RTCreateDescScene.mWidth = mSwapchain->mExtent.width;
-        RTCreateDescScene.mHeight = mSwapchain->mExtent.height;
-        RTCreateDescScene.mTargets = { {VK_FORMAT_R16G16B16A16_UNORM} };
-        RTCreateDescScene.mDepthTarget = { VK_FORMAT_D32_SFLOAT };
-        mRenderTargetScene = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDescScene);
-    }
+    mTransientPool = Renderer::CreateTransientResourcePool(mRenderContext);
+    AcquireRenderTargets();
 
     uint32_t emptyData[1];
     emptyData[0] = 0xFF000000;
@@ -184,22 +282,10 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
         reinterpret_cast<unsigned char*>(emptyData), VK_FORMAT_R8G8B8A8_UNORM);
 
 
-    // Ofscreen renderpass
-	{
-		Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
-		RTCreateDesc.mWidth = mSwapchain->mExtent.width;
-		RTCreateDesc.mHeight = mSwapchain->mExtent.height;
-		RTCreateDesc.mTargets = { {VK_FORMAT_R8G8B8A8_UNORM} };
-		RTCreateDesc.mDepthTarget = { VK_FORMAT_D32_SFLOAT };
-		mRenderTargetFinal = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
-	}
-
-
-
     auto codeCompute = Flux::Common::ReadFile<char>("Resources/Shaders/postfx.comp.spv");
 
     ShaderCreateDesc compShaderCD{};
-    compShaderCD.mCode = codeCompute;
+    compShaderCD.mCode = std::move(codeCompute);
     compShaderCD.mFilePath = "Resources/Shaders/postfx.comp.spv";
     compShaderCD.mType = ShaderTypes::eCompute;
     mComputeShader = Renderer::CreateShader(mRenderContext, &compShaderCD);
@@ -212,44 +298,9 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
     mRootSignatureCompute = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
 
     {
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mDescriptorPool->mPool;
-        allocInfo.descriptorSetCount = 1u;
-        allocInfo.pSetLayouts = mRootSignatureCompute->mDescriptorSetLayouts.data();
-
-        if (vkAllocateDescriptorSets(mRenderContext->mDevice->mDevice, &allocInfo, &mComputeDataPostfx.descriptorset) != VK_SUCCESS)
-        {
-            throw std::runtime_error("Failed to allocate descriptor sets!");
-        }
-
-        VkDescriptorImageInfo imageInfoComputeRead{};
-        imageInfoComputeRead.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL;
-        imageInfoComputeRead.imageView = mRenderTargetScene->mColorImages[0]->mView;
-
-        VkDescriptorImageInfo imageInfoComputeWrite{};
-        imageInfoComputeWrite.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_GENERAL;
-        imageInfoComputeWrite.imageView = mRenderTargetFinal->mColorImages[0]->mView;
+        mComputeDataPostfx.descriptorset = Renderer::AllocateDescriptorSet(mRenderContext, mDescriptorAllocator, mRootSignatureCompute->mDescriptorSetLayouts[0]);
 
-        std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = mComputeDataPostfx.descriptorset;
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pImageInfo = &imageInfoComputeRead;
-
-        descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[1].dstSet = mComputeDataPostfx.descriptorset;
-        descriptorWrites[1].dstBinding = 1;
-        descriptorWrites[1].dstArrayElement = 0;
-        descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-        descriptorWrites[1].descriptorCount = 1;
-        descriptorWrites[1].pImageInfo = &imageInfoComputeWrite;
-
-        vkUpdateDescriptorSets(mRenderContext->mDevice->mDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+        UpdatePostfxDescriptorSet();
 
         ComputePipelineCreatedesc computePipelineCreateDesc{};
         computePipelineCreateDesc.mRootSig = mRootSignatureCompute;
@@ -263,7 +314,7 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
         auto codeDepth = Flux::Common::ReadFile<char>("Resources/Shaders/simpleDepth.vert.spv");
 
         Gfx::ShaderCreateDesc depthShaderCreateDesc{};
-        depthShaderCreateDesc.mCode = codeDepth;
+        depthShaderCreateDesc.mCode = std::move(codeDepth);
         depthShaderCreateDesc.mFilePath = "Resources/Shaders/simpleDepth.vert.spv";
         depthShaderCreateDesc.mType = ShaderTypes::eVertex;
 
@@ -276,13 +327,6 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
 
         mDepthOnlypass.mRootSignatureDepthOnly = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
 
-        // Render target
-        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
-        RTCreateDesc.mWidth = 8096;
-        RTCreateDesc.mHeight = 8096;
-        RTCreateDesc.mDepthTarget = { VK_FORMAT_D32_SFLOAT };
-        mDepthOnlypass.mRenderTargetDepth = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
-
         // Pipeline
         std::vector vertexAttributes = CreateSceneVertexAttributes();
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -302,7 +346,7 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
         Gfx::GraphicsPipelineCreateDesc pipeCreateDesc{};
         pipeCreateDesc.mRootSig = mDepthOnlypass.mRootSignatureDepthOnly;
         pipeCreateDesc.mRt = mDepthOnlypass.mRenderTargetDepth;
-        pipeCreateDesc.mPushConstantSize = sizeof(glm::mat4);
+        pipeCreateDesc.mPushConstantSize = 0;
         pipeCreateDesc.vertexAttrDescriptions = vertexAttributes;
         pipeCreateDesc.bindingDescription = bindingDescription;
 
@@ -312,8 +356,24 @@ void CustomRenderer::CustomRenderer::InitVulkan() {
     }
 
     CreateDescriptorSets();
-    CreateCommandBuffers();
-    CreateSyncObjects();
+    CreateInstanceBuffers();
+    CreateFrameContexts();
+    CreateCommandRecorder();
+
+    {
+        const uint32_t tThreadCount = std::max(1u, std::thread::hardware_concurrency() / 2);
+        mPipelineCompiler = std::make_unique<PipelineCompiler>([this](const RenderState& aState) { return CreateGraphicsPipelineForState(aState); }, tThreadCount);
+
+        // Compiled up front so objects have something to draw with while their own pipeline compiles
+        RenderState tFallbackState;
+        tFallbackState.AddShader(ShaderTypes::eVertex, "Resources/Shaders/basicModel.vert.spv");
+        tFallbackState.AddShader(ShaderTypes::eFragment, "Resources/Shaders/basicModel.frag.spv");
+        mFallbackPipelineIndex = CreatePipeline(tFallbackState);
+    }
+
+    CreateBindlessResources();
+    CreateOcclusionCullingResources();
+    UpdateOcclusionCullingTargets();
 }
 
 void Flux::CustomRenderer::SetupQueryPool()
@@ -321,47 +381,258 @@ void Flux::CustomRenderer::SetupQueryPool()
     VkQueryPoolCreateInfo queryPoolInfo = {};
     queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
     queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
-    queryPoolInfo.queryCount = 1;
-    queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_CONTROL_SHADER_PATCHES_BIT |
-        VK_QUERY_PIPELINE_STATISTIC_TESSELLATION_EVALUATION_SHADER_INVOCATIONS_BIT;
+    queryPoolInfo.queryCount = STATISTICS_PASS_COUNT * MAX_FRAMES_IN_FLIGHT;
+    queryPoolInfo.pipelineStatistics = PIPELINE_STATISTICS;
 
     vkCreateQueryPool(mRenderContext->mDevice->mDevice, &queryPoolInfo, NULL, &mQueryPool);
 }
 
+void Flux::CustomRenderer::ReadQueryResults(uint32_t aFrameIndex)
+{
+    if (!mRenderDataPipeline.mSubmitted[aFrameIndex])
+    {
+        return;
+    }
+
+    // Every query is followed by its availability, a pass the frame graph culled never began its query
+    const size_t tStatCount = mRenderDataPipeline.pipelineStatNames.size();
+    const size_t tStride = tStatCount + 1;
+    std::vector<uint64_t> tResults(tStride * STATISTICS_PASS_COUNT, 0);
+
+    // The frame has finished, so this only returns VK_NOT_READY for the unused queries
+    const VkResult tResult = vkGetQueryPoolResults(
+        mRenderContext->mDevice->mDevice,
+        mQueryPool,
+        aFrameIndex * STATISTICS_PASS_COUNT,
+        STATISTICS_PASS_COUNT,
+        sizeof(uint64_t) * tResults.size(),
+        tResults.data(),
+        sizeof(uint64_t) * tStride,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    if (tResult != VK_SUCCESS && tResult != VK_NOT_READY)
+    {
+        throw std::runtime_error("failed to read pipeline statistics!");
+    }
+
+    for (uint32_t pass = 0; pass < STATISTICS_PASS_COUNT; pass++)
+    {
+        const uint64_t* tQuery = &tResults[pass * tStride];
+        const bool tAvailable = tQuery[tStatCount] != 0;
+
+        for (size_t i = 0; i < tStatCount; i++)
+        {
+            mRenderDataPipeline.pipelineStats[pass][i] = tAvailable ? tQuery[i] : 0;
+        }
+    }
+}
+
+void Flux::CustomRenderer::SetReadbackEnabled(bool aEnabled)
+{
+    assert(IsHeadless() || !aEnabled);
+    mHeadless.mReadbackEnabled = aEnabled;
+}
+
+void Flux::CustomRenderer::FlushReadback()
+{
+    WaitForFramesInFlight();
+
+    // Oldest submission first, so the last frame read is the last one submitted
+    for (uint32_t i = 0; i < mFramesInFlight; i++)
+    {
+        ReadFrameBack((mFrameIndex + i) % mFramesInFlight);
+    }
+}
+
+void Flux::CustomRenderer::ReadFrameBack(uint32_t aFrameIndex)
+{
+    if (!mHeadless.mReadbackPending[aFrameIndex])
+    {
+        return;
+    }
+
+    mHeadless.mReadbackPending[aFrameIndex] = false;
+
+    const std::shared_ptr<Gfx::BufferGPU>& tBuffer = mHeadless.mReadbackBuffers[aFrameIndex];
+    mHeadless.mLastFrameWidth = mSwapchain->mExtent.width;
+    mHeadless.mLastFrameHeight = mSwapchain->mExtent.height;
+    mHeadless.mLastFrame.resize(static_cast<size_t>(mHeadless.mLastFrameWidth) * mHeadless.mLastFrameHeight * 4);
+
+    void* data;
+    vmaInvalidateAllocation(mRenderContext->memoryAllocator, tBuffer->mAllocation, 0, VK_WHOLE_SIZE);
+    vmaMapMemory(mRenderContext->memoryAllocator, tBuffer->mAllocation, &data);
+    memcpy(mHeadless.mLastFrame.data(), data, mHeadless.mLastFrame.size());
+    vmaUnmapMemory(mRenderContext->memoryAllocator, tBuffer->mAllocation);
+}
+
+void Flux::CustomRenderer::DestroyReadbackBuffers()
+{
+    for (auto& buffer : mHeadless.mReadbackBuffers)
+    {
+        if (buffer != nullptr)
+        {
+            vkDestroyBuffer(mRenderContext->mDevice->mDevice, buffer->mBuffer, nullptr);
+            vmaFreeMemory(mRenderContext->memoryAllocator, buffer->mAllocation);
+            buffer = nullptr;
+        }
+    }
+
+    mHeadless.mReadbackPending = {};
+}
+
 void CustomRenderer::CustomRenderer::MainLoop() {
     vkDeviceWaitIdle(mRenderContext->mDevice->mDevice);
 }
 
 void CustomRenderer::CustomRenderer::CleanupSwapChain() {
-    for (auto& e : mPipelines)
+    Renderer::DestroySwapchain(mRenderContext, mSwapchain);
+
+    DestroyRenderTargets();
+}
+
+bool CustomRenderer::AcquireRenderTargets()
+{
+    const uint32_t tWidth = mSwapchain->mExtent.width;
+    const uint32_t tHeight = mSwapchain->mExtent.height;
+    const VkFormat tDepthFormat = Renderer::FindDepthFormat(mRenderContext);
+
+    // The post fx pass reads and writes the color targets as storage images, the final image is copied to the swapchain
+    const VkImageUsageFlags tColorUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    const VkImageUsageFlags tDepthUsage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    Renderer::BeginTransientResourceFrame(mTransientPool);
+    mTransientTargets.mShadowDepth = Renderer::RequestTransientImage(mTransientPool, { SHADOW_MAP_SIZE, SHADOW_MAP_SIZE, tDepthFormat, tDepthUsage, VK_IMAGE_ASPECT_DEPTH_BIT }, FRAME_PASS_DEPTH, FRAME_PASS_SCENE_LATE);
+    mTransientTargets.mSceneColor = Renderer::RequestTransientImage(mTransientPool, { tWidth, tHeight, VK_FORMAT_R16G16B16A16_UNORM, tColorUsage, VK_IMAGE_ASPECT_COLOR_BIT }, FRAME_PASS_SCENE, FRAME_PASS_POSTFX);
+    mTransientTargets.mSceneDepth = Renderer::RequestTransientImage(mTransientPool, { tWidth, tHeight, tDepthFormat, tDepthUsage, VK_IMAGE_ASPECT_DEPTH_BIT }, FRAME_PASS_SCENE, FRAME_PASS_SCENE_LATE);
+    mTransientTargets.mFinal = Renderer::RequestTransientImage(mTransientPool, { tWidth, tHeight, VK_FORMAT_R8G8B8A8_UNORM, tColorUsage, VK_IMAGE_ASPECT_COLOR_BIT }, FRAME_PASS_POSTFX, FRAME_PASS_COPY);
+
+    if (!Renderer::TransientImagesChanged(mTransientPool))
     {
-        Renderer::DestroyGraphicsPipeline(mRenderContext, e.second);
+        return false;
     }
 
-    mPipelines.clear();
+    // Frames in flight may still use the previous images and pipelines being compiled reference the scene render pass
+    if (mRenderTargetScene != nullptr)
+    {
+        WaitForFramesInFlight();
+        mPipelineCompiler->WaitIdle();
+        DestroyRenderTargets();
+    }
 
-    Renderer::DestroySwapchain(mRenderContext, mSwapchain);
+    Renderer::AllocateTransientImages(mRenderContext, mTransientPool);
+
+    {
+        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
+        RTCreateDesc.mWidth = SHADOW_MAP_SIZE;
+        RTCreateDesc.mHeight = SHADOW_MAP_SIZE;
+        RTCreateDesc.mExternalDepthImage = Renderer::GetTransientImage(mTransientPool, mTransientTargets.mShadowDepth);
+        mDepthOnlypass.mRenderTargetDepth = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
+    }
+
+    {
+        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
+        RTCreateDesc.mWidth = tWidth;
+        RTCreateDesc.mHeight = tHeight;
+        RTCreateDesc.mExternalColorImages = { Renderer::GetTransientImage(mTransientPool, mTransientTargets.mSceneColor) };
+        RTCreateDesc.mExternalDepthImage = Renderer::GetTransientImage(mTransientPool, mTransientTargets.mSceneDepth);
+        mRenderTargetScene = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
+
+        RTCreateDesc.mLoadContents = true;
+        mRenderTargetSceneLate = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
+    }
+
+    // Offscreen target the post fx pass writes into, the pass is a dispatch so it has no depth
+    {
+        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
+        RTCreateDesc.mWidth = tWidth;
+        RTCreateDesc.mHeight = tHeight;
+        RTCreateDesc.mExternalColorImages = { Renderer::GetTransientImage(mTransientPool, mTransientTargets.mFinal) };
+        mRenderTargetFinal = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
+    }
+
+    // The images are new, their contents are undefined
+    mFrameGraph.ResetImageStates();
 
-    vkFreeDescriptorSets(mRenderContext->mDevice->mDevice, mDescriptorPool->mPool, descriptorSetsSceneObjects.size(), descriptorSetsSceneObjects.data());
+    return true;
+}
+
+void CustomRenderer::DestroyRenderTargets()
+{
+    // The images stay with the transient pool
+    Renderer::DestroyRenderTarget(mRenderContext, mDepthOnlypass.mRenderTargetDepth);
     Renderer::DestroyRenderTarget(mRenderContext, mRenderTargetScene);
+    Renderer::DestroyRenderTarget(mRenderContext, mRenderTargetSceneLate);
     Renderer::DestroyRenderTarget(mRenderContext, mRenderTargetFinal);
 }
 
+void CustomRenderer::UpdatePostfxDescriptorSet()
+{
+    // Reads the scene color and writes the final image
+    const std::array<DescriptorInfo, 2> tDescriptors =
+    {
+        DescriptorInfo(mRenderTargetScene->mColorImages[0]->mView, VK_IMAGE_LAYOUT_GENERAL),
+        DescriptorInfo(mRenderTargetFinal->mColorImages[0]->mView, VK_IMAGE_LAYOUT_GENERAL),
+    };
+
+    Renderer::UpdateDescriptorSet(mRenderContext, mRootSignatureCompute, 0, mComputeDataPostfx.descriptorset, tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+}
+
+void CustomRenderer::UpdateShadowDescriptorSets()
+{
+    for (size_t i = 0; i < mDepthOnlypass.descriptorSet.size(); i++)
+    {
+        const std::array<DescriptorInfo, 2> tDescriptors =
+        {
+            DescriptorInfo(mDepthOnlypass.mBufferDepthTransformation[i]->mBuffer, 0, sizeof(glm::mat4)),
+            DescriptorInfo(mDepthOnlypass.mRenderTargetDepth->mDepthImage->mView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+        };
+
+        Renderer::UpdateDescriptorSet(mRenderContext, mRootSignatureScene, 2, mDepthOnlypass.descriptorSet[i], tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+    }
+}
+
+void CustomRenderer::WaitForFramesInFlight()
+{
+    // Nothing was submitted before Init
+    if (mFrames[0].mInFlight == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    // Only wait for the work this renderer submitted instead of draining the whole device
+    // Frame contexts past the current depth may still hold work from before it was lowered
+    std::array<VkFence, MAX_FRAMES_IN_FLIGHT> tFences;
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        tFences[i] = mFrames[i].mInFlight;
+    }
+
+    vkWaitForFences(mRenderContext->mDevice->mDevice, MAX_FRAMES_IN_FLIGHT, tFences.data(), VK_TRUE, UINT64_MAX);
+}
+
 void CustomRenderer::Cleanup() {
+    // Join the compile threads before anything they use is destroyed
+    mPipelineCompiler->WaitIdle();
+    CollectCompiledPipelines();
+    mPipelineCompiler = nullptr;
+
+    WaitForFramesInFlight();
+    mCommandRecorder = nullptr;
+
     CleanupSwapChain();
+    Renderer::DestroyTransientResourcePool(mRenderContext, mTransientPool);
 
     // Imgui cleanup
     {
         ImGui_ImplVulkan_Shutdown();
-        ImGui_ImplGlfw_Shutdown();
+        if (!IsHeadless())
+        {
+            ImGui_ImplGlfw_Shutdown();
+        }
     }
 
+    DestroyReadbackBuffers();
+
 
     vkDestroySampler(mRenderContext->mDevice->mDevice, textureSampler, nullptr);
     vkDestroySampler(mRenderContext->mDevice->mDevice, pointSampler, nullptr);
@@ -376,12 +647,15 @@ void CustomRenderer::Cleanup() {
         Renderer::DestroyRootSignature(mRenderContext, rootSig);
     }
     mRootSignaturesAll.clear();
+    mRootSignatureLookup.clear();
 
     for (auto pipeline : mPipelines)
     {
         Renderer::DestroyGraphicsPipeline(mRenderContext, pipeline.second);
     }
     mPipelines.clear();
+    mPipelineLookup.clear();
+    mPipelineCompileTimesMs.clear();
 
     for (auto shader : mShadersAll)
     {
@@ -407,13 +681,9 @@ void CustomRenderer::Cleanup() {
 		vmaFreeMemory(mRenderContext->memoryAllocator, texture->mAllocation);
 	}
 
-	for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		vkDestroySemaphore(mRenderContext->mDevice->mDevice, renderFinishedSemaphores[i], nullptr);
-		vkDestroySemaphore(mRenderContext->mDevice->mDevice, imageAvailableSemaphores[i], nullptr);
-		vkDestroyFence(mRenderContext->mDevice->mDevice, inFlightFences[i], nullptr);
-	}
+	DestroyFrameContexts();
 
-	for (size_t i = 0; i < mSwapchain->mImages.size(); i++) {
+	for (size_t i = 0; i < mUniformBuffersCamera.size(); i++) {
 		vkDestroyBuffer(mRenderContext->mDevice->mDevice, mUniformBuffersCamera[i]->mBuffer, nullptr);
 		vmaFreeMemory(this->mRenderContext->memoryAllocator, mUniformBuffersCamera[i]->mAllocation);
 	}
@@ -425,11 +695,6 @@ void CustomRenderer::Cleanup() {
 
     Renderer::DestroyRootSignature(mRenderContext, mDepthOnlypass.mRootSignatureDepthOnly);
     Renderer::DestroyGraphicsPipeline(mRenderContext, mDepthOnlypass.mGraphicsPipeline);
-    Renderer::DestroyRenderTarget(mRenderContext, mDepthOnlypass.mRenderTargetDepth);
-
-    vkFreeDescriptorSets(mRenderContext->mDevice->mDevice, mDescriptorPool->mPool, mDepthOnlypass.descriptorSet.size(), mDepthOnlypass.descriptorSet.data());
-
-    vkFreeDescriptorSets(mRenderContext->mDevice->mDevice, mDescriptorPool->mPool, mDepthOnlypass.descriptorSetShadowTexture.size(), mDepthOnlypass.descriptorSetShadowTexture.data());
 
     for (auto& buffer : mDepthOnlypass.mBufferDepthTransformation)
     {
@@ -437,21 +702,64 @@ void CustomRenderer::Cleanup() {
         vmaFreeMemory(mRenderContext->memoryAllocator, buffer->mAllocation);
     }
 
+    for (auto& buffer : mInstancing.mBuffers)
+    {
+        vkDestroyBuffer(mRenderContext->mDevice->mDevice, buffer->mBuffer, nullptr);
+        vmaFreeMemory(mRenderContext->memoryAllocator, buffer->mAllocation);
+    }
+
+    if (mOcclusionCulling.mHiZ != nullptr)
+    {
+        mOcclusionCulling.mHiZ = nullptr;
+
+        Renderer::DestroyComputePipeline(mRenderContext, mOcclusionCulling.mBuildPipeline);
+        Renderer::DestroyRootSignature(mRenderContext, mOcclusionCulling.mBuildRootSignature);
+        Renderer::DestroyComputePipeline(mRenderContext, mOcclusionCulling.mLatePipeline);
+        Renderer::DestroyRootSignature(mRenderContext, mOcclusionCulling.mLateRootSignature);
+    }
+
+    if (mGpuDriven.mScene != nullptr)
+    {
+        mGpuDriven.mScene = nullptr;
+
+        Renderer::DestroyComputePipeline(mRenderContext, mGpuDriven.mCullPipeline);
+        Renderer::DestroyRootSignature(mRenderContext, mGpuDriven.mCullRootSignature);
+        Renderer::DestroyGraphicsPipeline(mRenderContext, mGpuDriven.mDepthPipeline);
+        Renderer::DestroyRootSignature(mRenderContext, mGpuDriven.mDepthRootSignature);
+    }
+
+    if (mBindless.mMaterials != nullptr)
+    {
+        for (auto& buffer : mBindless.mObjectBuffers)
+        {
+            vkDestroyBuffer(mRenderContext->mDevice->mDevice, buffer->mBuffer, nullptr);
+            vmaFreeMemory(mRenderContext->memoryAllocator, buffer->mAllocation);
+        }
+
+        mBindless.mMaterials = nullptr;
+    }
 
-	vkFreeCommandBuffers(mRenderContext->mDevice->mDevice, commandPool, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
 
+	// Releases every set allocated through it
+	Renderer::DestroyDescriptorAllocator(mRenderContext, mDescriptorAllocator);
 	Renderer::DestroyDescriptorPool(mRenderContext, mDescriptorPool);
 
 	vkDestroyCommandPool(mRenderContext->mDevice->mDevice, commandPool, nullptr);
 
     vkDestroyQueryPool(mRenderContext->mDevice->mDevice, mQueryPool, nullptr);
+    mProfiling.mGpu = nullptr;
 
-    glfwTerminate();
+    if (!IsHeadless())
+    {
+        glfwTerminate();
+    }
 
     Renderer::DestroyRenderContext(mRenderContext);
 }
 
 void CustomRenderer::RecreateSwapChain() {
+    assert(!IsHeadless());
+
     int width = 0, height = 0;
     glfwGetFramebufferSize(mWindow, &width, &height);
     while (width == 0 || height == 0) {
@@ -459,31 +767,15 @@ void CustomRenderer::RecreateSwapChain() {
         glfwWaitEvents();
     }
 
-    vkDeviceWaitIdle(mRenderContext->mDevice->mDevice);
-
-    CleanupSwapChain();
-
-    mSwapchain = Renderer::CreateSwapChain(mRenderContext, mWindow);
-
-    {
-        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
-        RTCreateDesc.mWidth = mSwapchain->mExtent.width;
-        RTCreateDesc.mHeight = mSwapchain->mExtent.height;
-        RTCreateDesc.mTargets = { {VK_FORMAT_R16G16B16A16_UNORM} };
-        RTCreateDesc.mDepthTarget = { VK_FORMAT_D32_SFLOAT };
-        mRenderTargetScene = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
-    }
+    WaitForFramesInFlight();
 
-    {
-        Flux::Gfx::RenderTargetCreateDesc RTCreateDesc{};
-        RTCreateDesc.mWidth = mSwapchain->mExtent.width;
-        RTCreateDesc.mHeight = mSwapchain->mExtent.height;
-        RTCreateDesc.mTargets = { {VK_FORMAT_R8G8B8A8_UNORM} };
-        RTCreateDesc.mDepthTarget = { VK_FORMAT_D32_SFLOAT };
-        mRenderTargetFinal = Renderer::CreateRenderTarget(mRenderContext, mRenderContext->mDevice, mQueueGraphics, commandPool, mRenderContext->memoryAllocator, &RTCreateDesc);
-    }
+    std::shared_ptr<Swapchain> tOldSwapchain = mSwapchain;
+    mSwapchain = Renderer::CreateSwapChain(mRenderContext, mWindow, tOldSwapchain);
+    Renderer::DestroySwapchain(mRenderContext, tOldSwapchain);
 
-    CreateDescriptorSets();
+    // Pipelines use dynamic viewport/scissor, the size dependent targets are requested again by the next frame
+    // The swapchain images are new, their contents are undefined
+    mFrameGraph.ResetImageStates();
 }
 
 std::optional<std::shared_ptr<Flux::Gfx::Shader>> CustomRenderer::DoesShaderExist(std::string aFilePath)
@@ -499,95 +791,89 @@ std::optional<std::shared_ptr<Flux::Gfx::Shader>> CustomRenderer::DoesShaderExis
     return std::nullopt;
 }
 
-std::optional<std::shared_ptr<Flux::Gfx::RootSignature>> Flux::CustomRenderer::DoesRootSignatureExist(const std::vector<std::shared_ptr<Flux::Gfx::Shader>>& aShaders)
+// Sorted interned shader paths, root signatures built from the same shaders map to the same key
+static std::vector<uint32_t> GetShaderSetKey(const std::vector<std::shared_ptr<Flux::Gfx::Shader>>& aShaders)
 {
-    // Go through all root signatures, check if there is a matching shader list to an existing root signature
-    for (const auto& rootSig : mRootSignaturesAll)
-    {
-        if (rootSig->mShaders.size() != aShaders.size())
-        {
-            continue;
-        }
-
-        bool match = true;
+    std::vector<uint32_t> tKey;
+    tKey.reserve(aShaders.size());
 
-        for (const auto& shader : aShaders)
-        {
-            bool shaderMatch = false;
+    for (const auto& shader : aShaders)
+    {
+        tKey.push_back(InternShaderPath(shader->mFilePath));
+    }
 
-            // Check if we can find a matching shader from the root signature
-            // if not then there is no match and this root sig doesn't match our input
-            for (const auto& shaderRootSig : rootSig->mShaders)
-            {
-                if (shaderRootSig->mFilePath == shader->mFilePath)
-                {
-                    shaderMatch = true;
-                    break;
-                }
-            }
+    std::sort(tKey.begin(), tKey.end());
+    return tKey;
+}
 
-            if (!shaderMatch)
-            {
-                match = false;
-                break;
-            }
-        }
+std::optional<std::shared_ptr<Flux::Gfx::RootSignature>> Flux::CustomRenderer::DoesRootSignatureExist(const std::vector<std::shared_ptr<Flux::Gfx::Shader>>& aShaders)
+{
+    auto tRootSig = mRootSignatureLookup.find(GetShaderSetKey(aShaders));
 
-        if (match)
-        {
-            return std::optional<std::shared_ptr<Flux::Gfx::RootSignature>>(rootSig);
-        }
+    if (tRootSig != mRootSignatureLookup.end())
+    {
+        return std::optional<std::shared_ptr<Flux::Gfx::RootSignature>>(tRootSig->second);
     }
 
     return std::optional<std::shared_ptr<Flux::Gfx::RootSignature>>();
 }
 
-std::shared_ptr<Flux::Gfx::GraphicsPipeline> Flux::CustomRenderer::CreateGraphicsPipelineForState(RenderState state)
+void Flux::CustomRenderer::AddRootSignature(std::shared_ptr<Flux::Gfx::RootSignature> aRootSignature)
+{
+    mRootSignaturesAll.push_back(aRootSignature);
+    mRootSignatureLookup[GetShaderSetKey(aRootSignature->mShaders)] = aRootSignature;
+}
+
+std::shared_ptr<Flux::Gfx::GraphicsPipeline> Flux::CustomRenderer::CreateGraphicsPipelineForState(const RenderState& state)
 {
 
     std::vector<std::shared_ptr<Flux::Gfx::Shader>> tShaders;
+    std::shared_ptr<RootSignature> tRootSig = nullptr;
 
-    // Prepare the pipeline stages
-    for (auto& e : state.shaders)
+    // Runs on the pipeline compiler threads, shaders and root signatures are shared between pipelines
+    // Only the registry lookups are locked, the pipeline itself is compiled in parallel
     {
-        std::shared_ptr<Flux::Gfx::Shader> tShader;
+        std::lock_guard<std::mutex> tLock(mShaderRegistryMutex);
 
-        auto shaderOptional = DoesShaderExist(e.second);
-
-        if (!shaderOptional.has_value())
+        // Prepare the pipeline stages
+        for (auto& e : state.shaders)
         {
-            auto shaderCode = Common::ReadFile<char>(e.second);
+            std::shared_ptr<Flux::Gfx::Shader> tShader;
 
-            ShaderCreateDesc shaderCreateDesc{};
-            shaderCreateDesc.mCode = shaderCode;
-            shaderCreateDesc.mFilePath = e.second;
-            shaderCreateDesc.mType = e.first;
-            tShader = Renderer::CreateShader(mRenderContext, &shaderCreateDesc);
-            mShadersAll.push_back(tShader);
-        }
-        else
-        {
-            tShader = shaderOptional.value();
-        }
+            auto shaderOptional = DoesShaderExist(e.second);
 
-        tShaders.push_back(tShader);
-    }
+            if (!shaderOptional.has_value())
+            {
+                ShaderCreateDesc shaderCreateDesc{};
+                shaderCreateDesc.mCode = Common::ReadFile<char>(e.second);
+                shaderCreateDesc.mFilePath = e.second;
+                shaderCreateDesc.mType = e.first;
+                tShader = Renderer::CreateShader(mRenderContext, &shaderCreateDesc);
+                mShadersAll.push_back(tShader);
+            }
+            else
+            {
+                tShader = shaderOptional.value();
+            }
 
-    auto resultRootQuery = DoesRootSignatureExist(tShaders);
+            tShaders.push_back(tShader);
+        }
 
-    std::shared_ptr<RootSignature> tRootSig = nullptr;
-    if (resultRootQuery.has_value())
-    {
-        tRootSig = resultRootQuery.value();
-    }
-    else
-    {
-        RootSignatureCreateDesc rootSigCreateDesc{};
-        rootSigCreateDesc.mShaders = tShaders;
+        auto resultRootQuery = DoesRootSignatureExist(tShaders);
+
+        if (resultRootQuery.has_value())
+        {
+            tRootSig = resultRootQuery.value();
+        }
+        else
+        {
+            RootSignatureCreateDesc rootSigCreateDesc{};
+            rootSigCreateDesc.mShaders = tShaders;
 
-        tRootSig = Renderer::CreateRootSignature(mRenderContext, &rootSigCreateDesc);
+            tRootSig = Renderer::CreateRootSignature(mRenderContext, &rootSigCreateDesc);
 
-        mRootSignaturesAll.push_back(tRootSig);
+            AddRootSignature(tRootSig);
+        }
     }
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -597,80 +883,136 @@ std::shared_ptr<Flux::Gfx::GraphicsPipeline> Flux::CustomRenderer::CreateGraphic
     bindingDescription.stride = sizeof(VertexData);
     bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
-    std::vector<VkVertexInputAttributeDescription> vertexAttrDescriptions;
-    vertexAttrDescriptions.resize(5);
+    const std::vector<VkVertexInputAttributeDescription> vertexAttrDescriptions = CreateSceneVertexAttributes();
 
-    vertexAttrDescriptions[0].binding = 0;
-    vertexAttrDescriptions[0].location = 0;
-    vertexAttrDescriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttrDescriptions[0].offset = offsetof(VertexData, position);
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttrDescriptions.size());
+    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
+    vertexInputInfo.pVertexAttributeDescriptions = vertexAttrDescriptions.data();
 
-    vertexAttrDescriptions[1].binding = 0;
-    vertexAttrDescriptions[1].location = 1;
-    vertexAttrDescriptions[1].format = VK_FORMAT_R32G32_SFLOAT;
-    vertexAttrDescriptions[1].offset = offsetof(VertexData, texCoords);
+    Flux::Gfx::GraphicsPipelineCreateDesc pipelineDesc;
+    pipelineDesc.vertexAttrDescriptions = vertexAttrDescriptions;
+    pipelineDesc.bindingDescription = bindingDescription;
+    pipelineDesc.mPushConstantSize = 0;
+    pipelineDesc.mRootSig = tRootSig;
+    pipelineDesc.mRt = mRenderTargetScene;
 
-    vertexAttrDescriptions[2].binding = 0;
-    vertexAttrDescriptions[2].location = 2;
-    vertexAttrDescriptions[2].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttrDescriptions[2].offset = offsetof(VertexData, normal);
 
-    vertexAttrDescriptions[3].binding = 0;
-    vertexAttrDescriptions[3].location = 3;
-    vertexAttrDescriptions[3].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttrDescriptions[3].offset = offsetof(VertexData, tangent);
 
-    vertexAttrDescriptions[4].binding = 0;
-    vertexAttrDescriptions[4].location = 4;
-    vertexAttrDescriptions[4].format = VK_FORMAT_R32G32B32_SFLOAT;
-    vertexAttrDescriptions[4].offset = offsetof(VertexData, bitangent);
+    auto tPipeline = Renderer::CreateGraphicsPipeline(mRenderContext, &pipelineDesc);
 
+    return tPipeline;
+}
 
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttrDescriptions.size());
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDescription;
-    vertexInputInfo.pVertexAttributeDescriptions = vertexAttrDescriptions.data();
+std::optional<uint32_t> Flux::CustomRenderer::QueryPipeline(const RenderState& state)
+{
+    auto tResult = mPipelineLookup.find(state.mHash);
 
-    Flux::Gfx::GraphicsPipelineCreateDesc pipelineDesc;
-    pipelineDesc.vertexAttrDescriptions = vertexAttrDescriptions;
-    pipelineDesc.bindingDescription = bindingDescription;
-    pipelineDesc.mPushConstantSize = sizeof(glm::mat4);
-    pipelineDesc.mRootSig = tRootSig;
-    pipelineDesc.mRt = mRenderTargetScene;
+    if (tResult != mPipelineLookup.end())
+    {
+        // A hash collision between two different states would silently share a pipeline
+        assert(mPipelines[tResult->second].first == state);
+        return std::optional<uint32_t>(tResult->second);
+    }
 
+    return std::optional<uint32_t>();
+}
 
+uint32_t Flux::CustomRenderer::CreatePipeline(const RenderState& state)
+{
+    auto tQuery = QueryPipeline(state);
 
-    auto tPipeline = Renderer::CreateGraphicsPipeline(mRenderContext, &pipelineDesc);
+    if (tQuery.has_value())
+    {
+        return tQuery.value();
+    }
 
-    return tPipeline;
+    auto tStart = std::chrono::high_resolution_clock::now();
+    auto tPipeline = CreateGraphicsPipelineForState(state);
+    float tCompileTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+    return AddPipeline(state, tPipeline, tCompileTimeMs);
+}
+
+uint32_t Flux::CustomRenderer::AddPipeline(const RenderState& state, std::shared_ptr<Flux::Gfx::GraphicsPipeline> aPipeline, float aCompileTimeMs)
+{
+    this->mPipelines.push_back({ state, aPipeline });
+    mPipelineCompileTimesMs.push_back(aCompileTimeMs);
+
+    const uint32_t tIndex = static_cast<uint32_t>(this->mPipelines.size() - 1);
+    mPipelineLookup[state.mHash] = tIndex;
+
+    return tIndex;
+}
+
+void Flux::CustomRenderer::RequestPipeline(const RenderState& state)
+{
+    if (mFailedPipelines.find(state.mHash) != mFailedPipelines.end())
+    {
+        return;
+    }
+
+    mPipelineCompiler->Request(state);
 }
 
-std::optional<uint32_t> Flux::CustomRenderer::QueryPipeline(RenderState state)
+void Flux::CustomRenderer::CollectCompiledPipelines()
 {
-    for (uint32_t i = 0; i < mPipelines.size(); ++i)
+    for (auto& result : mPipelineCompiler->CollectResults())
     {
-        if (mPipelines[i].first == state)
+        if (result.mPipeline == nullptr)
         {
-            return std::optional<uint32_t>(i);
+            // Don't keep requesting a state that can't be compiled
+            mFailedPipelines.insert(result.mState.mHash);
+            continue;
         }
-    }
 
-    return std::optional<uint32_t>();
+        if (QueryPipeline(result.mState).has_value())
+        {
+            // Was created synchronously in the meantime
+            Renderer::DestroyGraphicsPipeline(mRenderContext, result.mPipeline);
+            continue;
+        }
+
+        AddPipeline(result.mState, result.mPipeline, result.mCompileTimeMs);
+    }
 }
 
-uint32_t Flux::CustomRenderer::CreatePipeline(RenderState state)
+std::optional<uint32_t> Flux::CustomRenderer::GetDrawPipeline(RenderState& state)
 {
-    auto tQuery = QueryPipeline(state);
+    if (IsPipelineValid(state))
+    {
+        return state.stateID;
+    }
 
-    if (tQuery.has_value())
+    // Pipeline is gone or still compiling, look it up again next frame
+    state.stateID = std::nullopt;
+
+    if (mPendingPipelineMode == PendingPipelineMode::eFallback)
     {
-        return tQuery.value();
+        return mFallbackPipelineIndex;
     }
 
-    this->mPipelines.push_back({state, CreateGraphicsPipelineForState(state) });
+    return std::nullopt;
+}
 
-    return this->mPipelines.size() - 1;
+void Flux::CustomRenderer::PrewarmPipelines(const std::shared_ptr<iScene> aScene, bool aWaitForCompletion)
+{
+    for (auto& object : aScene->GetSceneObjects())
+    {
+        object->mRenderState.UpdateHash();
+
+        if (!QueryPipeline(object->mRenderState).has_value())
+        {
+            RequestPipeline(object->mRenderState);
+        }
+    }
+
+    if (aWaitForCompletion)
+    {
+        mPipelineCompiler->WaitIdle();
+        CollectCompiledPipelines();
+    }
 }
 
 void CustomRenderer::CreateCommandPool() {
@@ -737,11 +1079,11 @@ void CustomRenderer::CreateTextureSampler()
 
 void CustomRenderer::CreateUniformBuffers()
 {
-    mUniformBuffersCamera.resize(mSwapchain->mImages.size());
-    mLightData.mUniformBuffersLights.resize(mSwapchain->mImages.size());
-    mDepthOnlypass.mBufferDepthTransformation.resize(mSwapchain->mImages.size());
+    mUniformBuffersCamera.resize(MAX_FRAMES_IN_FLIGHT);
+    mLightData.mUniformBuffersLights.resize(MAX_FRAMES_IN_FLIGHT);
+    mDepthOnlypass.mBufferDepthTransformation.resize(MAX_FRAMES_IN_FLIGHT);
 
-    for (size_t i = 0; i < mSwapchain->mImages.size(); i++)
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
     {
         {
             mUniformBuffersCamera[i] = std::make_shared<BufferGPU>();
@@ -761,187 +1103,725 @@ void CustomRenderer::CreateUniformBuffers()
     }
 }
 
+void CustomRenderer::AllocatePersistentDescriptorSets(VkDescriptorSetLayout aLayout, std::vector<VkDescriptorSet>& aOutSets)
+{
+    aOutSets.resize(MAX_FRAMES_IN_FLIGHT);
+
+    for (auto& set : aOutSets)
+    {
+        set = Renderer::AllocateDescriptorSet(mRenderContext, mDescriptorAllocator, aLayout);
+    }
+}
+
 void CustomRenderer::CreateDescriptorSets()
 {
 
     {
-        std::vector<VkDescriptorSetLayout> layouts(mSwapchain->mImages.size(), mRootSignatureScene->mDescriptorSetLayouts[0]);
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mDescriptorPool->mPool;
-        allocInfo.descriptorSetCount = static_cast<uint32_t>(mSwapchain->mImages.size());
-        allocInfo.pSetLayouts = layouts.data();
+        AllocatePersistentDescriptorSets(mRootSignatureScene->mDescriptorSetLayouts[0], descriptorSetsSceneObjects);
 
-        descriptorSetsSceneObjects.resize(mSwapchain->mImages.size());
-        if (vkAllocateDescriptorSets(mRenderContext->mDevice->mDevice, &allocInfo, descriptorSetsSceneObjects.data()) != VK_SUCCESS)
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
-            throw std::runtime_error("Failed to allcoate descriptor sets!");
+            const std::array<DescriptorInfo, 2> tDescriptors =
+            {
+                DescriptorInfo(mUniformBuffersCamera[i]->mBuffer, 0, sizeof(CustomRenderer::UniformBufferCamera)),
+                DescriptorInfo(mLightData.mUniformBuffersLights[i]->mBuffer, 0, sizeof(Light) * AMOUNT_OF_SUPPORTED_LIGHTS),
+            };
+
+            Renderer::UpdateDescriptorSet(mRenderContext, mRootSignatureScene, 0, descriptorSetsSceneObjects[i], tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
         }
+    }
+
+    {
+        AllocatePersistentDescriptorSets(mRootSignatureScene->mDescriptorSetLayouts[2], mDepthOnlypass.descriptorSet);
+
+        UpdateShadowDescriptorSets();
+    }
+    {
+        AllocatePersistentDescriptorSets(mDepthOnlypass.mRootSignatureDepthOnly->mDescriptorSetLayouts[0], mDepthOnlypass.descriptorSetShadowTexture);
 
-        for (size_t i = 0; i < mSwapchain->mImages.size(); i++)
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
         {
-            VkDescriptorBufferInfo bufferInfoCamera{};
-            bufferInfoCamera.buffer = mUniformBuffersCamera[i]->mBuffer;
-            bufferInfoCamera.offset = 0;
-            bufferInfoCamera.range = sizeof(CustomRenderer::UniformBufferCamera);
+            const DescriptorInfo tDescriptor(mDepthOnlypass.mBufferDepthTransformation[i]->mBuffer, 0, sizeof(glm::mat4));
 
-            VkDescriptorBufferInfo bufferInfoLight;
-            bufferInfoLight.buffer = mLightData.mUniformBuffersLights[i]->mBuffer;
-            bufferInfoLight.offset = 0;
-            bufferInfoLight.range = sizeof(Light) * AMOUNT_OF_SUPPORTED_LIGHTS;
+            Renderer::UpdateDescriptorSet(mRenderContext, mDepthOnlypass.mRootSignatureDepthOnly, 0, mDepthOnlypass.descriptorSetShadowTexture[i], &tDescriptor, 1);
+        }
+    }
 
-            std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
 
-            descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[0].dstSet = descriptorSetsSceneObjects[i];
-            descriptorWrites[0].dstBinding = 0;
-            descriptorWrites[0].dstArrayElement = 0;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[0].descriptorCount = 1;
-            descriptorWrites[0].pBufferInfo = &bufferInfoCamera;
+}
 
-            descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[1].dstSet = descriptorSetsSceneObjects[i];
-            descriptorWrites[1].dstBinding = 1;
-            descriptorWrites[1].dstArrayElement = 0;
-            descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[1].descriptorCount = 1;
-            descriptorWrites[1].pBufferInfo = &bufferInfoLight;
+void CustomRenderer::CreateInstanceBuffers()
+{
+    mInstancing.mBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+    mInstancing.mCapacities.assign(MAX_FRAMES_IN_FLIGHT, 0);
 
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        ReserveInstances(i, INITIAL_INSTANCE_CAPACITY);
+    }
+}
+
+void CustomRenderer::ReserveInstances(uint32_t aFrameIndex, size_t aCount)
+{
+    if (aCount <= mInstancing.mCapacities[aFrameIndex])
+    {
+        return;
+    }
+
+    // Doubled so a growing scene does not reallocate every frame
+    const size_t tCapacity = std::max(aCount, mInstancing.mCapacities[aFrameIndex] * 2);
+
+    std::shared_ptr<BufferGPU>& tBuffer = mInstancing.mBuffers[aFrameIndex];
+    if (tBuffer != nullptr)
+    {
+        vkDestroyBuffer(mRenderContext->mDevice->mDevice, tBuffer->mBuffer, nullptr);
+        vmaFreeMemory(mRenderContext->memoryAllocator, tBuffer->mAllocation);
+    }
 
+    tBuffer = std::make_shared<BufferGPU>();
+    Renderer::CreateBuffer(mRenderContext->mDevice->mDevice, mRenderContext->memoryAllocator, sizeof(glm::mat4) * tCapacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, tBuffer->mBuffer, tBuffer->mAllocation);
+    mInstancing.mCapacities[aFrameIndex] = tCapacity;
+}
 
-            vkUpdateDescriptorSets(mRenderContext->mDevice->mDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+void CustomRenderer::CreateCommandRecorder()
+{
+    // The render thread only waits while recording, so every core can record
+    const uint32_t tThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, 8u);
+
+    // Secondary command buffers are reused once the primary command buffer of the same frame in flight is done
+    mCommandRecorder = std::make_unique<ParallelCommandRecorder>(mRenderContext, mQueueGraphics->mQueueIndex, tThreadCount, MAX_FRAMES_IN_FLIGHT);
+}
+
+void CustomRenderer::CreateFrameContexts() {
+    // Command buffers are never reset one by one, the whole pool is reset at the start of its frame
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.queueFamilyIndex = mQueueGraphics->mQueueIndex;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+    VkFenceCreateInfo fenceInfo{};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    for (FrameContext& frame : mFrames) {
+        if (vkCreateCommandPool(mRenderContext->mDevice->mDevice, &poolInfo, nullptr, &frame.mCommandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create command pool!");
+        }
+
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = frame.mCommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+
+        if (vkAllocateCommandBuffers(mRenderContext->mDevice->mDevice, &allocInfo, &frame.mCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate command buffers!");
         }
+
+        if (vkCreateSemaphore(mRenderContext->mDevice->mDevice, &semaphoreInfo, nullptr, &frame.mImageAvailable) != VK_SUCCESS ||
+            vkCreateSemaphore(mRenderContext->mDevice->mDevice, &semaphoreInfo, nullptr, &frame.mRenderFinished) != VK_SUCCESS ||
+            vkCreateFence(mRenderContext->mDevice->mDevice, &fenceInfo, nullptr, &frame.mInFlight) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create synchronization objects for a frame!");
+        }
+    }
+}
+
+void CustomRenderer::DestroyFrameContexts() {
+    for (FrameContext& frame : mFrames) {
+        vkDestroySemaphore(mRenderContext->mDevice->mDevice, frame.mRenderFinished, nullptr);
+        vkDestroySemaphore(mRenderContext->mDevice->mDevice, frame.mImageAvailable, nullptr);
+        vkDestroyFence(mRenderContext->mDevice->mDevice, frame.mInFlight, nullptr);
+
+        // Frees its command buffer as well
+        vkDestroyCommandPool(mRenderContext->mDevice->mDevice, frame.mCommandPool, nullptr);
+        frame = FrameContext{};
+    }
+}
+
+void CustomRenderer::SetFramesInFlight(uint32_t aCount)
+{
+    const uint32_t tCount = std::clamp(aCount, 1u, MAX_FRAMES_IN_FLIGHT);
+    if (tCount == mFramesInFlight)
+    {
+        return;
+    }
+
+    // Starts over at the first frame context once everything submitted with the old depth has finished
+    WaitForFramesInFlight();
+    CollectFrameLatencies();
+
+    // Frame contexts past the new depth are not waited on again
+    for (FrameContext& frame : mFrames)
+    {
+        FreeRetiredMaterialSets(frame);
     }
 
+    mFramesInFlight = tCount;
+    mFrameIndex = 0;
+    ClearPresentationStats();
+}
+
+void CustomRenderer::SetPresentPolicy(const Gfx::PresentPolicy& aPolicy)
+{
+    const bool tModeChanged = aPolicy.mMode != mPresentation.mPolicy.mMode;
+    if (!tModeChanged && aPolicy.mFrameRateLimit == mPresentation.mPolicy.mFrameRateLimit && aPolicy.mLowLatency == mPresentation.mPolicy.mLowLatency)
     {
-        std::vector<VkDescriptorSetLayout> layouts(mSwapchain->mImages.size(), mRootSignatureScene->mDescriptorSetLayouts[2]);
+        return;
+    }
 
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mDescriptorPool->mPool;
-        allocInfo.descriptorSetCount = mSwapchain->mImages.size();
-        allocInfo.pSetLayouts = layouts.data();
+    mPresentation.mPolicy = aPolicy;
+    mPresentation.mPacer.SetFrameRateLimit(aPolicy.mFrameRateLimit);
+    ClearPresentationStats();
 
-        mDepthOnlypass.descriptorSet.resize(mSwapchain->mImages.size());
+    // Offscreen swapchains are never presented, the mode only matters for windows
+    if (tModeChanged && !IsHeadless())
+    {
+        mRenderContext->mPresentMode = aPolicy.mMode;
+        RecreateSwapChain();
+    }
+}
 
-        if (vkAllocateDescriptorSets(mRenderContext->mDevice->mDevice, &allocInfo, mDepthOnlypass.descriptorSet.data()) != VK_SUCCESS)
+void CustomRenderer::BeginFrame()
+{
+    // The zones of the last captured frame were drained at its frame end
+    if (mProfiling.mCaptureFramesLeft > 0 && --mProfiling.mCaptureFramesLeft == 0)
+    {
+        FinishTraceCapture();
+    }
+
+    FLUX_PROFILE_ZONE("Frame pacing");
+
+    const FramePacer::Clock::time_point tWaitStart = FramePacer::Clock::now();
+
+    mPresentation.mPacer.Wait();
+
+    // Input sampled once the previous frame is done shows up in the next frame, instead of behind the queued ones
+    // The fence is the closest to presentation that can be waited on without present wait support
+    if (mPresentation.mPolicy.mLowLatency && mFrames[0].mInFlight != VK_NULL_HANDLE)
+    {
+        const uint32_t tPrevious = (mFrameIndex + mFramesInFlight - 1) % mFramesInFlight;
+        vkWaitForFences(mRenderContext->mDevice->mDevice, 1, &mFrames[tPrevious].mInFlight, VK_TRUE, UINT64_MAX);
+    }
+
+    CollectFrameLatencies();
+
+    const FramePacer::Clock::time_point tNow = FramePacer::Clock::now();
+    mPresentation.mWaitTimesMs.Add(std::chrono::duration<double, std::milli>(tNow - tWaitStart).count());
+    if (mPresentation.mLastInputTime != FramePacer::Clock::time_point{})
+    {
+        mPresentation.mFrameTimesMs.Add(std::chrono::duration<double, std::milli>(tNow - mPresentation.mLastInputTime).count());
+    }
+
+    mPresentation.mLastInputTime = tNow;
+    mPresentation.mInputTime = tNow;
+    mPresentation.mInputSampled = true;
+}
+
+void CustomRenderer::CollectFrameLatencies()
+{
+    for (FrameContext& frame : mFrames)
+    {
+        if (frame.mLatencyPending && vkGetFenceStatus(mRenderContext->mDevice->mDevice, frame.mInFlight) == VK_SUCCESS)
         {
-            throw "Failed to allocate descriptor set";
+            mPresentation.mLatenciesMs.Add(std::chrono::duration<double, std::milli>(FramePacer::Clock::now() - frame.mInputTime).count());
+            mPresentation.mLatenciesMeasured++;
+            frame.mLatencyPending = false;
         }
+    }
+}
 
-        for (size_t i = 0; i < mSwapchain->mImages.size(); i++)
-        {
-            VkDescriptorBufferInfo bufferInfoLight{};
-            bufferInfoLight.buffer = mDepthOnlypass.mBufferDepthTransformation[i]->mBuffer;
-            bufferInfoLight.offset = 0;
-            bufferInfoLight.range = sizeof(glm::mat4);
+void CustomRenderer::StartTraceCapture()
+{
+    mProfiling.mTrace.Clear();
+    mProfiling.mTrace.SetTrackName(TRACE_TRACK_GPU, "GPU graphics queue");
 
-            std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+    mProfiling.mCaptureOrigin = FramePacer::Clock::now();
+    mProfiling.mCaptureFramesLeft = TRACE_CAPTURE_FRAMES;
+    mProfiling.mCaptureStatus = "Capturing " + std::to_string(TRACE_CAPTURE_FRAMES) + " frames";
+
+    mProfiling.mGpu->SetTrace(&mProfiling.mTrace, TRACE_TRACK_GPU, mProfiling.mCaptureOrigin);
+    CpuProfiler::Get().SetTrace(&mProfiling.mTrace, TRACE_TRACK_CPU_FIRST, mProfiling.mCaptureOrigin);
+}
 
-            descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[0].dstSet = mDepthOnlypass.descriptorSet[i];
-            descriptorWrites[0].dstBinding = 0;
-            descriptorWrites[0].dstArrayElement = 0;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[0].descriptorCount = 1;
-            descriptorWrites[0].pBufferInfo = &bufferInfoLight;
+void CustomRenderer::FinishTraceCapture()
+{
+    // The GPU zones of the frames still in flight are left out
+    mProfiling.mGpu->SetTrace(nullptr, 0, FramePacer::Clock::time_point{});
+    CpuProfiler::Get().SetTrace(nullptr, 0, FramePacer::Clock::time_point{});
 
-            VkDescriptorImageInfo imageInfoShadow{};
-            imageInfoShadow.imageLayout = VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageInfoShadow.imageView = mDepthOnlypass.mRenderTargetDepth->mDepthImage->mView;
+    if (mProfiling.mTrace.WriteToFile(TRACE_FILE_NAME))
+    {
+        mProfiling.mCaptureStatus = "Wrote " + std::to_string(mProfiling.mTrace.GetEventCount()) + " zones to " + TRACE_FILE_NAME;
+    }
+    else
+    {
+        mProfiling.mCaptureStatus = std::string("Failed to write ") + TRACE_FILE_NAME;
+    }
 
-            descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[1].dstSet = mDepthOnlypass.descriptorSet[i];
-            descriptorWrites[1].dstBinding = 1;
-            descriptorWrites[1].dstArrayElement = 0;
-            descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-            descriptorWrites[1].descriptorCount = 1;
-            descriptorWrites[1].pImageInfo = &imageInfoShadow;
+    mProfiling.mTrace.Clear();
+}
 
+void CustomRenderer::ClearPresentationStats()
+{
+    mPresentation.mFrameTimesMs.Clear();
+    mPresentation.mLatenciesMs.Clear();
+    mPresentation.mWaitTimesMs.Clear();
+    mPresentation.mLastInputTime = FramePacer::Clock::time_point{};
 
+    // Frames submitted under the old settings are not measured
+    for (FrameContext& frame : mFrames)
+    {
+        frame.mLatencyPending = false;
+    }
+}
 
-            vkUpdateDescriptorSets(mRenderContext->mDevice->mDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+void Flux::CustomRenderer::CreateBindlessResources()
+{
+    if (!mRenderContext->mDevice->mDescriptorIndexingSupported)
+    {
+        return;
+    }
+
+    // Also creates the shaders and the root signature
+    RenderState tBindlessState;
+    tBindlessState.AddShader(ShaderTypes::eVertex, "Resources/Shaders/basicModelBindless.vert.spv");
+    tBindlessState.AddShader(ShaderTypes::eFragment, "Resources/Shaders/basicModelBindless.frag.spv");
+    mBindless.mPipelineIndex = CreatePipeline(tBindlessState);
+    mBindless.mRootSignature = mPipelines[mBindless.mPipelineIndex.value()].second->mRootSignature.lock();
+
+    mBindless.mMaterials = std::make_unique<BindlessMaterials>(mRenderContext, mBindless.mRootSignature, 1, textureSampler, pointSampler);
+
+    // Object transforms and indices, rewritten every frame
+    mBindless.mObjectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+    AllocatePersistentDescriptorSets(mBindless.mRootSignature->mDescriptorSetLayouts[3], mBindless.mObjectSets);
+
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        mBindless.mObjectBuffers[i] = std::make_shared<BufferGPU>();
+        Renderer::CreateBuffer(mRenderContext->mDevice->mDevice, mRenderContext->memoryAllocator, sizeof(BindlessObjectData) * MAX_BINDLESS_OBJECTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU, mBindless.mObjectBuffers[i]->mBuffer, mBindless.mObjectBuffers[i]->mAllocation);
+
+        const DescriptorInfo tDescriptor(mBindless.mObjectBuffers[i]->mBuffer);
+        Renderer::UpdateDescriptorSet(mRenderContext, mBindless.mRootSignature, 3, mBindless.mObjectSets[i], &tDescriptor, 1);
+    }
+
+    // Objects with exactly this state are switched over to the bindless pipeline
+    RenderState tSceneState;
+    tSceneState.AddShader(ShaderTypes::eVertex, "Resources/Shaders/basicModel.vert.spv");
+    tSceneState.AddShader(ShaderTypes::eFragment, "Resources/Shaders/basicModel.frag.spv");
+    mBindless.mSceneStateHash = tSceneState.mHash;
+
+    CreateGpuDrivenResources();
+}
+
+void Flux::CustomRenderer::CreateGpuDrivenResources()
+{
+    // Needs the bindless object buffers, every object selects its transform and material through them
+    if (mBindless.mMaterials == nullptr || mRenderContext->mDevice->mCmdDrawIndexedIndirectCount == nullptr)
+    {
+        return;
+    }
+
+    {
+        ShaderCreateDesc cullShaderCD{};
+        cullShaderCD.mCode = Flux::Common::ReadFile<char>("Resources/Shaders/cullObjects.comp.spv");
+        cullShaderCD.mFilePath = "Resources/Shaders/cullObjects.comp.spv";
+        cullShaderCD.mType = ShaderTypes::eCompute;
+
+        auto tCullShader = Renderer::CreateShader(mRenderContext, &cullShaderCD);
+        mShadersAll.push_back(tCullShader);
+
+        RootSignatureCreateDesc rootSigDesc{};
+        rootSigDesc.mShaders.push_back(tCullShader);
+        mGpuDriven.mCullRootSignature = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
+
+        ComputePipelineCreatedesc computePipelineCreateDesc{};
+        computePipelineCreateDesc.mRootSig = mGpuDriven.mCullRootSignature;
+        mGpuDriven.mCullPipeline = Renderer::CreateComputePipeline(mRenderContext, &computePipelineCreateDesc);
+
+        AllocatePersistentDescriptorSets(mGpuDriven.mCullRootSignature->mDescriptorSetLayouts[0], mGpuDriven.mCullSets);
+    }
+
+    // Same state as the depth only pipeline, only the transforms come from the object buffer
+    {
+        auto codeDepth = Flux::Common::ReadFile<char>("Resources/Shaders/simpleDepthIndirect.vert.spv");
+
+        Gfx::ShaderCreateDesc depthShaderCreateDesc{};
+        depthShaderCreateDesc.mCode = std::move(codeDepth);
+        depthShaderCreateDesc.mFilePath = "Resources/Shaders/simpleDepthIndirect.vert.spv";
+        depthShaderCreateDesc.mType = ShaderTypes::eVertex;
+
+        auto tDepthShader = Renderer::CreateShader(mRenderContext, &depthShaderCreateDesc);
+        mShadersAll.push_back(tDepthShader);
+
+        RootSignatureCreateDesc rootSigDesc{};
+        rootSigDesc.mShaders.push_back(tDepthShader);
+        mGpuDriven.mDepthRootSignature = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
+
+        VkVertexInputBindingDescription bindingDescription{};
+        bindingDescription.binding = 0;
+        bindingDescription.stride = sizeof(VertexData);
+        bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        Gfx::GraphicsPipelineCreateDesc pipeCreateDesc{};
+        pipeCreateDesc.mRootSig = mGpuDriven.mDepthRootSignature;
+        pipeCreateDesc.mRt = mDepthOnlypass.mRenderTargetDepth;
+        pipeCreateDesc.mPushConstantSize = 0;
+        pipeCreateDesc.vertexAttrDescriptions = CreateSceneVertexAttributes();
+        pipeCreateDesc.bindingDescription = bindingDescription;
+        pipeCreateDesc.mDepthStencilState.depthCompareOp = DepthCompareOp::eCompareLess;
+        mGpuDriven.mDepthPipeline = Renderer::CreateGraphicsPipeline(mRenderContext, &pipeCreateDesc);
+
+        AllocatePersistentDescriptorSets(mGpuDriven.mDepthRootSignature->mDescriptorSetLayouts[1], mGpuDriven.mDepthObjectSets);
+
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+        {
+            const DescriptorInfo tDescriptor(mBindless.mObjectBuffers[i]->mBuffer);
+            Renderer::UpdateDescriptorSet(mRenderContext, mGpuDriven.mDepthRootSignature, 1, mGpuDriven.mDepthObjectSets[i], &tDescriptor, 1);
         }
     }
+
+    mGpuDriven.mScene = std::make_unique<GpuScene>(mRenderContext, mGpuDriven.mCullRootSignature, mGpuDriven.mCullPipeline, mBindless.mObjectBuffers, mGpuDriven.mCullSets, MAX_BINDLESS_OBJECTS);
+}
+
+void Flux::CustomRenderer::CreateOcclusionCullingResources()
+{
     {
-        std::vector<VkDescriptorSetLayout> layouts(mSwapchain->mImages.size(), mDepthOnlypass.mRootSignatureDepthOnly->mDescriptorSetLayouts[0]);
+        ShaderCreateDesc buildShaderCD{};
+        buildShaderCD.mCode = Flux::Common::ReadFile<char>("Resources/Shaders/depthPyramid.comp.spv");
+        buildShaderCD.mFilePath = "Resources/Shaders/depthPyramid.comp.spv";
+        buildShaderCD.mType = ShaderTypes::eCompute;
 
-        VkDescriptorSetAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocInfo.descriptorPool = mDescriptorPool->mPool;
-        allocInfo.descriptorSetCount = mSwapchain->mImages.size();
-        allocInfo.pSetLayouts = layouts.data();
+        auto tBuildShader = Renderer::CreateShader(mRenderContext, &buildShaderCD);
+        mShadersAll.push_back(tBuildShader);
 
-        mDepthOnlypass.descriptorSetShadowTexture.resize(mSwapchain->mImages.size());
+        RootSignatureCreateDesc rootSigDesc{};
+        rootSigDesc.mShaders.push_back(tBuildShader);
+        mOcclusionCulling.mBuildRootSignature = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
+
+        ComputePipelineCreatedesc computePipelineCreateDesc{};
+        computePipelineCreateDesc.mRootSig = mOcclusionCulling.mBuildRootSignature;
+        mOcclusionCulling.mBuildPipeline = Renderer::CreateComputePipeline(mRenderContext, &computePipelineCreateDesc);
 
-        if (vkAllocateDescriptorSets(mRenderContext->mDevice->mDevice, &allocInfo, mDepthOnlypass.descriptorSetShadowTexture.data()) != VK_SUCCESS)
+        mOcclusionCulling.mBuildSets.resize(HiZCulling::MAX_LEVELS);
+        for (auto& set : mOcclusionCulling.mBuildSets)
         {
-            throw "Failed to allocate descriptor set";
+            set = Renderer::AllocateDescriptorSet(mRenderContext, mDescriptorAllocator, mOcclusionCulling.mBuildRootSignature->mDescriptorSetLayouts[0]);
         }
+    }
+
+    {
+        ShaderCreateDesc lateShaderCD{};
+        lateShaderCD.mCode = Flux::Common::ReadFile<char>("Resources/Shaders/occlusionLate.comp.spv");
+        lateShaderCD.mFilePath = "Resources/Shaders/occlusionLate.comp.spv";
+        lateShaderCD.mType = ShaderTypes::eCompute;
+
+        auto tLateShader = Renderer::CreateShader(mRenderContext, &lateShaderCD);
+        mShadersAll.push_back(tLateShader);
+
+        RootSignatureCreateDesc rootSigDesc{};
+        rootSigDesc.mShaders.push_back(tLateShader);
+        mOcclusionCulling.mLateRootSignature = Renderer::CreateRootSignature(mRenderContext, &rootSigDesc);
+
+        ComputePipelineCreatedesc computePipelineCreateDesc{};
+        computePipelineCreateDesc.mRootSig = mOcclusionCulling.mLateRootSignature;
+        mOcclusionCulling.mLatePipeline = Renderer::CreateComputePipeline(mRenderContext, &computePipelineCreateDesc);
 
-        for (size_t i = 0; i < mSwapchain->mImages.size(); i++)
+        AllocatePersistentDescriptorSets(mOcclusionCulling.mLateRootSignature->mDescriptorSetLayouts[0], mOcclusionCulling.mLateSets);
+    }
+
+    mOcclusionCulling.mHiZ = std::make_unique<HiZCulling>(mRenderContext,
+        mOcclusionCulling.mBuildRootSignature, mOcclusionCulling.mBuildPipeline, mOcclusionCulling.mBuildSets,
+        mOcclusionCulling.mLateRootSignature, mOcclusionCulling.mLatePipeline, mOcclusionCulling.mLateSets,
+        pointSampler, MAX_OCCLUSION_CANDIDATES);
+}
+
+void Flux::CustomRenderer::UpdateOcclusionCullingTargets()
+{
+    mOcclusionCulling.mHiZ->Resize(mRenderTargetScene->mDepthImage->mView, mRenderTargetScene->mWidth, mRenderTargetScene->mHeight);
+
+    if (mGpuDriven.mScene != nullptr)
+    {
+        mGpuDriven.mScene->SetDepthPyramid(mOcclusionCulling.mHiZ->GetView(), pointSampler);
+    }
+}
+
+void Flux::CustomRenderer::CreateMaterialDescriptorSet(Material& aMaterial)
+{
+    aMaterial.mDescriptorSet = Renderer::AllocateDescriptorSet(mRenderContext, mDescriptorAllocator, mRootSignatureScene->mDescriptorSetLayouts[1]);
+
+    const std::array<DescriptorInfo, 5> tDescriptors =
+    {
+        DescriptorInfo(aMaterial.mTextureAlbedo->mView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+        DescriptorInfo(aMaterial.mTextureSpecular->mView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+        DescriptorInfo(aMaterial.mTextureNormal->mView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+        DescriptorInfo(textureSampler),
+        DescriptorInfo(pointSampler),
+    };
+
+    Renderer::UpdateDescriptorSet(mRenderContext, mRootSignatureScene, 1, aMaterial.mDescriptorSet, tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+}
+
+void Flux::CustomRenderer::ReleaseUnusedMaterials(FrameContext& aFrame)
+{
+    for (const auto& material : mResourceManager->ReleaseUnusedMaterials())
+    {
+        if (material->mDescriptorSet != VK_NULL_HANDLE)
         {
-            VkDescriptorBufferInfo bufferInfoLight{};
-            bufferInfoLight.buffer = mDepthOnlypass.mBufferDepthTransformation[i]->mBuffer;
-            bufferInfoLight.offset = 0;
-            bufferInfoLight.range = sizeof(glm::mat4);
+            aFrame.mRetiredMaterialSets.push_back(material->mDescriptorSet);
+            material->mDescriptorSet = VK_NULL_HANDLE;
+        }
+    }
+}
+
+void Flux::CustomRenderer::FreeRetiredMaterialSets(FrameContext& aFrame)
+{
+    for (VkDescriptorSet set : aFrame.mRetiredMaterialSets)
+    {
+        Renderer::FreeDescriptorSet(mDescriptorAllocator, mRootSignatureScene->mDescriptorSetLayouts[1], set);
+    }
+
+    aFrame.mRetiredMaterialSets.clear();
+}
+
+bool Flux::CustomRenderer::DrawsObjectBindless(const iSceneObject& aObject, size_t aObjectIndex) const
+{
+    // The object index doubles as the index into the bindless transform buffer
+    return DrawsBindless(aObject.mRenderState) && aObject.mMaterial->mBindlessIndex.has_value() && aObjectIndex < MAX_BINDLESS_OBJECTS;
+}
+
+bool Flux::CustomRenderer::DrawsObjectGpuDriven(const iSceneObject& aObject, size_t aObjectIndex) const
+{
+    return DrawsGpuDriven() && aObject.mMesh != nullptr && aObject.mMesh->mGpuSceneMesh.has_value() && DrawsObjectBindless(aObject, aObjectIndex);
+}
 
-            std::array<VkWriteDescriptorSet, 1> descriptorWrites{};
+void Flux::CustomRenderer::CullObjects(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, const std::shared_ptr<Camera> aCamera)
+{
+    const auto tStart = std::chrono::high_resolution_clock::now();
 
-            descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            descriptorWrites[0].dstSet = mDepthOnlypass.descriptorSetShadowTexture[i];
-            descriptorWrites[0].dstBinding = 0;
-            descriptorWrites[0].dstArrayElement = 0;
-            descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            descriptorWrites[0].descriptorCount = 1;
-            descriptorWrites[0].pBufferInfo = &bufferInfoLight;
+    FrustumCullingData& tCulling = mFrustumCulling;
+    tCulling.mSpheres.Clear();
+    tCulling.mSpheres.Reserve(aSceneObjects.size());
+    tCulling.mObjectIndices.clear();
 
-            vkUpdateDescriptorSets(mRenderContext->mDevice->mDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+    for (size_t objectIndex = 0; objectIndex < aSceneObjects.size(); ++objectIndex)
+    {
+        const auto& object = aSceneObjects[objectIndex];
+
+        // Culled by the GPU
+        if (DrawsObjectGpuDriven(*object, objectIndex))
+        {
+            continue;
         }
+
+        // Without an asset there are no bounds, such objects are never culled
+        const glm::vec4 tSphere = object->mAsset != nullptr ? TransformBoundingSphere(object->mAsset->mBoundingSphere, object->transform)
+            : glm::vec4(glm::vec3(object->transform[3]), std::numeric_limits<float>::max());
+
+        tCulling.mSpheres.Add(tSphere);
+        tCulling.mObjectIndices.push_back(static_cast<uint32_t>(objectIndex));
     }
 
+    const size_t tTested = tCulling.mSpheres.Size();
+    tCulling.mCulledScene = tTested - CullSpheres(aCamera->GetFrustum(), tCulling.mSpheres, tCulling.mCameraVisible);
+    tCulling.mCulledShadow = tTested - CullSpheres(Frustum::FromMatrix(mDepthOnlypass.mLightMatrix), tCulling.mSpheres, tCulling.mLightVisible);
+
+    // Only what the camera sees can be hidden, objects without an asset have no bounds to test
+    OcclusionCullingData& tOcclusion = mOcclusionCulling;
+    tOcclusion.mCandidateSlots.assign(aSceneObjects.size(), INVALID_CANDIDATE_SLOT);
+    tOcclusion.mTestedObjects = 0;
+    tOcclusion.mOccludedObjects = 0;
+    tOcclusion.mOccludedTriangles = 0;
+    tOcclusion.mHiZ->ClearCandidates();
+
+    for (size_t i = 0; tOcclusion.mEnabled && i < tTested; ++i)
+    {
+        const size_t objectIndex = tCulling.mObjectIndices[i];
+        const auto& object = aSceneObjects[objectIndex];
+        if (tCulling.mCameraVisible[i] == 0 || object->mAsset == nullptr)
+        {
+            continue;
+        }
 
+        // The indirect draw of a bindless object selects it through its first instance
+        const bool tBindless = DrawsObjectBindless(*object, objectIndex);
+        if (tBindless && !mRenderContext->mDevice->mDrawIndirectFirstInstanceSupported)
+        {
+            continue;
+        }
+
+        tOcclusion.mTestedObjects++;
+
+        const glm::vec4 tSphere(tCulling.mSpheres.mCenterX[i], tCulling.mSpheres.mCenterY[i], tCulling.mSpheres.mCenterZ[i], tCulling.mSpheres.mRadius[i]);
+        if (!tOcclusion.mHiZ->IsSphereOccluded(tSphere))
+        {
+            continue;
+        }
+
+        const uint32_t tIndexCount = static_cast<uint32_t>(object->mAsset->mIndices.size());
+        const std::optional<uint32_t> tSlot = tOcclusion.mHiZ->AddCandidate(tSphere, tIndexCount, tBindless ? static_cast<uint32_t>(objectIndex) : 0);
+        if (tSlot.has_value())
+        {
+            tOcclusion.mCandidateSlots[objectIndex] = tSlot.value();
+            tOcclusion.mOccludedObjects++;
+            tOcclusion.mOccludedTriangles += tIndexCount / 3;
+        }
+    }
+
+    tCulling.mCullTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
 }
 
-void CustomRenderer::CreateCommandBuffers() {
-    commandBuffers.resize(mSwapchain->mImages.size());
+void Flux::CustomRenderer::BuildRenderQueue(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, const std::shared_ptr<Camera> aCamera)
+{
+    mRenderQueue.Clear();
+
+    for (size_t i = 0; i < mFrustumCulling.mObjectIndices.size(); ++i)
+    {
+        const bool tCameraVisible = mFrustumCulling.mCameraVisible[i] != 0;
+        const bool tLightVisible = mFrustumCulling.mLightVisible[i] != 0;
+        if (!tCameraVisible && !tLightVisible)
+        {
+            continue;
+        }
+
+        const size_t objectIndex = mFrustumCulling.mObjectIndices[i];
+        const auto& object = aSceneObjects[objectIndex];
+
+        const bool tBindless = DrawsObjectBindless(*object, objectIndex);
+
+        // If object has no pipeline yet, can not render.
+        const std::optional<uint32_t> tPipelineIndex = tBindless ? mBindless.mPipelineIndex : GetDrawPipeline(object->mRenderState);
+        if (!tPipelineIndex.has_value())
+        {
+            continue;
+        }
 
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandBufferCount = (uint32_t)commandBuffers.size();
+        const float tDepth = glm::distance(aCamera->Position, glm::vec3(object->transform[3])) / aCamera->farPlane;
+        const uint32_t tMesh = static_cast<uint32_t>(object->mMesh->mIndex);
 
-    if (vkAllocateCommandBuffers(mRenderContext->mDevice->mDevice, &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate command buffers!");
+        // Bindless materials are selected through the object buffer, so they do not need to be grouped
+        const uint32_t tMaterial = tBindless ? 0 : static_cast<uint32_t>(object->mMaterial->mIndex);
+
+        // The depth pass uses one pipeline and set for everything, only the mesh matters there
+        if (tLightVisible)
+        {
+            mRenderQueue.Add(RenderQueue::MakeKey(RENDER_QUEUE_PASS_DEPTH, 0, 0, tMesh, tDepth), static_cast<uint32_t>(objectIndex));
+        }
+        if (tCameraVisible)
+        {
+            // Occluded in the previous frame, the late scene pass draws it if the depth of this frame shows it
+            const uint32_t tScenePass = mOcclusionCulling.mCandidateSlots[objectIndex] != INVALID_CANDIDATE_SLOT ? RENDER_QUEUE_PASS_SCENE_LATE : RENDER_QUEUE_PASS_SCENE;
+            mRenderQueue.Add(RenderQueue::MakeKey(tScenePass, tPipelineIndex.value(), tMaterial, tMesh, tDepth), static_cast<uint32_t>(objectIndex));
+        }
     }
+
+    mRenderQueue.Sort();
 }
 
-void CustomRenderer::CreateSyncObjects() {
-    imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    imagesInFlight.resize(mSwapchain->mImages.size(), VK_NULL_HANDLE);
+void Flux::CustomRenderer::BuildInstanceBatches(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, uint32_t aFrameIndex)
+{
+    InstancingData& tInstancing = mInstancing;
+    tInstancing.mDepthBatches.clear();
+    tInstancing.mSceneBatches.clear();
+    tInstancing.mSceneLateBatches.clear();
+
+    // Every queue item takes one transform at most
+    const auto& tItems = mRenderQueue.GetItems();
+    ReserveInstances(aFrameIndex, tItems.size());
+
+    // The buffer of this frame may have been reallocated above, so the sets are written fresh from this frame's transient pools
+    const DescriptorInfo tDescriptor(tInstancing.mBuffers[aFrameIndex]->mBuffer);
+    tInstancing.mSceneSet = Renderer::AllocateTransientDescriptorSet(mRenderContext, mDescriptorAllocator, mRootSignatureScene->mDescriptorSetLayouts[3]);
+    tInstancing.mDepthSet = Renderer::AllocateTransientDescriptorSet(mRenderContext, mDescriptorAllocator, mDepthOnlypass.mRootSignatureDepthOnly->mDescriptorSetLayouts[1]);
+    Renderer::UpdateDescriptorSet(mRenderContext, mRootSignatureScene, 3, tInstancing.mSceneSet, &tDescriptor, 1);
+    Renderer::UpdateDescriptorSet(mRenderContext, mDepthOnlypass.mRootSignatureDepthOnly, 1, tInstancing.mDepthSet, &tDescriptor, 1);
+
+    void* data;
+    vmaMapMemory(mRenderContext->memoryAllocator, tInstancing.mBuffers[aFrameIndex]->mAllocation, &data);
+    glm::mat4* tTransforms = static_cast<glm::mat4*>(data);
+    uint32_t tInstanceCount = 0;
+
+    // The queue sorts by mesh within the depth pass and by pipeline, material and mesh within the scene pass, so objects
+    // that can share a draw are neighbours, the handles are compared since the ids in the keys may be truncated
+    const std::pair<size_t, size_t> tDepthRange = mRenderQueue.GetPassRange(RENDER_QUEUE_PASS_DEPTH);
+    for (size_t itemIndex = tDepthRange.first; itemIndex < tDepthRange.second; ++itemIndex)
+    {
+        const uint32_t objectIndex = tItems[itemIndex].mObjectIndex;
+        const auto& object = aSceneObjects[objectIndex];
 
-    VkSemaphoreCreateInfo semaphoreInfo{};
-    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        if (!tInstancing.mDepthBatches.empty() && aSceneObjects[tInstancing.mDepthBatches.back().mObjectIndex]->mMesh == object->mMesh)
+        {
+            tInstancing.mDepthBatches.back().mInstanceCount++;
+        }
+        else
+        {
+            tInstancing.mDepthBatches.push_back({ objectIndex, 1, tInstanceCount });
+        }
 
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        tTransforms[tInstanceCount++] = object->transform;
+    }
 
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (vkCreateSemaphore(mRenderContext->mDevice->mDevice, &semaphoreInfo, nullptr, &imageAvailableSemaphores[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(mRenderContext->mDevice->mDevice, &semaphoreInfo, nullptr, &renderFinishedSemaphores[i]) != VK_SUCCESS ||
-            vkCreateFence(mRenderContext->mDevice->mDevice, &fenceInfo, nullptr, &inFlightFences[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create synchronization objects for a frame!");
+    // Bindless objects select their transform and material in the object buffer, they keep a draw each
+    std::optional<uint32_t> tBatchPipeline;
+    const std::pair<size_t, size_t> tSceneRange = mRenderQueue.GetPassRange(RENDER_QUEUE_PASS_SCENE);
+    for (size_t itemIndex = tSceneRange.first; itemIndex < tSceneRange.second; ++itemIndex)
+    {
+        const uint32_t objectIndex = tItems[itemIndex].mObjectIndex;
+        const auto& object = aSceneObjects[objectIndex];
+
+        if (DrawsObjectBindless(*object, objectIndex))
+        {
+            tInstancing.mSceneBatches.push_back({ objectIndex, 1, objectIndex });
+            tBatchPipeline = std::nullopt;
+            continue;
+        }
+
+        const std::optional<uint32_t> tPipelineIndex = GetDrawPipeline(object->mRenderState);
+        const iSceneObject* tBatchObject = tBatchPipeline.has_value() ? aSceneObjects[tInstancing.mSceneBatches.back().mObjectIndex].get() : nullptr;
+
+        if (tBatchObject != nullptr && tBatchPipeline == tPipelineIndex && tBatchObject->mMesh == object->mMesh && tBatchObject->mMaterial->mDescriptorSet == object->mMaterial->mDescriptorSet)
+        {
+            tInstancing.mSceneBatches.back().mInstanceCount++;
+        }
+        else
+        {
+            tInstancing.mSceneBatches.push_back({ objectIndex, 1, tInstanceCount });
+            tBatchPipeline = tPipelineIndex;
         }
+
+        tTransforms[tInstanceCount++] = object->transform;
     }
+
+    // The late test decides the instance count of every candidate, so its indirect draw carries the first instance
+    const std::pair<size_t, size_t> tLateRange = mRenderQueue.GetPassRange(RENDER_QUEUE_PASS_SCENE_LATE);
+    for (size_t itemIndex = tLateRange.first; itemIndex < tLateRange.second; ++itemIndex)
+    {
+        const uint32_t objectIndex = tItems[itemIndex].mObjectIndex;
+        const auto& object = aSceneObjects[objectIndex];
+
+        if (DrawsObjectBindless(*object, objectIndex))
+        {
+            tInstancing.mSceneLateBatches.push_back({ objectIndex, 1, objectIndex });
+            continue;
+        }
+
+        mOcclusionCulling.mHiZ->SetCandidateFirstInstance(mOcclusionCulling.mCandidateSlots[objectIndex], tInstanceCount);
+        tInstancing.mSceneLateBatches.push_back({ objectIndex, 1, tInstanceCount });
+        tTransforms[tInstanceCount++] = object->transform;
+    }
+
+    vmaUnmapMemory(mRenderContext->memoryAllocator, tInstancing.mBuffers[aFrameIndex]->mAllocation);
+
+    tInstancing.mInstanceCount = tInstanceCount;
 }
 
 void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
 
+    FLUX_PROFILE_FUNCTION();
+
     VmaStats stats{};
 
     vmaCalculateStats(mRenderContext->memoryAllocator, &stats);
@@ -952,10 +1832,20 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
     {
         // Start the Dear ImGui frame
         ImGui_ImplVulkan_NewFrame();
-        ImGui_ImplGlfw_NewFrame();
+        if (IsHeadless())
+        {
+            ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+        }
+        else
+        {
+            ImGui_ImplGlfw_NewFrame();
+        }
         ImGui::NewFrame();
     }
 
+    // Pick up pipelines that finished compiling since last frame
+    CollectCompiledPipelines();
+
     // Prepare scene resources
     auto& tSceneObjects = aScene->GetSceneObjects();
 
@@ -1045,89 +1935,6 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
             auto queryResultMaterial = mResourceManager->QueryMaterialAssetRegistered(object->mMaterial);
             if (!queryResultMaterial)
             {
-                std::vector<VkDescriptorSetLayout> layouts = { mRootSignatureScene->mDescriptorSetLayouts[1] };
-                VkDescriptorSetAllocateInfo allocInfo{};
-                allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-                allocInfo.descriptorPool = mDescriptorPool->mPool;
-                allocInfo.descriptorSetCount = 1;
-                allocInfo.pSetLayouts = layouts.data();
-
-                std::vector<VkDescriptorSet> mSet = { object->mMaterial->mDescriptorSet };
-                if (vkAllocateDescriptorSets(mRenderContext->mDevice->mDevice, &allocInfo, mSet.data()) != VK_SUCCESS)
-                {
-                    throw std::runtime_error("Failed to allocate descriptor sets!");
-                }
-
-
-				VkDescriptorImageInfo albedoImage{};
-                albedoImage.imageView = object->mMaterial->mTextureAlbedo->mView;
-                albedoImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-                VkDescriptorImageInfo specularImage{};
-                specularImage.imageView = object->mMaterial->mTextureSpecular->mView;
-                specularImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-                VkDescriptorImageInfo normalImage{};
-                normalImage.imageView = object->mMaterial->mTextureNormal->mView;
-                normalImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-                VkDescriptorImageInfo emptyImage{};
-                emptyImage.imageView = mEmptyTexture->mView;
-                emptyImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-
-                VkDescriptorImageInfo samplerInfo{};
-                samplerInfo.sampler = textureSampler;
-
-                VkDescriptorImageInfo samplerInfoShadow{};
-                samplerInfoShadow.sampler = pointSampler;
-
-				std::array<VkWriteDescriptorSet, 5> descriptorWrites{};
-
-				descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptorWrites[0].dstSet = mSet[0];
-				descriptorWrites[0].dstBinding = 0;
-				descriptorWrites[0].dstArrayElement = 0;
-				descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-				descriptorWrites[0].descriptorCount = 1;
-				descriptorWrites[0].pImageInfo = &albedoImage;
-
-                descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[1].dstSet = mSet[0];
-                descriptorWrites[1].dstBinding = 1;
-                descriptorWrites[1].dstArrayElement = 0;
-                descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-                descriptorWrites[1].descriptorCount = 1;
-                descriptorWrites[1].pImageInfo = &specularImage;
-
-                descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[2].dstSet = mSet[0];
-                descriptorWrites[2].dstBinding = 2;
-                descriptorWrites[2].dstArrayElement = 0;
-                descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-                descriptorWrites[2].descriptorCount = 1;
-                descriptorWrites[2].pImageInfo = &normalImage;
-
-				descriptorWrites[3].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				descriptorWrites[3].dstSet = mSet[0];
-				descriptorWrites[3].dstBinding = 3;
-				descriptorWrites[3].dstArrayElement = 0;
-				descriptorWrites[3].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-				descriptorWrites[3].descriptorCount = 1;
-                descriptorWrites[3].pImageInfo = &samplerInfo;
-
-                descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[4].dstSet = mSet[0];
-                descriptorWrites[4].dstBinding = 4;
-                descriptorWrites[4].dstArrayElement = 0;
-                descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-                descriptorWrites[4].descriptorCount = 1;
-                descriptorWrites[4].pImageInfo = &samplerInfoShadow;
-
-				vkUpdateDescriptorSets(mRenderContext->mDevice->mDevice, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-                object->mMaterial->mDescriptorSet = mSet[0];
-
-                //TODO DELETE ALLOCATED DESCRIPTOR SETS
                 mResourceManager->RegisterMaterial(object->mMaterial);
             }
             else
@@ -1136,62 +1943,230 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
             }
         }
 
+        // Bindless objects only need their material registered in the material buffer, the others use a set per material
+        if (object->mMaterial->mTextureAlbedo != nullptr)
+        {
+            if (DrawsBindless(object->mRenderState))
+            {
+                mBindless.mMaterials->RegisterMaterial(*object->mMaterial);
+            }
+            else if (object->mMaterial->mDescriptorSet == VK_NULL_HANDLE)
+            {
+                CreateMaterialDescriptorSet(*object->mMaterial);
+            }
+        }
+
+        // The meshes of bindless objects are merged into the GPU scene, which draws them without the render queue
+        if (mGpuDriven.mScene != nullptr && object->mMesh != nullptr && !object->mMesh->mGpuSceneMesh.has_value() && DrawsBindless(object->mRenderState))
+        {
+            object->mMesh->mGpuSceneMesh = mGpuDriven.mScene->RegisterMesh(object->mAsset);
+        }
+
 
         if (!object->mRenderState.stateID.has_value())
         {
-            object->mRenderState.stateID = std::optional(CreatePipeline(object->mRenderState));
+            // Shaders may have been added without AddShader, so make sure the key is current before the lookup
+            object->mRenderState.UpdateHash();
+            object->mRenderState.stateID = QueryPipeline(object->mRenderState);
+
+            // Compiled in the background, the object is skipped or drawn with the fallback until it is done
+            if (!object->mRenderState.stateID.has_value())
+            {
+                RequestPipeline(object->mRenderState);
+            }
         }
 
     }
 
-    vkWaitForFences(mRenderContext->mDevice->mDevice, 1, &inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    // Only does work when meshes were added, frames in flight are waited on before the merged buffers are replaced
+    if (mGpuDriven.mScene != nullptr)
+    {
+        mGpuDriven.mScene->UploadGeometry(mQueueGraphics->mVkQueue, commandPool);
+    }
 
-    uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(mRenderContext->mDevice->mDevice, mSwapchain->mSwapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    // Every per frame resource is indexed by the frame in flight, its fence is the only wait needed before reusing them
+    const uint32_t frameIndex = mFrameIndex;
+    FrameContext& tFrame = mFrames[frameIndex];
+    {
+        FLUX_PROFILE_ZONE("Wait for frame");
+        vkWaitForFences(mRenderContext->mDevice->mDevice, 1, &tFrame.mInFlight, VK_TRUE, UINT64_MAX);
+    }
+    CollectFrameLatencies();
+    ReadQueryResults(frameIndex);
+    ReadFrameBack(frameIndex);
+    mProfiling.mGpu->Collect(frameIndex);
+
+    // The GPU is done with this frame, so its transient descriptor sets can be recycled
+    Renderer::BeginDescriptorAllocatorFrame(mRenderContext, mDescriptorAllocator, frameIndex);
+    FreeRetiredMaterialSets(tFrame);
+    ReleaseUnusedMaterials(tFrame);
+
+    // Headless frames render into the offscreen image of their frame in flight, its fence was waited on above
+    uint32_t imageIndex = frameIndex;
+    VkResult result = VK_SUCCESS;
+    if (!IsHeadless())
+    {
+        result = vkAcquireNextImageKHR(mRenderContext->mDevice->mDevice, mSwapchain->mSwapChain, UINT64_MAX, tFrame.mImageAvailable, VK_NULL_HANDLE, &imageIndex);
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-        RecreateSwapChain();
-        return;
+        if (result == VK_ERROR_OUT_OF_DATE_KHR) {
+            RecreateSwapChain();
+            return;
+        }
+        else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
+            throw std::runtime_error("failed to acquire swap chain image!");
+        }
+    }
+
+    // The last submission of this frame is done, so its command buffers can be recorded again
+    if (vkResetCommandPool(mRenderContext->mDevice->mDevice, tFrame.mCommandPool, 0) != VK_SUCCESS) {
+        throw std::runtime_error("failed to reset command pool!");
     }
-    else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
-        throw std::runtime_error("failed to acquire swap chain image!");
+    mCommandRecorder->BeginFrame(frameIndex);
+
+    // Also done with the depth pyramid readback and the occlusion stats of that submission
+    mOcclusionCulling.mHiZ->BeginFrame(frameIndex);
+    if (mGpuDriven.mScene != nullptr)
+    {
+        mOcclusionCulling.mGpuStats = mGpuDriven.mScene->ReadOcclusionStats(frameIndex);
     }
 
-    if (imagesInFlight[imageIndex] != VK_NULL_HANDLE) {
-        vkWaitForFences(mRenderContext->mDevice->mDevice, 1, &imagesInFlight[imageIndex], VK_TRUE, UINT64_MAX);
+    // The same images are handed out every frame, they are only recreated after a resize
+    if (AcquireRenderTargets())
+    {
+        UpdatePostfxDescriptorSet();
+        UpdateShadowDescriptorSets();
+        UpdateOcclusionCullingTargets();
     }
-    imagesInFlight[imageIndex] = inFlightFences[currentFrame];
 
-    UpdateUniformBuffer(imageIndex, aScene->GetCamera(), aScene->GetLights());
+    UpdateUniformBuffer(frameIndex, aScene->GetCamera(), aScene->GetLights());
+
+    // Needs the light matrix written by UpdateUniformBuffer
+    CullObjects(tSceneObjects, aScene->GetCamera());
+    BuildRenderQueue(tSceneObjects, aScene->GetCamera());
+    BuildInstanceBatches(tSceneObjects, frameIndex);
+    mOcclusionCulling.mHiZ->UploadCandidates(frameIndex);
+    std::mutex tBindStatsMutex;
+
+    const glm::mat4 tCameraViewProjection = aScene->GetCamera()->GetProjectionMatrix() * aScene->GetCamera()->GetViewMatrix();
+
+    // Object data for the bindless path, an object's index is its position in the scene object list
+    // This copy is the only per object work left for GPU-driven objects, culling and draw generation happen on the GPU
+    mGpuDriven.mObjectCount = 0;
+    if (mBindless.mMaterials != nullptr)
+    {
+        void* data;
+        vmaMapMemory(mRenderContext->memoryAllocator, mBindless.mObjectBuffers[frameIndex]->mAllocation, &data);
+
+        BindlessObjectData* tObjects = static_cast<BindlessObjectData*>(data);
+        const size_t tObjectCount = std::min(tSceneObjects.size(), static_cast<size_t>(MAX_BINDLESS_OBJECTS));
+        for (size_t i = 0; i < tObjectCount; ++i)
+        {
+            const auto& object = tSceneObjects[i];
+            const bool tGpuDriven = DrawsObjectGpuDriven(*object, i);
+
+            tObjects[i].mModel = object->transform;
+            tObjects[i].mMeshIndex = tGpuDriven ? object->mMesh->mGpuSceneMesh.value() : INVALID_GPU_SCENE_MESH;
+            tObjects[i].mMaterialIndex = object->mMaterial->mBindlessIndex.value_or(0);
+
+            mGpuDriven.mObjectCount += tGpuDriven ? 1 : 0;
+        }
+
+        vmaUnmapMemory(mRenderContext->memoryAllocator, mBindless.mObjectBuffers[frameIndex]->mAllocation);
+
+        if (DrawsGpuDriven())
+        {
+            // The pyramid still holds the depth of the previous frame when the culling pass runs
+            GpuSceneOcclusion tOcclusion{};
+            tOcclusion.mViewProjection = mOcclusionCulling.mHiZ->GetViewProjection();
+            tOcclusion.mPyramidSize = glm::vec2(static_cast<float>(mOcclusionCulling.mHiZ->GetWidth()), static_cast<float>(mOcclusionCulling.mHiZ->GetHeight()));
+            tOcclusion.mPyramidLevels = mOcclusionCulling.mHiZ->GetLevelCount();
+            tOcclusion.mEnabled = mOcclusionCulling.mEnabled && mOcclusionCulling.mHiZ->HasPyramid();
+
+            mGpuDriven.mScene->UpdateCullData(frameIndex, tCameraViewProjection, mDepthOnlypass.mLightMatrix, static_cast<uint32_t>(tObjectCount), tOcclusion);
+        }
+    }
 
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    vkResetCommandBuffer(commandBuffers[imageIndex], 0);
-    if (vkBeginCommandBuffer(commandBuffers[imageIndex], &beginInfo) != VK_SUCCESS) {
+    if (vkBeginCommandBuffer(tFrame.mCommandBuffer, &beginInfo) != VK_SUCCESS) {
         throw std::runtime_error("failed to begin recording command buffer!");
     }
 
-    vkCmdResetQueryPool(commandBuffers[imageIndex], mQueryPool, 0, 1);
-
+    // Statistics queries of this frame, each measured pass begins and ends its own
+    const uint32_t tFirstQuery = frameIndex * STATISTICS_PASS_COUNT;
+    vkCmdResetQueryPool(tFrame.mCommandBuffer, mQueryPool, tFirstQuery, STATISTICS_PASS_COUNT);
+    mProfiling.mGpu->BeginFrame(tFrame.mCommandBuffer, frameIndex);
 
+    // Images are imported every frame, the render targets and swapchain images change when the swapchain is recreated
+    mFrameGraph.Reset();
+    {
+        FrameGraphImageDesc tShadowDepth{};
+        tShadowDepth.mImage = mDepthOnlypass.mRenderTargetDepth->mDepthImage->mImage;
+        tShadowDepth.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        tShadowDepth.mMemory = Renderer::GetTransientImageMemory(mTransientPool, mTransientTargets.mShadowDepth);
+        mFrameGraph.ImportImage("ShadowDepth", tShadowDepth);
+
+        FrameGraphImageDesc tSceneColor{};
+        tSceneColor.mImage = mRenderTargetScene->mColorImages[0]->mImage;
+        tSceneColor.mMemory = Renderer::GetTransientImageMemory(mTransientPool, mTransientTargets.mSceneColor);
+        mFrameGraph.ImportImage("SceneColor", tSceneColor);
+
+        FrameGraphImageDesc tSceneDepth{};
+        tSceneDepth.mImage = mRenderTargetScene->mDepthImage->mImage;
+        tSceneDepth.mAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        tSceneDepth.mMemory = Renderer::GetTransientImageMemory(mTransientPool, mTransientTargets.mSceneDepth);
+        mFrameGraph.ImportImage("SceneDepth", tSceneDepth);
+
+        FrameGraphImageDesc tFinal{};
+        tFinal.mImage = mRenderTargetFinal->mColorImages[0]->mImage;
+        tFinal.mMemory = Renderer::GetTransientImageMemory(mTransientPool, mTransientTargets.mFinal);
+        mFrameGraph.ImportImage("Final", tFinal);
+
+        // Owned by the occlusion culling, the culling pass reads the pyramid of the previous frame before it is rebuilt
+        FrameGraphImageDesc tDepthPyramid{};
+        tDepthPyramid.mImage = mOcclusionCulling.mHiZ->GetImage();
+        tDepthPyramid.mPreserveContents = true;
+        mFrameGraph.ImportImage("DepthPyramid", tDepthPyramid);
+
+        // The first barrier on the swapchain image chains with the acquire semaphore wait
+        // Offscreen images continue from their last frame and end up ready to be copied, the present layout needs the swapchain extension
+        FrameGraphImageDesc tSwapchain{};
+        tSwapchain.mImage = mSwapchain->mImages[imageIndex];
+        if (IsHeadless())
+        {
+            tSwapchain.mFinalAccess = ResourceAccess::eTransferRead;
+        }
+        else
+        {
+            tSwapchain.mInitialAccess = ResourceAccess::eAcquire;
+            tSwapchain.mFinalAccess = ResourceAccess::ePresent;
+        }
+        mFrameGraph.ImportImage("Swapchain", tSwapchain);
+    }
 
-    vkCmdBeginQuery(commandBuffers[imageIndex], mQueryPool, 0, 0);
-    if (frame >= 2)
+    // The passes run when the graph is executed, after the debug UI below has been built
+    // The culling pass only writes buffers, which the graph does not track, so it orders its own writes before the draws
+    const bool tGpuDriven = DrawsGpuDriven();
+    if (tGpuDriven)
     {
-        Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-            mDepthOnlypass.mRenderTargetDepth->mDepthImage->mImage, mDepthOnlypass.mRenderTargetDepth->mDepthImage->mFormat,
-            VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, 1, commandBuffers[imageIndex], VK_IMAGE_ASPECT_DEPTH_BIT);
+        mFrameGraph.AddPass("Cull", [&](VkCommandBuffer aPrimary)
+        {
+            mGpuDriven.mScene->RecordCulling(aPrimary, frameIndex);
+        })
+            .Read("DepthPyramid", ResourceAccess::eComputeStorageRead)
+            .SetSideEffects();
     }
 
-    // Depth pass
+    mFrameGraph.AddPass("Depth", [&](VkCommandBuffer aPrimary)
     {
-		VkRenderPassBeginInfo renderPassInfo{};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-		renderPassInfo.renderPass = mDepthOnlypass.mRenderTargetDepth->mPass;
-		renderPassInfo.framebuffer = mDepthOnlypass.mRenderTargetDepth->mFramebuffer;
-		renderPassInfo.renderArea.offset = { 0, 0 };
-		renderPassInfo.renderArea.extent = { 8096, 8096 };
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = mDepthOnlypass.mRenderTargetDepth->mPass;
+        renderPassInfo.framebuffer = mDepthOnlypass.mRenderTargetDepth->mFramebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = { mDepthOnlypass.mRenderTargetDepth->mWidth, mDepthOnlypass.mRenderTargetDepth->mHeight };
 
         std::array<VkClearValue, 1> clearValues{};
         clearValues[0].depthStencil = { 1.0f, 0 };
@@ -1199,178 +2174,369 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
-		vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Objects without a pipeline are not in the queue, objects sharing a mesh are drawn as one batch
+        // The GPU-driven draws are recorded as one extra item after the batches
+        const std::vector<InstanceBatch>& tDepthBatches = mInstancing.mDepthBatches;
+        const size_t tDepthQueueCount = tDepthBatches.size();
+        BindStats tDepthBindStats;
 
-		vkCmdBindPipeline(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, mDepthOnlypass.mGraphicsPipeline->pipeline);
-
-		for (auto& object : aScene->GetSceneObjects())
-		{
-			// If object contains no render state, can not render.
-			if (!object->mRenderState.stateID.has_value())
-			{
-				continue;
-			}
+        vkCmdBeginQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SHADOW, 0);
+        mCommandRecorder->RecordPass(aPrimary, renderPassInfo, PIPELINE_STATISTICS, tDepthQueueCount + (tGpuDriven ? 1 : 0), [&](VkCommandBuffer aCommandBuffer, size_t aBegin, size_t aEnd)
+        {
+            SetViewportAndScissor(aCommandBuffer, mDepthOnlypass.mRenderTargetDepth->mWidth, mDepthOnlypass.mRenderTargetDepth->mHeight);
 
-			if (!QueryPipeline(object->mRenderState))
-			{
-				object->mRenderState.stateID = std::nullopt;
-				continue;
-			}
+            BindStats tRangeBindStats;
 
+            vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mDepthOnlypass.mGraphicsPipeline->pipeline);
+            tRangeBindStats.mPipelineBinds++;
 
-			std::vector<VkDescriptorSet> objectSets = { mDepthOnlypass.descriptorSetShadowTexture[imageIndex] };
-			vkCmdBindDescriptorSets(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, mDepthOnlypass.mRootSignatureDepthOnly->mPipelineLayout, 0, objectSets.size(), objectSets.data(), 0, nullptr);
+            // Same pipeline and sets for every object, bind once
+            std::array<VkDescriptorSet, 2> tDepthSets = { mDepthOnlypass.descriptorSetShadowTexture[frameIndex], mInstancing.mDepthSet };
+            vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mDepthOnlypass.mRootSignatureDepthOnly->mPipelineLayout, 0, static_cast<uint32_t>(tDepthSets.size()), tDepthSets.data(), 0, nullptr);
+            tRangeBindStats.mDescriptorSetBinds++;
 
-			VkBuffer vertexBuffers[] = { object->mMesh->mVertexBuffer->mBuffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffers[imageIndex], 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(commandBuffers[imageIndex], object->mMesh->mIndexBuffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+            VkBuffer tBoundVertexBuffer = VK_NULL_HANDLE;
+            VkBuffer tBoundIndexBuffer = VK_NULL_HANDLE;
 
-			vkCmdPushConstants(
-				commandBuffers[imageIndex],
-				mDepthOnlypass.mRootSignatureDepthOnly->mPipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT,
-				0,
-				sizeof(glm::mat4),
-				&object->transform);
+            for (size_t batchIndex = aBegin; batchIndex < std::min(aEnd, tDepthQueueCount); ++batchIndex)
+            {
+                const InstanceBatch& tBatch = tDepthBatches[batchIndex];
+                const auto& object = tSceneObjects[tBatch.mObjectIndex];
 
-			vkCmdDrawIndexed(commandBuffers[imageIndex], static_cast<uint32_t>(object->mAsset->mIndices.size()), 1, 0, 0, 0);
-		}
-    }
+                if (object->mMesh->mVertexBuffer->mBuffer != tBoundVertexBuffer)
+                {
+                    VkBuffer vertexBuffers[] = { object->mMesh->mVertexBuffer->mBuffer };
+                    VkDeviceSize offsets[] = { 0 };
+                    vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, vertexBuffers, offsets);
+                    tBoundVertexBuffer = vertexBuffers[0];
+                    tRangeBindStats.mVertexBufferBinds++;
+                }
 
-    vkCmdEndRenderPass(commandBuffers[imageIndex]);
+                if (object->mMesh->mIndexBuffer->mBuffer != tBoundIndexBuffer)
+                {
+                    vkCmdBindIndexBuffer(aCommandBuffer, object->mMesh->mIndexBuffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+                    tBoundIndexBuffer = object->mMesh->mIndexBuffer->mBuffer;
+                    tRangeBindStats.mIndexBufferBinds++;
+                }
 
+                vkCmdDrawIndexed(aCommandBuffer, static_cast<uint32_t>(object->mAsset->mIndices.size()), tBatch.mInstanceCount, 0, 0, tBatch.mFirstInstance);
+                tRangeBindStats.mDraws++;
+            }
 
+            if (tGpuDriven && aEnd > tDepthQueueCount)
+            {
+                vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGpuDriven.mDepthPipeline->pipeline);
 
+                std::array<VkDescriptorSet, 2> tSets = { mDepthOnlypass.descriptorSetShadowTexture[frameIndex], mGpuDriven.mDepthObjectSets[frameIndex] };
+                vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mGpuDriven.mDepthRootSignature->mPipelineLayout, 0, static_cast<uint32_t>(tSets.size()), tSets.data(), 0, nullptr);
 
-    Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-        mDepthOnlypass.mRenderTargetDepth->mDepthImage->mImage, mDepthOnlypass.mRenderTargetDepth->mDepthImage->mFormat,
-        VkImageLayout::VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VkImageLayout::VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1, commandBuffers[imageIndex], VK_IMAGE_ASPECT_DEPTH_BIT);
+                mGpuDriven.mScene->RecordDraws(aCommandBuffer, frameIndex, GpuSceneView::eShadow);
 
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = mRenderTargetScene->mPass;
-    renderPassInfo.framebuffer = mRenderTargetScene->mFramebuffer;
-    renderPassInfo.renderArea.offset = { 0, 0 };
-    renderPassInfo.renderArea.extent = mSwapchain->mExtent;
+                tRangeBindStats.mPipelineBinds++;
+                tRangeBindStats.mDescriptorSetBinds++;
+                tRangeBindStats.mVertexBufferBinds++;
+                tRangeBindStats.mIndexBufferBinds++;
+                tRangeBindStats.mDraws++;
+            }
 
-    std::array<VkClearValue, 2> clearValues{};
-    clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-    clearValues[1].depthStencil = { 1.0f, 0 };
+            std::lock_guard<std::mutex> tLock(tBindStatsMutex);
+            tDepthBindStats += tRangeBindStats;
+        });
+        vkCmdEndQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SHADOW);
 
-    renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-    renderPassInfo.pClearValues = clearValues.data();
+        mDepthBindStats = tDepthBindStats;
+    })
+        .Write("ShadowDepth", ResourceAccess::eDepthAttachment);
 
-    if (frame <= 2)
-    {
-        Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-            mSwapchain->mImages[imageIndex],
-            mSwapchain->mImageFormat, VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, 1, commandBuffers[imageIndex]);
-    }
-    else
+    // Shared by the scene pass and the late scene pass, which draws the objects the occlusion test rejected in the same way
+    // Late objects recorded on the CPU take the indirect draw the late test wrote their instance count into
+    const auto tRecordScene = [&](VkCommandBuffer aPrimary, const std::shared_ptr<RenderTarget>& aRenderTarget, const std::vector<InstanceBatch>& aBatches, bool aLate, GpuSceneView aGpuView)
     {
-        Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-            mSwapchain->mImages[imageIndex],
-            mSwapchain->mImageFormat, VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, 1, commandBuffers[imageIndex]);
-    }
+        VkRenderPassBeginInfo renderPassInfo{};
+        renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassInfo.renderPass = aRenderTarget->mPass;
+        renderPassInfo.framebuffer = aRenderTarget->mFramebuffer;
+        renderPassInfo.renderArea.offset = { 0, 0 };
+        renderPassInfo.renderArea.extent = mSwapchain->mExtent;
 
+        std::array<VkClearValue, 2> clearValues{};
+        clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
+        clearValues[1].depthStencil = { 1.0f, 0 };
 
+        renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+        renderPassInfo.pClearValues = clearValues.data();
 
-    vkCmdBeginRenderPass(commandBuffers[imageIndex], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        // Pipeline layouts are shared between root signatures with identical bindings, so after switching to a pipeline
+        // with the same layout the bound sets are still valid and only the material set has to change
+        // Bindless objects never change sets, the first instance selects their transform and material in the object buffer
+        // The other objects select their transforms in the instance buffer the same way
+        // Every secondary command buffer starts without anything bound
+        const size_t tSceneQueueCount = aBatches.size();
+        BindStats tSceneBindStats;
 
-    for (auto& object : aScene->GetSceneObjects())
-    {
-        // If object contains no render state, can not render.
-        if (!object->mRenderState.stateID.has_value())
+        mCommandRecorder->RecordPass(aPrimary, renderPassInfo, PIPELINE_STATISTICS, tSceneQueueCount + (tGpuDriven ? 1 : 0), [&](VkCommandBuffer aCommandBuffer, size_t aBegin, size_t aEnd)
         {
-            continue;
-        }
+            SetViewportAndScissor(aCommandBuffer, aRenderTarget->mWidth, aRenderTarget->mHeight);
 
-        if (!QueryPipeline(object->mRenderState))
-        {
-            object->mRenderState.stateID = std::nullopt;
-            continue;
-        }
+            VkPipeline tBoundPipeline = VK_NULL_HANDLE;
+            VkPipelineLayout tBoundPipelineLayout = VK_NULL_HANDLE;
+            VkDescriptorSet tBoundMaterialSet = VK_NULL_HANDLE;
+            VkBuffer tBoundVertexBuffer = VK_NULL_HANDLE;
+            VkBuffer tBoundIndexBuffer = VK_NULL_HANDLE;
+            BindStats tRangeBindStats;
+
+            for (size_t batchIndex = aBegin; batchIndex < std::min(aEnd, tSceneQueueCount); ++batchIndex)
+            {
+                const InstanceBatch& tBatch = aBatches[batchIndex];
+                const size_t objectIndex = tBatch.mObjectIndex;
+                const auto& object = tSceneObjects[objectIndex];
 
+                const bool tBindless = DrawsObjectBindless(*object, objectIndex);
 
-        vkCmdBindPipeline(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, this->mPipelines[object->mRenderState.stateID.value()].second->pipeline);
-        std::vector<VkDescriptorSet> objectSets = { descriptorSetsSceneObjects[imageIndex], object->mMaterial->mDescriptorSet, mDepthOnlypass.descriptorSet[imageIndex] };
-        vkCmdBindDescriptorSets(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_GRAPHICS, this->mPipelines[object->mRenderState.stateID.value()].second->mRootSignature.lock()->mPipelineLayout, 0, objectSets.size(), objectSets.data(), 0, nullptr);
+                // Only objects with a pipeline are queued
+                const std::optional<uint32_t> tPipelineIndex = tBindless ? mBindless.mPipelineIndex : GetDrawPipeline(object->mRenderState);
+                assert(tPipelineIndex.has_value());
 
-        VkBuffer vertexBuffers[] = { object->mMesh->mVertexBuffer->mBuffer };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffers[imageIndex], 0, 1, vertexBuffers, offsets);
-        vkCmdBindIndexBuffer(commandBuffers[imageIndex], object->mMesh->mIndexBuffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+                const auto& tPipeline = this->mPipelines[tPipelineIndex.value()].second;
+                const VkPipelineLayout tPipelineLayout = tPipeline->mRootSignature.lock()->mPipelineLayout;
+                const VkDescriptorSet tMaterialSet = tBindless ? mBindless.mMaterials->GetDescriptorSet() : object->mMaterial->mDescriptorSet;
 
-        vkCmdPushConstants(
-            commandBuffers[imageIndex],
-            this->mPipelines[object->mRenderState.stateID.value()].second->mRootSignature.lock()->mPipelineLayout,
-            VK_SHADER_STAGE_VERTEX_BIT,
-            0,
-            sizeof(glm::mat4),
-            &object->transform);
+                if (tPipeline->pipeline != tBoundPipeline)
+                {
+                    vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tPipeline->pipeline);
+                    tBoundPipeline = tPipeline->pipeline;
+                    tRangeBindStats.mPipelineBinds++;
+                }
 
-        vkCmdDrawIndexed(commandBuffers[imageIndex], static_cast<uint32_t>(object->mAsset->mIndices.size()), 1, 0, 0, 0);
+                if (tPipelineLayout != tBoundPipelineLayout)
+                {
+                    if (tBindless)
+                    {
+                        std::array<VkDescriptorSet, 4> objectSets = { descriptorSetsSceneObjects[frameIndex], tMaterialSet, mDepthOnlypass.descriptorSet[frameIndex], mBindless.mObjectSets[frameIndex] };
+                        vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tPipelineLayout, 0, static_cast<uint32_t>(objectSets.size()), objectSets.data(), 0, nullptr);
+                    }
+                    else
+                    {
+                        std::array<VkDescriptorSet, 4> objectSets = { descriptorSetsSceneObjects[frameIndex], tMaterialSet, mDepthOnlypass.descriptorSet[frameIndex], mInstancing.mSceneSet };
+                        vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tPipelineLayout, 0, static_cast<uint32_t>(objectSets.size()), objectSets.data(), 0, nullptr);
+                    }
+
+                    tBoundPipelineLayout = tPipelineLayout;
+                    tBoundMaterialSet = tMaterialSet;
+                    tRangeBindStats.mDescriptorSetBinds++;
+                }
+                else if (tMaterialSet != tBoundMaterialSet)
+                {
+                    vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tPipelineLayout, 1, 1, &tMaterialSet, 0, nullptr);
+                    tBoundMaterialSet = tMaterialSet;
+                    tRangeBindStats.mDescriptorSetBinds++;
+                }
 
-    }
+                if (object->mMesh->mVertexBuffer->mBuffer != tBoundVertexBuffer)
+                {
+                    VkBuffer vertexBuffers[] = { object->mMesh->mVertexBuffer->mBuffer };
+                    VkDeviceSize offsets[] = { 0 };
+                    vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, vertexBuffers, offsets);
+                    tBoundVertexBuffer = vertexBuffers[0];
+                    tRangeBindStats.mVertexBufferBinds++;
+                }
 
-    vkCmdEndRenderPass(commandBuffers[imageIndex]);
+                if (object->mMesh->mIndexBuffer->mBuffer != tBoundIndexBuffer)
+                {
+                    vkCmdBindIndexBuffer(aCommandBuffer, object->mMesh->mIndexBuffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+                    tBoundIndexBuffer = object->mMesh->mIndexBuffer->mBuffer;
+                    tRangeBindStats.mIndexBufferBinds++;
+                }
 
-    Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-        mRenderTargetScene->mColorImages[0]->mImage, mRenderTargetScene->mColorImages[0]->mFormat,
-        VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, 1, commandBuffers[imageIndex]);
+                if (aLate)
+                {
+                    const VkDeviceSize tOffset = sizeof(VkDrawIndexedIndirectCommand) * mOcclusionCulling.mCandidateSlots[objectIndex];
+                    vkCmdDrawIndexedIndirect(aCommandBuffer, mOcclusionCulling.mHiZ->GetCandidateDraws(frameIndex), tOffset, 1, sizeof(VkDrawIndexedIndirectCommand));
+                }
+                else
+                {
+                    vkCmdDrawIndexed(aCommandBuffer, static_cast<uint32_t>(object->mAsset->mIndices.size()), tBatch.mInstanceCount, 0, 0, tBatch.mFirstInstance);
+                }
+                tRangeBindStats.mDraws++;
+            }
 
-    Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool,
-        mRenderTargetFinal->mColorImages[0]->mImage, mRenderTargetFinal->mColorImages[0]->mFormat,
-        VkImageLayout::VK_IMAGE_LAYOUT_UNDEFINED, VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, 1, commandBuffers[imageIndex]);
+            if (tGpuDriven && aEnd > tSceneQueueCount)
+            {
+                const auto& tPipeline = this->mPipelines[mBindless.mPipelineIndex.value()].second;
 
+                if (tPipeline->pipeline != tBoundPipeline)
+                {
+                    vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, tPipeline->pipeline);
+                    tRangeBindStats.mPipelineBinds++;
+                }
 
-    // Start compute fullscreen pass
-    vkCmdBindPipeline(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_COMPUTE, mComputePipeline->computePipeline);
-    vkCmdBindDescriptorSets(commandBuffers[imageIndex], VK_PIPELINE_BIND_POINT_COMPUTE, mRootSignatureCompute->mPipelineLayout, 0, 1, &mComputeDataPostfx.descriptorset, 0, 0);
+                // The queued objects may have left the sets of another layout bound
+                std::array<VkDescriptorSet, 4> objectSets = { descriptorSetsSceneObjects[frameIndex], mBindless.mMaterials->GetDescriptorSet(), mDepthOnlypass.descriptorSet[frameIndex], mBindless.mObjectSets[frameIndex] };
+                vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mBindless.mRootSignature->mPipelineLayout, 0, static_cast<uint32_t>(objectSets.size()), objectSets.data(), 0, nullptr);
+                tRangeBindStats.mDescriptorSetBinds++;
 
-    glm::ivec2 dispatchSize = glm::ivec2(16, 16);
-    vkCmdDispatch(commandBuffers[imageIndex],
-        (mRenderTargetFinal->mWidth + dispatchSize.x - 1) / dispatchSize.x, // x dispatch
-        (mRenderTargetFinal->mHeight + dispatchSize.y - 1) / dispatchSize.y, // y dispatch
-        1); // z dispatch
+                mGpuDriven.mScene->RecordDraws(aCommandBuffer, frameIndex, aGpuView);
 
+                tRangeBindStats.mVertexBufferBinds++;
+                tRangeBindStats.mIndexBufferBinds++;
+                tRangeBindStats.mDraws++;
+            }
 
-    Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool, mRenderTargetFinal->mColorImages[0]->mImage, mRenderTargetFinal->mColorImages[0]->mFormat,
-        VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 1, commandBuffers[imageIndex]);
+            std::lock_guard<std::mutex> tLock(tBindStatsMutex);
+            tSceneBindStats += tRangeBindStats;
+        });
 
-    Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool, mSwapchain->mImages[imageIndex], mSwapchain->mImageFormat,
-        VkImageLayout::VK_IMAGE_LAYOUT_GENERAL, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, commandBuffers[imageIndex]);
+        return tSceneBindStats;
+    };
 
-	// Copy final image to swapchain
-	{
-		VkImageCopy copy{};
+    mFrameGraph.AddPass("Scene", [&](VkCommandBuffer aPrimary)
+    {
+        vkCmdBeginQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SCENE, 0);
+        mSceneBindStats = tRecordScene(aPrimary, mRenderTargetScene, mInstancing.mSceneBatches, false, GpuSceneView::eScene);
+        vkCmdEndQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SCENE);
+    })
+        .Read("ShadowDepth", ResourceAccess::eFragmentShaderRead)
+        .Write("SceneColor", ResourceAccess::eColorAttachment)
+        .Write("SceneDepth", ResourceAccess::eDepthAttachment);
+
+    // Occlusion culling, the pyramid is built from what the scene pass drew and both late tests run against it
+    // The late tests only write buffers, so like the culling pass they order their own writes before the indirect draws
+    if (mOcclusionCulling.mEnabled)
+    {
+        mFrameGraph.AddPass("HiZ", [&](VkCommandBuffer aPrimary)
+        {
+            mOcclusionCulling.mHiZ->RecordBuild(aPrimary, tCameraViewProjection);
+        })
+            .Read("SceneDepth", ResourceAccess::eComputeStorageRead)
+            .Write("DepthPyramid", ResourceAccess::eComputeStorageWrite);
+
+        mFrameGraph.AddPass("LateCull", [&](VkCommandBuffer aPrimary)
+        {
+            mOcclusionCulling.mHiZ->RecordLateTest(aPrimary, frameIndex, tCameraViewProjection);
+
+            if (tGpuDriven)
+            {
+                mGpuDriven.mScene->RecordLateCulling(aPrimary, frameIndex);
+            }
+        })
+            .Read("DepthPyramid", ResourceAccess::eComputeStorageRead)
+            .SetSideEffects();
+
+        mFrameGraph.AddPass("SceneLate", [&](VkCommandBuffer aPrimary)
+        {
+            vkCmdBeginQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SCENE_LATE, 0);
+            mSceneBindStats += tRecordScene(aPrimary, mRenderTargetSceneLate, mInstancing.mSceneLateBatches, true, GpuSceneView::eSceneLate);
+            vkCmdEndQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_SCENE_LATE);
+        })
+            .Read("ShadowDepth", ResourceAccess::eFragmentShaderRead)
+            .Modify("SceneColor", ResourceAccess::eColorAttachment)
+            .Modify("SceneDepth", ResourceAccess::eDepthAttachment);
+
+        // Tests the CPU recorded objects of a later frame, once the submission of this one has finished
+        mFrameGraph.AddPass("HiZReadback", [&](VkCommandBuffer aPrimary)
+        {
+            mOcclusionCulling.mHiZ->RecordReadback(aPrimary, frameIndex);
+        })
+            .Read("DepthPyramid", ResourceAccess::eTransferRead)
+            .SetSideEffects();
+    }
 
-		copy.srcOffset = { 0, 0, 0 };
-		copy.srcSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-		copy.srcSubresource.mipLevel = 0;
-		copy.srcSubresource.layerCount = 1;
-		copy.srcSubresource.baseArrayLayer = 0;
+    mFrameGraph.AddPass("PostFx", [&](VkCommandBuffer aPrimary)
+    {
+        vkCmdBindPipeline(aPrimary, VK_PIPELINE_BIND_POINT_COMPUTE, mComputePipeline->computePipeline);
+        vkCmdBindDescriptorSets(aPrimary, VK_PIPELINE_BIND_POINT_COMPUTE, mRootSignatureCompute->mPipelineLayout, 0, 1, &mComputeDataPostfx.descriptorset, 0, 0);
+
+        glm::ivec2 dispatchSize = glm::ivec2(16, 16);
+        vkCmdBeginQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_POSTFX, 0);
+        vkCmdDispatch(aPrimary,
+            (mRenderTargetFinal->mWidth + dispatchSize.x - 1) / dispatchSize.x, // x dispatch
+            (mRenderTargetFinal->mHeight + dispatchSize.y - 1) / dispatchSize.y, // y dispatch
+            1); // z dispatch
+        vkCmdEndQuery(aPrimary, mQueryPool, tFirstQuery + STATISTICS_PASS_POSTFX);
+    })
+        .Read("SceneColor", ResourceAccess::eComputeStorageRead)
+        .Write("Final", ResourceAccess::eComputeStorageWrite);
+
+    // Copy final image to swapchain
+    mFrameGraph.AddPass("Copy", [&](VkCommandBuffer aPrimary)
+    {
+        VkImageCopy copy{};
 
-		copy.dstOffset = { 0, 0, 0 };
-		copy.extent.depth = 1;
-		copy.extent.width = mSwapchain->mExtent.width;
-		copy.extent.height = mSwapchain->mExtent.height;
+        copy.srcOffset = { 0, 0, 0 };
+        copy.srcSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.srcSubresource.mipLevel = 0;
+        copy.srcSubresource.layerCount = 1;
+        copy.srcSubresource.baseArrayLayer = 0;
 
-		copy.dstSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
-		copy.dstSubresource.mipLevel = 0;
-		copy.dstSubresource.layerCount = 1;
-		copy.dstSubresource.baseArrayLayer = 0;
+        copy.dstOffset = { 0, 0, 0 };
+        copy.extent.depth = 1;
+        copy.extent.width = mSwapchain->mExtent.width;
+        copy.extent.height = mSwapchain->mExtent.height;
 
+        copy.dstSubresource.aspectMask = VkImageAspectFlagBits::VK_IMAGE_ASPECT_COLOR_BIT;
+        copy.dstSubresource.mipLevel = 0;
+        copy.dstSubresource.layerCount = 1;
+        copy.dstSubresource.baseArrayLayer = 0;
 
-		vkCmdCopyImage(commandBuffers[imageIndex],
+        vkCmdCopyImage(aPrimary,
             mRenderTargetFinal->mColorImages[0]->mImage, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
             mSwapchain->mImages[imageIndex], VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+    })
+        .Read("Final", ResourceAccess::eTransferRead)
+        .Write("Swapchain", ResourceAccess::eTransferWrite);
 
-		// Transition swapchain to present
-		Renderer::TransitionImageLayout(mRenderContext->mDevice->mDevice, mQueueGraphics->mVkQueue, commandPool, mSwapchain->mImages[imageIndex], mSwapchain->mImageFormat, VkImageLayout::VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VkImageLayout::VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 1, commandBuffers[imageIndex]);
-	}
-    vkCmdEndQuery(commandBuffers[imageIndex], mQueryPool, 0);
+    // Drawn on top of the copied image, the swapchain render pass loads its contents
+    if (!IsHeadless())
+    {
+        mFrameGraph.AddPass("ImGui", [&](VkCommandBuffer aPrimary)
+        {
+            VkRenderPassBeginInfo info = {};
+            info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            info.renderPass = mSwapchain->mRenderPass;
+            info.framebuffer = mSwapchain->mFramebuffers[imageIndex];
+            info.renderArea.extent.width = mSwapchain->mExtent.width;
+            info.renderArea.extent.height = mSwapchain->mExtent.height;
+            vkCmdBeginRenderPass(aPrimary, &info, VK_SUBPASS_CONTENTS_INLINE);
+
+            // Record dear imgui primitives into command buffer
+            ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), aPrimary);
+
+            vkCmdEndRenderPass(aPrimary);
+        })
+            .Modify("Swapchain", ResourceAccess::eColorAttachment);
+    }
+
+    // The buffer is not tracked by the graph, the fence of the frame covers the host read
+    if (IsHeadless() && mHeadless.mReadbackEnabled)
+    {
+        if (mHeadless.mReadbackBuffers[frameIndex] == nullptr)
+        {
+            std::shared_ptr<Gfx::BufferGPU> tBuffer = std::make_shared<Gfx::BufferGPU>();
+            tBuffer->mUsageFlags = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+            tBuffer->mMemoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_TO_CPU;
+            Renderer::CreateBuffer(mRenderContext->mDevice->mDevice, mRenderContext->memoryAllocator,
+                static_cast<VkDeviceSize>(mSwapchain->mExtent.width) * mSwapchain->mExtent.height * 4, tBuffer->mUsageFlags, tBuffer->mMemoryUsage, tBuffer->mBuffer, tBuffer->mAllocation);
+            mHeadless.mReadbackBuffers[frameIndex] = tBuffer;
+        }
+
+        mFrameGraph.AddPass("Readback", [&](VkCommandBuffer aPrimary)
+        {
+            VkBufferImageCopy copy{};
+            copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            copy.imageSubresource.layerCount = 1;
+            copy.imageExtent = { mSwapchain->mExtent.width, mSwapchain->mExtent.height, 1 };
+
+            vkCmdCopyImageToBuffer(aPrimary, mSwapchain->mImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, mHeadless.mReadbackBuffers[frameIndex]->mBuffer, 1, &copy);
+
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(aPrimary, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        })
+            .Read("Swapchain", ResourceAccess::eTransferRead)
+            .SetSideEffects();
+    }
 
 
     ImGui::Begin("Lights");                          // Create a window called "Hello, world!" and append into it.
@@ -1391,9 +2557,23 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
 
     ImGui::TextColored(ImVec4(1, 1, 0, 1), "Pipeline stats");
 
+    // Of the frame that finished last, one column per pass
+    {
+        std::string tHeader = "Passes: ";
+        for (uint32_t pass = 0; pass < STATISTICS_PASS_COUNT; ++pass)
+        {
+            tHeader += (pass > 0 ? " | " : "") + mRenderDataPipeline.passNames[pass];
+        }
+        ImGui::Text(tHeader.c_str());
+    }
+
     for (int i = 0; i < mRenderDataPipeline.pipelineStatNames.size(); ++i)
     {
-        std::string text = mRenderDataPipeline.pipelineStatNames[i] + std::to_string(mRenderDataPipeline.pipelineStats[i]);
+        std::string text = mRenderDataPipeline.pipelineStatNames[i];
+        for (uint32_t pass = 0; pass < STATISTICS_PASS_COUNT; ++pass)
+        {
+            text += (pass > 0 ? " | " : "") + std::to_string(mRenderDataPipeline.pipelineStats[pass][i]);
+        }
         ImGui::Text(text.c_str());
     }
 
@@ -1408,6 +2588,213 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
     ImGui::Text(tUsedMb.c_str());
     ImGui::Text(tTotalAllocatedObject.c_str());
 
+    {
+        const auto& tTransientStats = mTransientPool->mStats;
+        std::string tTargetsMb = "Render targets MB: " + std::to_string(tTransientStats.mDedicatedBytes / 1024 / 1024) + " without aliasing, " + std::to_string(tTransientStats.mAliasedBytes / 1024 / 1024) + " aliased";
+        std::string tBlocks = "Transient blocks: " + std::to_string(tTransientStats.mBlocks) + " for " + std::to_string(tTransientStats.mImages) + " images, " + std::to_string(tTransientStats.mReallocations) + " reallocations, " + std::to_string(tTransientStats.mRecycledBlocks) + " blocks recycled";
+
+        ImGui::Text(tTargetsMb.c_str());
+        ImGui::Text(tBlocks.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Pipeline cache");
+    {
+        const auto& tCacheStats = mRenderContext->mPipelineCache->mStats;
+
+        std::string tLoadedKb = "Loaded from disk KB: " + std::to_string(mRenderContext->mPipelineCache->mLoadedSize / 1024);
+        std::string tHits = "Hits: " + std::to_string(tCacheStats.mHits.load());
+        std::string tMisses = "Misses: " + std::to_string(tCacheStats.mMisses.load());
+        std::string tUnknown = "Unknown (no creation feedback): " + std::to_string(tCacheStats.mUnknown.load());
+        std::string tCreationMs = "Total creation ms: " + std::to_string(tCacheStats.mCreationTimeMicroSeconds.load() / 1000.0);
+
+        ImGui::Text(tLoadedKb.c_str());
+        ImGui::Text(tHits.c_str());
+        ImGui::Text(tMisses.c_str());
+        ImGui::Text(tUnknown.c_str());
+        ImGui::Text(tCreationMs.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Shader reflection cache");
+    {
+        std::string tHits = "Hits: " + std::to_string(mRenderContext->mReflectionCache->mHits.load());
+        std::string tMisses = "Misses: " + std::to_string(mRenderContext->mReflectionCache->mMisses.load());
+
+        ImGui::Text(tHits.c_str());
+        ImGui::Text(tMisses.c_str());
+    }
+
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Command recording");
+    {
+        const auto& tRecordTimes = mCommandRecorder->GetRecordTimesMs();
+        for (size_t i = 0; i < tRecordTimes.size(); ++i)
+        {
+            std::string tThreadTime = "Thread " + std::to_string(i) + " ms: " + std::to_string(tRecordTimes[i]);
+            ImGui::Text(tThreadTime.c_str());
+        }
+
+        if (!mRenderContext->mDevice->mInheritedQueriesSupported)
+        {
+            std::string tInlineTime = "Inline ms (no inherited queries): " + std::to_string(mCommandRecorder->GetInlineRecordTimeMs());
+            ImGui::Text(tInlineTime.c_str());
+        }
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Frustum culling");
+    {
+        std::string tTested = "Objects tested: " + std::to_string(mFrustumCulling.mSpheres.Size()) + " in " + std::to_string(mFrustumCulling.mCullTimeMs) + " ms";
+        std::string tScene = "Culled from the scene pass: " + std::to_string(mFrustumCulling.mCulledScene);
+        std::string tShadow = "Culled from the shadow pass: " + std::to_string(mFrustumCulling.mCulledShadow);
+
+        ImGui::Text(tTested.c_str());
+        ImGui::Text(tScene.c_str());
+        ImGui::Text(tShadow.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Occlusion culling");
+    {
+        // The pyramid holds depth of the frames before the toggle, it is rebuilt before it is used again
+        if (ImGui::Checkbox("Enabled", &mOcclusionCulling.mEnabled))
+        {
+            mOcclusionCulling.mHiZ->Invalidate();
+        }
+
+        const HiZCulling& tHiZ = *mOcclusionCulling.mHiZ;
+        const HiZLateStats& tLateStats = tHiZ.GetLateStats();
+        const GpuSceneOcclusionStats& tGpuStats = mOcclusionCulling.mGpuStats;
+
+        std::string tPyramid = "Depth pyramid: " + std::to_string(tHiZ.GetWidth()) + "x" + std::to_string(tHiZ.GetHeight()) + ", " + std::to_string(tHiZ.GetLevelCount()) + " levels";
+        std::string tCpu = "CPU objects tested: " + std::to_string(mOcclusionCulling.mTestedObjects) + ", occluded: " + std::to_string(mOcclusionCulling.mOccludedObjects)
+            + " (" + std::to_string(mOcclusionCulling.mOccludedTriangles) + " triangles)";
+        std::string tCpuRescued = "CPU objects rescued by the late pass: " + std::to_string(tLateStats.mRescuedObjects) + " (" + std::to_string(tLateStats.mRescuedTriangles) + " triangles)";
+        std::string tGpu = "GPU objects occluded: " + std::to_string(tGpuStats.mOccludedObjects) + " (" + std::to_string(tGpuStats.mOccludedTriangles) + " triangles), rescued: "
+            + std::to_string(tGpuStats.mRescuedObjects) + " (" + std::to_string(tGpuStats.mRescuedTriangles) + " triangles)";
+        std::string tCulled = "GPU objects culled: " + std::to_string(tGpuStats.mOccludedObjects - tGpuStats.mRescuedObjects)
+            + " (" + std::to_string(tGpuStats.mOccludedTriangles - tGpuStats.mRescuedTriangles) + " triangles)";
+
+        ImGui::Text(tPyramid.c_str());
+        ImGui::Text(tCpu.c_str());
+        ImGui::Text(tCpuRescued.c_str());
+        ImGui::Text(tGpu.c_str());
+        ImGui::Text(tCulled.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Draw sorting");
+    {
+        std::string tSort = "Sorted draws: " + std::to_string(mRenderQueue.GetItems().size()) + " in " + std::to_string(mRenderQueue.GetSortTimeMs()) + " ms";
+        std::string tDepth = "Depth pass: " + std::to_string(mDepthBindStats.mDraws) + " draws, " + std::to_string(mDepthBindStats.mVertexBufferBinds) + " vertex and " + std::to_string(mDepthBindStats.mIndexBufferBinds) + " index buffer binds";
+        std::string tScene = "Scene pass: " + std::to_string(mSceneBindStats.mDraws) + " draws, " + std::to_string(mSceneBindStats.mPipelineBinds) + " pipeline, " + std::to_string(mSceneBindStats.mDescriptorSetBinds) + " descriptor set, "
+            + std::to_string(mSceneBindStats.mVertexBufferBinds) + " vertex and " + std::to_string(mSceneBindStats.mIndexBufferBinds) + " index buffer binds";
+        std::string tEliminated = "Redundant binds eliminated: " + std::to_string(mDepthBindStats.GetEliminatedBinds() + mSceneBindStats.GetEliminatedBinds());
+        std::string tInstancing = "Instancing: " + std::to_string(mInstancing.mInstanceCount) + " transforms in " + std::to_string(mInstancing.mDepthBatches.size()) + " depth and "
+            + std::to_string(mInstancing.mSceneBatches.size() + mInstancing.mSceneLateBatches.size()) + " scene batches";
+
+        ImGui::Text(tSort.c_str());
+        ImGui::Text(tDepth.c_str());
+        ImGui::Text(tScene.c_str());
+        ImGui::Text(tEliminated.c_str());
+        ImGui::Text(tInstancing.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Frame graph");
+    {
+        const FrameGraphStats& tStats = mFrameGraph.GetStats();
+        std::string tPasses = "Passes: " + std::to_string(tStats.mPasses) + ", culled: " + std::to_string(tStats.mCulledPasses);
+        std::string tBarriers = "Barrier batches: " + std::to_string(tStats.mBarrierBatches) + ", image barriers: " + std::to_string(tStats.mImageBarriers);
+
+        ImGui::Text(tPasses.c_str());
+        ImGui::Text(tBarriers.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Bindless materials");
+    if (mBindless.mMaterials != nullptr)
+    {
+        std::string tTextures = "Textures: " + std::to_string(mBindless.mMaterials->GetTextureCount());
+        std::string tMaterials = "Materials: " + std::to_string(mBindless.mMaterials->GetMaterialCount());
+
+        ImGui::Text(tTextures.c_str());
+        ImGui::Text(tMaterials.c_str());
+    }
+    else
+    {
+        ImGui::Text("Not supported, descriptor indexing is unavailable");
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "GPU-driven draws");
+    if (mGpuDriven.mScene != nullptr)
+    {
+        std::string tObjects = "Objects culled on the GPU: " + std::to_string(mGpuDriven.mObjectCount);
+        std::string tMeshes = "Meshes: " + std::to_string(mGpuDriven.mScene->GetMeshCount());
+        std::string tGeometry = "Merged vertices: " + std::to_string(mGpuDriven.mScene->GetVertexCount()) + ", indices: " + std::to_string(mGpuDriven.mScene->GetIndexCount());
+
+        ImGui::Text(tObjects.c_str());
+        ImGui::Text(tMeshes.c_str());
+        ImGui::Text(tGeometry.c_str());
+    }
+    else
+    {
+        ImGui::Text("Not supported, needs bindless and indirect count draws");
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Descriptor allocator");
+    {
+        std::lock_guard<std::mutex> tLock(mDescriptorAllocator->mMutex);
+
+        const Gfx::DescriptorAllocatorStats& tStats = mDescriptorAllocator->mStats;
+        const uint32_t tPersistentCapacity = tStats.mPersistentPools * mDescriptorAllocator->mSetsPerPool;
+        const uint32_t tPersistentUsed = tStats.mPersistentSetsLive + tStats.mPersistentSetsFree;
+
+        std::string tPools = "Pools: " + std::to_string(tStats.mPersistentPools) + " persistent, " + std::to_string(tStats.mTransientPools) + " transient";
+        std::string tSets = "Persistent sets: " + std::to_string(tStats.mPersistentSetsLive) + " live, " + std::to_string(tStats.mPersistentSetsFree) + " free, " + std::to_string(tPersistentUsed) + "/" + std::to_string(tPersistentCapacity) + " allocated";
+        std::string tReuses = "Free list reuses: " + std::to_string(tStats.mFreeListReuses);
+        std::string tTransient = "Transient sets this frame: " + std::to_string(tStats.mTransientSetsThisFrame);
+        std::string tExhaustions = "Pool exhaustions: " + std::to_string(tStats.mPoolExhaustions) + " (" + std::to_string(tStats.mFragmentedPools) + " fragmented)";
+
+        ImGui::Text(tPools.c_str());
+        ImGui::Text(tSets.c_str());
+        ImGui::Text(tReuses.c_str());
+        ImGui::Text(tTransient.c_str());
+        ImGui::Text(tExhaustions.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Layout cache");
+    {
+        const auto& tLayoutCache = mRenderContext->mLayoutCache;
+        std::lock_guard<std::mutex> tLock(tLayoutCache->mMutex);
+
+        std::string tSetLayouts = "Descriptor set layouts: " + std::to_string(tLayoutCache->mSetLayouts.size());
+        std::string tPipelineLayouts = "Pipeline layouts: " + std::to_string(tLayoutCache->mPipelineLayouts.size()) + " for " + std::to_string(mRootSignaturesAll.size()) + " root signatures";
+        std::string tHits = "Hits: " + std::to_string(tLayoutCache->mHits.load());
+
+        ImGui::Text(tSetLayouts.c_str());
+        ImGui::Text(tPipelineLayouts.c_str());
+        ImGui::Text(tHits.c_str());
+    }
+
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Pipeline compilation");
+    {
+        std::string tPending = "Pending: " + std::to_string(mPipelineCompiler->GetPendingCount());
+        ImGui::Text(tPending.c_str());
+
+        const char* tPendingModeNames[] = { "Skip", "Fallback" };
+        int tPendingMode = static_cast<int>(mPendingPipelineMode);
+        if (ImGui::Combo("While compiling", &tPendingMode, tPendingModeNames, IM_ARRAYSIZE(tPendingModeNames)))
+        {
+            SetPendingPipelineMode(static_cast<PendingPipelineMode>(tPendingMode));
+        }
+
+        for (size_t i = 0; i < mPipelines.size(); ++i)
+        {
+            std::string tName;
+            for (const auto& shader : mPipelines[i].first.shaders)
+            {
+                tName += shader.second.substr(shader.second.find_last_of("/\\") + 1) + " ";
+            }
+
+            std::string tCompileTime = tName + std::to_string(mPipelineCompileTimesMs[i]) + " ms";
+            ImGui::Text(tCompileTime.c_str());
+        }
+    }
 
     ImGui::TextColored(ImVec4(1, 1, 0, 1), "Timings stats");
 
@@ -1415,38 +2802,94 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
 
     ImGui::Text(tCpuMsText.c_str());
 
-    ImGui::End();
+    // Summed per frame over every thread, nested zones are indented
+    const CpuProfiler& tCpuProfiler = CpuProfiler::Get();
+    std::string tCpuFrameText = "Cpu frame: " + std::to_string(tCpuProfiler.GetFrameTimes().GetAverage()) + " ms avg, "
+        + std::to_string(tCpuProfiler.GetFrameTimes().GetPercentile(0.99)) + " ms p99, " + std::to_string(tCpuProfiler.GetDroppedZones()) + " zones dropped";
+    ImGui::Text(tCpuFrameText.c_str());
 
-    // Rendering
-    ImGui::Render();
+    for (const auto& zone : tCpuProfiler.GetZones())
+    {
+        std::string tZoneText = std::string(zone.mDepth * 2, ' ') + "Cpu " + zone.mName + ": " + std::to_string(zone.mMilliseconds.GetAverage()) + " ms avg, "
+            + std::to_string(zone.mMilliseconds.GetPercentile(0.95)) + " ms p95, " + std::to_string(zone.mMilliseconds.GetPercentile(0.99)) + " ms p99";
+        ImGui::Text(tZoneText.c_str());
+    }
+
+    // Of the last frames the GPU finished, nested zones are indented
+    if (!mProfiling.mGpu->IsSupported())
+    {
+        ImGui::Text("Gpu ms: timestamps unsupported on the graphics queue");
+    }
+
+    for (const auto& zone : mProfiling.mGpu->GetZones())
+    {
+        std::string tZoneText = std::string(zone.mDepth * 2, ' ') + "Gpu " + zone.mName + ": " + std::to_string(zone.mMilliseconds.GetAverage()) + " ms avg, "
+            + std::to_string(zone.mMilliseconds.GetPercentile(0.95)) + " ms p95, " + std::to_string(zone.mMilliseconds.GetPercentile(0.99)) + " ms p99";
+        ImGui::Text(tZoneText.c_str());
+    }
 
+    if (ImGui::Button("Reset timings"))
+    {
+        mProfiling.mGpu->ClearStatistics();
+        CpuProfiler::Get().ClearStatistics();
+    }
+    ImGui::SameLine();
+    if (mProfiling.mCaptureFramesLeft == 0 && ImGui::Button("Capture trace"))
+    {
+        StartTraceCapture();
+    }
 
+    if (!mProfiling.mCaptureStatus.empty())
+    {
+        ImGui::Text(mProfiling.mCaptureStatus.c_str());
+    }
 
+    ImGui::TextColored(ImVec4(1, 1, 0, 1), "Presentation");
 
-    VkClearValue clearValuesImgui{};
-    clearValuesImgui.color = { 0.0f, 0.0f, 0.0f, 1.0f };
+    // Applied once this frame is presented, fewer frames lower the input latency at the cost of CPU and GPU overlap
+    int tFramesInFlight = static_cast<int>(mFramesInFlight);
+    ImGui::SliderInt("Frames in flight", &tFramesInFlight, 1, static_cast<int>(MAX_FRAMES_IN_FLIGHT));
 
-    ImDrawData* draw_data = ImGui::GetDrawData();
+    Gfx::PresentPolicy tPresentPolicy = mPresentation.mPolicy;
     {
-        VkRenderPassBeginInfo info = {};
-        info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-        info.renderPass = mSwapchain->mRenderPass;
-        info.framebuffer = mSwapchain->mFramebuffers[imageIndex];
-        info.renderArea.extent.width = mSwapchain->mExtent.width;
-        info.renderArea.extent.height = mSwapchain->mExtent.height;
-        info.clearValueCount = 1;
-        info.pClearValues = &clearValuesImgui;
-        vkCmdBeginRenderPass(commandBuffers[imageIndex], &info, VK_SUBPASS_CONTENTS_INLINE);
+        const char* tModeNames[] = { "FIFO", "FIFO relaxed", "Mailbox", "Immediate" };
+        int tMode = static_cast<int>(tPresentPolicy.mMode);
+        if (ImGui::Combo("Present mode", &tMode, tModeNames, IM_ARRAYSIZE(tModeNames)))
+        {
+            tPresentPolicy.mMode = static_cast<Gfx::PresentMode>(tMode);
+        }
+
+        ImGui::SliderFloat("Frame rate limit", &tPresentPolicy.mFrameRateLimit, 0.0f, 240.0f, "%.0f");
+        ImGui::Checkbox("Low latency", &tPresentPolicy.mLowLatency);
+
+        std::string tActive = std::string("Active mode: ") + Gfx::GetPresentModeName(mSwapchain->mPresentMode)
+            + (mSwapchain->mPresentMode != Gfx::ToVkPresentMode(mPresentation.mPolicy.mMode) ? " (requested mode unsupported)" : "");
+        const double tAverageFrameMs = mPresentation.mFrameTimesMs.GetAverage();
+        std::string tFrameTimes = "Frame: " + std::to_string(tAverageFrameMs) + " ms avg, " + std::to_string(mPresentation.mFrameTimesMs.GetPercentile(0.99)) + " ms p99, "
+            + std::to_string(tAverageFrameMs > 0.0 ? 1000.0 / tAverageFrameMs : 0.0) + " fps";
+        std::string tLatency = "Latency: " + std::to_string(mPresentation.mLatenciesMs.GetAverage()) + " ms avg, " + std::to_string(mPresentation.mLatenciesMs.GetPercentile(0.99)) + " ms p99";
+        std::string tWait = "Pacing wait: " + std::to_string(mPresentation.mWaitTimesMs.GetAverage()) + " ms avg";
+
+        ImGui::Text(tActive.c_str());
+        ImGui::Text(tFrameTimes.c_str());
+        ImGui::Text(tLatency.c_str());
+        ImGui::Text(tWait.c_str());
     }
 
-    // Record dear imgui primitives into command buffer
-    ImGui_ImplVulkan_RenderDrawData(draw_data, commandBuffers[imageIndex]);
+    ImGui::End();
+
+    // Rendering
+    ImGui::Render();
 
-    // Submit command buffer
-    vkCmdEndRenderPass(commandBuffers[imageIndex]);
+    mFrameGraph.Compile();
 
+    {
+        FLUX_PROFILE_ZONE("Execute frame graph");
+        GpuProfiler::Scope tFrameZone(*mProfiling.mGpu, tFrame.mCommandBuffer, "Frame");
+        mFrameGraph.Execute(*mRenderContext->mDevice, tFrame.mCommandBuffer);
+    }
 
-    if (vkEndCommandBuffer(commandBuffers[imageIndex]) != VK_SUCCESS) {
+    if (vkEndCommandBuffer(tFrame.mCommandBuffer) != VK_SUCCESS) {
         throw std::runtime_error("failed to record command buffer!");
     }
 
@@ -1454,51 +2897,82 @@ void CustomRenderer::Draw(const std::shared_ptr<iScene> aScene) {
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
+    // Headless submissions have no acquire to wait for and no present to signal
+    VkSemaphore waitSemaphores[] = { tFrame.mImageAvailable };
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = IsHeadless() ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
+    submitInfo.pCommandBuffers = &tFrame.mCommandBuffer;
 
-    VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
-    submitInfo.signalSemaphoreCount = 1;
+    VkSemaphore signalSemaphores[] = { tFrame.mRenderFinished };
+    submitInfo.signalSemaphoreCount = IsHeadless() ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    vkResetFences(mRenderContext->mDevice->mDevice, 1, &inFlightFences[currentFrame]);
+    vkResetFences(mRenderContext->mDevice->mDevice, 1, &tFrame.mInFlight);
 
-    if (vkQueueSubmit(mQueueGraphics->mVkQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    const FramePacer::Clock::time_point tSubmitStart = FramePacer::Clock::now();
+    {
+        FLUX_PROFILE_ZONE("Submit");
+        if (vkQueueSubmit(mQueueGraphics->mVkQueue, 1, &submitInfo, tFrame.mInFlight) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
     }
 
-    GetQueryResults();
+    mRenderDataPipeline.mSubmitted[frameIndex] = true;
+    mHeadless.mReadbackPending[frameIndex] = IsHeadless() && mHeadless.mReadbackEnabled;
+    mProfiling.mGpu->EndFrame(frameIndex, tSubmitStart);
 
-    VkPresentInfoKHR presentInfo{};
-    presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    tFrame.mLatencyPending = mPresentation.mInputSampled;
+    tFrame.mInputTime = mPresentation.mInputTime;
+    mPresentation.mInputSampled = false;
 
-    presentInfo.waitSemaphoreCount = 1;
-    presentInfo.pWaitSemaphores = signalSemaphores;
+    if (!IsHeadless())
+    {
+        VkPresentInfoKHR presentInfo{};
+        presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
-    VkSwapchainKHR swapChains[] = { mSwapchain->mSwapChain };
-    presentInfo.swapchainCount = 1;
-    presentInfo.pSwapchains = swapChains;
+        presentInfo.waitSemaphoreCount = 1;
+        presentInfo.pWaitSemaphores = signalSemaphores;
 
-    presentInfo.pImageIndices = &imageIndex;
+        VkSwapchainKHR swapChains[] = { mSwapchain->mSwapChain };
+        presentInfo.swapchainCount = 1;
+        presentInfo.pSwapchains = swapChains;
 
-    result = vkQueuePresentKHR(mQueuePresent->mVkQueue, &presentInfo);
+        presentInfo.pImageIndices = &imageIndex;
 
-    if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
-        framebufferResized = false;
-        RecreateSwapChain();
-    }
-    else if (result != VK_SUCCESS) {
-        throw std::runtime_error("failed to present swap chain image!");
+        {
+            FLUX_PROFILE_ZONE("Present");
+            result = vkQueuePresentKHR(mQueuePresent->mVkQueue, &presentInfo);
+        }
+
+        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized) {
+            framebufferResized = false;
+            RecreateSwapChain();
+        }
+        else if (result != VK_SUCCESS) {
+            throw std::runtime_error("failed to present swap chain image!");
+        }
     }
 
     frame++;
-    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    mFrameIndex = (mFrameIndex + 1) % mFramesInFlight;
+
+    SetFramesInFlight(static_cast<uint32_t>(tFramesInFlight));
+    SetPresentPolicy(tPresentPolicy);
+
+    // Persist newly compiled pipelines now and then so a crash doesn't lose them, the cache is saved on shutdown as well
+    if (frame % PIPELINE_CACHE_SAVE_INTERVAL == 0 && mRenderContext->mPipelineCache->mDirty)
+    {
+        Renderer::SavePipelineCache(mRenderContext, mRenderContext->mPipelineCache);
+    }
+
+    if (frame % PIPELINE_CACHE_SAVE_INTERVAL == 0)
+    {
+        ShaderReflection::SaveReflectionCache(*mRenderContext->mReflectionCache);
+    }
 }
 
 void Flux::CustomRenderer::SetWindow(GLFWwindow* aWindow)
@@ -1506,7 +2980,7 @@ void Flux::CustomRenderer::SetWindow(GLFWwindow* aWindow)
     mWindow = aWindow;
 }
 
-void CustomRenderer::UpdateUniformBuffer(uint32_t currentImage, std::shared_ptr<Camera> aCam, std::vector<std::shared_ptr<Light>> aLights) {
+void CustomRenderer::UpdateUniformBuffer(uint32_t aFrameIndex, std::shared_ptr<Camera> aCam, std::vector<std::shared_ptr<Light>> aLights) {
     static auto startTime = std::chrono::high_resolution_clock::now();
 
     auto currentTime = std::chrono::high_resolution_clock::now();
@@ -1521,9 +2995,9 @@ void CustomRenderer::UpdateUniformBuffer(uint32_t currentImage, std::shared_ptr<
     ubo.farPlane = aCam->farPlane;
 
     void *data;
-    vmaMapMemory(mRenderContext->memoryAllocator, mUniformBuffersCamera[currentImage]->mAllocation, &data);
+    vmaMapMemory(mRenderContext->memoryAllocator, mUniformBuffersCamera[aFrameIndex]->mAllocation, &data);
     memcpy(data, &ubo, sizeof(ubo));
-    vmaUnmapMemory(mRenderContext->memoryAllocator, mUniformBuffersCamera[currentImage]->mAllocation);
+    vmaUnmapMemory(mRenderContext->memoryAllocator, mUniformBuffersCamera[aFrameIndex]->mAllocation);
 
 
     {
@@ -1562,10 +3036,11 @@ void CustomRenderer::UpdateUniformBuffer(uint32_t currentImage, std::shared_ptr<
             glm::vec3(0.0f, 1.0f, 0.0f));
 
         glm::mat4 directionalLight = lightProjection * lightView;
+        mDepthOnlypass.mLightMatrix = directionalLight;
         void* data;
-        vmaMapMemory(mRenderContext->memoryAllocator, mDepthOnlypass.mBufferDepthTransformation[currentImage]->mAllocation, &data);
+        vmaMapMemory(mRenderContext->memoryAllocator, mDepthOnlypass.mBufferDepthTransformation[aFrameIndex]->mAllocation, &data);
         memcpy(data, &directionalLight, sizeof(glm::mat4));
-        vmaUnmapMemory(mRenderContext->memoryAllocator, mDepthOnlypass.mBufferDepthTransformation[currentImage]->mAllocation);
+        vmaUnmapMemory(mRenderContext->memoryAllocator, mDepthOnlypass.mBufferDepthTransformation[aFrameIndex]->mAllocation);
     }
 
 
@@ -1592,7 +3067,7 @@ void CustomRenderer::UpdateUniformBuffer(uint32_t currentImage, std::shared_ptr<
 
 
     void* lightData;
-    vmaMapMemory(mRenderContext->memoryAllocator, mLightData.mUniformBuffersLights[currentImage]->mAllocation, &lightData);
+    vmaMapMemory(mRenderContext->memoryAllocator, mLightData.mUniformBuffersLights[aFrameIndex]->mAllocation, &lightData);
     memcpy(lightData, mLightData.lightCache, sizeof(Light) * AMOUNT_OF_SUPPORTED_LIGHTS);
-    vmaUnmapMemory(mRenderContext->memoryAllocator, mLightData.mUniformBuffersLights[currentImage]->mAllocation);
+    vmaUnmapMemory(mRenderContext->memoryAllocator, mLightData.mUniformBuffersLights[aFrameIndex]->mAllocation);
 }
\ No newline at end of file
@@ -11,8 +11,12 @@
 #include <cstdint>
 #include <optional>
 #include <set>
+#include <map>
 #include <array>
 #include <chrono>
+#include <unordered_map>
+#include <unordered_set>
+#include <mutex>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -27,20 +31,35 @@
 #include "Renderer/TextureVK.h"
 #include "Renderer/BufferGPU.h"
 #include "Renderer/Queue.h"
+#include "Renderer/FrameGraph.h"
 
 #include "Application/BasicGeometry.h"
 #include "Application/Scene/iScene.h"
 #include "Application/Rendering/RenderState.h"
 
 #include "Common/AssetProcessing/AssetObjects.h"
+#include "Common/Culling/FrustumCulling.h"
+#include "Common/Time/FramePacer.h"
+#include "Common/Profiling/ChromeTrace.h"
+#include "Common/Profiling/CpuProfiler.h"
 
 #include "Application/Rendering/RenderingResourceManager.h"
+#include "Application/Rendering/PipelineCompiler.h"
+#include "Application/Rendering/ParallelCommandRecorder.h"
+#include "Common/Rendering/RenderQueue.h"
+#include "Application/Rendering/BindlessMaterials.h"
+#include "Application/Rendering/GpuScene.h"
+#include "Application/Rendering/HiZCulling.h"
+#include "Application/Rendering/GpuProfiler.h"
 #include "Application/Rendering/RenderDataStructs.h"
 
 
-constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4; // Every frame context exists up front, so the depth can change between frames
+constexpr uint32_t DEFAULT_FRAMES_IN_FLIGHT = 2;
 constexpr int AMOUNT_OF_SUPPORTED_LIGHTS = 1024;
 constexpr bool FORCE_DEBUG = true;
+constexpr int PIPELINE_CACHE_SAVE_INTERVAL = 1000; // In frames, only writes when new pipelines were created
+constexpr int MAX_BINDLESS_OBJECTS = 16384;
 
 
 #ifdef NDEBUG
@@ -53,16 +72,68 @@ namespace Flux
 {
 	class Camera;
 	class Swapchain;
+	class iSceneObject;
+
+	// Renders into offscreen images instead of a window, for build machines and batch jobs without a display
+	// Needs no surface extensions, so it runs on software rasterizers like lavapipe
+	struct HeadlessRendererDesc
+	{
+		uint32_t mWidth = 1280;
+		uint32_t mHeight = 720;
+		bool mEnableValidation = false;
+	};
+
 	class CustomRenderer
 	{
 	public:
 		CustomRenderer(GLFWwindow* window);
+		CustomRenderer(const HeadlessRendererDesc& aDesc);
 		void Init();
 		void WaitIdle();
 		void Draw(const std::shared_ptr<iScene> aScene);
 		void Cleanup();
 		void SetWindow(GLFWwindow* aWindow);
 
+		// Queues pipeline compilation for every render state in the scene, call right after loading a scene
+		void PrewarmPipelines(const std::shared_ptr<iScene> aScene, bool aWaitForCompletion);
+
+		// What to do with objects whose pipeline is still compiling
+		enum class PendingPipelineMode
+		{
+			eSkip, // Not drawn until their pipeline is ready
+			eFallback // Drawn with the basic model pipeline that is compiled up front
+		};
+
+		void SetPendingPipelineMode(PendingPipelineMode aMode) { mPendingPipelineMode = aMode; }
+		PendingPipelineMode GetPendingPipelineMode() const { return mPendingPipelineMode; }
+
+		// Frames the CPU may record ahead of the GPU, clamped to [1, MAX_FRAMES_IN_FLIGHT]
+		// One frame has the lowest input latency, more frames let the CPU and GPU overlap for throughput
+		// Waits for the frames in flight when called after Init
+		void SetFramesInFlight(uint32_t aCount);
+		uint32_t GetFramesInFlight() const { return mFramesInFlight; }
+
+		// Recreates the swapchain when the present mode changes, the mode it got may be a fallback
+		void SetPresentPolicy(const Gfx::PresentPolicy& aPolicy);
+		const Gfx::PresentPolicy& GetPresentPolicy() const { return mPresentation.mPolicy; }
+
+		bool IsHeadless() const { return mRenderContext->mHeadless; }
+
+		// Headless only, copies every rendered frame to host memory, which costs a transfer per frame
+		// GetLastFrame holds the last finished frame row by row in the swapchain format, 4 bytes per pixel
+		void SetReadbackEnabled(bool aEnabled);
+		bool IsReadbackEnabled() const { return mHeadless.mReadbackEnabled; }
+		const std::vector<uint8_t>& GetLastFrame() const { return mHeadless.mLastFrame; }
+		uint32_t GetLastFrameWidth() const { return mHeadless.mLastFrameWidth; }
+		uint32_t GetLastFrameHeight() const { return mHeadless.mLastFrameHeight; }
+
+		// Waits for every frame in flight so the last submitted frame is the one GetLastFrame holds
+		void FlushReadback();
+
+		// Call right before sampling input, applies the frame limiter and the low latency wait
+		// The latency of the next Draw is measured from here
+		void BeginFrame();
+
 		struct UniformBufferCamera
 		{
 			glm::mat4 view;
@@ -86,9 +157,11 @@ namespace Flux
 			Light lightCache[AMOUNT_OF_SUPPORTED_LIGHTS];
 		};
 
+		// Every frame in flight owns one pipeline statistics query per measured pass
+		// Results are read once the fence of the frame shows it finished, so reading never waits on the GPU
 		struct RenderDataQuery
 		{
-			std::vector<uint64_t> pipelineStats;
+			std::vector<std::vector<uint64_t>> pipelineStats; // Per pass, of the last frame that finished, zero for passes it skipped
 			std::vector<std::string> pipelineStatNames
 			{
 				"Input assembly vertex count        ",
@@ -98,26 +171,16 @@ namespace Flux
 				"Clipping stage primitives output        ",
 				"Fragment shader invocations        ",
 				"Tess. control shader patches        ",
-				"Tess. eval. shader invocations        "
+				"Tess. eval. shader invocations        ",
+				"Compute shader invocations        "
 			};
+			std::vector<std::string> passNames { "Shadow", "Scene", "Scene late", "Post fx" };
+
+			std::array<bool, MAX_FRAMES_IN_FLIGHT> mSubmitted{}; // The queries of the frame were reset and used at least once
 		} mRenderDataPipeline;
 
-		void GetQueryResults()
-		{
-			// We use vkGetQueryResults to copy the results into a host visible buffer
-			vkGetQueryPoolResults(
-				mRenderContext->mDevice->mDevice,
-				mQueryPool,
-				0,
-				1,
-				sizeof(uint64_t) * mRenderDataPipeline.pipelineStats.size(),
-				mRenderDataPipeline.pipelineStats.data(),
-				sizeof(uint64_t),
-				// Store results a 64 bit values and wait until the results have been finished
-				// If you don't want to wait, you can use VK_QUERY_RESULT_WITH_AVAILABILITY_BIT
-				// which also returns the state of the result (ready) in the result
-				VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
-		}
+		// Copies the statistics of this frame in flight, only call once its fence is signaled
+		void ReadQueryResults(uint32_t aFrameIndex);
 
 		LightData mLightData;
 
@@ -133,8 +196,6 @@ namespace Flux
 			Cleanup();
 		}
 
-		bool mVsync;
-
 		std::shared_ptr<Flux::Gfx::Texture> mEmptyTexture;
 
 		VkSampler textureSampler;
@@ -148,14 +209,27 @@ namespace Flux
 		std::vector<VkDescriptorSet> descriptorSetsSceneObjects;
 
 
-		VkCommandPool commandPool;
-		std::vector<VkCommandBuffer> commandBuffers;
+		VkCommandPool commandPool; // Single time commands
+
+		// Everything a frame in flight owns, per frame resources elsewhere use the same index
+		// The fence of a frame guards all of them, the swapchain image index only selects the image to present
+		struct FrameContext
+		{
+			VkCommandPool mCommandPool = VK_NULL_HANDLE; // Reset as a whole once the fence is signaled
+			VkCommandBuffer mCommandBuffer = VK_NULL_HANDLE;
+			VkSemaphore mImageAvailable = VK_NULL_HANDLE;
+			VkSemaphore mRenderFinished = VK_NULL_HANDLE;
+			VkFence mInFlight = VK_NULL_HANDLE;
+
+			bool mLatencyPending = false; // Submitted after BeginFrame, measured once the fence is seen signaled
+			FramePacer::Clock::time_point mInputTime;
+
+			std::vector<VkDescriptorSet> mRetiredMaterialSets; // Returned to the allocator once this frame context comes around again
+		};
 
-		std::vector<VkSemaphore> imageAvailableSemaphores;
-		std::vector<VkSemaphore> renderFinishedSemaphores;
-		std::vector<VkFence> inFlightFences;
-		std::vector<VkFence> imagesInFlight;
-		size_t currentFrame = 0;
+		std::array<FrameContext, MAX_FRAMES_IN_FLIGHT> mFrames;
+		uint32_t mFramesInFlight = DEFAULT_FRAMES_IN_FLIGHT;
+		uint32_t mFrameIndex = 0;
 
 
 		std::vector<std::shared_ptr<Gfx::BufferGPU>> mUniformBuffersCamera;
@@ -165,10 +239,70 @@ namespace Flux
 
 		std::vector<std::shared_ptr<VkDescriptorSet>> mSceneSets;
 		std::vector<std::pair<RenderState, std::shared_ptr<Flux::Gfx::GraphicsPipeline>>> mPipelines;
+		std::unordered_map<uint64_t, uint32_t> mPipelineLookup; // Render state hash to index in mPipelines
+		std::vector<float> mPipelineCompileTimesMs; // Same indexing as mPipelines
+
+		PendingPipelineMode mPendingPipelineMode = PendingPipelineMode::eSkip;
+		std::optional<uint32_t> mFallbackPipelineIndex;
+
+		std::unique_ptr<PipelineCompiler> mPipelineCompiler;
+		std::unordered_set<uint64_t> mFailedPipelines;
+		std::mutex mShaderRegistryMutex; // Guards mShadersAll and the root signature registry, pipelines are created on worker threads
 
 
 		std::unique_ptr<RenderingResourceManager> mResourceManager;
 
+		std::unique_ptr<ParallelCommandRecorder> mCommandRecorder; // Depth and scene pass draws
+
+		RenderQueue mRenderQueue; // Rebuilt every frame, both passes record in its order
+		BindStats mDepthBindStats; // Last frame
+		BindStats mSceneBindStats;
+
+		Gfx::FrameGraph mFrameGraph; // Rebuilt every frame, the image states carry over
+
+		// Frame pacing and what it achieved, cleared whenever the policy or the frames in flight change
+		struct PresentationData
+		{
+			Gfx::PresentPolicy mPolicy;
+			FramePacer mPacer;
+
+			bool mInputSampled = false; // BeginFrame was called since the last submission
+			FramePacer::Clock::time_point mInputTime;
+			FramePacer::Clock::time_point mLastInputTime;
+
+			RollingStatistics mFrameTimesMs; // Between input samples
+			RollingStatistics mLatenciesMs; // Input sample to GPU completion, fences are polled once per frame so this is an upper bound
+			uint64_t mLatenciesMeasured = 0; // Never cleared, tells callers how many of the latencies are new
+			RollingStatistics mWaitTimesMs; // Spent in the frame limiter and the low latency wait
+		}mPresentation;
+
+		// GPU time of every frame graph pass, a capture writes them with the CPU zones into one trace
+		struct ProfilingData
+		{
+			std::unique_ptr<GpuProfiler> mGpu;
+
+			ChromeTrace mTrace;
+			uint32_t mCaptureFramesLeft = 0; // A capture runs while above 0
+			FramePacer::Clock::time_point mCaptureOrigin;
+			std::string mCaptureStatus;
+		}mProfiling;
+
+		// Without a window there is nothing to acquire or present, every frame renders into the offscreen image of its frame in flight
+		struct HeadlessData
+		{
+			bool mReadbackEnabled = false;
+			std::array<std::shared_ptr<Gfx::BufferGPU>, MAX_FRAMES_IN_FLIGHT> mReadbackBuffers; // Created on first use, as large as the swapchain image
+			std::array<bool, MAX_FRAMES_IN_FLIGHT> mReadbackPending{}; // The last submission of the frame copied its image
+
+			std::vector<uint8_t> mLastFrame;
+			uint32_t mLastFrameWidth = 0;
+			uint32_t mLastFrameHeight = 0;
+		}mHeadless;
+
+		// Copies the image the last submission of this frame read back, only call once its fence is signaled
+		void ReadFrameBack(uint32_t aFrameIndex);
+		void DestroyReadbackBuffers();
+
 		struct VertexPosUv
 		{
 			glm::vec3 position;
@@ -183,8 +317,12 @@ namespace Flux
 	private:
 		std::optional<std::shared_ptr<Flux::Gfx::Shader>> DoesShaderExist(std::string aFilePath);
 		std::optional<std::shared_ptr<Flux::Gfx::RootSignature>> DoesRootSignatureExist(const std::vector<std::shared_ptr<Flux::Gfx::Shader>>& aShaders);
+		void AddRootSignature(std::shared_ptr<Flux::Gfx::RootSignature> aRootSignature);
 
 
+		// Queues, pools and profilers shared by the windowed and the headless constructor
+		void InitDevice();
+
 		void InitVulkan();
 
 		void SetupQueryPool();
@@ -195,9 +333,39 @@ namespace Flux
 
 		void RecreateSwapChain();
 
-		std::shared_ptr<Flux::Gfx::GraphicsPipeline> CreateGraphicsPipelineForState(RenderState state);
-		std::optional<uint32_t> QueryPipeline(RenderState state);
-		uint32_t CreatePipeline(RenderState state);
+		// Requests the render targets from the transient pool, true when they were recreated and the descriptors referencing them need an update
+		bool AcquireRenderTargets();
+		void DestroyRenderTargets();
+
+		void UpdateShadowDescriptorSets();
+
+		void UpdatePostfxDescriptorSet();
+
+		void WaitForFramesInFlight();
+
+		// Finishes the latency measurement of every frame whose fence has been signaled
+		void CollectFrameLatencies();
+		void ClearPresentationStats();
+
+		// Records the next frames into a trace file, GPU zones arrive once their frames finished
+		void StartTraceCapture();
+		void FinishTraceCapture();
+
+		std::shared_ptr<Flux::Gfx::GraphicsPipeline> CreateGraphicsPipelineForState(const RenderState& state);
+		std::optional<uint32_t> QueryPipeline(const RenderState& state);
+		uint32_t CreatePipeline(const RenderState& state);
+		void RequestPipeline(const RenderState& state);
+		void CollectCompiledPipelines();
+		uint32_t AddPipeline(const RenderState& state, std::shared_ptr<Flux::Gfx::GraphicsPipeline> aPipeline, float aCompileTimeMs);
+
+		// Pipeline to draw the object with this frame, the fallback while its own pipeline is compiling
+		std::optional<uint32_t> GetDrawPipeline(RenderState& state);
+
+		// Draw time check that the cached stateID still points at the pipeline for this state
+		bool IsPipelineValid(const RenderState& state) const
+		{
+			return state.stateID.has_value() && state.stateID.value() < mPipelines.size() && mPipelines[state.stateID.value()].first.mHash == state.mHash;
+		}
 
 		void CreateCommandPool();
 
@@ -207,27 +375,89 @@ namespace Flux
 
 		void CreateDescriptorSets();
 
-		void CreateCommandBuffers();
+		// One set per frame in flight
+		void AllocatePersistentDescriptorSets(VkDescriptorSetLayout aLayout, std::vector<VkDescriptorSet>& aOutSets);
+
+		void CreateFrameContexts();
+		void DestroyFrameContexts();
+
+		void CreateCommandRecorder();
+
+		void CreateBindlessResources();
+
+		void CreateGpuDrivenResources();
+
+		void CreateOcclusionCullingResources();
+
+		void CreateInstanceBuffers();
+
+		// Grows the instance buffer of this frame, only call once its last submission has finished
+		void ReserveInstances(uint32_t aFrameIndex, size_t aCount);
+
+		// Points the depth pyramid at the current scene depth, call whenever the render targets were recreated
+		void UpdateOcclusionCullingTargets();
+
+		void CreateMaterialDescriptorSet(Material& aMaterial);
+		// Earlier frames may still bind the set of a released material, so it is only freed after the fence of this frame context
+		void ReleaseUnusedMaterials(FrameContext& aFrame);
+		void FreeRetiredMaterialSets(FrameContext& aFrame);
+
+		bool DrawsBindless(const RenderState& state) const
+		{
+			return mBindless.mMaterials != nullptr && state.mHash == mBindless.mSceneStateHash;
+		}
+
+		bool DrawsObjectBindless(const iSceneObject& aObject, size_t aObjectIndex) const;
+
+		bool DrawsGpuDriven() const
+		{
+			return mGpuDriven.mScene != nullptr && mGpuDriven.mScene->IsReady();
+		}
+
+		// Left out of the render queue, the culling pass writes its draws
+		bool DrawsObjectGpuDriven(const iSceneObject& aObject, size_t aObjectIndex) const;
+
+		// Fills mFrustumCulling with the objects that are not GPU-driven and tests them against both views
+		// Objects the camera sees are also tested against the depth pyramid, the occluded ones become late candidates
+		void CullObjects(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, const std::shared_ptr<Camera> aCamera);
 
-		void CreateSyncObjects();
+		// Sorts the objects that survived CullObjects by pass, pipeline, material, mesh and distance to the camera
+		// An object only gets a depth draw when the light sees it and a scene draw when the camera does
+		void BuildRenderQueue(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, const std::shared_ptr<Camera> aCamera);
 
-		void UpdateUniformBuffer(uint32_t currentImage, std::shared_ptr<Camera> aCam, std::vector<std::shared_ptr<Light>> aLights);
+		// Merges neighbouring queue items that share mesh, material and pipeline into instanced draws and writes their transforms
+		void BuildInstanceBatches(const std::vector<std::shared_ptr<iSceneObject>>& aSceneObjects, uint32_t aFrameIndex);
+
+		void UpdateUniformBuffer(uint32_t aFrameIndex, std::shared_ptr<Camera> aCam, std::vector<std::shared_ptr<Light>> aLights);
 
 		GLFWwindow* mWindow;
 
 	public:
 		std::vector < std::shared_ptr<Flux::Gfx::Shader>> mShadersAll;
 		std::vector<std::shared_ptr<Flux::Gfx::RootSignature>> mRootSignaturesAll;
+		std::map<std::vector<uint32_t>, std::shared_ptr<Flux::Gfx::RootSignature>> mRootSignatureLookup; // Sorted interned shader paths to root signature
 
 		std::shared_ptr<Flux::Gfx::RenderContext> mRenderContext;
 		std::shared_ptr<Flux::Gfx::Swapchain> mSwapchain;
 		std::shared_ptr<Flux::Gfx::Queue> mQueueGraphics;
 		std::shared_ptr<Flux::Gfx::Queue> mQueuePresent;
 		std::shared_ptr<Flux::Gfx::DescriptorPool> mDescriptorPool;
+		std::shared_ptr<Flux::Gfx::DescriptorAllocator> mDescriptorAllocator;
 
 		std::shared_ptr<Flux::Gfx::RenderTarget> mRenderTargetScene;
+		std::shared_ptr<Flux::Gfx::RenderTarget> mRenderTargetSceneLate; // Same images, loads what the scene pass drew
 
 		std::shared_ptr<Flux::Gfx::RenderTarget> mRenderTargetFinal;
+
+		// Owns the images of the shadow, scene and final targets, handles are valid for the current frame
+		std::shared_ptr<Flux::Gfx::TransientResourcePool> mTransientPool;
+		struct TransientTargets
+		{
+			uint32_t mShadowDepth = 0;
+			uint32_t mSceneColor = 0;
+			uint32_t mSceneDepth = 0;
+			uint32_t mFinal = 0;
+		} mTransientTargets;
 		std::shared_ptr<Flux::Gfx::RootSignature> mRootSignatureCompute;
 		std::shared_ptr<Flux::Gfx::Shader> mComputeShader;
 		std::shared_ptr<Flux::Gfx::ComputePipeline> mComputePipeline;
@@ -244,10 +474,100 @@ namespace Flux
 			std::vector<std::shared_ptr<Flux::Gfx::BufferGPU>> mBufferDepthTransformation;
 			std::vector<VkDescriptorSet> descriptorSet;
 			std::vector<VkDescriptorSet> descriptorSetShadowTexture;
+			glm::mat4 mLightMatrix; // Written with the uniform buffer, the shadow draws are culled against it
 
 
 		}mDepthOnlypass;
 
+		// Objects using the default scene shaders are drawn with basicModelBindless when descriptor indexing is supported
+		// Sets 0 and 2 are shared with the regular scene root signature, set 1 holds all materials and set 3 the object transforms
+		struct BindlessData
+		{
+			std::shared_ptr<Gfx::RootSignature> mRootSignature;
+			std::unique_ptr<BindlessMaterials> mMaterials;
+			std::optional<uint32_t> mPipelineIndex;
+			uint64_t mSceneStateHash = 0;
+
+			std::vector<std::shared_ptr<Flux::Gfx::BufferGPU>> mObjectBuffers; // Per frame in flight
+			std::vector<VkDescriptorSet> mObjectSets;
+		}mBindless;
+
+		// Bindless objects are culled and drawn by the GPU when indirect count draws are supported
+		// A compute pass writes the draws of the shadow and scene passes, which then take one indirect draw each
+		struct GpuDrivenData
+		{
+			std::unique_ptr<GpuScene> mScene;
+			std::shared_ptr<Gfx::RootSignature> mCullRootSignature;
+			std::shared_ptr<Gfx::ComputePipeline> mCullPipeline;
+			std::vector<VkDescriptorSet> mCullSets;
+
+			// simpleDepthIndirect, set 0 is compatible with the depth only pass and set 1 holds the bindless object buffer
+			std::shared_ptr<Gfx::RootSignature> mDepthRootSignature;
+			std::shared_ptr<Gfx::GraphicsPipeline> mDepthPipeline;
+			std::vector<VkDescriptorSet> mDepthObjectSets;
+
+			uint32_t mObjectCount = 0; // Handed to the culling pass this frame
+		}mGpuDriven;
+
+		// Objects recorded on the CPU are tested against the camera frustum and the light volume before they enter the render queue
+		struct FrustumCullingData
+		{
+			BoundingSphereSoA mSpheres; // World space
+			std::vector<uint32_t> mObjectIndices; // Scene object of every sphere
+			std::vector<uint8_t> mCameraVisible; // Per sphere
+			std::vector<uint8_t> mLightVisible; // Per sphere
+
+			size_t mCulledScene = 0;
+			size_t mCulledShadow = 0;
+			float mCullTimeMs = 0.0f;
+		}mFrustumCulling;
+
+		// Objects hidden behind the depth of the previous frame are skipped by the scene pass, the depth pyramid built
+		// from what the scene pass drew then decides which of them are drawn by the late scene pass
+		struct OcclusionCullingData
+		{
+			std::unique_ptr<HiZCulling> mHiZ;
+			std::shared_ptr<Gfx::RootSignature> mBuildRootSignature;
+			std::shared_ptr<Gfx::ComputePipeline> mBuildPipeline;
+			std::vector<VkDescriptorSet> mBuildSets; // One per pyramid level
+			std::shared_ptr<Gfx::RootSignature> mLateRootSignature;
+			std::shared_ptr<Gfx::ComputePipeline> mLatePipeline;
+			std::vector<VkDescriptorSet> mLateSets;
+
+			bool mEnabled = true;
+
+			std::vector<uint32_t> mCandidateSlots; // Per scene object, the indirect draw of a late candidate
+
+			size_t mTestedObjects = 0;
+			size_t mOccludedObjects = 0;
+			size_t mOccludedTriangles = 0;
+			GpuSceneOcclusionStats mGpuStats; // Last submission of the current image
+		}mOcclusionCulling;
+
+		// Objects that are not bindless take their transform from a per frame instance buffer, so repeated objects share one draw
+		// Set 3 of the scene pipelines and set 1 of the depth only pipeline hold the buffer
+		struct InstanceBatch
+		{
+			uint32_t mObjectIndex; // First object, the others share its mesh, material and pipeline
+			uint32_t mInstanceCount;
+			uint32_t mFirstInstance; // The object index for bindless objects, they are never merged
+		};
+
+		struct InstancingData
+		{
+			std::vector<std::shared_ptr<Gfx::BufferGPU>> mBuffers; // Per frame in flight
+			std::vector<size_t> mCapacities; // In transforms
+			VkDescriptorSet mSceneSet = VK_NULL_HANDLE; // Transient, written for the frame being built
+			VkDescriptorSet mDepthSet = VK_NULL_HANDLE;
+
+			// Same order as the queue items of their pass
+			std::vector<InstanceBatch> mDepthBatches;
+			std::vector<InstanceBatch> mSceneBatches;
+			std::vector<InstanceBatch> mSceneLateBatches; // Never merged, each candidate has an indirect draw of its own
+
+			uint32_t mInstanceCount = 0;
+		}mInstancing;
+
 
 		VkQueryPool mQueryPool;
 
@@ -0,0 +1,205 @@
+#include "GpuProfiler.h"
+
+#include <cassert>
+#include <chrono>
+#include <stdexcept>
+
+using namespace Flux::Gfx;
+
+Flux::GpuProfiler::GpuProfiler(std::shared_ptr<Gfx::RenderContext> aContext, uint32_t aQueueFamily, uint32_t aFrameCount) :
+	mContext(aContext), mQueryPool(VK_NULL_HANDLE), mValidBits(0), mTimestampPeriod(aContext->mDevice->mPhysicalDeviceProperties.limits.timestampPeriod),
+	mRecordingFrame(0), mTrace(nullptr), mTraceTrack(0)
+{
+	mFrames.resize(aFrameCount);
+
+	uint32_t tFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(mContext->mDevice->mPhysicalDevice, &tFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> tFamilies(tFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(mContext->mDevice->mPhysicalDevice, &tFamilyCount, tFamilies.data());
+
+	assert(aQueueFamily < tFamilyCount);
+	mValidBits = tFamilies[aQueueFamily].timestampValidBits;
+
+	// Zero valid bits means the queue can not write timestamps
+	if (mValidBits == 0)
+	{
+		return;
+	}
+
+	VkQueryPoolCreateInfo tQueryPoolInfo{};
+	tQueryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	tQueryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	tQueryPoolInfo.queryCount = aFrameCount * MAX_ZONES * 2;
+
+	if (vkCreateQueryPool(mContext->mDevice->mDevice, &tQueryPoolInfo, nullptr, &mQueryPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create timestamp query pool!");
+	}
+}
+
+Flux::GpuProfiler::~GpuProfiler()
+{
+	if (mQueryPool != VK_NULL_HANDLE)
+	{
+		vkDestroyQueryPool(mContext->mDevice->mDevice, mQueryPool, nullptr);
+	}
+}
+
+void Flux::GpuProfiler::Collect(uint32_t aFrameIndex)
+{
+	assert(aFrameIndex < mFrames.size());
+	FrameQueries& tFrame = mFrames[aFrameIndex];
+
+	for (auto& zone : mZones)
+	{
+		zone.mCalls = 0;
+		zone.mFrameMilliseconds = 0.0;
+	}
+
+	if (!IsSupported() || !tFrame.mSubmitted || tFrame.mZones.empty())
+	{
+		return;
+	}
+
+	tFrame.mSubmitted = false;
+
+	// Every timestamp is followed by its availability, a zone is skipped unless both of its timestamps were written
+	const uint32_t tQueryCount = static_cast<uint32_t>(tFrame.mZones.size()) * 2;
+	std::vector<uint64_t> tResults(tQueryCount * 2, 0);
+
+	const VkResult tResult = vkGetQueryPoolResults(mContext->mDevice->mDevice, mQueryPool, GetFirstQuery(aFrameIndex), tQueryCount,
+		sizeof(uint64_t) * tResults.size(), tResults.data(), sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+	if (tResult != VK_SUCCESS && tResult != VK_NOT_READY)
+	{
+		throw std::runtime_error("failed to read timestamp queries!");
+	}
+
+	// The first zone that began is placed at the submit time, the others relative to it
+	const uint64_t tOriginTicks = tResults[0];
+
+	for (size_t i = 0; i < tFrame.mZones.size(); ++i)
+	{
+		const Zone& tZone = tFrame.mZones[i];
+		const uint64_t* tBegin = &tResults[i * 4];
+		const uint64_t* tEnd = &tResults[i * 4 + 2];
+
+		if (!tZone.mEnded || tBegin[1] == 0 || tEnd[1] == 0)
+		{
+			continue;
+		}
+
+		const double tMilliseconds = TicksToMilliseconds(tBegin[0], tEnd[0], mValidBits, mTimestampPeriod);
+
+		auto tLookup = mZoneLookup.find(tZone.mName);
+		if (tLookup == mZoneLookup.end())
+		{
+			tLookup = mZoneLookup.emplace(tZone.mName, mZones.size()).first;
+			mZones.emplace_back();
+			mZones.back().mName = tZone.mName;
+			mZones.back().mDepth = tZone.mDepth;
+		}
+		ZoneStatistics& tStatistics = mZones[tLookup->second];
+		tStatistics.mMilliseconds.Add(tMilliseconds);
+		tStatistics.mCalls++;
+		tStatistics.mFrameMilliseconds += tMilliseconds;
+
+		// Frames submitted before the trace started are left out
+		if (mTrace != nullptr && tFrame.mSubmitTime >= mTraceOrigin)
+		{
+			const double tSubmitMicroseconds = std::chrono::duration<double, std::micro>(tFrame.mSubmitTime - mTraceOrigin).count();
+
+			TraceEvent tEvent;
+			tEvent.mName = tZone.mName;
+			tEvent.mCategory = "gpu";
+			tEvent.mTrack = mTraceTrack;
+			tEvent.mStartMicroseconds = tSubmitMicroseconds + TicksToMilliseconds(tOriginTicks, tBegin[0], mValidBits, mTimestampPeriod) * 1000.0;
+			tEvent.mDurationMicroseconds = tMilliseconds * 1000.0;
+			mTrace->AddEvent(tEvent);
+		}
+	}
+}
+
+void Flux::GpuProfiler::BeginFrame(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex)
+{
+	assert(aFrameIndex < mFrames.size());
+	assert(mOpenZones.empty());
+
+	mRecordingFrame = aFrameIndex;
+
+	FrameQueries& tFrame = mFrames[aFrameIndex];
+	tFrame.mZones.clear();
+	tFrame.mSubmitted = false;
+
+	if (IsSupported())
+	{
+		vkCmdResetQueryPool(aCommandBuffer, mQueryPool, GetFirstQuery(aFrameIndex), MAX_ZONES * 2);
+	}
+}
+
+void Flux::GpuProfiler::EndFrame(uint32_t aFrameIndex, FramePacer::Clock::time_point aSubmitTime)
+{
+	assert(aFrameIndex == mRecordingFrame);
+	assert(mOpenZones.empty());
+
+	FrameQueries& tFrame = mFrames[aFrameIndex];
+	tFrame.mSubmitted = true;
+	tFrame.mSubmitTime = aSubmitTime;
+}
+
+void Flux::GpuProfiler::BeginZone(VkCommandBuffer aCommandBuffer, const std::string& aName)
+{
+	FrameQueries& tFrame = mFrames[mRecordingFrame];
+
+	if (!IsSupported() || tFrame.mZones.size() >= MAX_ZONES)
+	{
+		mOpenZones.push_back(UINT32_MAX);
+		return;
+	}
+
+	const uint32_t tZone = static_cast<uint32_t>(tFrame.mZones.size());
+	tFrame.mZones.push_back({ aName, static_cast<uint32_t>(mOpenZones.size()), false });
+	mOpenZones.push_back(tZone);
+
+	vkCmdWriteTimestamp(aCommandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mQueryPool, GetFirstQuery(mRecordingFrame) + tZone * 2);
+}
+
+void Flux::GpuProfiler::EndZone(VkCommandBuffer aCommandBuffer)
+{
+	assert(!mOpenZones.empty());
+
+	const uint32_t tZone = mOpenZones.back();
+	mOpenZones.pop_back();
+
+	if (tZone == UINT32_MAX)
+	{
+		return;
+	}
+
+	// Written once every command before it has finished
+	vkCmdWriteTimestamp(aCommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mQueryPool, GetFirstQuery(mRecordingFrame) + tZone * 2 + 1);
+	mFrames[mRecordingFrame].mZones[tZone].mEnded = true;
+}
+
+void Flux::GpuProfiler::ClearStatistics()
+{
+	for (auto& zone : mZones)
+	{
+		zone.mMilliseconds.Clear();
+	}
+}
+
+void Flux::GpuProfiler::SetTrace(ChromeTrace* aTrace, uint32_t aTrack, FramePacer::Clock::time_point aOrigin)
+{
+	mTrace = aTrace;
+	mTraceTrack = aTrack;
+	mTraceOrigin = aOrigin;
+}
+
+double Flux::GpuProfiler::TicksToMilliseconds(uint64_t aBegin, uint64_t aEnd, uint32_t aValidBits, float aTimestampPeriod)
+{
+	const uint64_t tMask = aValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << aValidBits) - 1;
+	const uint64_t tTicks = (aEnd - aBegin) & tMask;
+
+	return static_cast<double>(tTicks) * static_cast<double>(aTimestampPeriod) / 1000000.0;
+}
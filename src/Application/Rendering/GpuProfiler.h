@@ -0,0 +1,115 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "Renderer/RenderContext.h"
+
+#include "Common/Time/FramePacer.h"
+#include "Common/Profiling/ChromeTrace.h"
+
+namespace Flux
+{
+
+// Measures the GPU time of zones with timestamp queries, every frame in flight has its own range of queries
+// Timings are picked up once the fence of the frame shows it finished, so collecting never waits on the GPU
+// Without timestamp support on the queue nothing is recorded and no zones are reported
+class GpuProfiler
+{
+public:
+	static constexpr uint32_t MAX_ZONES = 64; // Per frame, later zones are not measured
+
+	GpuProfiler(std::shared_ptr<Gfx::RenderContext> aContext, uint32_t aQueueFamily, uint32_t aFrameCount);
+	~GpuProfiler();
+
+	bool IsSupported() const { return mQueryPool != VK_NULL_HANDLE; }
+
+	// Picks up the timings the last submission of this frame wrote, call once it has finished
+	void Collect(uint32_t aFrameIndex);
+
+	// Resets the queries of this frame, record outside a render pass before the first zone
+	void BeginFrame(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex);
+
+	// The frame was submitted at aSubmitTime, its zones are placed on the CPU timeline of a trace from there
+	void EndFrame(uint32_t aFrameIndex, FramePacer::Clock::time_point aSubmitTime);
+
+	// Zones nest, record both outside a render pass or both inside the same one
+	void BeginZone(VkCommandBuffer aCommandBuffer, const std::string& aName);
+	void EndZone(VkCommandBuffer aCommandBuffer);
+
+	class Scope
+	{
+	public:
+		Scope(GpuProfiler& aProfiler, VkCommandBuffer aCommandBuffer, const std::string& aName) : mProfiler(aProfiler), mCommandBuffer(aCommandBuffer) { mProfiler.BeginZone(mCommandBuffer, aName); }
+		~Scope() { mProfiler.EndZone(mCommandBuffer); }
+
+	private:
+		Scope(const Scope&) = delete;
+		Scope& operator= (const Scope&) = delete;
+
+		GpuProfiler& mProfiler;
+		VkCommandBuffer mCommandBuffer;
+	};
+
+	struct ZoneStatistics
+	{
+		std::string mName;
+		uint32_t mDepth = 0; // Number of zones around it
+		uint32_t mCalls = 0; // Frame read by the last Collect, 0 when it had nothing to read
+		double mFrameMilliseconds = 0.0; // Same frame, summed over its calls
+		RollingStatistics mMilliseconds; // Per call
+	};
+
+	// In the order the zones were first measured
+	const std::vector<ZoneStatistics>& GetZones() const { return mZones; }
+	void ClearStatistics();
+
+	// Zones collected from now on are added to aTrace on aTrack, relative to aOrigin, until the trace is set to nullptr
+	void SetTrace(ChromeTrace* aTrace, uint32_t aTrack, FramePacer::Clock::time_point aOrigin);
+
+	// Difference of two timestamps in milliseconds, the counters wrap at aValidBits
+	static double TicksToMilliseconds(uint64_t aBegin, uint64_t aEnd, uint32_t aValidBits, float aTimestampPeriod);
+
+private:
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator= (const GpuProfiler&) = delete;
+
+	struct Zone
+	{
+		std::string mName;
+		uint32_t mDepth;
+		bool mEnded;
+	};
+
+	// Zone i writes query 2 * i when it begins and 2 * i + 1 when it ends, both relative to the range of the frame
+	struct FrameQueries
+	{
+		std::vector<Zone> mZones;
+		bool mSubmitted = false;
+		FramePacer::Clock::time_point mSubmitTime;
+	};
+
+	uint32_t GetFirstQuery(uint32_t aFrameIndex) const { return aFrameIndex * MAX_ZONES * 2; }
+
+	std::shared_ptr<Gfx::RenderContext> mContext;
+	VkQueryPool mQueryPool;
+	uint32_t mValidBits;
+	float mTimestampPeriod; // Nanoseconds per tick
+
+	std::vector<FrameQueries> mFrames;
+	uint32_t mRecordingFrame;
+	std::vector<uint32_t> mOpenZones; // Of the frame being recorded, zones past MAX_ZONES are UINT32_MAX
+
+	std::vector<ZoneStatistics> mZones;
+	std::unordered_map<std::string, size_t> mZoneLookup;
+
+	ChromeTrace* mTrace;
+	uint32_t mTraceTrack;
+	FramePacer::Clock::time_point mTraceOrigin;
+};
+
+}
@@ -0,0 +1,336 @@
+#include "GpuScene.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "Renderer/Renderer.h"
+#include "Common/Culling/FrustumCulling.h"
+
+using namespace Flux::Gfx;
+
+static constexpr uint32_t CULL_GROUP_SIZE = 64; // local_size_x of cullObjects.comp
+
+static std::shared_ptr<BufferGPU> CreateHostBuffer(std::shared_ptr<RenderContext> aContext, VkDeviceSize aSize, VkBufferUsageFlags aUsage)
+{
+	std::shared_ptr<BufferGPU> tBuffer = std::make_shared<BufferGPU>();
+	tBuffer->mUsageFlags = aUsage;
+	tBuffer->mMemoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU;
+	Renderer::CreateBuffer(aContext->mDevice->mDevice, aContext->memoryAllocator, aSize, aUsage, tBuffer->mMemoryUsage, tBuffer->mBuffer, tBuffer->mAllocation);
+	return tBuffer;
+}
+
+static std::shared_ptr<BufferGPU> CreateDeviceBuffer(std::shared_ptr<RenderContext> aContext, VkDeviceSize aSize, VkBufferUsageFlags aUsage)
+{
+	std::shared_ptr<BufferGPU> tBuffer = std::make_shared<BufferGPU>();
+	tBuffer->mUsageFlags = aUsage;
+	tBuffer->mMemoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY;
+	Renderer::CreateBuffer(aContext->mDevice->mDevice, aContext->memoryAllocator, aSize, aUsage, tBuffer->mMemoryUsage, tBuffer->mBuffer, tBuffer->mAllocation);
+	return tBuffer;
+}
+
+static std::shared_ptr<BufferGPU> CreateReadbackBuffer(std::shared_ptr<RenderContext> aContext, VkDeviceSize aSize, VkBufferUsageFlags aUsage)
+{
+	std::shared_ptr<BufferGPU> tBuffer = std::make_shared<BufferGPU>();
+	tBuffer->mUsageFlags = aUsage;
+	tBuffer->mMemoryUsage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_TO_CPU;
+	Renderer::CreateBuffer(aContext->mDevice->mDevice, aContext->memoryAllocator, aSize, aUsage, tBuffer->mMemoryUsage, tBuffer->mBuffer, tBuffer->mAllocation);
+
+	// Read before the first submission that writes it
+	void* data;
+	vmaMapMemory(aContext->memoryAllocator, tBuffer->mAllocation, &data);
+	memset(data, 0, aSize);
+	vmaUnmapMemory(aContext->memoryAllocator, tBuffer->mAllocation);
+	vmaFlushAllocation(aContext->memoryAllocator, tBuffer->mAllocation, 0, VK_WHOLE_SIZE);
+
+	return tBuffer;
+}
+
+static void DestroyBuffer(std::shared_ptr<RenderContext> aContext, std::shared_ptr<BufferGPU>& aBuffer)
+{
+	if (aBuffer != nullptr)
+	{
+		vkDestroyBuffer(aContext->mDevice->mDevice, aBuffer->mBuffer, nullptr);
+		vmaFreeMemory(aContext->memoryAllocator, aBuffer->mAllocation);
+		aBuffer = nullptr;
+	}
+}
+
+Flux::GpuScene::GpuScene(std::shared_ptr<Gfx::RenderContext> aContext, std::shared_ptr<Gfx::RootSignature> aCullRootSignature, std::shared_ptr<Gfx::ComputePipeline> aCullPipeline,
+	const std::vector<std::shared_ptr<Gfx::BufferGPU>>& aObjectBuffers, const std::vector<VkDescriptorSet>& aCullSets, uint32_t aMaxObjects) :
+	mContext(aContext), mCullRootSignature(aCullRootSignature), mCullPipeline(aCullPipeline), mMaxObjects(aMaxObjects),
+	mGeometryDirty(false), mVertexCount(0), mIndexCount(0), mPyramidView(VK_NULL_HANDLE), mPyramidSampler(VK_NULL_HANDLE)
+{
+	assert(aContext->mDevice->mCmdDrawIndexedIndirectCount != nullptr);
+	assert(aObjectBuffers.size() == aCullSets.size());
+
+	mFrames.resize(aObjectBuffers.size());
+
+	for (size_t i = 0; i < mFrames.size(); ++i)
+	{
+		FrameBuffers& tFrame = mFrames[i];
+		tFrame.mCullData = CreateHostBuffer(mContext, sizeof(GpuSceneCullData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+
+		for (auto& draws : tFrame.mDraws)
+		{
+			draws = CreateDeviceBuffer(mContext, sizeof(VkDrawIndexedIndirectCommand) * mMaxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		}
+
+		tFrame.mDrawCounts = CreateDeviceBuffer(mContext, sizeof(uint32_t) * static_cast<size_t>(GpuSceneView::eCount), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		tFrame.mLateCandidates = CreateDeviceBuffer(mContext, sizeof(uint32_t) * mMaxObjects, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		tFrame.mStats = CreateReadbackBuffer(mContext, sizeof(GpuSceneOcclusionStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		tFrame.mObjects = aObjectBuffers[i];
+		tFrame.mCullSet = aCullSets[i];
+		tFrame.mObjectCount = 0;
+	}
+}
+
+Flux::GpuScene::~GpuScene()
+{
+	DestroyGeometry();
+
+	for (auto& frame : mFrames)
+	{
+		DestroyBuffer(mContext, frame.mCullData);
+		DestroyBuffer(mContext, frame.mDrawCounts);
+		DestroyBuffer(mContext, frame.mLateCandidates);
+		DestroyBuffer(mContext, frame.mStats);
+
+		for (auto& draws : frame.mDraws)
+		{
+			DestroyBuffer(mContext, draws);
+		}
+	}
+}
+
+uint32_t Flux::GpuScene::RegisterMesh(const std::shared_ptr<MeshAsset>& aAsset)
+{
+	assert(aAsset);
+
+	auto tExisting = mMeshIndices.find(aAsset.get());
+	if (tExisting != mMeshIndices.end())
+	{
+		return tExisting->second;
+	}
+
+	const uint32_t tIndex = static_cast<uint32_t>(mMeshes.size());
+	mMeshes.push_back(aAsset);
+	mMeshIndices[aAsset.get()] = tIndex;
+	mGeometryDirty = true;
+
+	return tIndex;
+}
+
+void Flux::GpuScene::UploadGeometry(VkQueue aQueue, VkCommandPool aCommandPool)
+{
+	if (!mGeometryDirty)
+	{
+		return;
+	}
+
+	// Meshes are normally all registered while the scene loads, so rebuilding everything is cheaper than managing free space
+	if (HasGeometry())
+	{
+		vkDeviceWaitIdle(mContext->mDevice->mDevice);
+		DestroyGeometry();
+	}
+
+	std::vector<VertexData> tVertices;
+	std::vector<uint32_t> tIndices;
+	std::vector<GpuSceneMeshData> tMeshData;
+	tMeshData.reserve(mMeshes.size());
+
+	for (const auto& mesh : mMeshes)
+	{
+		GpuSceneMeshData tData{};
+		tData.mFirstIndex = static_cast<uint32_t>(tIndices.size());
+		tData.mIndexCount = static_cast<uint32_t>(mesh->mIndices.size());
+		tData.mVertexOffset = static_cast<int32_t>(tVertices.size());
+		tData.mBoundingSphere = mesh->mBoundingSphere;
+		tMeshData.push_back(tData);
+
+		tVertices.insert(tVertices.end(), mesh->mVertexData.begin(), mesh->mVertexData.end());
+		tIndices.insert(tIndices.end(), mesh->mIndices.begin(), mesh->mIndices.end());
+	}
+
+	if (tVertices.empty() || tIndices.empty())
+	{
+		return;
+	}
+
+	const VkDevice tDevice = mContext->mDevice->mDevice;
+
+	mVertexBuffer = Renderer::CreateAndUploadBuffer(tDevice, aQueue, aCommandPool, mContext->memoryAllocator,
+		VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+		tVertices.data(), sizeof(tVertices[0]) * tVertices.size());
+
+	mIndexBuffer = Renderer::CreateAndUploadBuffer(tDevice, aQueue, aCommandPool, mContext->memoryAllocator,
+		VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY, VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+		tIndices.data(), sizeof(tIndices[0]) * tIndices.size());
+
+	mMeshBuffer = Renderer::CreateAndUploadBuffer(tDevice, aQueue, aCommandPool, mContext->memoryAllocator,
+		VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+		tMeshData.data(), sizeof(tMeshData[0]) * tMeshData.size());
+
+	mVertexCount = static_cast<uint32_t>(tVertices.size());
+	mIndexCount = static_cast<uint32_t>(tIndices.size());
+	mGeometryDirty = false;
+
+	// Nothing reads the sets at this point, either they were never used or the device was idled above
+	WriteCullSets();
+}
+
+void Flux::GpuScene::SetDepthPyramid(VkImageView aView, VkSampler aSampler)
+{
+	mPyramidView = aView;
+	mPyramidSampler = aSampler;
+
+	WriteCullSets();
+}
+
+void Flux::GpuScene::UpdateCullData(uint32_t aFrameIndex, const glm::mat4& aCameraViewProjection, const glm::mat4& aLightViewProjection, uint32_t aObjectCount, const GpuSceneOcclusion& aOcclusion)
+{
+	assert(aFrameIndex < mFrames.size());
+	FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	GpuSceneCullData tCullData{};
+	const Frustum tCameraFrustum = Frustum::FromMatrix(aCameraViewProjection);
+	const Frustum tLightFrustum = Frustum::FromMatrix(aLightViewProjection);
+	std::copy(std::begin(tCameraFrustum.mPlanes), std::end(tCameraFrustum.mPlanes), tCullData.mCameraPlanes);
+	std::copy(std::begin(tLightFrustum.mPlanes), std::end(tLightFrustum.mPlanes), tCullData.mLightPlanes);
+	tCullData.mViewProjection = aCameraViewProjection;
+	tCullData.mPreviousViewProjection = aOcclusion.mViewProjection;
+	tCullData.mPyramidSize = aOcclusion.mPyramidSize;
+	tCullData.mPyramidLevels = aOcclusion.mPyramidLevels;
+	tCullData.mObjectCount = std::min(aObjectCount, mMaxObjects);
+	tCullData.mEarlyOcclusion = aOcclusion.mEnabled ? 1 : 0;
+
+	void* data;
+	vmaMapMemory(mContext->memoryAllocator, tFrame.mCullData->mAllocation, &data);
+	memcpy(data, &tCullData, sizeof(tCullData));
+	vmaUnmapMemory(mContext->memoryAllocator, tFrame.mCullData->mAllocation);
+
+	tFrame.mObjectCount = tCullData.mObjectCount;
+}
+
+void Flux::GpuScene::RecordCulling(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex) const
+{
+	assert(IsReady());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	// The draw buffers of this frame were last read by a submission that has already finished, only the counts and stats need ordering
+	vkCmdFillBuffer(aCommandBuffer, tFrame.mDrawCounts->mBuffer, 0, VK_WHOLE_SIZE, 0);
+	vkCmdFillBuffer(aCommandBuffer, tFrame.mStats->mBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier tClearBarrier{};
+	tClearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tClearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	tClearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &tClearBarrier, 0, nullptr, 0, nullptr);
+
+	RecordPhase(aCommandBuffer, tFrame, 0);
+
+	// The late phase reads the candidates, the counts and the stats again
+	VkMemoryBarrier tDrawBarrier{};
+	tDrawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tDrawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	tDrawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &tDrawBarrier, 0, nullptr, 0, nullptr);
+}
+
+void Flux::GpuScene::RecordLateCulling(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex) const
+{
+	assert(IsReady());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	RecordPhase(aCommandBuffer, tFrame, 1);
+
+	VkMemoryBarrier tDrawBarrier{};
+	tDrawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tDrawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	tDrawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &tDrawBarrier, 0, nullptr, 0, nullptr);
+}
+
+Flux::GpuSceneOcclusionStats Flux::GpuScene::ReadOcclusionStats(uint32_t aFrameIndex) const
+{
+	assert(aFrameIndex < mFrames.size());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	GpuSceneOcclusionStats tStats;
+	void* data;
+	vmaInvalidateAllocation(mContext->memoryAllocator, tFrame.mStats->mAllocation, 0, VK_WHOLE_SIZE);
+	vmaMapMemory(mContext->memoryAllocator, tFrame.mStats->mAllocation, &data);
+	memcpy(&tStats, data, sizeof(tStats));
+	vmaUnmapMemory(mContext->memoryAllocator, tFrame.mStats->mAllocation);
+
+	return tStats;
+}
+
+void Flux::GpuScene::RecordDraws(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex, GpuSceneView aView) const
+{
+	assert(HasGeometry());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+	const size_t tView = static_cast<size_t>(aView);
+
+	const VkDeviceSize tOffset = 0;
+	vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, &mVertexBuffer->mBuffer, &tOffset);
+	vkCmdBindIndexBuffer(aCommandBuffer, mIndexBuffer->mBuffer, 0, VK_INDEX_TYPE_UINT32);
+
+	mContext->mDevice->mCmdDrawIndexedIndirectCount(aCommandBuffer,
+		tFrame.mDraws[tView]->mBuffer, 0,
+		tFrame.mDrawCounts->mBuffer, sizeof(uint32_t) * tView,
+		mMaxObjects, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+void Flux::GpuScene::RecordPhase(VkCommandBuffer aCommandBuffer, const FrameBuffers& aFrame, uint32_t aPhase) const
+{
+	if (aFrame.mObjectCount == 0)
+	{
+		return;
+	}
+
+	vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullPipeline->computePipeline);
+	vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mCullRootSignature->mPipelineLayout, 0, 1, &aFrame.mCullSet, 0, nullptr);
+	vkCmdPushConstants(aCommandBuffer, mCullRootSignature->mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(aPhase), &aPhase);
+	vkCmdDispatch(aCommandBuffer, (aFrame.mObjectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+}
+
+void Flux::GpuScene::DestroyGeometry()
+{
+	DestroyBuffer(mContext, mVertexBuffer);
+	DestroyBuffer(mContext, mIndexBuffer);
+	DestroyBuffer(mContext, mMeshBuffer);
+}
+
+void Flux::GpuScene::WriteCullSets()
+{
+	// Written once both the geometry and the pyramid exist, every binding is written at once
+	if (mMeshBuffer == nullptr || mPyramidView == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	for (const auto& frame : mFrames)
+	{
+		const std::array<DescriptorInfo, 11> tDescriptors =
+		{
+			DescriptorInfo(frame.mCullData->mBuffer, 0, sizeof(GpuSceneCullData)),
+			DescriptorInfo(frame.mObjects->mBuffer),
+			DescriptorInfo(mMeshBuffer->mBuffer),
+			DescriptorInfo(frame.mDraws[static_cast<size_t>(GpuSceneView::eScene)]->mBuffer),
+			DescriptorInfo(frame.mDraws[static_cast<size_t>(GpuSceneView::eShadow)]->mBuffer),
+			DescriptorInfo(frame.mDrawCounts->mBuffer),
+			DescriptorInfo(frame.mDraws[static_cast<size_t>(GpuSceneView::eSceneLate)]->mBuffer),
+			DescriptorInfo(frame.mLateCandidates->mBuffer),
+			DescriptorInfo(frame.mStats->mBuffer),
+			DescriptorInfo(mPyramidView, VK_IMAGE_LAYOUT_GENERAL),
+			DescriptorInfo(mPyramidSampler),
+		};
+
+		Renderer::UpdateDescriptorSet(mContext, mCullRootSignature, 0, frame.mCullSet, tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <glm/glm.hpp>
+
+#include "Renderer/RenderContext.h"
+#include "Renderer/RootSignature.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/BufferGPU.h"
+
+#include "Common/AssetProcessing/AssetObjects.h"
+
+namespace Flux
+{
+
+// Matches MeshData in common.glsl
+struct GpuSceneMeshData
+{
+	uint32_t mFirstIndex;
+	uint32_t mIndexCount;
+	int32_t mVertexOffset;
+	uint32_t mPadding;
+	glm::vec4 mBoundingSphere; // Object space center in xyz, radius in w
+};
+
+// Matches CullData in cullObjects.comp
+struct GpuSceneCullData
+{
+	glm::vec4 mCameraPlanes[6];
+	glm::vec4 mLightPlanes[6];
+	glm::mat4 mViewProjection;
+	glm::mat4 mPreviousViewProjection;
+	glm::vec2 mPyramidSize;
+	uint32_t mPyramidLevels;
+	uint32_t mObjectCount;
+	uint32_t mEarlyOcclusion;
+	uint32_t mPadding[3];
+};
+
+// Depth pyramid the early culling phase tests against
+struct GpuSceneOcclusion
+{
+	glm::mat4 mViewProjection; // The pyramid was built with it
+	glm::vec2 mPyramidSize;
+	uint32_t mPyramidLevels = 0;
+	bool mEnabled = false; // False while the pyramid holds no depth yet
+};
+
+// Matches Stats in cullObjects.comp, occluded objects are rejected by the early phase and rescued ones drawn by the late phase
+struct GpuSceneOcclusionStats
+{
+	uint32_t mOccludedObjects = 0;
+	uint32_t mOccludedTriangles = 0;
+	uint32_t mRescuedObjects = 0;
+	uint32_t mRescuedTriangles = 0;
+};
+
+// Draws written by the culling pass, one list and count per view
+enum class GpuSceneView
+{
+	eScene = 0,
+	eShadow = 1,
+	eSceneLate = 2, // Objects the early phase rejected that are visible in the depth of this frame
+	eCount
+};
+
+// Geometry and draw buffers of the GPU-driven path
+// Every registered mesh is merged into one vertex and one index buffer, so all draws of a view share the same bindings
+// The culling pass reads the bindless object buffers and writes compacted indirect draws and their counts per view,
+// which are then issued with a single indirect count draw each
+// Culling runs in two phases, the early phase also rejects objects hidden in the depth pyramid of the previous frame
+// and the late phase retests those against the pyramid built from the early scene draws of this frame
+class GpuScene
+{
+public:
+	// aObjectBuffers are the bindless object buffers, one per frame in flight, aCullSets are sets of the cull root signature for the same frames
+	GpuScene(std::shared_ptr<Gfx::RenderContext> aContext, std::shared_ptr<Gfx::RootSignature> aCullRootSignature, std::shared_ptr<Gfx::ComputePipeline> aCullPipeline,
+		const std::vector<std::shared_ptr<Gfx::BufferGPU>>& aObjectBuffers, const std::vector<VkDescriptorSet>& aCullSets, uint32_t aMaxObjects);
+	~GpuScene();
+
+	// Returns the index of the mesh in the mesh buffer, the geometry is uploaded by the next UploadGeometry
+	uint32_t RegisterMesh(const std::shared_ptr<MeshAsset>& aAsset);
+
+	// Rebuilds the merged buffers when meshes were registered, waits for the device first since frames in flight still read the old ones
+	void UploadGeometry(VkQueue aQueue, VkCommandPool aCommandPool);
+
+	bool HasGeometry() const { return mVertexBuffer != nullptr; }
+
+	// Culling needs the geometry and a depth pyramid to bind
+	bool IsReady() const { return HasGeometry() && mPyramidView != VK_NULL_HANDLE; }
+
+	// Both culling phases read this view, it has to stay in the general layout while they run
+	// Rewrites the culling sets, so no frame in flight may be using them
+	void SetDepthPyramid(VkImageView aView, VkSampler aSampler);
+
+	// The frusta are extracted from the view projection matrices, only the first aObjectCount objects are culled
+	void UpdateCullData(uint32_t aFrameIndex, const glm::mat4& aCameraViewProjection, const glm::mat4& aLightViewProjection, uint32_t aObjectCount, const GpuSceneOcclusion& aOcclusion);
+
+	// Clears the draw counts and stats, runs the early phase and makes the draws visible to the indirect draw stage
+	void RecordCulling(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex) const;
+
+	// Runs the late phase on the pyramid of this frame, the early phase has to be recorded before
+	void RecordLateCulling(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex) const;
+
+	// Stats of the last submission of this frame, only valid once it has finished
+	GpuSceneOcclusionStats ReadOcclusionStats(uint32_t aFrameIndex) const;
+
+	// Binds the merged geometry and issues the draws of aView, the pipeline and its sets have to be bound already
+	void RecordDraws(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex, GpuSceneView aView) const;
+
+	uint32_t GetMeshCount() const { return static_cast<uint32_t>(mMeshes.size()); }
+	uint32_t GetVertexCount() const { return mVertexCount; }
+	uint32_t GetIndexCount() const { return mIndexCount; }
+
+private:
+	GpuScene(const GpuScene&) = delete;
+	GpuScene& operator= (const GpuScene&) = delete;
+
+	void DestroyGeometry();
+	void WriteCullSets();
+
+	std::shared_ptr<Gfx::RenderContext> mContext;
+	std::shared_ptr<Gfx::RootSignature> mCullRootSignature;
+	std::shared_ptr<Gfx::ComputePipeline> mCullPipeline;
+	uint32_t mMaxObjects;
+
+	std::vector<std::shared_ptr<MeshAsset>> mMeshes;
+	std::unordered_map<const MeshAsset*, uint32_t> mMeshIndices;
+	bool mGeometryDirty;
+	uint32_t mVertexCount;
+	uint32_t mIndexCount;
+
+	std::shared_ptr<Gfx::BufferGPU> mVertexBuffer;
+	std::shared_ptr<Gfx::BufferGPU> mIndexBuffer;
+	std::shared_ptr<Gfx::BufferGPU> mMeshBuffer;
+
+	VkImageView mPyramidView;
+	VkSampler mPyramidSampler;
+
+	// Per frame in flight
+	struct FrameBuffers
+	{
+		std::shared_ptr<Gfx::BufferGPU> mCullData;
+		std::shared_ptr<Gfx::BufferGPU> mDraws[static_cast<size_t>(GpuSceneView::eCount)];
+		std::shared_ptr<Gfx::BufferGPU> mDrawCounts; // One uint per view
+		std::shared_ptr<Gfx::BufferGPU> mLateCandidates; // One uint per object
+		std::shared_ptr<Gfx::BufferGPU> mStats; // GpuSceneOcclusionStats, read by the CPU
+		std::shared_ptr<Gfx::BufferGPU> mObjects; // Not owned
+		VkDescriptorSet mCullSet;
+		uint32_t mObjectCount;
+	};
+
+	// aPhase is the push constant of cullObjects.comp
+	void RecordPhase(VkCommandBuffer aCommandBuffer, const FrameBuffers& aFrame, uint32_t aPhase) const;
+
+	std::vector<FrameBuffers> mFrames;
+};
+
+}
@@ -0,0 +1,360 @@
+#include "HiZCulling.h"
+
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Renderer/Renderer.h"
+
+using namespace Flux::Gfx;
+
+static constexpr uint32_t BUILD_GROUP_SIZE = 8; // local_size_x and local_size_y of depthPyramid.comp
+static constexpr uint32_t LATE_GROUP_SIZE = 64; // local_size_x of occlusionLate.comp
+
+// Matches the push constants of depthPyramid.comp
+struct BuildConstants
+{
+	glm::ivec2 mSourceSize;
+	glm::ivec2 mDestinationSize;
+};
+
+// Matches the push constants of occlusionLate.comp
+struct LateTestConstants
+{
+	glm::mat4 mViewProjection;
+	glm::vec2 mPyramidSize;
+	uint32_t mPyramidLevels;
+	uint32_t mCandidateCount;
+};
+
+static std::shared_ptr<BufferGPU> CreateHostBuffer(std::shared_ptr<RenderContext> aContext, VkDeviceSize aSize, VkBufferUsageFlags aUsage, VmaMemoryUsage aMemoryUsage)
+{
+	std::shared_ptr<BufferGPU> tBuffer = std::make_shared<BufferGPU>();
+	tBuffer->mUsageFlags = aUsage;
+	tBuffer->mMemoryUsage = aMemoryUsage;
+	Renderer::CreateBuffer(aContext->mDevice->mDevice, aContext->memoryAllocator, aSize, aUsage, tBuffer->mMemoryUsage, tBuffer->mBuffer, tBuffer->mAllocation);
+
+	// Zeroed, the stats are read before the first submission that writes them
+	void* data;
+	vmaMapMemory(aContext->memoryAllocator, tBuffer->mAllocation, &data);
+	memset(data, 0, aSize);
+	vmaUnmapMemory(aContext->memoryAllocator, tBuffer->mAllocation);
+	vmaFlushAllocation(aContext->memoryAllocator, tBuffer->mAllocation, 0, VK_WHOLE_SIZE);
+
+	return tBuffer;
+}
+
+static void DestroyBuffer(std::shared_ptr<RenderContext> aContext, std::shared_ptr<BufferGPU>& aBuffer)
+{
+	if (aBuffer != nullptr)
+	{
+		vkDestroyBuffer(aContext->mDevice->mDevice, aBuffer->mBuffer, nullptr);
+		vmaFreeMemory(aContext->memoryAllocator, aBuffer->mAllocation);
+		aBuffer = nullptr;
+	}
+}
+
+Flux::HiZCulling::HiZCulling(std::shared_ptr<Gfx::RenderContext> aContext,
+	std::shared_ptr<Gfx::RootSignature> aBuildRootSignature, std::shared_ptr<Gfx::ComputePipeline> aBuildPipeline, const std::vector<VkDescriptorSet>& aBuildSets,
+	std::shared_ptr<Gfx::RootSignature> aLateRootSignature, std::shared_ptr<Gfx::ComputePipeline> aLatePipeline, const std::vector<VkDescriptorSet>& aLateSets,
+	VkSampler aPointSampler, uint32_t aMaxCandidates) :
+	mContext(aContext), mBuildRootSignature(aBuildRootSignature), mBuildPipeline(aBuildPipeline), mBuildSets(aBuildSets),
+	mLateRootSignature(aLateRootSignature), mLatePipeline(aLatePipeline), mPointSampler(aPointSampler), mMaxCandidates(aMaxCandidates),
+	mImage(VK_NULL_HANDLE), mAllocation(VK_NULL_HANDLE), mView(VK_NULL_HANDLE), mWidth(0), mHeight(0), mLevelCount(0), mSceneWidth(0), mSceneHeight(0), mReadbackLevel(0),
+	mHasPyramid(false), mViewProjection(1.0f), mCpuViewProjection(1.0f)
+{
+	assert(aBuildSets.size() == MAX_LEVELS);
+
+	mFrames.resize(aLateSets.size());
+
+	for (size_t i = 0; i < mFrames.size(); ++i)
+	{
+		FrameBuffers& tFrame = mFrames[i];
+		tFrame.mReadback = CreateHostBuffer(mContext, sizeof(float) * READBACK_MAX_SIZE * READBACK_MAX_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_TO_CPU);
+		tFrame.mCandidateSpheres = CreateHostBuffer(mContext, sizeof(glm::vec4) * mMaxCandidates, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU);
+		tFrame.mCandidateDraws = CreateHostBuffer(mContext, sizeof(VkDrawIndexedIndirectCommand) * mMaxCandidates, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_CPU_TO_GPU);
+		tFrame.mStats = CreateHostBuffer(mContext, sizeof(HiZLateStats), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_TO_CPU);
+		tFrame.mLateSet = aLateSets[i];
+	}
+}
+
+Flux::HiZCulling::~HiZCulling()
+{
+	DestroyPyramid();
+
+	for (auto& frame : mFrames)
+	{
+		DestroyBuffer(mContext, frame.mReadback);
+		DestroyBuffer(mContext, frame.mCandidateSpheres);
+		DestroyBuffer(mContext, frame.mCandidateDraws);
+		DestroyBuffer(mContext, frame.mStats);
+	}
+}
+
+void Flux::HiZCulling::Resize(VkImageView aSceneDepthView, uint32_t aWidth, uint32_t aHeight)
+{
+	DestroyPyramid();
+
+	// Rounded down, so every level covers the screen exactly and a level 0 texel covers one to two depth texels per axis
+	mSceneWidth = aWidth;
+	mSceneHeight = aHeight;
+	mWidth = DepthPyramid::PreviousPowerOfTwo(aWidth);
+	mHeight = DepthPyramid::PreviousPowerOfTwo(aHeight);
+	mLevelCount = std::min(DepthPyramid::CountLevels(mWidth, mHeight), MAX_LEVELS);
+
+	Renderer::CreateImage(mContext, mWidth, mHeight, VK_FORMAT_R32_SFLOAT, VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY,
+		mImage, mAllocation, mLevelCount);
+	mView = Renderer::CreateImageView(mContext, mImage, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, mLevelCount);
+
+	// Every level is written through a storage image view of its own
+	mLevelViews.resize(mLevelCount);
+	for (uint32_t level = 0; level < mLevelCount; ++level)
+	{
+		VkImageViewCreateInfo viewInfo{};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = mImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R32_SFLOAT;
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.baseMipLevel = level;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.baseArrayLayer = 0;
+		viewInfo.subresourceRange.layerCount = 1;
+
+		if (vkCreateImageView(mContext->mDevice->mDevice, &viewInfo, nullptr, &mLevelViews[level]) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create depth pyramid level view!");
+		}
+	}
+
+	// Level 0 reads the scene depth, every other level the one below
+	for (uint32_t level = 0; level < mLevelCount; ++level)
+	{
+		const std::array<DescriptorInfo, 3> tDescriptors =
+		{
+			DescriptorInfo(level == 0 ? aSceneDepthView : mLevelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL),
+			DescriptorInfo(mPointSampler),
+			DescriptorInfo(mLevelViews[level], VK_IMAGE_LAYOUT_GENERAL),
+		};
+
+		Renderer::UpdateDescriptorSet(mContext, mBuildRootSignature, 0, mBuildSets[level], tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+	}
+
+	for (const auto& frame : mFrames)
+	{
+		const std::array<DescriptorInfo, 5> tDescriptors =
+		{
+			DescriptorInfo(frame.mCandidateSpheres->mBuffer),
+			DescriptorInfo(frame.mCandidateDraws->mBuffer),
+			DescriptorInfo(frame.mStats->mBuffer),
+			DescriptorInfo(mView, VK_IMAGE_LAYOUT_GENERAL),
+			DescriptorInfo(mPointSampler),
+		};
+
+		Renderer::UpdateDescriptorSet(mContext, mLateRootSignature, 0, frame.mLateSet, tDescriptors.data(), static_cast<uint32_t>(tDescriptors.size()));
+	}
+
+	// The CPU only needs a coarse level, a smaller copy keeps the readback cheap
+	mReadbackLevel = 0;
+	while (mReadbackLevel + 1 < mLevelCount && (std::max(mWidth >> mReadbackLevel, 1u) > READBACK_MAX_SIZE || std::max(mHeight >> mReadbackLevel, 1u) > READBACK_MAX_SIZE))
+	{
+		mReadbackLevel++;
+	}
+
+	Invalidate();
+}
+
+void Flux::HiZCulling::Invalidate()
+{
+	mHasPyramid = false;
+	mCpuPyramid.Clear();
+
+	for (auto& frame : mFrames)
+	{
+		frame.mReadbackValid = false;
+	}
+}
+
+void Flux::HiZCulling::BeginFrame(uint32_t aFrameIndex)
+{
+	assert(aFrameIndex < mFrames.size());
+	FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	void* data;
+
+	if (tFrame.mReadbackValid)
+	{
+		vmaInvalidateAllocation(mContext->memoryAllocator, tFrame.mReadback->mAllocation, 0, VK_WHOLE_SIZE);
+		vmaMapMemory(mContext->memoryAllocator, tFrame.mReadback->mAllocation, &data);
+		mCpuPyramid.Build(static_cast<const float*>(data), tFrame.mReadbackWidth, tFrame.mReadbackHeight);
+		vmaUnmapMemory(mContext->memoryAllocator, tFrame.mReadback->mAllocation);
+
+		mCpuViewProjection = tFrame.mReadbackViewProjection;
+	}
+	else
+	{
+		mCpuPyramid.Clear();
+	}
+
+	vmaInvalidateAllocation(mContext->memoryAllocator, tFrame.mStats->mAllocation, 0, VK_WHOLE_SIZE);
+	vmaMapMemory(mContext->memoryAllocator, tFrame.mStats->mAllocation, &data);
+	memcpy(&mLateStats, data, sizeof(mLateStats));
+	vmaUnmapMemory(mContext->memoryAllocator, tFrame.mStats->mAllocation);
+}
+
+void Flux::HiZCulling::RecordBuild(VkCommandBuffer aCommandBuffer, const glm::mat4& aViewProjection)
+{
+	assert(mImage != VK_NULL_HANDLE);
+
+	vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mBuildPipeline->computePipeline);
+
+	BuildConstants tConstants{};
+	tConstants.mSourceSize = glm::ivec2(mSceneWidth, mSceneHeight);
+
+	for (uint32_t level = 0; level < mLevelCount; ++level)
+	{
+		tConstants.mDestinationSize = glm::ivec2(std::max(mWidth >> level, 1u), std::max(mHeight >> level, 1u));
+
+		// Each level reads the one written before it
+		if (level > 0)
+		{
+			VkMemoryBarrier tLevelBarrier{};
+			tLevelBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			tLevelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			tLevelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &tLevelBarrier, 0, nullptr, 0, nullptr);
+		}
+
+		vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mBuildRootSignature->mPipelineLayout, 0, 1, &mBuildSets[level], 0, nullptr);
+		vkCmdPushConstants(aCommandBuffer, mBuildRootSignature->mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(tConstants), &tConstants);
+		vkCmdDispatch(aCommandBuffer,
+			(tConstants.mDestinationSize.x + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE,
+			(tConstants.mDestinationSize.y + BUILD_GROUP_SIZE - 1) / BUILD_GROUP_SIZE,
+			1);
+
+		tConstants.mSourceSize = tConstants.mDestinationSize;
+	}
+
+	mHasPyramid = true;
+	mViewProjection = aViewProjection;
+}
+
+void Flux::HiZCulling::RecordReadback(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex)
+{
+	assert(aFrameIndex < mFrames.size());
+	FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	tFrame.mReadbackWidth = std::max(mWidth >> mReadbackLevel, 1u);
+	tFrame.mReadbackHeight = std::max(mHeight >> mReadbackLevel, 1u);
+	tFrame.mReadbackViewProjection = mViewProjection;
+	tFrame.mReadbackValid = true;
+
+	VkBufferImageCopy tRegion{};
+	tRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	tRegion.imageSubresource.mipLevel = mReadbackLevel;
+	tRegion.imageSubresource.baseArrayLayer = 0;
+	tRegion.imageSubresource.layerCount = 1;
+	tRegion.imageExtent = { tFrame.mReadbackWidth, tFrame.mReadbackHeight, 1 };
+
+	vkCmdCopyImageToBuffer(aCommandBuffer, mImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, tFrame.mReadback->mBuffer, 1, &tRegion);
+
+	VkMemoryBarrier tHostBarrier{};
+	tHostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tHostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	tHostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &tHostBarrier, 0, nullptr, 0, nullptr);
+}
+
+std::optional<uint32_t> Flux::HiZCulling::AddCandidate(const glm::vec4& aSphere, uint32_t aIndexCount, uint32_t aFirstInstance)
+{
+	if (mCandidateDraws.size() >= mMaxCandidates)
+	{
+		return std::nullopt;
+	}
+
+	VkDrawIndexedIndirectCommand tDraw{};
+	tDraw.indexCount = aIndexCount;
+	tDraw.instanceCount = 0; // Written by the late test
+	tDraw.firstIndex = 0;
+	tDraw.vertexOffset = 0;
+	tDraw.firstInstance = aFirstInstance;
+
+	mCandidateSpheres.push_back(aSphere);
+	mCandidateDraws.push_back(tDraw);
+
+	return static_cast<uint32_t>(mCandidateDraws.size() - 1);
+}
+
+void Flux::HiZCulling::UploadCandidates(uint32_t aFrameIndex)
+{
+	assert(aFrameIndex < mFrames.size());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	if (mCandidateDraws.empty())
+	{
+		return;
+	}
+
+	void* data;
+	vmaMapMemory(mContext->memoryAllocator, tFrame.mCandidateSpheres->mAllocation, &data);
+	memcpy(data, mCandidateSpheres.data(), sizeof(mCandidateSpheres[0]) * mCandidateSpheres.size());
+	vmaUnmapMemory(mContext->memoryAllocator, tFrame.mCandidateSpheres->mAllocation);
+
+	vmaMapMemory(mContext->memoryAllocator, tFrame.mCandidateDraws->mAllocation, &data);
+	memcpy(data, mCandidateDraws.data(), sizeof(mCandidateDraws[0]) * mCandidateDraws.size());
+	vmaUnmapMemory(mContext->memoryAllocator, tFrame.mCandidateDraws->mAllocation);
+}
+
+void Flux::HiZCulling::RecordLateTest(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex, const glm::mat4& aViewProjection) const
+{
+	assert(aFrameIndex < mFrames.size());
+	const FrameBuffers& tFrame = mFrames[aFrameIndex];
+
+	vkCmdFillBuffer(aCommandBuffer, tFrame.mStats->mBuffer, 0, VK_WHOLE_SIZE, 0);
+
+	VkMemoryBarrier tClearBarrier{};
+	tClearBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tClearBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	tClearBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &tClearBarrier, 0, nullptr, 0, nullptr);
+
+	if (!mCandidateDraws.empty())
+	{
+		LateTestConstants tConstants{};
+		tConstants.mViewProjection = aViewProjection;
+		tConstants.mPyramidSize = glm::vec2(static_cast<float>(mWidth), static_cast<float>(mHeight));
+		tConstants.mPyramidLevels = mLevelCount;
+		tConstants.mCandidateCount = GetCandidateCount();
+
+		vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mLatePipeline->computePipeline);
+		vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, mLateRootSignature->mPipelineLayout, 0, 1, &tFrame.mLateSet, 0, nullptr);
+		vkCmdPushConstants(aCommandBuffer, mLateRootSignature->mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(tConstants), &tConstants);
+		vkCmdDispatch(aCommandBuffer, (tConstants.mCandidateCount + LATE_GROUP_SIZE - 1) / LATE_GROUP_SIZE, 1, 1);
+	}
+
+	VkMemoryBarrier tDrawBarrier{};
+	tDrawBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	tDrawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	tDrawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(aCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &tDrawBarrier, 0, nullptr, 0, nullptr);
+}
+
+void Flux::HiZCulling::DestroyPyramid()
+{
+	for (auto& view : mLevelViews)
+	{
+		vkDestroyImageView(mContext->mDevice->mDevice, view, nullptr);
+	}
+	mLevelViews.clear();
+
+	if (mImage != VK_NULL_HANDLE)
+	{
+		vkDestroyImageView(mContext->mDevice->mDevice, mView, nullptr);
+		vmaDestroyImage(mContext->memoryAllocator, mImage, mAllocation);
+		mImage = VK_NULL_HANDLE;
+		mView = VK_NULL_HANDLE;
+	}
+}
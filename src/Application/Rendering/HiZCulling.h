@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <vector>
+#include <optional>
+#include <glm/glm.hpp>
+
+#include "Renderer/RenderContext.h"
+#include "Renderer/RootSignature.h"
+#include "Renderer/Pipeline.h"
+#include "Renderer/BufferGPU.h"
+
+#include "Common/Culling/OcclusionCulling.h"
+
+namespace Flux
+{
+
+// Matches Stats in occlusionLate.comp
+struct HiZLateStats
+{
+	uint32_t mRescuedObjects = 0;
+	uint32_t mRescuedTriangles = 0;
+};
+
+// Depth pyramid of the scene pass for occlusion culling, built by compute after the early scene draws of every frame
+// Culling tests against the pyramid of the previous frame with the view projection it was built with, and retests what
+// that rejected against the pyramid of the current frame, so objects that became visible are drawn in a late scene pass
+// GpuScene runs both tests for the GPU-driven objects, this class covers the objects recorded on the CPU: their first test
+// uses a coarse level read back to the CPU, which is as old as the frames in flight, their second test sets the instance
+// count of an indirect draw the CPU prepared for them
+class HiZCulling
+{
+public:
+	static constexpr uint32_t MAX_LEVELS = 16;
+	static constexpr uint32_t READBACK_MAX_SIZE = 256; // Per axis, the largest level that fits is read back
+
+	// aBuildSets are MAX_LEVELS sets of the depthPyramid root signature, one per level
+	// aLateSets are sets of the occlusionLate root signature, one per frame in flight
+	HiZCulling(std::shared_ptr<Gfx::RenderContext> aContext,
+		std::shared_ptr<Gfx::RootSignature> aBuildRootSignature, std::shared_ptr<Gfx::ComputePipeline> aBuildPipeline, const std::vector<VkDescriptorSet>& aBuildSets,
+		std::shared_ptr<Gfx::RootSignature> aLateRootSignature, std::shared_ptr<Gfx::ComputePipeline> aLatePipeline, const std::vector<VkDescriptorSet>& aLateSets,
+		VkSampler aPointSampler, uint32_t aMaxCandidates);
+	~HiZCulling();
+
+	// Recreates the pyramid for a scene depth of this size, level 0 reads aSceneDepthView in the general layout
+	// Nothing that uses the old pyramid may be in flight
+	void Resize(VkImageView aSceneDepthView, uint32_t aWidth, uint32_t aHeight);
+
+	// Forgets the pyramid and the levels read back, for when their depth no longer matches the scene
+	void Invalidate();
+
+	// Picks up the level and the late test stats the last submission of this frame wrote, call once it has finished
+	void BeginFrame(uint32_t aFrameIndex);
+
+	// Builds every level from the scene depth, aViewProjection is the matrix the scene was drawn with
+	void RecordBuild(VkCommandBuffer aCommandBuffer, const glm::mat4& aViewProjection);
+
+	// Copies the readback level into the buffer of this frame, the pyramid has to be in the transfer source layout
+	void RecordReadback(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex);
+
+	// Tests against the level picked up by BeginFrame, nothing is occluded without one
+	bool IsSphereOccluded(const glm::vec4& aSphere) const { return mCpuPyramid.IsSphereOccluded(aSphere, mCpuViewProjection); }
+
+	// Candidates are objects the CPU test rejected, each gets an indirect draw in the late scene pass
+	// Returns the index of its draw in GetCandidateDraws, nothing when the buffer is full
+	void ClearCandidates() { mCandidateSpheres.clear(); mCandidateDraws.clear(); }
+	std::optional<uint32_t> AddCandidate(const glm::vec4& aSphere, uint32_t aIndexCount, uint32_t aFirstInstance);
+	void UploadCandidates(uint32_t aFrameIndex);
+
+	// For candidates that select their transform in the instance buffer, call before UploadCandidates
+	void SetCandidateFirstInstance(uint32_t aCandidate, uint32_t aFirstInstance) { mCandidateDraws[aCandidate].firstInstance = aFirstInstance; }
+
+	// Decides the instance count of every candidate draw with the pyramid of this frame and makes them visible to the indirect draw stage
+	void RecordLateTest(VkCommandBuffer aCommandBuffer, uint32_t aFrameIndex, const glm::mat4& aViewProjection) const;
+
+	VkBuffer GetCandidateDraws(uint32_t aFrameIndex) const { return mFrames[aFrameIndex].mCandidateDraws->mBuffer; }
+	uint32_t GetCandidateCount() const { return static_cast<uint32_t>(mCandidateDraws.size()); }
+
+	VkImage GetImage() const { return mImage; }
+	VkImageView GetView() const { return mView; }
+	uint32_t GetWidth() const { return mWidth; }
+	uint32_t GetHeight() const { return mHeight; }
+	uint32_t GetLevelCount() const { return mLevelCount; }
+
+	// A build was recorded since the last resize, GetViewProjection is the matrix of the last one
+	bool HasPyramid() const { return mHasPyramid; }
+	const glm::mat4& GetViewProjection() const { return mViewProjection; }
+
+	const DepthPyramid& GetCpuPyramid() const { return mCpuPyramid; }
+	const HiZLateStats& GetLateStats() const { return mLateStats; }
+
+private:
+	HiZCulling(const HiZCulling&) = delete;
+	HiZCulling& operator= (const HiZCulling&) = delete;
+
+	void DestroyPyramid();
+
+	std::shared_ptr<Gfx::RenderContext> mContext;
+	std::shared_ptr<Gfx::RootSignature> mBuildRootSignature;
+	std::shared_ptr<Gfx::ComputePipeline> mBuildPipeline;
+	std::vector<VkDescriptorSet> mBuildSets;
+	std::shared_ptr<Gfx::RootSignature> mLateRootSignature;
+	std::shared_ptr<Gfx::ComputePipeline> mLatePipeline;
+	VkSampler mPointSampler;
+	uint32_t mMaxCandidates;
+
+	VkImage mImage;
+	VmaAllocation mAllocation;
+	VkImageView mView; // Every level
+	std::vector<VkImageView> mLevelViews;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mLevelCount;
+	uint32_t mSceneWidth;
+	uint32_t mSceneHeight;
+	uint32_t mReadbackLevel;
+
+	bool mHasPyramid;
+	glm::mat4 mViewProjection;
+
+	// Per frame in flight
+	struct FrameBuffers
+	{
+		std::shared_ptr<Gfx::BufferGPU> mReadback; // Readback level, row by row
+		std::shared_ptr<Gfx::BufferGPU> mCandidateSpheres;
+		std::shared_ptr<Gfx::BufferGPU> mCandidateDraws;
+		std::shared_ptr<Gfx::BufferGPU> mStats; // HiZLateStats
+		VkDescriptorSet mLateSet;
+
+		// Of the level copied by the last submission
+		bool mReadbackValid = false;
+		uint32_t mReadbackWidth = 0;
+		uint32_t mReadbackHeight = 0;
+		glm::mat4 mReadbackViewProjection;
+	};
+
+	std::vector<FrameBuffers> mFrames;
+
+	DepthPyramid mCpuPyramid;
+	glm::mat4 mCpuViewProjection;
+	HiZLateStats mLateStats;
+
+	std::vector<glm::vec4> mCandidateSpheres;
+	std::vector<VkDrawIndexedIndirectCommand> mCandidateDraws;
+};
+
+}
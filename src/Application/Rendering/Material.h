@@ -2,6 +2,7 @@
 #include <memory>
 #include <vector>
 #include <string>
+#include <optional>
 
 #include <Common/AssetProcessing/AssetObjects.h>
 #include <Renderer/TextureVK.h>
@@ -22,7 +23,8 @@ public:
 	std::shared_ptr < Flux::Gfx::Texture > mTextureNormal = nullptr;
 
 
-	VkDescriptorSet mDescriptorSet;
+	VkDescriptorSet mDescriptorSet = VK_NULL_HANDLE; // Only created for materials drawn without bindless
+	std::optional<uint32_t> mBindlessIndex; // Index in the bindless material buffer once registered
 	uint64_t mIndex;
 	static uint64_t matIDIndex;
 
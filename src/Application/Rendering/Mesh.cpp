@@ -1 +1,3 @@
 #include "Mesh.h"
+
+uint64_t Flux::MeshVK::meshIDIndex = 0;
@@ -1,5 +1,7 @@
 #pragma once
 #include <memory>
+#include <optional>
+#include <cstdint>
 
 #include "Renderer/BufferGPU.h"
 
@@ -8,10 +10,17 @@ namespace Flux
 class MeshVK
 {
 public:
-	MeshVK() = default;
+	MeshVK() : mIndex(meshIDIndex++) {}
 	~MeshVK() = default;
 
 	std::shared_ptr<Gfx::BufferGPU> mVertexBuffer = nullptr;
 	std::shared_ptr<Gfx::BufferGPU> mIndexBuffer = nullptr;
+
+	// Index of the mesh in the GPU scene when the object is drawn by the GPU-driven path
+	std::optional<uint32_t> mGpuSceneMesh;
+
+	// Never reused, unlike the address of a released mesh
+	uint64_t mIndex;
+	static uint64_t meshIDIndex;
 };
 }
@@ -0,0 +1,232 @@
+#include "ParallelCommandRecorder.h"
+
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <cassert>
+
+#include "Common/Profiling/CpuProfiler.h"
+
+// Below this a range is not worth the overhead of an extra secondary command buffer
+constexpr size_t MIN_OBJECTS_PER_RANGE = 64;
+
+Flux::ParallelCommandRecorder::ParallelCommandRecorder(std::shared_ptr<Gfx::RenderContext> aContext, uint32_t aQueueFamilyIndex, uint32_t aThreadCount, uint32_t aFrameCount) :
+	mContext(aContext), mFrameIndex(0), mRecord(nullptr), mInheritance{}, mGeneration(0), mBusyWorkers(0), mFailed(false), mStop(false), mInlineRecordTimeMs(0.0f)
+{
+	assert(aThreadCount > 0);
+	assert(aFrameCount > 0);
+
+	VkCommandPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	poolInfo.queueFamilyIndex = aQueueFamilyIndex;
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+	// Command pools are externally synchronized, so every thread records from its own pool
+	mPools.resize(aFrameCount);
+	for (auto& frame : mPools)
+	{
+		frame.resize(aThreadCount);
+		for (auto& threadPool : frame)
+		{
+			if (vkCreateCommandPool(mContext->mDevice->mDevice, &poolInfo, nullptr, &threadPool.mPool) != VK_SUCCESS)
+			{
+				throw std::runtime_error("failed to create command pool!");
+			}
+		}
+	}
+
+	mRecordTimesMs.resize(aThreadCount, 0.0f);
+
+	for (uint32_t i = 0; i < aThreadCount; ++i)
+	{
+		mWorkers.emplace_back(&ParallelCommandRecorder::WorkerLoop, this, i);
+	}
+}
+
+Flux::ParallelCommandRecorder::~ParallelCommandRecorder()
+{
+	{
+		std::lock_guard<std::mutex> tLock(mMutex);
+		mStop = true;
+	}
+
+	mWorkAvailable.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+
+	// Destroying a pool frees its command buffers
+	for (auto& frame : mPools)
+	{
+		for (auto& threadPool : frame)
+		{
+			vkDestroyCommandPool(mContext->mDevice->mDevice, threadPool.mPool, nullptr);
+		}
+	}
+}
+
+void Flux::ParallelCommandRecorder::BeginFrame(uint32_t aFrameIndex)
+{
+	mFrameIndex = aFrameIndex % mPools.size();
+
+	for (auto& threadPool : mPools[mFrameIndex])
+	{
+		vkResetCommandPool(mContext->mDevice->mDevice, threadPool.mPool, 0);
+		threadPool.mUsed = 0;
+	}
+
+	std::fill(mRecordTimesMs.begin(), mRecordTimesMs.end(), 0.0f);
+	mInlineRecordTimeMs = 0.0f;
+}
+
+void Flux::ParallelCommandRecorder::RecordPass(VkCommandBuffer aPrimary, const VkRenderPassBeginInfo& aBeginInfo, VkQueryPipelineStatisticFlags aPipelineStatistics, size_t aObjectCount, const RecordFunction& aRecord)
+{
+	if (aPipelineStatistics != 0 && !mContext->mDevice->mInheritedQueriesSupported)
+	{
+		const auto tStart = std::chrono::high_resolution_clock::now();
+
+		vkCmdBeginRenderPass(aPrimary, &aBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		aRecord(aPrimary, 0, aObjectCount);
+		vkCmdEndRenderPass(aPrimary);
+
+		mInlineRecordTimeMs += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+		return;
+	}
+
+	vkCmdBeginRenderPass(aPrimary, &aBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	if (aObjectCount > 0)
+	{
+		const size_t tThreadCount = mWorkers.size();
+		const size_t tRangeCount = std::min(tThreadCount, std::max<size_t>(1, aObjectCount / MIN_OBJECTS_PER_RANGE));
+
+		{
+			std::lock_guard<std::mutex> tLock(mMutex);
+
+			mRecord = &aRecord;
+
+			mInheritance = {};
+			mInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+			mInheritance.renderPass = aBeginInfo.renderPass;
+			mInheritance.subpass = 0;
+			mInheritance.framebuffer = aBeginInfo.framebuffer;
+			mInheritance.pipelineStatistics = aPipelineStatistics;
+
+			mRanges.clear();
+			for (size_t i = 0; i < tRangeCount; ++i)
+			{
+				mRanges.emplace_back(aObjectCount * i / tRangeCount, aObjectCount * (i + 1) / tRangeCount);
+			}
+
+			mRecorded.assign(tRangeCount, VK_NULL_HANDLE);
+			mBusyWorkers = static_cast<uint32_t>(tThreadCount);
+			mFailed = false;
+			mGeneration++;
+		}
+
+		mWorkAvailable.notify_all();
+
+		std::unique_lock<std::mutex> tLock(mMutex);
+		mWorkDone.wait(tLock, [this] { return mBusyWorkers == 0; });
+
+		if (mFailed)
+		{
+			throw std::runtime_error("failed to record secondary command buffer!");
+		}
+
+		vkCmdExecuteCommands(aPrimary, static_cast<uint32_t>(mRecorded.size()), mRecorded.data());
+	}
+
+	vkCmdEndRenderPass(aPrimary);
+}
+
+void Flux::ParallelCommandRecorder::WorkerLoop(uint32_t aThreadIndex)
+{
+	FLUX_PROFILE_THREAD("Command recorder " + std::to_string(aThreadIndex));
+
+	uint64_t tSeenGeneration = 0;
+
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> tLock(mMutex);
+			mWorkAvailable.wait(tLock, [this, tSeenGeneration] { return mStop || mGeneration != tSeenGeneration; });
+
+			if (mStop)
+			{
+				return;
+			}
+
+			tSeenGeneration = mGeneration;
+		}
+
+		// The pass description is not touched by the render thread until every worker reported back
+		if (aThreadIndex < mRanges.size())
+		{
+			RecordRange(aThreadIndex);
+		}
+
+		{
+			std::lock_guard<std::mutex> tLock(mMutex);
+			mBusyWorkers--;
+		}
+
+		mWorkDone.notify_one();
+	}
+}
+
+void Flux::ParallelCommandRecorder::RecordRange(uint32_t aThreadIndex)
+{
+	FLUX_PROFILE_ZONE("Record range");
+
+	const auto tStart = std::chrono::high_resolution_clock::now();
+
+	ThreadCommandPool& tThreadPool = mPools[mFrameIndex][aThreadIndex];
+
+	if (tThreadPool.mUsed == tThreadPool.mBuffers.size())
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = tThreadPool.mPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer tCommandBuffer = VK_NULL_HANDLE;
+		if (vkAllocateCommandBuffers(mContext->mDevice->mDevice, &allocInfo, &tCommandBuffer) != VK_SUCCESS)
+		{
+			std::lock_guard<std::mutex> tLock(mMutex);
+			mFailed = true;
+			return;
+		}
+
+		tThreadPool.mBuffers.push_back(tCommandBuffer);
+	}
+
+	VkCommandBuffer tCommandBuffer = tThreadPool.mBuffers[tThreadPool.mUsed++];
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &mInheritance;
+
+	if (vkBeginCommandBuffer(tCommandBuffer, &beginInfo) != VK_SUCCESS)
+	{
+		std::lock_guard<std::mutex> tLock(mMutex);
+		mFailed = true;
+		return;
+	}
+
+	(*mRecord)(tCommandBuffer, mRanges[aThreadIndex].first, mRanges[aThreadIndex].second);
+
+	if (vkEndCommandBuffer(tCommandBuffer) != VK_SUCCESS)
+	{
+		std::lock_guard<std::mutex> tLock(mMutex);
+		mFailed = true;
+		return;
+	}
+
+	mRecorded[aThreadIndex] = tCommandBuffer;
+	mRecordTimesMs[aThreadIndex] += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+}
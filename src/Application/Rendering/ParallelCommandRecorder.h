@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "vulkan/vulkan.h"
+#include "Renderer/RenderContext.h"
+
+namespace Flux
+{
+
+// Records the draws of a render pass into secondary command buffers on worker threads
+// The objects are split into even ranges, one per thread, which are executed from the primary command buffer in order
+class ParallelCommandRecorder
+{
+public:
+	// Records the objects [aBegin, aEnd) into a command buffer that is already inside the render pass
+	// Dynamic state is not inherited, so it has to be set again
+	using RecordFunction = std::function<void(VkCommandBuffer aCommandBuffer, size_t aBegin, size_t aEnd)>;
+
+	// aFrameCount is the amount of primary command buffers that can be in flight, each gets its own command pools
+	ParallelCommandRecorder(std::shared_ptr<Gfx::RenderContext> aContext, uint32_t aQueueFamilyIndex, uint32_t aThreadCount, uint32_t aFrameCount);
+	~ParallelCommandRecorder();
+
+	// Resets the command pools of this frame, only call once its primary command buffer has finished executing
+	void BeginFrame(uint32_t aFrameIndex);
+
+	// Begins the render pass, records aObjectCount objects and ends the render pass
+	// aPipelineStatistics are the flags of a pipeline statistics query active in aPrimary, without inherited queries
+	// such a pass is recorded inline on the calling thread
+	void RecordPass(VkCommandBuffer aPrimary, const VkRenderPassBeginInfo& aBeginInfo, VkQueryPipelineStatisticFlags aPipelineStatistics, size_t aObjectCount, const RecordFunction& aRecord);
+
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+
+	// Recording time per thread, summed over the passes of the current frame
+	const std::vector<float>& GetRecordTimesMs() const { return mRecordTimesMs; }
+	float GetInlineRecordTimeMs() const { return mInlineRecordTimeMs; }
+
+private:
+	ParallelCommandRecorder(const ParallelCommandRecorder&) = delete;
+	ParallelCommandRecorder& operator= (const ParallelCommandRecorder&) = delete;
+
+	struct ThreadCommandPool
+	{
+		VkCommandPool mPool = VK_NULL_HANDLE;
+		std::vector<VkCommandBuffer> mBuffers;
+		size_t mUsed = 0;
+	};
+
+	void WorkerLoop(uint32_t aThreadIndex);
+	void RecordRange(uint32_t aThreadIndex);
+
+	std::shared_ptr<Gfx::RenderContext> mContext;
+	std::vector<std::vector<ThreadCommandPool>> mPools; // Per frame, per thread
+	uint32_t mFrameIndex;
+
+	std::vector<std::thread> mWorkers;
+	std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+
+	// The pass being recorded, only changed by the render thread while no worker is busy
+	const RecordFunction* mRecord;
+	VkCommandBufferInheritanceInfo mInheritance;
+	std::vector<std::pair<size_t, size_t>> mRanges; // One per thread that has work in this pass
+	std::vector<VkCommandBuffer> mRecorded; // Same indexing as mRanges
+	uint64_t mGeneration;
+	uint32_t mBusyWorkers;
+	bool mFailed;
+	bool mStop;
+
+	std::vector<float> mRecordTimesMs;
+	float mInlineRecordTimeMs;
+};
+
+}
@@ -0,0 +1,130 @@
+#include "PipelineCompiler.h"
+
+#include <chrono>
+#include <iostream>
+#include <cassert>
+
+#include "Common/Profiling/CpuProfiler.h"
+
+Flux::PipelineCompiler::PipelineCompiler(CompileFunction aCompileFunction, uint32_t aThreadCount) :
+	mCompileFunction(aCompileFunction), mActiveJobs(0), mStop(false)
+{
+	assert(aThreadCount > 0);
+
+	for (uint32_t i = 0; i < aThreadCount; ++i)
+	{
+		mWorkers.emplace_back(&PipelineCompiler::WorkerLoop, this);
+	}
+}
+
+Flux::PipelineCompiler::~PipelineCompiler()
+{
+	{
+		std::lock_guard<std::mutex> tLock(mMutex);
+		mStop = true;
+	}
+
+	mWorkAvailable.notify_all();
+
+	for (auto& worker : mWorkers)
+	{
+		worker.join();
+	}
+}
+
+bool Flux::PipelineCompiler::Request(const RenderState& aState)
+{
+	{
+		std::lock_guard<std::mutex> tLock(mMutex);
+
+		if (!mPending.insert(aState.mHash).second)
+		{
+			return false;
+		}
+
+		mQueue.push_back(aState);
+	}
+
+	mWorkAvailable.notify_one();
+	return true;
+}
+
+bool Flux::PipelineCompiler::IsPending(uint64_t aHash) const
+{
+	std::lock_guard<std::mutex> tLock(mMutex);
+	return mPending.find(aHash) != mPending.end();
+}
+
+uint32_t Flux::PipelineCompiler::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> tLock(mMutex);
+	return static_cast<uint32_t>(mPending.size());
+}
+
+std::vector<Flux::PipelineCompiler::Result> Flux::PipelineCompiler::CollectResults()
+{
+	std::lock_guard<std::mutex> tLock(mMutex);
+
+	std::vector<Result> tResults;
+	tResults.swap(mResults);
+
+	for (const auto& result : tResults)
+	{
+		mPending.erase(result.mState.mHash);
+	}
+
+	return tResults;
+}
+
+void Flux::PipelineCompiler::WaitIdle()
+{
+	std::unique_lock<std::mutex> tLock(mMutex);
+	mWorkDone.wait(tLock, [this] { return mQueue.empty() && mActiveJobs == 0; });
+}
+
+void Flux::PipelineCompiler::WorkerLoop()
+{
+	FLUX_PROFILE_THREAD("Pipeline compiler");
+
+	while (true)
+	{
+		RenderState tState;
+
+		{
+			std::unique_lock<std::mutex> tLock(mMutex);
+			mWorkAvailable.wait(tLock, [this] { return mStop || !mQueue.empty(); });
+
+			if (mStop)
+			{
+				return;
+			}
+
+			tState = mQueue.front();
+			mQueue.pop_front();
+			mActiveJobs++;
+		}
+
+		auto tStart = std::chrono::high_resolution_clock::now();
+
+		std::shared_ptr<Flux::Gfx::GraphicsPipeline> tPipeline = nullptr;
+		try
+		{
+			FLUX_PROFILE_ZONE("Compile pipeline");
+			tPipeline = mCompileFunction(tState);
+		}
+		catch (const std::exception& e)
+		{
+			std::cout << "Failed to compile pipeline: " << e.what() << std::endl;
+		}
+
+		float tCompileTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+
+		{
+			std::lock_guard<std::mutex> tLock(mMutex);
+			mResults.push_back({ tState, tPipeline, tCompileTimeMs });
+			mActiveJobs--;
+		}
+
+		mWorkDone.notify_all();
+	}
+}
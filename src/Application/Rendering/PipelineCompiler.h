@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <unordered_set>
+
+#include "Renderer/Pipeline.h"
+#include "Application/Rendering/RenderState.h"
+
+namespace Flux
+{
+
+// Compiles graphics pipelines on worker threads so a new render state never stalls the render thread
+// The render thread requests states and picks up the finished pipelines with CollectResults
+class PipelineCompiler
+{
+public:
+	using CompileFunction = std::function<std::shared_ptr<Flux::Gfx::GraphicsPipeline>(const RenderState&)>;
+
+	struct Result
+	{
+		RenderState mState;
+		std::shared_ptr<Flux::Gfx::GraphicsPipeline> mPipeline; // Null when compilation failed
+		float mCompileTimeMs;
+	};
+
+	PipelineCompiler(CompileFunction aCompileFunction, uint32_t aThreadCount);
+	~PipelineCompiler();
+
+	// Returns false when the state is already queued, compiling or waiting to be collected
+	bool Request(const RenderState& aState);
+	bool IsPending(uint64_t aHash) const;
+	uint32_t GetPendingCount() const;
+
+	std::vector<Result> CollectResults();
+
+	// Blocks until every requested pipeline has been compiled
+	void WaitIdle();
+
+private:
+	PipelineCompiler(const PipelineCompiler&) = delete;
+	PipelineCompiler& operator= (const PipelineCompiler&) = delete;
+
+	void WorkerLoop();
+
+	CompileFunction mCompileFunction;
+	std::vector<std::thread> mWorkers;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::condition_variable mWorkDone;
+
+	std::deque<RenderState> mQueue;
+	std::vector<Result> mResults;
+	std::unordered_set<uint64_t> mPending;
+	uint32_t mActiveJobs;
+	bool mStop;
+};
+
+}
@@ -1 +1,43 @@
 #include "RenderState.h"
+
+#include "Common/Hash/HashCombine.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+uint32_t Flux::InternShaderPath(const std::string& aFilePath)
+{
+	static std::mutex sMutex;
+	static std::unordered_map<std::string, uint32_t> sShaderIDs;
+
+	std::lock_guard<std::mutex> tLock(sMutex);
+
+	auto tResult = sShaderIDs.emplace(aFilePath, static_cast<uint32_t>(sShaderIDs.size()));
+	return tResult.first->second;
+}
+
+void Flux::RenderState::UpdateHash()
+{
+	// Sort so the key doesn't depend on the order the shaders were added in, same as operator==
+	std::vector<uint64_t> tShaderKeys;
+	tShaderKeys.reserve(shaders.size());
+
+	for (const auto& shader : shaders)
+	{
+		tShaderKeys.push_back((static_cast<uint64_t>(shader.first) << 32) | InternShaderPath(shader.second));
+	}
+
+	std::sort(tShaderKeys.begin(), tShaderKeys.end());
+
+	uint64_t tHash = 0;
+	for (const auto& key : tShaderKeys)
+	{
+		tHash = HashCombine(tHash, key);
+	}
+
+	tHash = HashCombine(tHash, static_cast<uint64_t>(drawState.cullMode));
+	tHash = HashCombine(tHash, static_cast<uint64_t>(drawState.frontFaceMode));
+
+	mHash = tHash;
+}
@@ -33,14 +33,33 @@ struct RasterizerState
 	CullModes cullMode;
 };
 
+// Returns a small stable id for a shader path, equal paths always map to the same id
+uint32_t InternShaderPath(const std::string& aFilePath);
+
 struct RenderState
 {
 	std::vector<std::pair<Flux::Gfx::ShaderTypes, std::string>> shaders;
 	RasterizerState drawState;
 	std::optional<uint32_t> stateID;
 
+	// 64 bit key built from the interned shader ids and the raster state, used to look up the pipeline
+	uint64_t mHash = 0;
+
+	void AddShader(Flux::Gfx::ShaderTypes aType, const std::string& aFilePath)
+	{
+		shaders.push_back({ aType, aFilePath });
+		UpdateHash();
+	}
+
+	// Call after modifying shaders or drawState directly
+	void UpdateHash();
 
-	inline bool operator==(const RenderState& rhs) {
+	inline bool operator==(const RenderState& rhs) const {
+
+		if (mHash != rhs.mHash)
+		{
+			return false;
+		}
 
 		if (this->shaders.size() != rhs.shaders.size())
 		{
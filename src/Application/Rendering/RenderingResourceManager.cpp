@@ -1,5 +1,7 @@
 #include "RenderingResourceManager.h"
 
+#include <algorithm>
+
 
 using namespace Flux::Gfx;
 
@@ -84,6 +86,18 @@ bool Flux::RenderingResourceManager::RegisterMaterial(std::shared_ptr<Flux::Mate
 	return true;
 }
 
+std::vector<std::shared_ptr<Flux::Material>> Flux::RenderingResourceManager::ReleaseUnusedMaterials()
+{
+	std::vector<std::shared_ptr<Flux::Material>> tReleased;
+
+	// The manager holds the last reference once every object using the material is gone
+	auto tUnused = std::partition(mMaterials.begin(), mMaterials.end(), [](const std::shared_ptr<Flux::Material>& aMaterial) { return aMaterial.use_count() > 1; });
+	tReleased.assign(tUnused, mMaterials.end());
+	mMaterials.erase(tUnused, mMaterials.end());
+
+	return tReleased;
+}
+
 void Flux::RenderingResourceManager::Update()
 {
 }
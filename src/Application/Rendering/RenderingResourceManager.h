@@ -32,6 +32,8 @@ public:
 
 	std::optional<std::shared_ptr<Flux::Material>> QueryMaterialAssetRegistered(std::shared_ptr<Flux::Material> aMeshAsset) const;
 	bool RegisterMaterial(std::shared_ptr<Flux::Material> aMeshAsset);
+	// Unregisters the materials no scene object references anymore and hands them back so their GPU resources can be released
+	std::vector<std::shared_ptr<Flux::Material>> ReleaseUnusedMaterials();
 
 	void Update();
 
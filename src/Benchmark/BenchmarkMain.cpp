@@ -0,0 +1,168 @@
+#include "FlythroughBenchmark.h"
+#include "JobSystemBenchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+    struct Options {
+        std::string mSuite = "flythrough";
+        Flux::FlythroughBenchmarkDesc mDesc;
+        std::string mOutput = "benchmark"; // Prefix of the .json and .csv files
+        std::string mBaseline; // JSON of an earlier run, compared against when set
+        double mThreshold = -1.0; // Relative, overrides every default threshold when set
+    };
+
+    void PrintUsage() {
+        std::cout << "Usage: Benchmark [options]\n"
+            << "  --suite <name>     flythrough renders the scene, jobs measures the job system, default flythrough\n"
+            << "  --frames <n>       Recorded frames or job repetitions, default 600\n"
+            << "  --warmup <n>       Frames rendered or repetitions run before recording, default 60\n"
+            << "  --width <n>        Render width, default 1280\n"
+            << "  --height <n>       Render height, default 720\n"
+            << "  --frames-in-flight <n>  Frames the CPU may record ahead of the GPU, 1 to 4, default the renderer's\n"
+            << "  --path <file>      Camera path, default Resources/Benchmarks/sponza_flythrough.path\n"
+            << "  --out <prefix>     Writes <prefix>.json and <prefix>.csv, default benchmark\n"
+            << "  --baseline <file>  Compares the p50 and p95 of every metric against an earlier JSON report\n"
+            << "  --threshold <f>    Relative regression threshold for every metric, like 0.1 for 10%\n"
+            << "  --validation       Enables the validation layers\n";
+    }
+
+    bool ParseOptions(int argc, char** argv, Options& aOptions) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string tArgument = argv[i];
+            const bool tHasValue = i + 1 < argc;
+
+            if (tArgument == "--validation") {
+                aOptions.mDesc.mEnableValidation = true;
+            }
+            else if (tArgument == "--suite" && tHasValue) {
+                aOptions.mSuite = argv[++i];
+            }
+            else if (tArgument == "--frames" && tHasValue) {
+                aOptions.mDesc.mFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (tArgument == "--warmup" && tHasValue) {
+                aOptions.mDesc.mWarmupFrames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (tArgument == "--width" && tHasValue) {
+                aOptions.mDesc.mWidth = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (tArgument == "--height" && tHasValue) {
+                aOptions.mDesc.mHeight = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (tArgument == "--frames-in-flight" && tHasValue) {
+                aOptions.mDesc.mFramesInFlight = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+            }
+            else if (tArgument == "--path" && tHasValue) {
+                aOptions.mDesc.mPathFile = argv[++i];
+            }
+            else if (tArgument == "--out" && tHasValue) {
+                aOptions.mOutput = argv[++i];
+            }
+            else if (tArgument == "--baseline" && tHasValue) {
+                aOptions.mBaseline = argv[++i];
+            }
+            else if (tArgument == "--threshold" && tHasValue) {
+                aOptions.mThreshold = std::strtod(argv[++i], nullptr);
+            }
+            else {
+                std::cerr << "unknown or incomplete argument " << tArgument << std::endl;
+                return false;
+            }
+        }
+
+        const bool tKnownSuite = aOptions.mSuite == "flythrough" || aOptions.mSuite == "jobs";
+        const bool tValidDepth = aOptions.mDesc.mFramesInFlight <= 4;
+        return tKnownSuite && tValidDepth && aOptions.mDesc.mFrames > 0 && aOptions.mDesc.mWidth > 0 && aOptions.mDesc.mHeight > 0;
+    }
+
+    // Returns the number of regressed metrics
+    size_t PrintComparison(const std::vector<Flux::MetricComparison>& aComparisons) {
+        size_t tRegressions = 0;
+
+        std::printf("%-56s %12s %12s %12s %12s\n", "metric", "base p50", "p50", "base p95", "p95");
+        for (const auto& comparison : aComparisons) {
+            const char* tStatus = comparison.mRegressed ? "REGRESSED" : (comparison.mMissing ? "missing" : (comparison.mNew ? "new" : ""));
+            std::printf("%-56s %12.4f %12.4f %12.4f %12.4f %s\n", comparison.mName.c_str(), comparison.mBaselineP50, comparison.mCurrentP50,
+                comparison.mBaselineP95, comparison.mCurrentP95, tStatus);
+
+            if (comparison.mRegressed) {
+                tRegressions++;
+            }
+        }
+
+        return tRegressions;
+    }
+}
+
+// Exits with 0 when every metric is within its threshold of the baseline, 1 on a regression and EXIT_FAILURE on errors
+int main(int argc, char** argv) {
+    Options tOptions;
+    if (!ParseOptions(argc, argv, tOptions)) {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    Flux::FlythroughBenchmark tFlythrough(tOptions.mDesc);
+
+    Flux::JobSystemBenchmarkDesc tJobsDesc;
+    tJobsDesc.mRepetitions = tOptions.mDesc.mFrames;
+    tJobsDesc.mWarmupRepetitions = tOptions.mDesc.mWarmupFrames;
+    Flux::JobSystemBenchmark tJobs(tJobsDesc);
+
+    const bool tRunJobs = tOptions.mSuite == "jobs";
+
+    try {
+        if (tRunJobs) {
+            tJobs.Run();
+        }
+        else {
+            tFlythrough.Run();
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const Flux::BenchmarkReport& tReport = tRunJobs ? tJobs.GetReport() : tFlythrough.GetReport();
+    if (!tReport.WriteJsonToFile(tOptions.mOutput + ".json") || !tReport.WriteCsvToFile(tOptions.mOutput + ".csv")) {
+        std::cerr << "failed to write " << tOptions.mOutput << ".json and .csv!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<Flux::MetricSummary> tSummaries = tReport.Summarize();
+    if (tOptions.mBaseline.empty()) {
+        std::printf("%-56s %12s %12s %12s %12s\n", "metric", "avg", "p50", "p95", "p99");
+        for (const auto& summary : tSummaries) {
+            std::printf("%-56s %12.4f %12.4f %12.4f %12.4f\n", summary.mName.c_str(), summary.mAverage, summary.mP50, summary.mP95, summary.mP99);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    std::vector<Flux::MetricSummary> tBaseline;
+    if (!Flux::BenchmarkReport::LoadSummariesFromFile(tOptions.mBaseline, tBaseline)) {
+        std::cerr << "failed to read baseline " << tOptions.mBaseline << "!" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Flux::RegressionThreshold tDefault;
+    std::map<std::string, Flux::RegressionThreshold> tOverrides = tRunJobs ? Flux::JobSystemBenchmark::GetDefaultThresholds() : Flux::FlythroughBenchmark::GetDefaultThresholds();
+    if (tOptions.mThreshold >= 0.0) {
+        tDefault.mRelative = tOptions.mThreshold;
+        for (auto& threshold : tOverrides) {
+            threshold.second.mRelative = tOptions.mThreshold;
+        }
+    }
+
+    const size_t tRegressions = PrintComparison(Flux::BenchmarkReport::Compare(tBaseline, tSummaries, tDefault, tOverrides));
+    if (tRegressions > 0) {
+        std::cout << tRegressions << " metrics regressed against " << tOptions.mBaseline << std::endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,190 @@
+#include "FlythroughBenchmark.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Application/Camera.h"
+#include "Application/Input.h"
+#include "Application/Scene/FirstScene.h"
+#include "Application/Rendering/CustomRenderer.h"
+#include "Application/Rendering/GpuProfiler.h"
+
+#include "Common/Profiling/CpuProfiler.h"
+
+namespace
+{
+	// Fixed so the scene advances the same for every run
+	const float cFrameDelta = 1.0f / 60.0f;
+
+	const double cBytesToMegabytes = 1.0 / (1024.0 * 1024.0);
+
+	// The statistic names are padded for the debug window
+	std::string TrimRight(const std::string& aText)
+	{
+		const size_t tLast = aText.find_last_not_of(" \t");
+		return tLast == std::string::npos ? std::string() : aText.substr(0, tLast + 1);
+	}
+}
+
+Flux::FlythroughBenchmark::FlythroughBenchmark(const FlythroughBenchmarkDesc& aDesc) : mDesc(aDesc)
+{
+}
+
+Flux::FlythroughBenchmark::~FlythroughBenchmark()
+{
+}
+
+std::map<std::string, Flux::RegressionThreshold> Flux::FlythroughBenchmark::GetDefaultThresholds()
+{
+	std::map<std::string, RegressionThreshold> tThresholds;
+	tThresholds["cpu/"] = RegressionThreshold{ 0.15, 0.1 };
+	tThresholds["gpu/"] = RegressionThreshold{ 0.10, 0.05 };
+	tThresholds["stats/"] = RegressionThreshold{ 0.05, 0.0 };
+	tThresholds["memory/"] = RegressionThreshold{ 0.05, 1.0 };
+	tThresholds["latency/"] = RegressionThreshold{ 0.15, 0.25 };
+	return tThresholds;
+}
+
+void Flux::FlythroughBenchmark::Run()
+{
+	FLUX_PROFILE_THREAD("Main thread");
+
+	if (!mPath.Load(mDesc.mPathFile) || mPath.IsEmpty())
+	{
+		throw std::runtime_error("failed to load camera path " + mDesc.mPathFile + "!");
+	}
+
+	HeadlessRendererDesc tRendererDesc;
+	tRendererDesc.mWidth = mDesc.mWidth;
+	tRendererDesc.mHeight = mDesc.mHeight;
+	tRendererDesc.mEnableValidation = mDesc.mEnableValidation;
+
+	mRenderer = std::make_unique<CustomRenderer>(tRendererDesc);
+	mRenderer->Init();
+
+	// Fewer frames lower the latency, more let the CPU and GPU overlap, runs at each depth are compared through their reports
+	if (mDesc.mFramesInFlight > 0)
+	{
+		mRenderer->SetFramesInFlight(mDesc.mFramesInFlight);
+	}
+
+	mScene = std::make_shared<FirstScene>(std::make_shared<Input>());
+	mScene->Init();
+	mRenderer->PrewarmPipelines(mScene, true);
+
+	mReport.Clear();
+	mReport.SetInfo("scene", "FirstScene");
+	mReport.SetInfo("path", mDesc.mPathFile);
+	mReport.SetInfo("resolution", std::to_string(mDesc.mWidth) + "x" + std::to_string(mDesc.mHeight));
+	mReport.SetInfo("warmup frames", std::to_string(mDesc.mWarmupFrames));
+	mReport.SetInfo("frames in flight", std::to_string(mRenderer->GetFramesInFlight()));
+	mReport.SetInfo("gpu", mRenderer->mRenderContext->mDevice->mPhysicalDeviceProperties.deviceName);
+
+	// Warmup holds the first view, so the recorded frames start from a settled state
+	for (uint32_t frame = 0; frame < mDesc.mWarmupFrames; ++frame)
+	{
+		RenderFrame(0.0f);
+	}
+
+	CpuProfiler::Get().ClearStatistics();
+	mRenderer->mProfiling.mGpu->ClearStatistics();
+	mLatenciesRecorded = mRenderer->mPresentation.mLatenciesMeasured;
+
+	const float tLastFrame = static_cast<float>(std::max(mDesc.mFrames, 2u) - 1);
+	for (uint32_t frame = 0; frame < mDesc.mFrames; ++frame)
+	{
+		RenderFrame(static_cast<float>(frame) / tLastFrame);
+		RecordFrame();
+	}
+
+	mScene->Cleanup();
+	mRenderer->WaitIdle();
+	mRenderer->Cleanup();
+	mRenderer.reset();
+	mScene.reset();
+}
+
+void Flux::FlythroughBenchmark::RenderFrame(float aT)
+{
+	mRenderer->BeginFrame();
+
+	{
+		FLUX_PROFILE_ZONE("Scene update");
+		mScene->Update(cFrameDelta);
+	}
+
+	// After the update, so the scene can not move the camera away from the path
+	const CameraPathKey tKey = mPath.Evaluate(aT);
+	const std::shared_ptr<Camera> tCamera = mScene->GetCamera();
+	tCamera->Position = tKey.mPosition;
+	tCamera->Yaw = tKey.mYaw;
+	tCamera->Pitch = tKey.mPitch;
+	tCamera->viewportWidth = static_cast<int32_t>(mDesc.mWidth);
+	tCamera->viewportHeight = static_cast<int32_t>(mDesc.mHeight);
+	tCamera->ProcessMouseMovement(0.0f, 0.0f); // Updates the vectors from the angles
+
+	mRenderer->Draw(mScene);
+
+	FLUX_PROFILE_FRAME();
+}
+
+void Flux::FlythroughBenchmark::RecordFrame()
+{
+	mReport.BeginFrame();
+
+	const CpuProfiler& tCpu = CpuProfiler::Get();
+	mReport.AddSample("cpu/frame", tCpu.GetFrameTimes().GetLast());
+	for (const auto& zone : tCpu.GetZones())
+	{
+		if (zone.mCalls > 0)
+		{
+			mReport.AddSample("cpu/" + zone.mName, zone.mMilliseconds.GetLast());
+		}
+	}
+
+	// Draw collects the GPU zones and the pipeline statistics of the same finished frame
+	bool tGpuFrameCollected = false;
+	for (const auto& zone : mRenderer->mProfiling.mGpu->GetZones())
+	{
+		if (zone.mCalls > 0)
+		{
+			mReport.AddSample("gpu/" + zone.mName, zone.mFrameMilliseconds);
+			tGpuFrameCollected = true;
+		}
+	}
+
+	if (tGpuFrameCollected)
+	{
+		const CustomRenderer::RenderDataQuery& tQuery = mRenderer->mRenderDataPipeline;
+		for (size_t pass = 0; pass < tQuery.pipelineStats.size() && pass < tQuery.passNames.size(); ++pass)
+		{
+			for (size_t stat = 0; stat < tQuery.pipelineStats[pass].size() && stat < tQuery.pipelineStatNames.size(); ++stat)
+			{
+				mReport.AddSample("stats/" + tQuery.passNames[pass] + "/" + TrimRight(tQuery.pipelineStatNames[stat]), static_cast<double>(tQuery.pipelineStats[pass][stat]));
+			}
+		}
+	}
+
+	// Frames that completed together are measured in the same poll, the last one stands for them
+	const uint64_t tLatenciesMeasured = mRenderer->mPresentation.mLatenciesMeasured;
+	if (tLatenciesMeasured != mLatenciesRecorded)
+	{
+		mReport.AddSample("latency/input to completion", mRenderer->mPresentation.mLatenciesMs.GetLast());
+		mLatenciesRecorded = tLatenciesMeasured;
+	}
+
+	VmaBudget tBudgets[VK_MAX_MEMORY_HEAPS] = {};
+	vmaGetBudget(mRenderer->mRenderContext->memoryAllocator, tBudgets);
+
+	VkDeviceSize tAllocationBytes = 0;
+	VkDeviceSize tBlockBytes = 0;
+	const uint32_t tHeapCount = mRenderer->mRenderContext->mDevice->mPhysicalDeviceMemoryProperties.memoryHeapCount;
+	for (uint32_t heap = 0; heap < tHeapCount; ++heap)
+	{
+		tAllocationBytes += tBudgets[heap].allocationBytes;
+		tBlockBytes += tBudgets[heap].blockBytes;
+	}
+
+	mReport.AddSample("memory/allocation MB", static_cast<double>(tAllocationBytes) * cBytesToMegabytes);
+	mReport.AddSample("memory/block MB", static_cast<double>(tBlockBytes) * cBytesToMegabytes);
+}
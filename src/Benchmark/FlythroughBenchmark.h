@@ -0,0 +1,64 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Common/Benchmark/CameraPath.h"
+#include "Common/Benchmark/BenchmarkReport.h"
+
+namespace Flux
+{
+	class CustomRenderer;
+	class FirstScene;
+
+	struct FlythroughBenchmarkDesc
+	{
+		uint32_t mWidth = 1280;
+		uint32_t mHeight = 720;
+		uint32_t mWarmupFrames = 60; // Rendered before recording, pipelines, caches and the frames in flight settle
+		uint32_t mFrames = 600;
+		uint32_t mFramesInFlight = 0; // Set before warmup, 0 keeps the default of the renderer
+		std::string mPathFile = "Resources/Benchmarks/sponza_flythrough.path";
+		bool mEnableValidation = false;
+	};
+
+	// Renders FirstScene headless at a fixed resolution while the camera follows a recorded path, one path step per frame
+	// so every run renders the same views regardless of how fast it runs
+	// Records per frame: "cpu/frame" and "cpu/<zone>" in ms, "gpu/<pass>" in ms, "stats/<pass>/<statistic>" as counts and
+	// "memory/..." in MB as reported by the VMA budget and "latency/input to completion" in ms from the input sample of a
+	// frame to its fence being seen signaled. GPU timings, pipeline statistics and latencies are read once a frame finished,
+	// so they trail the CPU samples by the frames in flight
+	class FlythroughBenchmark
+	{
+	public:
+		explicit FlythroughBenchmark(const FlythroughBenchmarkDesc& aDesc);
+		~FlythroughBenchmark();
+
+		// Throws when the path can not be loaded or the renderer fails
+		void Run();
+
+		const BenchmarkReport& GetReport() const { return mReport; }
+
+		// Thresholds per metric group, timings get room for run to run noise
+		static std::map<std::string, RegressionThreshold> GetDefaultThresholds();
+
+	private:
+		FlythroughBenchmark(const FlythroughBenchmark&) = delete;
+		FlythroughBenchmark& operator= (const FlythroughBenchmark&) = delete;
+
+		void RenderFrame(float aT);
+		void RecordFrame();
+
+		FlythroughBenchmarkDesc mDesc;
+		CameraPath mPath;
+		BenchmarkReport mReport;
+
+		uint64_t mLatenciesRecorded = 0;
+
+		std::unique_ptr<CustomRenderer> mRenderer;
+		std::shared_ptr<FirstScene> mScene;
+	};
+}
@@ -0,0 +1,166 @@
+#include "JobSystemBenchmark.h"
+
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include "Common/Jobs/JobSystem.h"
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	double ElapsedNanoseconds(Clock::time_point aStart)
+	{
+		return std::chrono::duration<double, std::nano>(Clock::now() - aStart).count();
+	}
+
+	// Uneven on purpose, so threads that get cheap ranges run out early and have to steal
+	float Work(size_t aIndex)
+	{
+		float tValue = static_cast<float>(aIndex);
+		const size_t tIterations = 4 + (aIndex * 7) % 61;
+		for (size_t i = 0; i < tIterations; ++i)
+		{
+			tValue = std::sin(tValue) * 0.5f + static_cast<float>(i);
+		}
+		return tValue;
+	}
+}
+
+Flux::JobSystemBenchmark::JobSystemBenchmark(const JobSystemBenchmarkDesc& aDesc) : mDesc(aDesc)
+{
+}
+
+std::map<std::string, Flux::RegressionThreshold> Flux::JobSystemBenchmark::GetDefaultThresholds()
+{
+	std::map<std::string, RegressionThreshold> tThresholds;
+	tThresholds["jobs/"] = RegressionThreshold{ 0.15, 0.0 };
+	tThresholds["jobs/spawn"] = RegressionThreshold{ 0.25, 5.0 };
+	tThresholds["jobs/create"] = RegressionThreshold{ 0.25, 5.0 };
+	return tThresholds;
+}
+
+void Flux::JobSystemBenchmark::Run()
+{
+	const uint32_t tHardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	const uint32_t tMaxThreads = mDesc.mMaxThreads > 0 ? mDesc.mMaxThreads : tHardwareThreads;
+
+	std::vector<uint32_t> tThreadCounts;
+	for (uint32_t tThreads = 1; tThreads < tMaxThreads; tThreads *= 2)
+	{
+		tThreadCounts.push_back(tThreads);
+	}
+	tThreadCounts.push_back(tMaxThreads);
+
+	// Samples per metric and repetition, every system is measured on its own so only it has threads running
+	std::vector<std::pair<std::string, std::vector<double>>> tMetrics;
+	std::vector<float> tResults(mDesc.mParallelForItems);
+	const uint32_t tTotalRepetitions = mDesc.mWarmupRepetitions + mDesc.mRepetitions;
+
+	{
+		JobSystem tJobs(tMaxThreads - 1);
+		std::vector<double> tSpawn;
+		std::vector<double> tCreateSubmit;
+		std::vector<double> tSpawnFromTask;
+
+		for (uint32_t repetition = 0; repetition < tTotalRepetitions; ++repetition)
+		{
+			TaskGroup tGroup;
+			Clock::time_point tStart = Clock::now();
+			for (uint32_t i = 0; i < mDesc.mSpawnTasks; ++i)
+			{
+				tJobs.Run(tGroup, []() {});
+			}
+			tJobs.Wait(tGroup);
+			const double tSpawnNs = ElapsedNanoseconds(tStart) / mDesc.mSpawnTasks;
+
+			tStart = Clock::now();
+			for (uint32_t i = 0; i < mDesc.mSpawnTasks; ++i)
+			{
+				tJobs.Submit(tJobs.Create(tGroup, []() {}));
+			}
+			tJobs.Wait(tGroup);
+			const double tCreateSubmitNs = ElapsedNanoseconds(tStart) / mDesc.mSpawnTasks;
+
+			tStart = Clock::now();
+			tJobs.Run(tGroup, [&]() {
+				TaskGroup tInner;
+				for (uint32_t i = 0; i < mDesc.mSpawnTasks; ++i)
+				{
+					tJobs.Run(tInner, []() {});
+				}
+				tJobs.Wait(tInner);
+			});
+			tJobs.Wait(tGroup);
+			const double tSpawnFromTaskNs = ElapsedNanoseconds(tStart) / mDesc.mSpawnTasks;
+
+			if (repetition >= mDesc.mWarmupRepetitions)
+			{
+				tSpawn.push_back(tSpawnNs);
+				tCreateSubmit.push_back(tCreateSubmitNs);
+				tSpawnFromTask.push_back(tSpawnFromTaskNs);
+			}
+		}
+
+		tMetrics.emplace_back("jobs/spawn ns", std::move(tSpawn));
+		tMetrics.emplace_back("jobs/create submit ns", std::move(tCreateSubmit));
+		tMetrics.emplace_back("jobs/spawn from task ns", std::move(tSpawnFromTask));
+	}
+
+	std::vector<double> tMedians;
+	for (const uint32_t threads : tThreadCounts)
+	{
+		JobSystem tJobs(threads - 1);
+		std::vector<double> tTimes;
+
+		for (uint32_t repetition = 0; repetition < tTotalRepetitions; ++repetition)
+		{
+			const Clock::time_point tStart = Clock::now();
+			tJobs.ParallelFor(0, tResults.size(), [&](size_t aBegin, size_t aEnd) {
+				for (size_t i = aBegin; i < aEnd; ++i)
+				{
+					tResults[i] = Work(i);
+				}
+			}, 256);
+			const double tMilliseconds = ElapsedNanoseconds(tStart) * 1e-6;
+
+			if (repetition >= mDesc.mWarmupRepetitions)
+			{
+				tTimes.push_back(tMilliseconds);
+			}
+		}
+
+		std::vector<double> tSorted = tTimes;
+		std::nth_element(tSorted.begin(), tSorted.begin() + tSorted.size() / 2, tSorted.end());
+		tMedians.push_back(tSorted.empty() ? 0.0 : tSorted[tSorted.size() / 2]);
+
+		tMetrics.emplace_back("jobs/parallel for/" + std::to_string(threads) + " threads ms", std::move(tTimes));
+	}
+
+	mReport.Clear();
+	mReport.SetInfo("suite", "jobs");
+	mReport.SetInfo("hardware threads", std::to_string(tHardwareThreads));
+	mReport.SetInfo("spawn tasks", std::to_string(mDesc.mSpawnTasks));
+	mReport.SetInfo("parallel for items", std::to_string(mDesc.mParallelForItems));
+
+	// Higher is better, so kept out of the metrics the baseline comparison checks
+	for (size_t i = 1; i < tThreadCounts.size(); ++i)
+	{
+		const double tSpeedup = tMedians[i] > 0.0 ? tMedians[0] / tMedians[i] : 0.0;
+		mReport.SetInfo("speedup " + std::to_string(tThreadCounts[i]) + " threads", std::to_string(tSpeedup));
+	}
+
+	for (uint32_t repetition = 0; repetition < mDesc.mRepetitions; ++repetition)
+	{
+		mReport.BeginFrame();
+		for (const auto& metric : tMetrics)
+		{
+			mReport.AddSample(metric.first, metric.second[repetition]);
+		}
+	}
+}
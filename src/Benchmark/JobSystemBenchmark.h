@@ -0,0 +1,39 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <cstdint>
+
+#include "Common/Benchmark/BenchmarkReport.h"
+
+namespace Flux
+{
+	struct JobSystemBenchmarkDesc
+	{
+		uint32_t mWarmupRepetitions = 5;
+		uint32_t mRepetitions = 50;
+		uint32_t mSpawnTasks = 10000; // Empty tasks per spawn measurement
+		size_t mParallelForItems = 1 << 16;
+		uint32_t mMaxThreads = 0; // 0 measures up to every hardware thread
+	};
+
+	// Microbenchmarks of the JobSystem, every repetition is a row of the report
+	// "jobs/spawn ns" and "jobs/create submit ns" are the cost per empty task from spawning to the end of the wait,
+	// "jobs/spawn from task ns" spawns from a worker into its own deque
+	// "jobs/parallel for/<n> threads ms" runs an uneven workload on n threads, the speedups over one thread are in the info
+	class JobSystemBenchmark
+	{
+	public:
+		explicit JobSystemBenchmark(const JobSystemBenchmarkDesc& aDesc);
+
+		void Run();
+
+		const BenchmarkReport& GetReport() const { return mReport; }
+
+		static std::map<std::string, RegressionThreshold> GetDefaultThresholds();
+
+	private:
+		JobSystemBenchmarkDesc mDesc;
+		BenchmarkReport mReport;
+	};
+}
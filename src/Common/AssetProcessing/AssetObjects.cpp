@@ -1,5 +1,8 @@
 #include "AssetObjects.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace Flux
 {
 	ErrorAssetFileNotFound::ErrorAssetFileNotFound(std::filesystem::path const &aFilepath)
@@ -11,4 +14,35 @@ namespace Flux
 	{
 		return mMessage.c_str();
 	}
+
+	void MeshAsset::ComputeBounds()
+	{
+		if (mVertexData.empty())
+		{
+			mBoundsMin = glm::vec3(0.0f);
+			mBoundsMax = glm::vec3(0.0f);
+			mBoundingSphere = glm::vec4(0.0f);
+			return;
+		}
+
+		mBoundsMin = mVertexData[0].position;
+		mBoundsMax = mVertexData[0].position;
+		for (const auto& vertex : mVertexData)
+		{
+			mBoundsMin = glm::min(mBoundsMin, vertex.position);
+			mBoundsMax = glm::max(mBoundsMax, vertex.position);
+		}
+
+		// Center of the box with the distance to the furthest vertex, not the smallest sphere but close for most meshes
+		const glm::vec3 tCenter = (mBoundsMin + mBoundsMax) * 0.5f;
+
+		float tRadiusSquared = 0.0f;
+		for (const auto& vertex : mVertexData)
+		{
+			const glm::vec3 tOffset = vertex.position - tCenter;
+			tRadiusSquared = std::max(tRadiusSquared, glm::dot(tOffset, tOffset));
+		}
+
+		mBoundingSphere = glm::vec4(tCenter, std::sqrt(tRadiusSquared));
+	}
 }
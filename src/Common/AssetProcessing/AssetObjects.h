@@ -4,6 +4,7 @@
 #include <string>
 #include <filesystem>
 
+#include <glm/glm.hpp>
 #include <glm/gtx/common.hpp>
 
 namespace Flux
@@ -62,12 +63,23 @@ namespace Flux
 		MeshAsset(std::vector<VertexData>& aVertexData, std::vector<uint32_t>& aIndices, MaterialAsset& aMaterialAsset) :
 			mVertexData(aVertexData),
 			mIndices(aIndices),
-			mMaterialAsset(aMaterialAsset) {}
+			mMaterialAsset(aMaterialAsset)
+		{
+			ComputeBounds();
+		}
 		MeshAsset() = default;
 
+		// Has to be called again when the vertex data is changed after construction
+		void ComputeBounds();
+
 		std::vector<VertexData> mVertexData;
 		std::vector<uint32_t> mIndices;
 		MaterialAsset mMaterialAsset;
+
+		// Object space bounds
+		glm::vec3 mBoundsMin = glm::vec3(0.0f);
+		glm::vec3 mBoundsMax = glm::vec3(0.0f);
+		glm::vec4 mBoundingSphere = glm::vec4(0.0f); // Center in xyz, radius in w
 	};
 
 	struct ModelAsset
@@ -0,0 +1,540 @@
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#include "Common/Time/FramePacer.h"
+#include "Common/Profiling/ChromeTrace.h"
+
+namespace Flux
+{
+	namespace
+	{
+		// Reads back what WriteJson writes, values that are not needed are skipped without being kept
+		class JsonReader
+		{
+		public:
+			explicit JsonReader(const std::string& aText) : mText(aText), mPosition(0) {}
+
+			bool Consume(char aCharacter)
+			{
+				SkipWhitespace();
+				if (mPosition < mText.size() && mText[mPosition] == aCharacter)
+				{
+					mPosition++;
+					return true;
+				}
+
+				return false;
+			}
+
+			bool Peek(char aCharacter)
+			{
+				SkipWhitespace();
+				return mPosition < mText.size() && mText[mPosition] == aCharacter;
+			}
+
+			bool ReadString(std::string& aOutString)
+			{
+				if (!Consume('"'))
+				{
+					return false;
+				}
+
+				aOutString.clear();
+				while (mPosition < mText.size())
+				{
+					const char tCharacter = mText[mPosition++];
+					if (tCharacter == '"')
+					{
+						return true;
+					}
+
+					if (tCharacter != '\\')
+					{
+						aOutString += tCharacter;
+						continue;
+					}
+
+					if (mPosition >= mText.size())
+					{
+						return false;
+					}
+
+					const char tEscaped = mText[mPosition++];
+					switch (tEscaped)
+					{
+					case 'n': aOutString += '\n'; break;
+					case 'r': aOutString += '\r'; break;
+					case 't': aOutString += '\t'; break;
+					case 'b': aOutString += '\b'; break;
+					case 'f': aOutString += '\f'; break;
+					case 'u':
+						// Escape only writes control characters this way
+						if (mPosition + 4 > mText.size())
+						{
+							return false;
+						}
+						aOutString += static_cast<char>(std::strtol(mText.substr(mPosition, 4).c_str(), nullptr, 16));
+						mPosition += 4;
+						break;
+					default: aOutString += tEscaped; break;
+					}
+				}
+
+				return false;
+			}
+
+			bool ReadNumber(double& aOutNumber)
+			{
+				SkipWhitespace();
+				const char* tStart = mText.c_str() + mPosition;
+				char* tEnd = nullptr;
+				aOutNumber = std::strtod(tStart, &tEnd);
+				if (tEnd == tStart)
+				{
+					return false;
+				}
+
+				mPosition += static_cast<size_t>(tEnd - tStart);
+				return true;
+			}
+
+			bool SkipValue()
+			{
+				SkipWhitespace();
+				if (mPosition >= mText.size())
+				{
+					return false;
+				}
+
+				std::string tString;
+				switch (mText[mPosition])
+				{
+				case '"':
+					return ReadString(tString);
+				case '{':
+					mPosition++;
+					if (Consume('}'))
+					{
+						return true;
+					}
+					do
+					{
+						if (!ReadString(tString) || !Consume(':') || !SkipValue())
+						{
+							return false;
+						}
+					} while (Consume(','));
+					return Consume('}');
+				case '[':
+					mPosition++;
+					if (Consume(']'))
+					{
+						return true;
+					}
+					do
+					{
+						if (!SkipValue())
+						{
+							return false;
+						}
+					} while (Consume(','));
+					return Consume(']');
+				default:
+					// Numbers and literals
+					while (mPosition < mText.size() && std::strchr(",}] \t\r\n", mText[mPosition]) == nullptr)
+					{
+						mPosition++;
+					}
+					return true;
+				}
+			}
+
+		private:
+			void SkipWhitespace()
+			{
+				while (mPosition < mText.size() && std::isspace(static_cast<unsigned char>(mText[mPosition])))
+				{
+					mPosition++;
+				}
+			}
+
+			const std::string& mText;
+			size_t mPosition;
+		};
+
+		bool ReadSummary(JsonReader& aReader, MetricSummary& aOutSummary)
+		{
+			if (!aReader.Consume('{'))
+			{
+				return false;
+			}
+
+			if (aReader.Consume('}'))
+			{
+				return true;
+			}
+
+			do
+			{
+				std::string tKey;
+				if (!aReader.ReadString(tKey) || !aReader.Consume(':'))
+				{
+					return false;
+				}
+
+				double tNumber = 0.0;
+				bool tValid = true;
+				if (tKey == "name") { tValid = aReader.ReadString(aOutSummary.mName); }
+				else if (tKey == "samples") { tValid = aReader.ReadNumber(tNumber); aOutSummary.mSamples = static_cast<size_t>(tNumber); }
+				else if (tKey == "avg") { tValid = aReader.ReadNumber(aOutSummary.mAverage); }
+				else if (tKey == "p50") { tValid = aReader.ReadNumber(aOutSummary.mP50); }
+				else if (tKey == "p95") { tValid = aReader.ReadNumber(aOutSummary.mP95); }
+				else if (tKey == "p99") { tValid = aReader.ReadNumber(aOutSummary.mP99); }
+				else if (tKey == "max") { tValid = aReader.ReadNumber(aOutSummary.mMax); }
+				else { tValid = aReader.SkipValue(); }
+
+				if (!tValid)
+				{
+					return false;
+				}
+			} while (aReader.Consume(','));
+
+			return aReader.Consume('}');
+		}
+
+		const RegressionThreshold& FindThreshold(const std::string& aMetric, const RegressionThreshold& aDefault, const std::map<std::string, RegressionThreshold>& aOverrides)
+		{
+			const RegressionThreshold* tResult = &aDefault;
+			size_t tLongest = 0;
+			for (const auto& entry : aOverrides)
+			{
+				if (entry.first.size() >= tLongest && aMetric.compare(0, entry.first.size(), entry.first) == 0)
+				{
+					tResult = &entry.second;
+					tLongest = entry.first.size();
+				}
+			}
+
+			return *tResult;
+		}
+
+		bool Exceeds(double aCurrent, double aBaseline, const RegressionThreshold& aThreshold)
+		{
+			return aCurrent > aBaseline * (1.0 + aThreshold.mRelative) + aThreshold.mAbsolute;
+		}
+	}
+
+	void BenchmarkReport::SetInfo(const std::string& aKey, const std::string& aValue)
+	{
+		for (auto& info : mInfo)
+		{
+			if (info.first == aKey)
+			{
+				info.second = aValue;
+				return;
+			}
+		}
+
+		mInfo.emplace_back(aKey, aValue);
+	}
+
+	void BenchmarkReport::BeginFrame()
+	{
+		mFrameCount++;
+		for (auto& values : mValues)
+		{
+			values.push_back(std::numeric_limits<double>::quiet_NaN());
+		}
+	}
+
+	void BenchmarkReport::AddSample(const std::string& aMetric, double aValue)
+	{
+		assert(mFrameCount > 0);
+
+		auto tFound = mMetricIndices.find(aMetric);
+		if (tFound == mMetricIndices.end())
+		{
+			tFound = mMetricIndices.emplace(aMetric, mMetricNames.size()).first;
+			mMetricNames.push_back(aMetric);
+			mValues.emplace_back(mFrameCount, std::numeric_limits<double>::quiet_NaN());
+		}
+
+		double& tValue = mValues[tFound->second].back();
+		tValue = std::isnan(tValue) ? aValue : tValue + aValue;
+	}
+
+	void BenchmarkReport::Clear()
+	{
+		mMetricNames.clear();
+		mMetricIndices.clear();
+		mValues.clear();
+		mFrameCount = 0;
+	}
+
+	std::vector<MetricSummary> BenchmarkReport::Summarize() const
+	{
+		std::vector<MetricSummary> tSummaries;
+		tSummaries.reserve(mMetricNames.size());
+
+		for (size_t metric = 0; metric < mMetricNames.size(); ++metric)
+		{
+			const std::vector<double>& tValues = mValues[metric];
+			const size_t tSamples = static_cast<size_t>(std::count_if(tValues.begin(), tValues.end(), [](double aValue) { return !std::isnan(aValue); }));
+
+			// Large enough for the whole run, so the percentiles match the ones shown while running
+			RollingStatistics tStatistics(std::max(tSamples, size_t(1)));
+			for (const double value : tValues)
+			{
+				if (!std::isnan(value))
+				{
+					tStatistics.Add(value);
+				}
+			}
+
+			MetricSummary tSummary;
+			tSummary.mName = mMetricNames[metric];
+			tSummary.mSamples = tSamples;
+			tSummary.mAverage = tStatistics.GetAverage();
+			tSummary.mP50 = tStatistics.GetPercentile(0.50);
+			tSummary.mP95 = tStatistics.GetPercentile(0.95);
+			tSummary.mP99 = tStatistics.GetPercentile(0.99);
+			tSummary.mMax = tStatistics.GetMax();
+			tSummaries.push_back(tSummary);
+		}
+
+		return tSummaries;
+	}
+
+	void BenchmarkReport::WriteJson(std::ostream& aStream) const
+	{
+		const std::streamsize tPrecision = aStream.precision();
+		const std::ios_base::fmtflags tFlags = aStream.flags();
+		aStream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+		aStream.precision(4);
+
+		aStream << "{\n\"info\":{";
+		for (size_t i = 0; i < mInfo.size(); ++i)
+		{
+			aStream << (i > 0 ? "," : "") << "\n\"" << ChromeTrace::Escape(mInfo[i].first) << "\":\"" << ChromeTrace::Escape(mInfo[i].second) << "\"";
+		}
+
+		aStream << "\n},\n\"frames\":" << mFrameCount << ",\n\"metrics\":[";
+
+		const std::vector<MetricSummary> tSummaries = Summarize();
+		for (size_t i = 0; i < tSummaries.size(); ++i)
+		{
+			const MetricSummary& tSummary = tSummaries[i];
+			aStream << (i > 0 ? "," : "") << "\n{\"name\":\"" << ChromeTrace::Escape(tSummary.mName) << "\",\"samples\":" << tSummary.mSamples
+				<< ",\"avg\":" << tSummary.mAverage << ",\"p50\":" << tSummary.mP50 << ",\"p95\":" << tSummary.mP95
+				<< ",\"p99\":" << tSummary.mP99 << ",\"max\":" << tSummary.mMax << "}";
+		}
+
+		aStream << "\n]\n}\n";
+
+		aStream.precision(tPrecision);
+		aStream.flags(tFlags);
+	}
+
+	void BenchmarkReport::WriteCsv(std::ostream& aStream) const
+	{
+		const std::streamsize tPrecision = aStream.precision();
+		const std::ios_base::fmtflags tFlags = aStream.flags();
+		aStream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+		aStream.precision(4);
+
+		// Metric names are quoted, doubling the quotes inside
+		aStream << "frame";
+		for (const auto& name : mMetricNames)
+		{
+			std::string tQuoted;
+			for (const char character : name)
+			{
+				tQuoted += character == '"' ? "\"\"" : std::string(1, character);
+			}
+			aStream << ",\"" << tQuoted << "\"";
+		}
+		aStream << "\n";
+
+		for (size_t frame = 0; frame < mFrameCount; ++frame)
+		{
+			aStream << frame;
+			for (const auto& values : mValues)
+			{
+				aStream << ",";
+				if (!std::isnan(values[frame]))
+				{
+					aStream << values[frame];
+				}
+			}
+			aStream << "\n";
+		}
+
+		aStream.precision(tPrecision);
+		aStream.flags(tFlags);
+	}
+
+	bool BenchmarkReport::WriteJsonToFile(const std::string& aPath) const
+	{
+		std::ofstream tFile(aPath, std::ios::out | std::ios::trunc);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		WriteJson(tFile);
+		return tFile.good();
+	}
+
+	bool BenchmarkReport::WriteCsvToFile(const std::string& aPath) const
+	{
+		std::ofstream tFile(aPath, std::ios::out | std::ios::trunc);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		WriteCsv(tFile);
+		return tFile.good();
+	}
+
+	bool BenchmarkReport::LoadSummaries(std::istream& aStream, std::vector<MetricSummary>& aOutSummaries)
+	{
+		aOutSummaries.clear();
+
+		const std::string tText((std::istreambuf_iterator<char>(aStream)), std::istreambuf_iterator<char>());
+		JsonReader tReader(tText);
+
+		if (!tReader.Consume('{'))
+		{
+			return false;
+		}
+
+		bool tHasMetrics = false;
+		if (!tReader.Peek('}'))
+		{
+			do
+			{
+				std::string tKey;
+				if (!tReader.ReadString(tKey) || !tReader.Consume(':'))
+				{
+					aOutSummaries.clear();
+					return false;
+				}
+
+				if (tKey != "metrics")
+				{
+					if (!tReader.SkipValue())
+					{
+						aOutSummaries.clear();
+						return false;
+					}
+					continue;
+				}
+
+				if (!tReader.Consume('['))
+				{
+					aOutSummaries.clear();
+					return false;
+				}
+
+				tHasMetrics = true;
+				if (tReader.Consume(']'))
+				{
+					continue;
+				}
+
+				do
+				{
+					MetricSummary tSummary;
+					if (!ReadSummary(tReader, tSummary))
+					{
+						aOutSummaries.clear();
+						return false;
+					}
+					aOutSummaries.push_back(tSummary);
+				} while (tReader.Consume(','));
+
+				if (!tReader.Consume(']'))
+				{
+					aOutSummaries.clear();
+					return false;
+				}
+			} while (tReader.Consume(','));
+		}
+
+		if (!tReader.Consume('}') || !tHasMetrics)
+		{
+			aOutSummaries.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	bool BenchmarkReport::LoadSummariesFromFile(const std::string& aPath, std::vector<MetricSummary>& aOutSummaries)
+	{
+		std::ifstream tFile(aPath);
+		if (!tFile.is_open())
+		{
+			aOutSummaries.clear();
+			return false;
+		}
+
+		return LoadSummaries(tFile, aOutSummaries);
+	}
+
+	std::vector<MetricComparison> BenchmarkReport::Compare(const std::vector<MetricSummary>& aBaseline, const std::vector<MetricSummary>& aCurrent,
+		const RegressionThreshold& aDefault, const std::map<std::string, RegressionThreshold>& aOverrides)
+	{
+		std::vector<MetricComparison> tComparisons;
+
+		// Baseline order first, then the metrics the baseline does not have
+		for (const auto& baseline : aBaseline)
+		{
+			MetricComparison tComparison;
+			tComparison.mName = baseline.mName;
+			tComparison.mBaselineP50 = baseline.mP50;
+			tComparison.mBaselineP95 = baseline.mP95;
+
+			const auto tCurrent = std::find_if(aCurrent.begin(), aCurrent.end(), [&](const MetricSummary& aSummary) { return aSummary.mName == baseline.mName; });
+			if (tCurrent == aCurrent.end())
+			{
+				tComparison.mMissing = true;
+			}
+			else
+			{
+				const RegressionThreshold& tThreshold = FindThreshold(baseline.mName, aDefault, aOverrides);
+				tComparison.mCurrentP50 = tCurrent->mP50;
+				tComparison.mCurrentP95 = tCurrent->mP95;
+				tComparison.mRegressed = Exceeds(tCurrent->mP50, baseline.mP50, tThreshold) || Exceeds(tCurrent->mP95, baseline.mP95, tThreshold);
+			}
+
+			tComparisons.push_back(tComparison);
+		}
+
+		for (const auto& current : aCurrent)
+		{
+			const bool tInBaseline = std::any_of(aBaseline.begin(), aBaseline.end(), [&](const MetricSummary& aSummary) { return aSummary.mName == current.mName; });
+			if (!tInBaseline)
+			{
+				MetricComparison tComparison;
+				tComparison.mName = current.mName;
+				tComparison.mCurrentP50 = current.mP50;
+				tComparison.mCurrentP95 = current.mP95;
+				tComparison.mNew = true;
+				tComparisons.push_back(tComparison);
+			}
+		}
+
+		return tComparisons;
+	}
+}
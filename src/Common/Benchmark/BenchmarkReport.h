@@ -0,0 +1,92 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <istream>
+#include <utility>
+#include <unordered_map>
+
+namespace Flux
+{
+	// Distribution of one metric over the frames of a run
+	struct MetricSummary
+	{
+		std::string mName;
+		size_t mSamples = 0;
+		double mAverage = 0.0;
+		double mP50 = 0.0;
+		double mP95 = 0.0;
+		double mP99 = 0.0;
+		double mMax = 0.0;
+	};
+
+	// A metric regressed when its p50 or p95 is above baseline * (1 + mRelative) + mAbsolute
+	// mAbsolute keeps metrics close to zero from failing on noise
+	struct RegressionThreshold
+	{
+		double mRelative = 0.1;
+		double mAbsolute = 0.0;
+	};
+
+	struct MetricComparison
+	{
+		std::string mName;
+		double mBaselineP50 = 0.0;
+		double mBaselineP95 = 0.0;
+		double mCurrentP50 = 0.0;
+		double mCurrentP95 = 0.0;
+		bool mRegressed = false;
+		bool mMissing = false; // In the baseline only
+		bool mNew = false; // In the current run only
+	};
+
+	// Per frame samples of named metrics, like "cpu/frame" or "gpu/Scene", summarized with percentiles
+	// Every metric is lower is better, frames without a sample of a metric are left out of its summary
+	class BenchmarkReport
+	{
+	public:
+		// Describes the run in the JSON output, like the resolution or the GPU
+		void SetInfo(const std::string& aKey, const std::string& aValue);
+
+		// Starts a frame, samples are added to the last frame started
+		void BeginFrame();
+
+		// Samples of the same metric in one frame are summed, like a zone entered several times
+		void AddSample(const std::string& aMetric, double aValue);
+
+		void Clear();
+
+		size_t GetFrameCount() const { return mFrameCount; }
+		size_t GetMetricCount() const { return mMetricNames.size(); }
+
+		// In the order the metrics were first sampled
+		std::vector<MetricSummary> Summarize() const;
+
+		// Info and summaries
+		void WriteJson(std::ostream& aStream) const;
+
+		// A row per frame and a column per metric, cells of frames without a sample are empty
+		void WriteCsv(std::ostream& aStream) const;
+
+		// Return false when the file can not be written
+		bool WriteJsonToFile(const std::string& aPath) const;
+		bool WriteCsvToFile(const std::string& aPath) const;
+
+		// Reads the summaries of a file written by WriteJson, returns false when it can not be read or parsed
+		static bool LoadSummaries(std::istream& aStream, std::vector<MetricSummary>& aOutSummaries);
+		static bool LoadSummariesFromFile(const std::string& aPath, std::vector<MetricSummary>& aOutSummaries);
+
+		// Compares every metric of either run, aOverrides maps metric name prefixes to thresholds and the longest match wins
+		static std::vector<MetricComparison> Compare(const std::vector<MetricSummary>& aBaseline, const std::vector<MetricSummary>& aCurrent,
+			const RegressionThreshold& aDefault, const std::map<std::string, RegressionThreshold>& aOverrides = {});
+
+	private:
+		std::vector<std::pair<std::string, std::string>> mInfo;
+		std::vector<std::string> mMetricNames;
+		std::unordered_map<std::string, size_t> mMetricIndices;
+		std::vector<std::vector<double>> mValues; // Per metric, per frame, NaN without a sample
+		size_t mFrameCount = 0;
+	};
+}
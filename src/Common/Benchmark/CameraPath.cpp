@@ -0,0 +1,100 @@
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+namespace Flux
+{
+	namespace
+	{
+		// Uniform Catmull-Rom between aP1 and aP2, aT in [0, 1]
+		template <typename T>
+		T CatmullRom(const T& aP0, const T& aP1, const T& aP2, const T& aP3, float aT)
+		{
+			const float tT2 = aT * aT;
+			const float tT3 = tT2 * aT;
+
+			return 0.5f * ((2.0f * aP1) + (aP2 - aP0) * aT + (2.0f * aP0 - 5.0f * aP1 + 4.0f * aP2 - aP3) * tT2 + (3.0f * aP1 - aP0 - 3.0f * aP2 + aP3) * tT3);
+		}
+	}
+
+	CameraPathKey CameraPath::Evaluate(float aT) const
+	{
+		assert(!mKeys.empty());
+
+		if (mKeys.size() == 1)
+		{
+			return mKeys[0];
+		}
+
+		const float tSegments = static_cast<float>(mKeys.size() - 1);
+		const float tPosition = std::clamp(aT, 0.0f, 1.0f) * tSegments;
+		const size_t tSegment = std::min(static_cast<size_t>(tPosition), mKeys.size() - 2);
+		const float tLocal = tPosition - static_cast<float>(tSegment);
+
+		const CameraPathKey& tK0 = mKeys[tSegment > 0 ? tSegment - 1 : 0];
+		const CameraPathKey& tK1 = mKeys[tSegment];
+		const CameraPathKey& tK2 = mKeys[tSegment + 1];
+		const CameraPathKey& tK3 = mKeys[std::min(tSegment + 2, mKeys.size() - 1)];
+
+		CameraPathKey tResult;
+		tResult.mPosition = CatmullRom(tK0.mPosition, tK1.mPosition, tK2.mPosition, tK3.mPosition, tLocal);
+		tResult.mYaw = CatmullRom(tK0.mYaw, tK1.mYaw, tK2.mYaw, tK3.mYaw, tLocal);
+		tResult.mPitch = CatmullRom(tK0.mPitch, tK1.mPitch, tK2.mPitch, tK3.mPitch, tLocal);
+
+		return tResult;
+	}
+
+	bool CameraPath::Load(const std::string& aPath)
+	{
+		mKeys.clear();
+
+		std::ifstream tFile(aPath);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		std::string tLine;
+		while (std::getline(tFile, tLine))
+		{
+			const size_t tFirst = tLine.find_first_not_of(" \t\r");
+			if (tFirst == std::string::npos || tLine[tFirst] == '#')
+			{
+				continue;
+			}
+
+			std::istringstream tStream(tLine);
+			CameraPathKey tKey;
+			if (!(tStream >> tKey.mPosition.x >> tKey.mPosition.y >> tKey.mPosition.z >> tKey.mYaw >> tKey.mPitch))
+			{
+				mKeys.clear();
+				return false;
+			}
+
+			mKeys.push_back(tKey);
+		}
+
+		return true;
+	}
+
+	bool CameraPath::Save(const std::string& aPath) const
+	{
+		std::ofstream tFile(aPath, std::ios::out | std::ios::trunc);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		tFile << "# x y z yaw pitch\n";
+		for (const auto& key : mKeys)
+		{
+			tFile << key.mPosition.x << " " << key.mPosition.y << " " << key.mPosition.z << " " << key.mYaw << " " << key.mPitch << "\n";
+		}
+
+		return tFile.good();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace Flux
+{
+	// Camera pose with the euler angles of Camera, in degrees
+	struct CameraPathKey
+	{
+		glm::vec3 mPosition = glm::vec3(0.0f);
+		float mYaw = 0.0f;
+		float mPitch = 0.0f;
+	};
+
+	// Keys recorded in the application, played back as a Catmull-Rom spline that passes through every key
+	// Keys are spaced evenly along the path, the end keys are repeated so the spline starts and stops at them
+	class CameraPath
+	{
+	public:
+		void AddKey(const CameraPathKey& aKey) { mKeys.push_back(aKey); }
+		void Clear() { mKeys.clear(); }
+
+		bool IsEmpty() const { return mKeys.empty(); }
+		const std::vector<CameraPathKey>& GetKeys() const { return mKeys; }
+
+		// aT in [0, 1] runs from the first to the last key, the path needs at least one key
+		CameraPathKey Evaluate(float aT) const;
+
+		// One key per line as "x y z yaw pitch", empty lines and lines starting with # are skipped
+		// Returns false when the file can not be read or a line is malformed, the keys are then left empty
+		bool Load(const std::string& aPath);
+		bool Save(const std::string& aPath) const;
+
+	private:
+		std::vector<CameraPathKey> mKeys;
+	};
+}
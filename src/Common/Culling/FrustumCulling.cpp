@@ -0,0 +1,187 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FLUX_CULLING_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLUX_CULLING_SSE
+#endif
+
+namespace Flux
+{
+	Frustum Frustum::FromMatrix(const glm::mat4& aViewProjection)
+	{
+		// Rows of the matrix, glm is column major
+		const glm::vec4 tRow0(aViewProjection[0][0], aViewProjection[1][0], aViewProjection[2][0], aViewProjection[3][0]);
+		const glm::vec4 tRow1(aViewProjection[0][1], aViewProjection[1][1], aViewProjection[2][1], aViewProjection[3][1]);
+		const glm::vec4 tRow2(aViewProjection[0][2], aViewProjection[1][2], aViewProjection[2][2], aViewProjection[3][2]);
+		const glm::vec4 tRow3(aViewProjection[0][3], aViewProjection[1][3], aViewProjection[2][3], aViewProjection[3][3]);
+
+		Frustum tFrustum;
+		tFrustum.mPlanes[eLeft] = tRow3 + tRow0;
+		tFrustum.mPlanes[eRight] = tRow3 - tRow0;
+		tFrustum.mPlanes[eBottom] = tRow3 + tRow1;
+		tFrustum.mPlanes[eTop] = tRow3 - tRow1;
+		tFrustum.mPlanes[eNear] = tRow3 + tRow2;
+		tFrustum.mPlanes[eFar] = tRow3 - tRow2;
+
+		for (int i = 0; i < eCount; ++i)
+		{
+			tFrustum.mPlanes[i] /= glm::length(glm::vec3(tFrustum.mPlanes[i]));
+		}
+
+		return tFrustum;
+	}
+
+	void BoundingSphereSoA::Clear()
+	{
+		mCenterX.clear();
+		mCenterY.clear();
+		mCenterZ.clear();
+		mRadius.clear();
+	}
+
+	void BoundingSphereSoA::Reserve(size_t aCount)
+	{
+		mCenterX.reserve(aCount);
+		mCenterY.reserve(aCount);
+		mCenterZ.reserve(aCount);
+		mRadius.reserve(aCount);
+	}
+
+	void BoundingSphereSoA::Add(const glm::vec4& aSphere)
+	{
+		mCenterX.push_back(aSphere.x);
+		mCenterY.push_back(aSphere.y);
+		mCenterZ.push_back(aSphere.z);
+		mRadius.push_back(aSphere.w);
+	}
+
+	glm::vec4 TransformBoundingSphere(const glm::vec4& aSphere, const glm::mat4& aTransform)
+	{
+		const glm::vec3 tCenter = glm::vec3(aTransform * glm::vec4(glm::vec3(aSphere), 1.0f));
+		const float tScale = std::max(glm::length(glm::vec3(aTransform[0])), std::max(glm::length(glm::vec3(aTransform[1])), glm::length(glm::vec3(aTransform[2]))));
+
+		return glm::vec4(tCenter, aSphere.w * tScale);
+	}
+
+	static size_t CullSpheresRange(const Frustum& aFrustum, const BoundingSphereSoA& aSpheres, size_t aBegin, size_t aEnd, uint8_t* aOutVisible)
+	{
+		size_t tVisible = 0;
+
+		for (size_t i = aBegin; i < aEnd; ++i)
+		{
+			bool tInside = true;
+			for (int plane = 0; plane < Frustum::eCount; ++plane)
+			{
+				const glm::vec4& tPlane = aFrustum.mPlanes[plane];
+				// Same order of operations as the SIMD paths, so both agree on spheres that touch a plane
+				float tDistance = tPlane.x * aSpheres.mCenterX[i] + tPlane.w;
+				tDistance = tPlane.y * aSpheres.mCenterY[i] + tDistance;
+				tDistance = tPlane.z * aSpheres.mCenterZ[i] + tDistance;
+				tInside = tInside && tDistance >= -aSpheres.mRadius[i];
+			}
+
+			aOutVisible[i] = tInside ? 1 : 0;
+			tVisible += aOutVisible[i];
+		}
+
+		return tVisible;
+	}
+
+	size_t CullSpheresScalar(const Frustum& aFrustum, const BoundingSphereSoA& aSpheres, std::vector<uint8_t>& aOutVisible)
+	{
+		aOutVisible.resize(aSpheres.Size());
+		return CullSpheresRange(aFrustum, aSpheres, 0, aSpheres.Size(), aOutVisible.data());
+	}
+
+	size_t CullSpheres(const Frustum& aFrustum, const BoundingSphereSoA& aSpheres, std::vector<uint8_t>& aOutVisible)
+	{
+		assert(aSpheres.mCenterX.size() == aSpheres.Size() && aSpheres.mCenterY.size() == aSpheres.Size() && aSpheres.mCenterZ.size() == aSpheres.Size());
+
+		const size_t tCount = aSpheres.Size();
+		aOutVisible.resize(tCount);
+
+		size_t tVisible = 0;
+		size_t i = 0;
+
+#if defined(FLUX_CULLING_AVX)
+		__m256 tPlaneX[Frustum::eCount], tPlaneY[Frustum::eCount], tPlaneZ[Frustum::eCount], tPlaneW[Frustum::eCount];
+		for (int plane = 0; plane < Frustum::eCount; ++plane)
+		{
+			tPlaneX[plane] = _mm256_set1_ps(aFrustum.mPlanes[plane].x);
+			tPlaneY[plane] = _mm256_set1_ps(aFrustum.mPlanes[plane].y);
+			tPlaneZ[plane] = _mm256_set1_ps(aFrustum.mPlanes[plane].z);
+			tPlaneW[plane] = _mm256_set1_ps(aFrustum.mPlanes[plane].w);
+		}
+
+		const __m256 tZero = _mm256_setzero_ps();
+		for (; i + 8 <= tCount; i += 8)
+		{
+			const __m256 tX = _mm256_loadu_ps(&aSpheres.mCenterX[i]);
+			const __m256 tY = _mm256_loadu_ps(&aSpheres.mCenterY[i]);
+			const __m256 tZ = _mm256_loadu_ps(&aSpheres.mCenterZ[i]);
+			const __m256 tNegRadius = _mm256_sub_ps(tZero, _mm256_loadu_ps(&aSpheres.mRadius[i]));
+
+			__m256 tInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (int plane = 0; plane < Frustum::eCount; ++plane)
+			{
+				__m256 tDistance = _mm256_add_ps(_mm256_mul_ps(tPlaneX[plane], tX), tPlaneW[plane]);
+				tDistance = _mm256_add_ps(_mm256_mul_ps(tPlaneY[plane], tY), tDistance);
+				tDistance = _mm256_add_ps(_mm256_mul_ps(tPlaneZ[plane], tZ), tDistance);
+				tInside = _mm256_and_ps(tInside, _mm256_cmp_ps(tDistance, tNegRadius, _CMP_GE_OQ));
+			}
+
+			const int tMask = _mm256_movemask_ps(tInside);
+			for (int lane = 0; lane < 8; ++lane)
+			{
+				aOutVisible[i + lane] = static_cast<uint8_t>((tMask >> lane) & 1);
+				tVisible += aOutVisible[i + lane];
+			}
+		}
+#elif defined(FLUX_CULLING_SSE)
+		__m128 tPlaneX[Frustum::eCount], tPlaneY[Frustum::eCount], tPlaneZ[Frustum::eCount], tPlaneW[Frustum::eCount];
+		for (int plane = 0; plane < Frustum::eCount; ++plane)
+		{
+			tPlaneX[plane] = _mm_set1_ps(aFrustum.mPlanes[plane].x);
+			tPlaneY[plane] = _mm_set1_ps(aFrustum.mPlanes[plane].y);
+			tPlaneZ[plane] = _mm_set1_ps(aFrustum.mPlanes[plane].z);
+			tPlaneW[plane] = _mm_set1_ps(aFrustum.mPlanes[plane].w);
+		}
+
+		const __m128 tZero = _mm_setzero_ps();
+		for (; i + 4 <= tCount; i += 4)
+		{
+			const __m128 tX = _mm_loadu_ps(&aSpheres.mCenterX[i]);
+			const __m128 tY = _mm_loadu_ps(&aSpheres.mCenterY[i]);
+			const __m128 tZ = _mm_loadu_ps(&aSpheres.mCenterZ[i]);
+			const __m128 tNegRadius = _mm_sub_ps(tZero, _mm_loadu_ps(&aSpheres.mRadius[i]));
+
+			__m128 tInside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (int plane = 0; plane < Frustum::eCount; ++plane)
+			{
+				__m128 tDistance = _mm_add_ps(_mm_mul_ps(tPlaneX[plane], tX), tPlaneW[plane]);
+				tDistance = _mm_add_ps(_mm_mul_ps(tPlaneY[plane], tY), tDistance);
+				tDistance = _mm_add_ps(_mm_mul_ps(tPlaneZ[plane], tZ), tDistance);
+				tInside = _mm_and_ps(tInside, _mm_cmpge_ps(tDistance, tNegRadius));
+			}
+
+			const int tMask = _mm_movemask_ps(tInside);
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				aOutVisible[i + lane] = static_cast<uint8_t>((tMask >> lane) & 1);
+				tVisible += aOutVisible[i + lane];
+			}
+		}
+#endif
+
+		// Remainder that does not fill a register, or everything without SIMD support
+		tVisible += CullSpheresRange(aFrustum, aSpheres, i, tCount, aOutVisible.data());
+
+		return tVisible;
+	}
+}
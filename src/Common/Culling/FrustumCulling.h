@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+namespace Flux
+{
+	// Plane normals point inwards and are normalized, so the signed distance of a point is dot(xyz, p) + w
+	struct Frustum
+	{
+		enum Plane
+		{
+			eLeft = 0,
+			eRight,
+			eBottom,
+			eTop,
+			eNear,
+			eFar,
+			eCount
+		};
+
+		glm::vec4 mPlanes[eCount];
+
+		// Works for perspective and orthographic projections, the near plane is placed for a [-1, 1] depth range,
+		// with [0, 1] it ends up a bit behind the real one, which only keeps a few more objects
+		static Frustum FromMatrix(const glm::mat4& aViewProjection);
+	};
+
+	// Bounding spheres split per component, so a SIMD register holds the same component of several spheres
+	struct BoundingSphereSoA
+	{
+		std::vector<float> mCenterX;
+		std::vector<float> mCenterY;
+		std::vector<float> mCenterZ;
+		std::vector<float> mRadius;
+
+		void Clear();
+		void Reserve(size_t aCount);
+		void Add(const glm::vec4& aSphere); // Center in xyz, radius in w
+		size_t Size() const { return mRadius.size(); }
+	};
+
+	// Moves the sphere into the space of aTransform, the radius is scaled by the largest axis scale so it stays conservative
+	glm::vec4 TransformBoundingSphere(const glm::vec4& aSphere, const glm::mat4& aTransform);
+
+	// Writes one entry per sphere into aOutVisible, 1 when the sphere is inside or intersects the frustum
+	// Tests 8 spheres at a time with AVX, 4 with SSE and falls back to CullSpheresScalar otherwise, returns the amount of visible spheres
+	size_t CullSpheres(const Frustum& aFrustum, const BoundingSphereSoA& aSpheres, std::vector<uint8_t>& aOutVisible);
+
+	// Reference version of CullSpheres
+	size_t CullSpheresScalar(const Frustum& aFrustum, const BoundingSphereSoA& aSpheres, std::vector<uint8_t>& aOutVisible);
+}
@@ -0,0 +1,137 @@
+#include "OcclusionCulling.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace Flux
+{
+	bool ProjectSphere(const glm::vec4& aSphere, const glm::mat4& aViewProjection, glm::vec2& aOutMinUv, glm::vec2& aOutMaxUv, float& aOutNearestDepth)
+	{
+		aOutMinUv = glm::vec2(1.0f);
+		aOutMaxUv = glm::vec2(0.0f);
+		aOutNearestDepth = 1.0f;
+
+		// Corners of the box around the sphere, the rectangle of the box contains the one of the sphere
+		for (int i = 0; i < 8; ++i)
+		{
+			const glm::vec3 tCorner = glm::vec3(aSphere) + aSphere.w * glm::vec3((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f);
+			const glm::vec4 tClip = aViewProjection * glm::vec4(tCorner, 1.0f);
+
+			if (tClip.w <= 0.0f)
+			{
+				return false;
+			}
+
+			const glm::vec3 tNdc = glm::vec3(tClip) / tClip.w;
+			if (tNdc.z < 0.0f)
+			{
+				return false;
+			}
+
+			const glm::vec2 tUv = glm::vec2(tNdc) * 0.5f + 0.5f;
+			aOutMinUv = glm::min(aOutMinUv, tUv);
+			aOutMaxUv = glm::max(aOutMaxUv, tUv);
+			aOutNearestDepth = std::min(aOutNearestDepth, tNdc.z);
+		}
+
+		aOutMinUv = glm::clamp(aOutMinUv, glm::vec2(0.0f), glm::vec2(1.0f));
+		aOutMaxUv = glm::clamp(aOutMaxUv, glm::vec2(0.0f), glm::vec2(1.0f));
+		return true;
+	}
+
+	void DepthPyramid::Build(const float* aDepth, uint32_t aWidth, uint32_t aHeight)
+	{
+		assert(aDepth != nullptr && aWidth > 0 && aHeight > 0);
+
+		mLevels.resize(CountLevels(aWidth, aHeight));
+
+		mLevels[0].mWidth = aWidth;
+		mLevels[0].mHeight = aHeight;
+		mLevels[0].mDepth.assign(aDepth, aDepth + static_cast<size_t>(aWidth) * aHeight);
+
+		for (size_t level = 1; level < mLevels.size(); ++level)
+		{
+			const Level& tSource = mLevels[level - 1];
+			Level& tLevel = mLevels[level];
+			tLevel.mWidth = std::max(tSource.mWidth / 2, 1u);
+			tLevel.mHeight = std::max(tSource.mHeight / 2, 1u);
+			tLevel.mDepth.resize(static_cast<size_t>(tLevel.mWidth) * tLevel.mHeight);
+
+			for (uint32_t y = 0; y < tLevel.mHeight; ++y)
+			{
+				const uint32_t tY0 = std::min(y * 2, tSource.mHeight - 1);
+				const uint32_t tY1 = std::min(y * 2 + 1, tSource.mHeight - 1);
+
+				for (uint32_t x = 0; x < tLevel.mWidth; ++x)
+				{
+					const uint32_t tX0 = std::min(x * 2, tSource.mWidth - 1);
+					const uint32_t tX1 = std::min(x * 2 + 1, tSource.mWidth - 1);
+
+					tLevel.mDepth[y * tLevel.mWidth + x] = std::max(
+						std::max(tSource.mDepth[tY0 * tSource.mWidth + tX0], tSource.mDepth[tY0 * tSource.mWidth + tX1]),
+						std::max(tSource.mDepth[tY1 * tSource.mWidth + tX0], tSource.mDepth[tY1 * tSource.mWidth + tX1]));
+				}
+			}
+		}
+	}
+
+	bool DepthPyramid::IsSphereOccluded(const glm::vec4& aSphere, const glm::mat4& aViewProjection) const
+	{
+		if (mLevels.empty())
+		{
+			return false;
+		}
+
+		glm::vec2 tMinUv;
+		glm::vec2 tMaxUv;
+		float tNearestDepth;
+		if (!ProjectSphere(aSphere, aViewProjection, tMinUv, tMaxUv, tNearestDepth))
+		{
+			return false;
+		}
+
+		// A rectangle at most one texel wide touches at most two texels per axis
+		const glm::vec2 tExtent = (tMaxUv - tMinUv) * glm::vec2(static_cast<float>(mLevels[0].mWidth), static_cast<float>(mLevels[0].mHeight));
+		const float tLevel = std::ceil(std::log2(std::max(std::max(tExtent.x, tExtent.y), 1.0f)));
+		const Level& tDepth = mLevels[std::min(static_cast<uint32_t>(tLevel), GetLevelCount() - 1)];
+
+		const uint32_t tX0 = std::min(static_cast<uint32_t>(tMinUv.x * tDepth.mWidth), tDepth.mWidth - 1);
+		const uint32_t tX1 = std::min(static_cast<uint32_t>(tMaxUv.x * tDepth.mWidth), tDepth.mWidth - 1);
+		const uint32_t tY0 = std::min(static_cast<uint32_t>(tMinUv.y * tDepth.mHeight), tDepth.mHeight - 1);
+		const uint32_t tY1 = std::min(static_cast<uint32_t>(tMaxUv.y * tDepth.mHeight), tDepth.mHeight - 1);
+
+		float tFurthestDepth = 0.0f;
+		for (uint32_t y = tY0; y <= tY1; ++y)
+		{
+			for (uint32_t x = tX0; x <= tX1; ++x)
+			{
+				tFurthestDepth = std::max(tFurthestDepth, tDepth.mDepth[y * tDepth.mWidth + x]);
+			}
+		}
+
+		return tNearestDepth > tFurthestDepth;
+	}
+
+	uint32_t DepthPyramid::CountLevels(uint32_t aWidth, uint32_t aHeight)
+	{
+		uint32_t tLevels = 1;
+		for (uint32_t tSize = std::max(aWidth, aHeight); tSize > 1; tSize /= 2)
+		{
+			tLevels++;
+		}
+
+		return tLevels;
+	}
+
+	uint32_t DepthPyramid::PreviousPowerOfTwo(uint32_t aValue)
+	{
+		uint32_t tResult = 1;
+		while (tResult <= aValue / 2)
+		{
+			tResult *= 2;
+		}
+
+		return tResult;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+namespace Flux
+{
+	// Screen rectangle of a sphere in [0, 1] uv coordinates with the depth of its closest point
+	// Returns false when the sphere crosses the camera or near plane, such spheres can not be tested against depth
+	// occlusion.glsl has the same function for the GPU
+	bool ProjectSphere(const glm::vec4& aSphere, const glm::mat4& aViewProjection, glm::vec2& aOutMinUv, glm::vec2& aOutMaxUv, float& aOutNearestDepth);
+
+	// Conservative depth, every texel holds the furthest depth of the texels it covers in the level below
+	// Depth is in [0, 1] with smaller values closer to the camera, level 0 has power of two sizes so every level covers the screen exactly
+	class DepthPyramid
+	{
+	public:
+		// aDepth holds aWidth * aHeight values row by row and becomes level 0, the levels above are reduced from it
+		void Build(const float* aDepth, uint32_t aWidth, uint32_t aHeight);
+		void Clear() { mLevels.clear(); }
+
+		bool IsEmpty() const { return mLevels.empty(); }
+		uint32_t GetLevelCount() const { return static_cast<uint32_t>(mLevels.size()); }
+		uint32_t GetWidth(uint32_t aLevel) const { return mLevels[aLevel].mWidth; }
+		uint32_t GetHeight(uint32_t aLevel) const { return mLevels[aLevel].mHeight; }
+		float GetDepth(uint32_t aLevel, uint32_t aX, uint32_t aY) const { return mLevels[aLevel].mDepth[aY * mLevels[aLevel].mWidth + aX]; }
+
+		// aViewProjection is the matrix the depth was rendered with
+		// Picks the level where the sphere covers at most 2x2 texels, an empty pyramid occludes nothing
+		bool IsSphereOccluded(const glm::vec4& aSphere, const glm::mat4& aViewProjection) const;
+
+		// Levels down to 1x1 for a level 0 of this size
+		static uint32_t CountLevels(uint32_t aWidth, uint32_t aHeight);
+
+		// Level 0 size of the pyramid of a depth buffer, rounded down so a level 0 texel covers one to two depth texels per axis
+		static uint32_t PreviousPowerOfTwo(uint32_t aValue);
+
+	private:
+		struct Level
+		{
+			uint32_t mWidth;
+			uint32_t mHeight;
+			std::vector<float> mDepth;
+		};
+
+		std::vector<Level> mLevels;
+	};
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Flux
+{
+	// 64 bit variant of boost::hash_combine with a splitmix finalizer on the value
+	inline uint64_t HashCombine(uint64_t aSeed, uint64_t aValue)
+	{
+		aValue ^= aValue >> 30;
+		aValue *= 0xbf58476d1ce4e5b9ull;
+		aValue ^= aValue >> 27;
+		aValue *= 0x94d049bb133111ebull;
+		aValue ^= aValue >> 31;
+
+		return aSeed ^ (aValue + 0x9e3779b97f4a7c15ull + (aSeed << 6) + (aSeed >> 2));
+	}
+}
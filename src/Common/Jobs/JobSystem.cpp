@@ -0,0 +1,393 @@
+#include "JobSystem.h"
+
+#include <string>
+#include <cassert>
+#include <algorithm>
+
+#include "Common/Profiling/CpuProfiler.h"
+
+namespace Flux
+{
+	struct Task
+	{
+		JobSystem::Function mFunction;
+		TaskGroup* mGroup = nullptr;
+		bool mCreated = false; // Owned by its group, run tasks are deleted once they finished
+		std::atomic<uint32_t> mBlockers{ 0 }; // Unfinished prerequisites, plus one until submitted
+
+		// Only used by created tasks
+		std::mutex mMutex;
+		bool mFinished = false;
+		std::vector<Task*> mDependents;
+	};
+
+	namespace
+	{
+		// Failed searches for work before a worker sleeps, waking up costs far more than a few yields
+		const uint32_t cSpinsBeforeSleep = 64;
+
+		std::atomic<uint64_t> sNextSystemId{ 1 };
+
+		struct ThreadSlot
+		{
+			uint64_t mSystemId = 0;
+			uint32_t mSlot = 0;
+		};
+
+		thread_local ThreadSlot tThreadSlot;
+
+		uint32_t NextRandom(uint32_t& aState)
+		{
+			// xorshift32
+			aState ^= aState << 13;
+			aState ^= aState >> 17;
+			aState ^= aState << 5;
+			return aState;
+		}
+	}
+
+	TaskGroup::TaskGroup() : mPending(0)
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		assert(IsDone());
+	}
+
+	JobSystem::JobSystem(uint32_t aWorkerCount) : mId(sNextSystemId.fetch_add(1)), mSharedSize(0), mEpoch(0), mSleeping(0), mStop(false)
+	{
+		for (uint32_t i = 0; i <= aWorkerCount; ++i)
+		{
+			mSlots.push_back(std::make_unique<Slot>());
+			mSlots.back()->mRandom = 0x9E3779B9u * (i + 1);
+		}
+
+		tThreadSlot.mSystemId = mId;
+		tThreadSlot.mSlot = 0;
+
+		mThreads.reserve(aWorkerCount);
+		for (uint32_t i = 1; i <= aWorkerCount; ++i)
+		{
+			mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> tLock(mSleepMutex);
+			mStop.store(true);
+		}
+		mWake.notify_all();
+
+		for (auto& thread : mThreads)
+		{
+			thread.join();
+		}
+
+		assert(mShared.empty());
+		if (tThreadSlot.mSystemId == mId)
+		{
+			tThreadSlot = ThreadSlot();
+		}
+	}
+
+	void JobSystem::Run(TaskGroup& aGroup, Function aFunction)
+	{
+		Task* tTask = new Task();
+		tTask->mFunction = std::move(aFunction);
+		tTask->mGroup = &aGroup;
+
+		aGroup.mPending.fetch_add(1, std::memory_order_relaxed);
+		Schedule(tTask);
+	}
+
+	Task* JobSystem::Create(TaskGroup& aGroup, Function aFunction)
+	{
+		std::unique_ptr<Task> tTask = std::make_unique<Task>();
+		tTask->mFunction = std::move(aFunction);
+		tTask->mGroup = &aGroup;
+		tTask->mCreated = true;
+		tTask->mBlockers.store(1, std::memory_order_relaxed);
+
+		Task* tHandle = tTask.get();
+		aGroup.mPending.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> tLock(aGroup.mMutex);
+		aGroup.mCreated.push_back(std::move(tTask));
+		return tHandle;
+	}
+
+	void JobSystem::AddDependency(Task* aTask, Task* aPrerequisite)
+	{
+		assert(aTask->mCreated && aPrerequisite->mCreated && aTask != aPrerequisite);
+		assert(aTask->mBlockers.load() > 0);
+
+		// A prerequisite that already finished adds nothing to wait for
+		std::lock_guard<std::mutex> tLock(aPrerequisite->mMutex);
+		if (!aPrerequisite->mFinished)
+		{
+			aTask->mBlockers.fetch_add(1, std::memory_order_relaxed);
+			aPrerequisite->mDependents.push_back(aTask);
+		}
+	}
+
+	void JobSystem::Submit(Task* aTask)
+	{
+		assert(aTask->mCreated);
+
+		if (aTask->mBlockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			Schedule(aTask);
+		}
+	}
+
+	void JobSystem::Wait(TaskGroup& aGroup)
+	{
+		const uint32_t tSlot = GetCurrentSlot();
+
+		while (!aGroup.IsDone())
+		{
+			Task* tTask = FindTask(tSlot);
+			if (tTask != nullptr)
+			{
+				Execute(tTask);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		std::exception_ptr tException;
+		{
+			std::lock_guard<std::mutex> tLock(aGroup.mMutex);
+			aGroup.mCreated.clear();
+			std::swap(tException, aGroup.mException);
+		}
+
+		if (tException)
+		{
+			std::rethrow_exception(tException);
+		}
+	}
+
+	void JobSystem::ParallelFor(size_t aBegin, size_t aEnd, const RangeFunction& aFunction, size_t aMinGrain)
+	{
+		if (aBegin >= aEnd)
+		{
+			return;
+		}
+
+		if (mThreads.empty())
+		{
+			aFunction(aBegin, aEnd);
+			return;
+		}
+
+		// Four ranges per thread to start with
+		uint32_t tSplitDepth = 2;
+		for (size_t tThreads = mSlots.size(); tThreads > 1; tThreads = (tThreads + 1) / 2)
+		{
+			tSplitDepth++;
+		}
+
+		TaskGroup tGroup;
+		const RangeContext tContext{ &aFunction, &tGroup, std::max(aMinGrain, size_t(1)), tSplitDepth };
+
+		// The spawned ranges reference the context, so the group is waited for even when the calling thread throws
+		try
+		{
+			RunRange(tContext, aBegin, aEnd, tSplitDepth, GetCurrentSlot());
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> tLock(tGroup.mMutex);
+			if (!tGroup.mException)
+			{
+				tGroup.mException = std::current_exception();
+			}
+		}
+
+		Wait(tGroup);
+	}
+
+	uint32_t JobSystem::GetDefaultWorkerCount()
+	{
+		const uint32_t tHardwareThreads = std::thread::hardware_concurrency();
+		return tHardwareThreads > 1 ? tHardwareThreads - 1 : 0;
+	}
+
+	uint32_t JobSystem::GetCurrentSlot() const
+	{
+		return tThreadSlot.mSystemId == mId ? tThreadSlot.mSlot : NO_SLOT;
+	}
+
+	void JobSystem::WorkerLoop(uint32_t aSlot)
+	{
+		tThreadSlot.mSystemId = mId;
+		tThreadSlot.mSlot = aSlot;
+
+		FLUX_PROFILE_THREAD("Job worker " + std::to_string(aSlot));
+
+		uint32_t tFailedSearches = 0;
+		while (true)
+		{
+			// Read before searching, a task scheduled after the search failed changes it
+			const uint64_t tEpoch = mEpoch.load();
+
+			Task* tTask = FindTask(aSlot);
+			if (tTask != nullptr)
+			{
+				Execute(tTask);
+				tFailedSearches = 0;
+				continue;
+			}
+
+			if (mStop.load())
+			{
+				return;
+			}
+
+			if (++tFailedSearches < cSpinsBeforeSleep)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			tFailedSearches = 0;
+
+			std::unique_lock<std::mutex> tLock(mSleepMutex);
+			mSleeping.fetch_add(1);
+			mWake.wait(tLock, [&]() { return mStop.load() || mEpoch.load() != tEpoch; });
+			mSleeping.fetch_sub(1);
+		}
+	}
+
+	void JobSystem::Schedule(Task* aTask)
+	{
+		const uint32_t tSlot = GetCurrentSlot();
+		if (tSlot != NO_SLOT)
+		{
+			mSlots[tSlot]->mQueue.Push(aTask);
+		}
+		else
+		{
+			std::lock_guard<std::mutex> tLock(mSharedMutex);
+			mShared.push_back(aTask);
+			mSharedSize.fetch_add(1);
+		}
+
+		// Either a sleeping worker sees the new epoch before it waits, or this sees it sleeping and wakes it
+		mEpoch.fetch_add(1);
+		if (mSleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> tLock(mSleepMutex);
+			mWake.notify_one();
+		}
+	}
+
+	Task* JobSystem::FindTask(uint32_t aSlot)
+	{
+		Task* tTask = nullptr;
+
+		if (aSlot != NO_SLOT && mSlots[aSlot]->mQueue.Pop(tTask))
+		{
+			return tTask;
+		}
+
+		if (mSharedSize.load(std::memory_order_relaxed) > 0)
+		{
+			std::lock_guard<std::mutex> tLock(mSharedMutex);
+			if (!mShared.empty())
+			{
+				tTask = mShared.front();
+				mShared.pop_front();
+				mSharedSize.fetch_sub(1);
+				return tTask;
+			}
+		}
+
+		// Starting at a random victim spreads the thieves over the deques
+		const uint32_t tSlotCount = static_cast<uint32_t>(mSlots.size());
+		const uint32_t tFirst = aSlot != NO_SLOT ? NextRandom(mSlots[aSlot]->mRandom) % tSlotCount : 0;
+		for (uint32_t i = 0; i < tSlotCount; ++i)
+		{
+			const uint32_t tVictim = (tFirst + i) % tSlotCount;
+			if (tVictim != aSlot && mSlots[tVictim]->mQueue.Steal(tTask))
+			{
+				return tTask;
+			}
+		}
+
+		return nullptr;
+	}
+
+	void JobSystem::Execute(Task* aTask)
+	{
+		TaskGroup* tGroup = aTask->mGroup;
+
+		try
+		{
+			aTask->mFunction();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> tLock(tGroup->mMutex);
+			if (!tGroup->mException)
+			{
+				tGroup->mException = std::current_exception();
+			}
+		}
+
+		if (aTask->mCreated)
+		{
+			std::vector<Task*> tDependents;
+			{
+				std::lock_guard<std::mutex> tLock(aTask->mMutex);
+				aTask->mFinished = true;
+				tDependents.swap(aTask->mDependents);
+			}
+
+			for (Task* dependent : tDependents)
+			{
+				if (dependent->mBlockers.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					Schedule(dependent);
+				}
+			}
+		}
+		else
+		{
+			delete aTask;
+		}
+
+		// Last, a waiting thread may free the group and its tasks right after
+		tGroup->mPending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void JobSystem::RunRange(const RangeContext& aContext, size_t aBegin, size_t aEnd, uint32_t aSplitDepth, uint32_t aSpawnerSlot)
+	{
+		const uint32_t tSlot = GetCurrentSlot();
+
+		// Stolen by a thread that ran out of work, chances are others did too so the range is split further
+		if (tSlot != aSpawnerSlot)
+		{
+			aSplitDepth = aContext.mSplitDepth;
+		}
+
+		while (aSplitDepth > 0 && (aEnd - aBegin) / 2 >= aContext.mMinGrain)
+		{
+			const size_t tMiddle = aBegin + (aEnd - aBegin) / 2;
+			const size_t tEnd = aEnd;
+			aSplitDepth--;
+
+			const uint32_t tSplitDepth = aSplitDepth;
+			Run(*aContext.mGroup, [this, &aContext, tMiddle, tEnd, tSplitDepth, tSlot]() { RunRange(aContext, tMiddle, tEnd, tSplitDepth, tSlot); });
+			aEnd = tMiddle;
+		}
+
+		(*aContext.mFunction)(aBegin, aEnd);
+	}
+}
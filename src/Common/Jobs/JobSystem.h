@@ -0,0 +1,125 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#include "Common/Jobs/WorkStealingDeque.h"
+
+namespace Flux
+{
+	struct Task; // Defined in JobSystem.cpp, handles are only passed back to the system
+
+	// Counts the tasks of a JobSystem that have not finished yet, wait for it before it goes out of scope
+	// The first exception a task of the group throws is rethrown by Wait, the other tasks still run
+	class TaskGroup
+	{
+	public:
+		TaskGroup();
+		~TaskGroup();
+
+		bool IsDone() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator= (const TaskGroup&) = delete;
+
+		std::atomic<uint32_t> mPending;
+
+		std::mutex mMutex; // Guards the members below, only taken for created tasks and exceptions
+		std::vector<std::unique_ptr<Task>> mCreated; // Kept until the group was waited for, so their handles stay valid
+		std::exception_ptr mException;
+	};
+
+	// Work-stealing task scheduler, every worker thread owns a deque of tasks
+	// A thread runs the tasks it spawned last first and steals the oldest tasks of another thread when it runs out
+	// The thread that creates the system has a deque as well and runs tasks while it waits, tasks spawned by other
+	// threads go through a shared queue
+	class JobSystem
+	{
+	public:
+		using Function = std::function<void()>;
+		using RangeFunction = std::function<void(size_t aBegin, size_t aEnd)>;
+
+		// Threads besides the one creating the system, 0 runs every task on the threads that wait
+		explicit JobSystem(uint32_t aWorkerCount = GetDefaultWorkerCount());
+		~JobSystem(); // Every group has to be waited for before
+
+		uint32_t GetWorkerCount() const { return static_cast<uint32_t>(mThreads.size()); }
+
+		// Schedules aFunction, which may spawn and wait for other tasks
+		void Run(TaskGroup& aGroup, Function aFunction);
+
+		// Tasks with dependencies: create them, add their prerequisites and submit them, every created task has to be submitted
+		// A task runs once it was submitted and each of its prerequisites finished, handles stay valid until their group was waited for
+		Task* Create(TaskGroup& aGroup, Function aFunction);
+		void AddDependency(Task* aTask, Task* aPrerequisite); // aTask must not be submitted yet
+		void Submit(Task* aTask);
+
+		// Runs tasks on the calling thread until every task of the group finished
+		void Wait(TaskGroup& aGroup);
+
+		// Calls aFunction on subranges of [aBegin, aEnd) in parallel and returns once all of them finished
+		// Ranges are halved a few times per thread, and again whenever an idle thread steals one, so uneven work gets split
+		// finer while even work keeps large ranges, they never get smaller than aMinGrain
+		void ParallelFor(size_t aBegin, size_t aEnd, const RangeFunction& aFunction, size_t aMinGrain = 1);
+
+		// One worker per hardware thread besides the calling one
+		static uint32_t GetDefaultWorkerCount();
+
+	private:
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator= (const JobSystem&) = delete;
+
+		static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+		// A deque with its thread, slot 0 belongs to the thread that created the system
+		struct Slot
+		{
+			WorkStealingDeque<Task*> mQueue;
+			uint32_t mRandom; // Picks the first victim to steal from
+		};
+
+		struct RangeContext
+		{
+			const RangeFunction* mFunction;
+			TaskGroup* mGroup;
+			size_t mMinGrain;
+			uint32_t mSplitDepth;
+		};
+
+		// Of the calling thread, NO_SLOT for threads that are not part of this system
+		uint32_t GetCurrentSlot() const;
+
+		void WorkerLoop(uint32_t aSlot);
+		void Schedule(Task* aTask);
+		Task* FindTask(uint32_t aSlot);
+		void Execute(Task* aTask);
+		void RunRange(const RangeContext& aContext, size_t aBegin, size_t aEnd, uint32_t aSplitDepth, uint32_t aSpawnerSlot);
+
+		const uint64_t mId; // Tells systems apart in the thread local lookup, addresses can be reused
+
+		std::vector<std::unique_ptr<Slot>> mSlots;
+		std::vector<std::thread> mThreads;
+
+		std::mutex mSharedMutex;
+		std::deque<Task*> mShared; // Spawned by threads without a slot
+		std::atomic<uint32_t> mSharedSize; // Lets idle threads skip the lock
+
+		// Workers without work sleep until a task is scheduled, the epoch tells them whether one was while they looked
+		std::mutex mSleepMutex;
+		std::condition_variable mWake;
+		std::atomic<uint64_t> mEpoch;
+		std::atomic<uint32_t> mSleeping;
+		std::atomic<bool> mStop;
+	};
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace Flux
+{
+	// Chase-Lev deque, after "Correct and Efficient Work-Stealing for Weak Memory Models" by Le, Pop, Cohen and Zappa Nardelli
+	// The owning thread pushes and pops at the bottom, any thread steals from the top, so the owner works on what it pushed
+	// last while thieves take the oldest, usually largest, pieces of work
+	// Full arrays are replaced by one twice as large, the old ones are kept until destruction since a thief may still read them
+	template <typename T>
+	class WorkStealingDeque
+	{
+		static_assert(std::is_trivially_copyable<T>::value, "items are copied through atomics");
+
+	public:
+		// aCapacity is rounded up to a power of two
+		explicit WorkStealingDeque(size_t aCapacity = 256) : mTop(0), mBottom(0)
+		{
+			size_t tCapacity = 2;
+			while (tCapacity < aCapacity)
+			{
+				tCapacity *= 2;
+			}
+
+			mArrays.push_back(std::make_unique<Array>(tCapacity));
+			mArray.store(mArrays.back().get(), std::memory_order_relaxed);
+		}
+
+		// Owner only
+		void Push(T aItem)
+		{
+			const int64_t tBottom = mBottom.load(std::memory_order_relaxed);
+			const int64_t tTop = mTop.load(std::memory_order_acquire);
+			Array* tArray = mArray.load(std::memory_order_relaxed);
+
+			if (tBottom - tTop > static_cast<int64_t>(tArray->mMask))
+			{
+				tArray = Grow(tArray, tTop, tBottom);
+			}
+
+			// Release on the store rather than a separate fence, so thieves that see the new bottom also see what the item points to
+			tArray->Put(tBottom, aItem);
+			mBottom.store(tBottom + 1, std::memory_order_release);
+		}
+
+		// Owner only, the item pushed last
+		bool Pop(T& aOutItem)
+		{
+			const int64_t tBottom = mBottom.load(std::memory_order_relaxed) - 1;
+			Array* tArray = mArray.load(std::memory_order_relaxed);
+			mBottom.store(tBottom, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			int64_t tTop = mTop.load(std::memory_order_relaxed);
+
+			if (tTop > tBottom)
+			{
+				mBottom.store(tBottom + 1, std::memory_order_relaxed);
+				return false;
+			}
+
+			aOutItem = tArray->Get(tBottom);
+			if (tTop == tBottom)
+			{
+				// The last item, a thief may be taking it at the same time
+				const bool tWon = mTop.compare_exchange_strong(tTop, tTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+				mBottom.store(tBottom + 1, std::memory_order_relaxed);
+				return tWon;
+			}
+
+			return true;
+		}
+
+		// Any thread, the oldest item, fails when empty or when another thread took the item first
+		bool Steal(T& aOutItem)
+		{
+			int64_t tTop = mTop.load(std::memory_order_acquire);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			const int64_t tBottom = mBottom.load(std::memory_order_acquire);
+
+			if (tTop >= tBottom)
+			{
+				return false;
+			}
+
+			Array* tArray = mArray.load(std::memory_order_acquire);
+			const T tItem = tArray->Get(tTop);
+			if (!mTop.compare_exchange_strong(tTop, tTop + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+			{
+				return false;
+			}
+
+			aOutItem = tItem;
+			return true;
+		}
+
+		// Exact only while no other thread uses the deque
+		size_t GetSize() const
+		{
+			const int64_t tBottom = mBottom.load(std::memory_order_relaxed);
+			const int64_t tTop = mTop.load(std::memory_order_relaxed);
+			return tBottom > tTop ? static_cast<size_t>(tBottom - tTop) : 0;
+		}
+
+		bool IsEmpty() const { return GetSize() == 0; }
+		size_t GetCapacity() const { return mArray.load(std::memory_order_relaxed)->mMask + 1; }
+
+	private:
+		WorkStealingDeque(const WorkStealingDeque&) = delete;
+		WorkStealingDeque& operator= (const WorkStealingDeque&) = delete;
+
+		// Ring buffer indexed by the unbounded top and bottom counters
+		struct Array
+		{
+			explicit Array(size_t aCapacity) : mMask(aCapacity - 1), mItems(new std::atomic<T>[aCapacity]) {}
+
+			T Get(int64_t aIndex) const { return mItems[static_cast<size_t>(aIndex) & mMask].load(std::memory_order_relaxed); }
+			void Put(int64_t aIndex, T aItem) { mItems[static_cast<size_t>(aIndex) & mMask].store(aItem, std::memory_order_relaxed); }
+
+			const size_t mMask;
+			std::unique_ptr<std::atomic<T>[]> mItems;
+		};
+
+		Array* Grow(Array* aArray, int64_t aTop, int64_t aBottom)
+		{
+			mArrays.push_back(std::make_unique<Array>((aArray->mMask + 1) * 2));
+			Array* tArray = mArrays.back().get();
+
+			for (int64_t i = aTop; i < aBottom; ++i)
+			{
+				tArray->Put(i, aArray->Get(i));
+			}
+
+			mArray.store(tArray, std::memory_order_release);
+			return tArray;
+		}
+
+		// On their own cache lines, thieves write the top while the owner writes the bottom
+		alignas(64) std::atomic<int64_t> mTop;
+		alignas(64) std::atomic<int64_t> mBottom;
+		alignas(64) std::atomic<Array*> mArray;
+		std::vector<std::unique_ptr<Array>> mArrays; // Owner only, every array ever used
+	};
+}
@@ -0,0 +1,82 @@
+#include "ChromeTrace.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Flux
+{
+	void ChromeTrace::Write(std::ostream& aStream) const
+	{
+		// Microseconds with nanosecond precision, the default stream precision rounds long captures
+		const std::streamsize tPrecision = aStream.precision();
+		const std::ios_base::fmtflags tFlags = aStream.flags();
+		aStream.setf(std::ios_base::fixed, std::ios_base::floatfield);
+		aStream.precision(3);
+
+		aStream << "{\"traceEvents\":[";
+
+		bool tFirst = true;
+		for (const auto& track : mTrackNames)
+		{
+			aStream << (tFirst ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << track.first
+				<< ",\"args\":{\"name\":\"" << Escape(track.second) << "\"}}";
+			tFirst = false;
+		}
+
+		// Complete events, each has its start and duration
+		for (const auto& event : mEvents)
+		{
+			aStream << (tFirst ? "" : ",") << "\n{\"name\":\"" << Escape(event.mName) << "\",\"cat\":\"" << Escape(event.mCategory)
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.mTrack << ",\"ts\":" << event.mStartMicroseconds << ",\"dur\":" << event.mDurationMicroseconds << "}";
+			tFirst = false;
+		}
+
+		aStream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+		aStream.precision(tPrecision);
+		aStream.flags(tFlags);
+	}
+
+	bool ChromeTrace::WriteToFile(const std::string& aPath) const
+	{
+		std::ofstream tFile(aPath, std::ios::out | std::ios::trunc);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		Write(tFile);
+		return tFile.good();
+	}
+
+	std::string ChromeTrace::Escape(const std::string& aText)
+	{
+		std::string tResult;
+		tResult.reserve(aText.size());
+
+		for (const char character : aText)
+		{
+			switch (character)
+			{
+			case '"': tResult += "\\\""; break;
+			case '\\': tResult += "\\\\"; break;
+			case '\n': tResult += "\\n"; break;
+			case '\r': tResult += "\\r"; break;
+			case '\t': tResult += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(character) < 0x20)
+				{
+					char tCode[8];
+					snprintf(tCode, sizeof(tCode), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(character)));
+					tResult += tCode;
+				}
+				else
+				{
+					tResult += character;
+				}
+			}
+		}
+
+		return tResult;
+	}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+#include <unordered_map>
+
+namespace Flux
+{
+	// A zone on a timeline, times in microseconds on one clock shared by every track
+	struct TraceEvent
+	{
+		std::string mName;
+		std::string mCategory;
+		uint32_t mTrack = 0;
+		double mStartMicroseconds = 0.0;
+		double mDurationMicroseconds = 0.0;
+	};
+
+	// Collects zones of several tracks, like CPU threads and GPU queues, and writes them in the Chrome trace event format
+	// The output opens in chrome://tracing and ui.perfetto.dev, every track is shown as a named thread of one process
+	class ChromeTrace
+	{
+	public:
+		void SetTrackName(uint32_t aTrack, const std::string& aName) { mTrackNames[aTrack] = aName; }
+		void AddEvent(const TraceEvent& aEvent) { mEvents.push_back(aEvent); }
+		void Clear() { mEvents.clear(); }
+
+		size_t GetEventCount() const { return mEvents.size(); }
+		const std::vector<TraceEvent>& GetEvents() const { return mEvents; }
+
+		void Write(std::ostream& aStream) const;
+
+		// Returns false when the file can not be written
+		bool WriteToFile(const std::string& aPath) const;
+
+		// For a JSON string value, without the quotes
+		static std::string Escape(const std::string& aText);
+
+	private:
+		std::unordered_map<uint32_t, std::string> mTrackNames;
+		std::vector<TraceEvent> mEvents;
+	};
+}
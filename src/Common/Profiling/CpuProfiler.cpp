@@ -0,0 +1,278 @@
+#include "CpuProfiler.h"
+
+#include <cassert>
+#include <algorithm>
+
+namespace Flux
+{
+	// Written by its thread and read by EndFrame, the counters only grow so they never wrap in practice
+	struct CpuProfiler::ThreadBuffer
+	{
+		struct Event
+		{
+			const char* mName;
+			uint32_t mDepth;
+			int64_t mStart;
+			int64_t mEnd;
+		};
+
+		std::vector<Event> mEvents = std::vector<Event>(CpuProfiler::THREAD_BUFFER_CAPACITY);
+		std::atomic<uint64_t> mWrite{ 0 }; // Only written by the thread
+		std::atomic<uint64_t> mRead{ 0 }; // Only written by EndFrame
+		std::atomic<uint64_t> mDropped{ 0 };
+
+		std::atomic<bool> mExited{ false }; // Set when its thread ends, after its last zone was pushed
+
+		uint32_t mDepth = 0; // Open zones, only touched by the thread
+		uint32_t mIndex = 0; // Registration order, the track in traces
+		std::string mName; // Guarded by the threads mutex
+		bool mFree = false; // Waiting for a new thread, guarded by the threads mutex
+
+		void Push(const Event& aEvent)
+		{
+			const uint64_t tWrite = mWrite.load(std::memory_order_relaxed);
+			if (tWrite - mRead.load(std::memory_order_acquire) >= mEvents.size())
+			{
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+
+			mEvents[tWrite % mEvents.size()] = aEvent;
+			mWrite.store(tWrite + 1, std::memory_order_release);
+		}
+	};
+
+	static std::atomic<uint64_t> sNextProfilerId{ 1 };
+
+	CpuProfiler::Zone::Zone(const char* aName, CpuProfiler& aProfiler) : mBuffer(aProfiler.GetThreadBuffer()), mName(aName)
+	{
+		mDepth = mBuffer->mDepth++;
+		mStart = Now();
+	}
+
+	CpuProfiler::Zone::~Zone()
+	{
+		const int64_t tEnd = Now();
+		mBuffer->mDepth--;
+		mBuffer->Push({ mName, mDepth, mStart, tEnd });
+	}
+
+	CpuProfiler::CpuProfiler() : mId(sNextProfilerId.fetch_add(1)), mNextThreadIndex(0), mLastFrameEnd(0), mDroppedZones(0), mTrace(nullptr), mTraceFirstTrack(0), mTraceOrigin(0)
+	{
+	}
+
+	CpuProfiler::~CpuProfiler() = default;
+
+	CpuProfiler& CpuProfiler::Get()
+	{
+		static CpuProfiler sProfiler;
+		return sProfiler;
+	}
+
+	CpuProfiler::ThreadBuffer* CpuProfiler::GetThreadBuffer()
+	{
+		// Marks the buffers of the thread as exited when it ends, a profiler destroyed before that already freed its buffer
+		struct ThreadBuffers
+		{
+			uint64_t mProfilerId = 0; // Last profiler used on this thread, almost always the global one
+			ThreadBuffer* mBuffer = nullptr;
+			std::vector<std::pair<uint64_t, std::weak_ptr<ThreadBuffer>>> mBuffers;
+
+			~ThreadBuffers()
+			{
+				for (auto& buffer : mBuffers)
+				{
+					if (const std::shared_ptr<ThreadBuffer> tBuffer = buffer.second.lock())
+					{
+						tBuffer->mExited.store(true, std::memory_order_release);
+					}
+				}
+			}
+		};
+
+		thread_local ThreadBuffers tThread;
+
+		if (tThread.mProfilerId == mId)
+		{
+			return tThread.mBuffer;
+		}
+
+		auto& tBuffers = tThread.mBuffers;
+		tBuffers.erase(std::remove_if(tBuffers.begin(), tBuffers.end(), [](const auto& aBuffer) { return aBuffer.second.expired(); }), tBuffers.end());
+
+		std::shared_ptr<ThreadBuffer> tBuffer;
+		for (const auto& buffer : tBuffers)
+		{
+			if (buffer.first == mId)
+			{
+				tBuffer = buffer.second.lock();
+				break;
+			}
+		}
+
+		if (tBuffer == nullptr)
+		{
+			std::lock_guard<std::mutex> tLock(mThreadsMutex);
+
+			if (!mFreeThreads.empty())
+			{
+				tBuffer = mFreeThreads.back();
+				mFreeThreads.pop_back();
+
+				tBuffer->mExited.store(false, std::memory_order_relaxed);
+				tBuffer->mFree = false;
+				tBuffer->mDepth = 0;
+			}
+			else
+			{
+				tBuffer = std::make_shared<ThreadBuffer>();
+				mThreads.push_back(tBuffer);
+			}
+
+			// A new track, so the zones of the thread that exited keep their name in traces
+			tBuffer->mIndex = mNextThreadIndex++;
+			tBuffer->mName = "Thread " + std::to_string(tBuffer->mIndex);
+
+			tBuffers.emplace_back(mId, tBuffer);
+		}
+
+		tThread.mProfilerId = mId;
+		tThread.mBuffer = tBuffer.get();
+
+		return tThread.mBuffer;
+	}
+
+	size_t CpuProfiler::GetThreadBufferCount() const
+	{
+		std::lock_guard<std::mutex> tLock(mThreadsMutex);
+		return mThreads.size();
+	}
+
+	void CpuProfiler::SetThreadName(const std::string& aName)
+	{
+		ThreadBuffer* tBuffer = GetThreadBuffer();
+
+		std::lock_guard<std::mutex> tLock(mThreadsMutex);
+		tBuffer->mName = aName;
+	}
+
+	size_t CpuProfiler::GetZoneIndex(const char* aName, uint32_t aDepth)
+	{
+		const auto tPointerLookup = mZoneLookupByPointer.find(aName);
+		if (tPointerLookup != mZoneLookupByPointer.end())
+		{
+			return tPointerLookup->second;
+		}
+
+		auto tLookup = mZoneLookup.find(aName);
+		if (tLookup == mZoneLookup.end())
+		{
+			tLookup = mZoneLookup.emplace(aName, mZones.size()).first;
+			mZones.emplace_back();
+			mZones.back().mName = aName;
+			mZones.back().mDepth = aDepth;
+			mFrameMilliseconds.push_back(0.0);
+		}
+
+		mZoneLookupByPointer.emplace(aName, tLookup->second);
+		return tLookup->second;
+	}
+
+	void CpuProfiler::EndFrame()
+	{
+		const int64_t tNow = Now();
+		if (mLastFrameEnd != 0)
+		{
+			mFrameTimesMs.Add(static_cast<double>(tNow - mLastFrameEnd) / 1000000.0);
+		}
+		mLastFrameEnd = tNow;
+
+		for (size_t i = 0; i < mZones.size(); ++i)
+		{
+			mZones[i].mCalls = 0;
+			mFrameMilliseconds[i] = 0.0;
+		}
+
+		{
+			std::lock_guard<std::mutex> tLock(mThreadsMutex);
+
+			for (auto& thread : mThreads)
+			{
+				if (thread->mFree)
+				{
+					continue;
+				}
+
+				// Read before the zones, every zone of an exited thread is visible then
+				const bool tExited = thread->mExited.load(std::memory_order_acquire);
+
+				const uint64_t tRead = thread->mRead.load(std::memory_order_relaxed);
+				const uint64_t tWrite = thread->mWrite.load(std::memory_order_acquire);
+
+				for (uint64_t i = tRead; i < tWrite; ++i)
+				{
+					const ThreadBuffer::Event& tEvent = thread->mEvents[i % thread->mEvents.size()];
+					const double tMilliseconds = static_cast<double>(tEvent.mEnd - tEvent.mStart) / 1000000.0;
+
+					const size_t tZone = GetZoneIndex(tEvent.mName, tEvent.mDepth);
+					mZones[tZone].mCalls++;
+					mFrameMilliseconds[tZone] += tMilliseconds;
+
+					if (mTrace != nullptr && tEvent.mStart >= mTraceOrigin)
+					{
+						TraceEvent tTraceEvent;
+						tTraceEvent.mName = tEvent.mName;
+						tTraceEvent.mCategory = "cpu";
+						tTraceEvent.mTrack = mTraceFirstTrack + thread->mIndex;
+						tTraceEvent.mStartMicroseconds = static_cast<double>(tEvent.mStart - mTraceOrigin) / 1000.0;
+						tTraceEvent.mDurationMicroseconds = tMilliseconds * 1000.0;
+						mTrace->AddEvent(tTraceEvent);
+					}
+				}
+
+				// The slots are free for the thread again
+				thread->mRead.store(tWrite, std::memory_order_release);
+				mDroppedZones += thread->mDropped.exchange(0, std::memory_order_relaxed);
+
+				if (mTrace != nullptr)
+				{
+					mTrace->SetTrackName(mTraceFirstTrack + thread->mIndex, thread->mName);
+				}
+
+				if (tExited)
+				{
+					thread->mFree = true;
+					mFreeThreads.push_back(thread);
+				}
+			}
+		}
+
+		// Zones that did not run this frame keep their samples
+		for (size_t i = 0; i < mZones.size(); ++i)
+		{
+			if (mZones[i].mCalls > 0)
+			{
+				mZones[i].mMilliseconds.Add(mFrameMilliseconds[i]);
+			}
+		}
+	}
+
+	void CpuProfiler::ClearStatistics()
+	{
+		for (auto& zone : mZones)
+		{
+			zone.mMilliseconds.Clear();
+		}
+
+		mFrameTimesMs.Clear();
+		mLastFrameEnd = 0;
+		mDroppedZones = 0;
+	}
+
+	void CpuProfiler::SetTrace(ChromeTrace* aTrace, uint32_t aFirstTrack, Clock::time_point aOrigin)
+	{
+		mTrace = aTrace;
+		mTraceFirstTrack = aFirstTrack;
+		mTraceOrigin = std::chrono::duration_cast<std::chrono::nanoseconds>(aOrigin.time_since_epoch()).count();
+	}
+}
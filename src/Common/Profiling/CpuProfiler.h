@@ -0,0 +1,132 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+
+#include "Common/Time/FramePacer.h"
+#include "Common/Profiling/ChromeTrace.h"
+
+// Zones are compiled in unless FLUX_PROFILING_DISABLED is defined, the macros then expand to nothing
+#if !defined(FLUX_PROFILING_DISABLED)
+#define FLUX_PROFILING
+#endif
+
+#define FLUX_PROFILE_CONCAT_INNER(a, b) a##b
+#define FLUX_PROFILE_CONCAT(a, b) FLUX_PROFILE_CONCAT_INNER(a, b)
+
+#if defined(FLUX_PROFILING)
+// Measures the rest of the enclosing scope, the name has to outlive the profiler like a string literal does
+#define FLUX_PROFILE_ZONE(aName) ::Flux::CpuProfiler::Zone FLUX_PROFILE_CONCAT(tProfileZone, __LINE__)(aName)
+#define FLUX_PROFILE_FUNCTION() FLUX_PROFILE_ZONE(__func__)
+#define FLUX_PROFILE_THREAD(aName) ::Flux::CpuProfiler::Get().SetThreadName(aName)
+#define FLUX_PROFILE_FRAME() ::Flux::CpuProfiler::Get().EndFrame()
+#else
+#define FLUX_PROFILE_ZONE(aName) ((void)0)
+#define FLUX_PROFILE_FUNCTION() ((void)0)
+#define FLUX_PROFILE_THREAD(aName) ((void)0)
+#define FLUX_PROFILE_FRAME() ((void)0)
+#endif
+
+namespace Flux
+{
+	// Hierarchical zones of every thread, timed in nanoseconds on the steady clock
+	// Each thread appends its zones to a ring buffer of its own without locking, EndFrame drains every buffer
+	// Use the macros rather than the class, so zones disappear when profiling is compiled out
+	class CpuProfiler
+	{
+		struct ThreadBuffer;
+
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// Zones per thread between two frame ends, later zones are dropped
+		static constexpr size_t THREAD_BUFFER_CAPACITY = 8192;
+
+		class Zone
+		{
+		public:
+			explicit Zone(const char* aName, CpuProfiler& aProfiler = Get());
+			~Zone();
+
+		private:
+			Zone(const Zone&) = delete;
+			Zone& operator= (const Zone&) = delete;
+
+			ThreadBuffer* mBuffer;
+			const char* mName;
+			uint32_t mDepth;
+			int64_t mStart;
+		};
+
+		struct ZoneStatistics
+		{
+			std::string mName;
+			uint32_t mDepth = 0; // Zones around it when it was first measured
+			uint32_t mCalls = 0; // Last frame, over every thread
+			RollingStatistics mMilliseconds; // Per frame, summed over every call of the frame
+		};
+
+		CpuProfiler();
+		~CpuProfiler(); // Defined where ThreadBuffer is complete
+
+		// The profiler the macros record into
+		static CpuProfiler& Get();
+
+		// Nanoseconds on Clock
+		static int64_t Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count(); }
+
+		// Names the track of the calling thread in traces
+		void SetThreadName(const std::string& aName);
+
+		// Frame boundary, drains the zones every thread finished since the last one, call from one thread only
+		void EndFrame();
+
+		// In the order the zones were first measured, only EndFrame changes them
+		const std::vector<ZoneStatistics>& GetZones() const { return mZones; }
+		const RollingStatistics& GetFrameTimes() const { return mFrameTimesMs; }
+		uint64_t GetDroppedZones() const { return mDroppedZones; }
+
+		// Buffers allocated so far, a thread that exited hands its buffer to the next thread that registers once EndFrame drained it
+		size_t GetThreadBufferCount() const;
+		void ClearStatistics();
+
+		// Zones drained from now on are added to aTrace relative to aOrigin, every thread on its own track counting up from aFirstTrack
+		// Pass nullptr to stop, the trace is only touched by EndFrame
+		void SetTrace(ChromeTrace* aTrace, uint32_t aFirstTrack, Clock::time_point aOrigin);
+
+	private:
+		CpuProfiler(const CpuProfiler&) = delete;
+		CpuProfiler& operator= (const CpuProfiler&) = delete;
+
+		// Of the calling thread, registered on first use or taken over from a thread that exited
+		ThreadBuffer* GetThreadBuffer();
+
+		size_t GetZoneIndex(const char* aName, uint32_t aDepth);
+
+		const uint64_t mId; // Tells profilers apart in the thread local lookup, addresses can be reused
+
+		mutable std::mutex mThreadsMutex; // Only taken to register a thread, name it and drain the buffers
+		std::vector<std::shared_ptr<ThreadBuffer>> mThreads; // Threads only hold weak references, so exiting never touches the profiler
+		std::vector<std::shared_ptr<ThreadBuffer>> mFreeThreads; // Drained after their thread exited
+		uint32_t mNextThreadIndex;
+
+		std::vector<ZoneStatistics> mZones;
+		std::unordered_map<const char*, size_t> mZoneLookupByPointer;
+		std::unordered_map<std::string, size_t> mZoneLookup; // The same name can live at several addresses
+		std::vector<double> mFrameMilliseconds;
+
+		RollingStatistics mFrameTimesMs;
+		int64_t mLastFrameEnd;
+		uint64_t mDroppedZones;
+
+		ChromeTrace* mTrace;
+		uint32_t mTraceFirstTrack;
+		int64_t mTraceOrigin;
+	};
+}
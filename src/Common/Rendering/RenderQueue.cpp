@@ -0,0 +1,70 @@
+#include "RenderQueue.h"
+
+#include <chrono>
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+uint64_t Flux::RenderQueue::MakeKey(uint32_t aPass, uint32_t aPipeline, uint32_t aMaterial, uint32_t aMesh, float aDepth)
+{
+	assert(aPass < (1u << PASS_BITS));
+
+	const uint32_t tDepthMax = (1u << DEPTH_BITS) - 1;
+	const uint32_t tDepth = static_cast<uint32_t>(std::clamp(aDepth, 0.0f, 1.0f) * tDepthMax);
+
+	// Ids past the field width wrap around, that only costs some sorting quality
+	uint64_t tKey = aPass;
+	tKey = (tKey << PIPELINE_BITS) | (aPipeline & ((1u << PIPELINE_BITS) - 1));
+	tKey = (tKey << MATERIAL_BITS) | (aMaterial & ((1u << MATERIAL_BITS) - 1));
+	tKey = (tKey << MESH_BITS) | (aMesh & ((1u << MESH_BITS) - 1));
+	tKey = (tKey << DEPTH_BITS) | tDepth;
+
+	return tKey;
+}
+
+void Flux::RenderQueue::Sort()
+{
+	const auto tStart = std::chrono::high_resolution_clock::now();
+
+	mScratch.resize(mItems.size());
+
+	for (uint32_t shift = 0; shift < 64; shift += 8)
+	{
+		std::array<size_t, 256> tCounts{};
+		for (const DrawItem& item : mItems)
+		{
+			tCounts[(item.mKey >> shift) & 0xFF]++;
+		}
+
+		// Every key has the same byte here, this pass would not change the order
+		if (tCounts[(mItems.empty() ? 0 : (mItems[0].mKey >> shift) & 0xFF)] == mItems.size())
+		{
+			continue;
+		}
+
+		size_t tOffset = 0;
+		for (size_t& count : tCounts)
+		{
+			const size_t tCount = count;
+			count = tOffset;
+			tOffset += tCount;
+		}
+
+		for (const DrawItem& item : mItems)
+		{
+			mScratch[tCounts[(item.mKey >> shift) & 0xFF]++] = item;
+		}
+
+		mItems.swap(mScratch);
+	}
+
+	mSortTimeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - tStart).count();
+}
+
+std::pair<size_t, size_t> Flux::RenderQueue::GetPassRange(uint32_t aPass) const
+{
+	const auto tBegin = std::partition_point(mItems.begin(), mItems.end(), [aPass](const DrawItem& aItem) { return GetPass(aItem.mKey) < aPass; });
+	const auto tEnd = std::partition_point(tBegin, mItems.end(), [aPass](const DrawItem& aItem) { return GetPass(aItem.mKey) == aPass; });
+
+	return { static_cast<size_t>(tBegin - mItems.begin()), static_cast<size_t>(tEnd - mItems.begin()) };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace Flux
+{
+
+// Draws of a frame, sorted so that objects sharing state end up next to each other
+// The key is only used for ordering, recording still compares the actual handles, so truncated ids can never cause a wrong bind
+class RenderQueue
+{
+public:
+	// Most significant first: pass 4 bits, pipeline 12 bits, material 16 bits, mesh 16 bits, depth 16 bits
+	static constexpr uint32_t PASS_BITS = 4;
+	static constexpr uint32_t PIPELINE_BITS = 12;
+	static constexpr uint32_t MATERIAL_BITS = 16;
+	static constexpr uint32_t MESH_BITS = 16;
+	static constexpr uint32_t DEPTH_BITS = 16;
+
+	struct DrawItem
+	{
+		uint64_t mKey;
+		uint32_t mObjectIndex; // Into the scene object list
+	};
+
+	// Material and mesh are the never reused indices of the resources, aDepth is the normalized view distance in [0, 1], closer objects sort first
+	static uint64_t MakeKey(uint32_t aPass, uint32_t aPipeline, uint32_t aMaterial, uint32_t aMesh, float aDepth);
+	static uint32_t GetPass(uint64_t aKey) { return static_cast<uint32_t>(aKey >> (64 - PASS_BITS)); }
+
+	void Clear() { mItems.clear(); }
+	void Add(uint64_t aKey, uint32_t aObjectIndex) { mItems.push_back({ aKey, aObjectIndex }); }
+
+	// Stable LSD radix sort on the key, 8 bits per pass, bytes that are equal for every key are skipped
+	void Sort();
+
+	const std::vector<DrawItem>& GetItems() const { return mItems; }
+
+	// Range of the sorted items with this pass value, only valid after Sort
+	std::pair<size_t, size_t> GetPassRange(uint32_t aPass) const;
+
+	float GetSortTimeMs() const { return mSortTimeMs; }
+
+private:
+	std::vector<DrawItem> mItems;
+	std::vector<DrawItem> mScratch;
+
+	float mSortTimeMs = 0.0f;
+};
+
+// Binds issued while recording a pass, the naive path issues every bind for every draw
+struct BindStats
+{
+	uint32_t mDraws = 0;
+	uint32_t mPipelineBinds = 0;
+	uint32_t mDescriptorSetBinds = 0;
+	uint32_t mVertexBufferBinds = 0;
+	uint32_t mIndexBufferBinds = 0;
+
+	uint32_t GetIssuedBinds() const { return mPipelineBinds + mDescriptorSetBinds + mVertexBufferBinds + mIndexBufferBinds; }
+	uint32_t GetEliminatedBinds() const { return mDraws * 4 > GetIssuedBinds() ? mDraws * 4 - GetIssuedBinds() : 0; }
+
+	BindStats& operator+= (const BindStats& aOther)
+	{
+		mDraws += aOther.mDraws;
+		mPipelineBinds += aOther.mPipelineBinds;
+		mDescriptorSetBinds += aOther.mDescriptorSetBinds;
+		mVertexBufferBinds += aOther.mVertexBufferBinds;
+		mIndexBufferBinds += aOther.mIndexBufferBinds;
+		return *this;
+	}
+};
+
+}
@@ -0,0 +1,116 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <thread>
+
+namespace Flux
+{
+	RollingStatistics::RollingStatistics(size_t aCapacity) : mSamples(aCapacity), mNext(0), mCount(0)
+	{
+		assert(aCapacity > 0);
+	}
+
+	void RollingStatistics::Add(double aValue)
+	{
+		mSamples[mNext] = aValue;
+		mNext = (mNext + 1) % mSamples.size();
+		mCount = std::min(mCount + 1, mSamples.size());
+	}
+
+	void RollingStatistics::Clear()
+	{
+		mNext = 0;
+		mCount = 0;
+	}
+
+	double RollingStatistics::GetLast() const
+	{
+		return mCount > 0 ? mSamples[(mNext + mSamples.size() - 1) % mSamples.size()] : 0.0;
+	}
+
+	double RollingStatistics::GetAverage() const
+	{
+		if (mCount == 0)
+		{
+			return 0.0;
+		}
+
+		double tSum = 0.0;
+		for (size_t i = 0; i < mCount; ++i)
+		{
+			tSum += mSamples[i];
+		}
+
+		return tSum / static_cast<double>(mCount);
+	}
+
+	double RollingStatistics::GetMax() const
+	{
+		return mCount > 0 ? *std::max_element(mSamples.begin(), mSamples.begin() + mCount) : 0.0;
+	}
+
+	double RollingStatistics::GetPercentile(double aFraction) const
+	{
+		if (mCount == 0)
+		{
+			return 0.0;
+		}
+
+		// Until the ring is full the samples are the first mCount entries, afterwards every entry is a sample
+		std::vector<double> tSorted(mSamples.begin(), mSamples.begin() + mCount);
+		const double tRank = std::ceil(std::clamp(aFraction, 0.0, 1.0) * static_cast<double>(mCount));
+		const size_t tIndex = std::max(static_cast<size_t>(tRank), size_t(1)) - 1;
+		std::nth_element(tSorted.begin(), tSorted.begin() + tIndex, tSorted.end());
+
+		return tSorted[tIndex];
+	}
+
+	void FramePacer::SetFrameRateLimit(float aFramesPerSecond)
+	{
+		mFrameRateLimit = std::max(aFramesPerSecond, 0.0f);
+		mHasDeadline = false;
+	}
+
+	double FramePacer::Wait()
+	{
+		if (mFrameRateLimit <= 0.0f)
+		{
+			return 0.0;
+		}
+
+		const Clock::duration tInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / mFrameRateLimit));
+		const Clock::time_point tStart = Clock::now();
+
+		if (!mHasDeadline)
+		{
+			mDeadline = tStart;
+			mHasDeadline = true;
+		}
+
+		// Sleeping overshoots by up to a scheduler tick, so the last part is spent yielding
+		const Clock::duration tSpinTime = std::chrono::milliseconds(2);
+		if (mDeadline - tStart > tSpinTime)
+		{
+			std::this_thread::sleep_until(mDeadline - tSpinTime);
+		}
+
+		Clock::time_point tNow = Clock::now();
+		while (tNow < mDeadline)
+		{
+			std::this_thread::yield();
+			tNow = Clock::now();
+		}
+
+		mDeadline = NextDeadline(mDeadline, tNow, tInterval);
+
+		return std::chrono::duration<double, std::milli>(tNow - tStart).count();
+	}
+
+	FramePacer::Clock::time_point FramePacer::NextDeadline(Clock::time_point aPrevious, Clock::time_point aNow, Clock::duration aInterval)
+	{
+		const Clock::time_point tNext = aPrevious + aInterval;
+		return tNext > aNow ? tNext : aNow + aInterval;
+	}
+}
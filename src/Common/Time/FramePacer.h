@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+namespace Flux
+{
+	// The last samples of a per frame measurement, so averages and percentiles follow recent changes
+	class RollingStatistics
+	{
+	public:
+		explicit RollingStatistics(size_t aCapacity = 240);
+
+		void Add(double aValue);
+		void Clear();
+
+		size_t GetCount() const { return mCount; }
+		double GetLast() const;
+		double GetAverage() const;
+		double GetMax() const;
+
+		// Nearest rank, aFraction in [0, 1], 0 without samples
+		double GetPercentile(double aFraction) const;
+
+	private:
+		std::vector<double> mSamples; // Ring buffer
+		size_t mNext;
+		size_t mCount;
+	};
+
+	// Caps the frame rate by sleeping until the next frame is due
+	class FramePacer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		// Frames per second, 0 disables the limit
+		void SetFrameRateLimit(float aFramesPerSecond);
+		float GetFrameRateLimit() const { return mFrameRateLimit; }
+
+		// Blocks until the next frame is due, returns the time waited in milliseconds
+		double Wait();
+
+		// Deadline of the frame after one due at aPrevious that started at aNow
+		// A frame that started more than an interval late restarts the cadence, so missed frames are not made up in a burst
+		static Clock::time_point NextDeadline(Clock::time_point aPrevious, Clock::time_point aNow, Clock::duration aInterval);
+
+	private:
+		float mFrameRateLimit = 0.0f;
+		bool mHasDeadline = false;
+		Clock::time_point mDeadline;
+	};
+}
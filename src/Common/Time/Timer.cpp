@@ -2,14 +2,13 @@
 
 void Timer::Reset()
 {
-	mStart = std::chrono::high_resolution_clock::now();
+	mStart = std::chrono::steady_clock::now();
 }
 
 double Timer::GetDelta()
 {
-	auto mCurrentTime = std::chrono::high_resolution_clock::now();
-	std::chrono::duration<double> elapsed = mCurrentTime - mStart;
-	double delta = static_cast<double>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+	auto mCurrentTime = std::chrono::steady_clock::now();
+	double delta = std::chrono::duration<double, std::milli>(mCurrentTime - mStart).count();
 	mStart = mCurrentTime;
 
 	return delta;
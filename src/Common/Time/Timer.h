@@ -2,16 +2,17 @@
 
 #include <chrono>
 
-// Basic timer class
+// Basic timer class, steady so deltas never go backwards
 class Timer
 {
 public:
 	void Reset();
 	
+	// Milliseconds since the last call or reset, with sub millisecond precision
 	double GetDelta();
 
 private:
-	std::chrono::high_resolution_clock::time_point mStart;
+	std::chrono::steady_clock::time_point mStart;
 
 };
 
@@ -0,0 +1,159 @@
+#include "DescriptorAllocator.h"
+
+#include <cassert>
+#include <stdexcept>
+
+using namespace Flux::Gfx;
+
+static bool IsPoolExhausted(VkResult aResult, DescriptorAllocatorStats& aStats)
+{
+	if (aResult == VK_ERROR_OUT_OF_POOL_MEMORY || aResult == VK_ERROR_FRAGMENTED_POOL)
+	{
+		aStats.mPoolExhaustions++;
+		aStats.mFragmentedPools += aResult == VK_ERROR_FRAGMENTED_POOL ? 1 : 0;
+		return true;
+	}
+
+	return false;
+}
+
+void Flux::Gfx::InitializeDescriptorAllocator(DescriptorAllocator& aAllocator, const DescriptorAllocatorCreateDesc& aDesc)
+{
+	assert(aDesc.mSetsPerPool > 0);
+	assert(aDesc.mFrameCount > 0);
+
+	aAllocator.mSetsPerPool = aDesc.mSetsPerPool;
+	aAllocator.mFramePools.resize(aDesc.mFrameCount);
+}
+
+void Flux::Gfx::DestroyDescriptorAllocatorPools(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend)
+{
+	std::lock_guard<std::mutex> tLock(aAllocator.mMutex);
+
+	for (auto& pool : aAllocator.mPersistentPools)
+	{
+		aBackend.mDestroyPool(pool);
+	}
+
+	for (auto& frame : aAllocator.mFramePools)
+	{
+		for (auto& pool : frame.mPools)
+		{
+			aBackend.mDestroyPool(pool);
+		}
+	}
+
+	aAllocator.mPersistentPools.clear();
+	aAllocator.mFramePools.clear();
+	aAllocator.mFreeSets.clear();
+	aAllocator.mStats = DescriptorAllocatorStats{};
+}
+
+VkDescriptorSet Flux::Gfx::AllocatePersistentSet(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, VkDescriptorSetLayout aLayout)
+{
+	std::lock_guard<std::mutex> tLock(aAllocator.mMutex);
+	DescriptorAllocatorStats& tStats = aAllocator.mStats;
+
+	auto& tFreeSets = aAllocator.mFreeSets[aLayout];
+	if (!tFreeSets.empty())
+	{
+		VkDescriptorSet tSet = tFreeSets.back();
+		tFreeSets.pop_back();
+
+		tStats.mPersistentSetsFree--;
+		tStats.mPersistentSetsLive++;
+		tStats.mFreeListReuses++;
+		return tSet;
+	}
+
+	if (aAllocator.mPersistentPools.empty())
+	{
+		aAllocator.mPersistentPools.push_back(aBackend.mCreatePool());
+		tStats.mPersistentPools++;
+	}
+
+	VkDescriptorSet tSet = VK_NULL_HANDLE;
+	VkResult tResult = aBackend.mAllocateSet(aAllocator.mPersistentPools.back(), aLayout, tSet);
+
+	if (IsPoolExhausted(tResult, tStats))
+	{
+		aAllocator.mPersistentPools.push_back(aBackend.mCreatePool());
+		tStats.mPersistentPools++;
+
+		tResult = aBackend.mAllocateSet(aAllocator.mPersistentPools.back(), aLayout, tSet);
+	}
+
+	if (tResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	tStats.mPersistentSetsLive++;
+	return tSet;
+}
+
+void Flux::Gfx::FreePersistentSet(DescriptorAllocator& aAllocator, VkDescriptorSetLayout aLayout, VkDescriptorSet aSet)
+{
+	assert(aSet != VK_NULL_HANDLE);
+
+	std::lock_guard<std::mutex> tLock(aAllocator.mMutex);
+
+	aAllocator.mFreeSets[aLayout].push_back(aSet);
+	aAllocator.mStats.mPersistentSetsLive--;
+	aAllocator.mStats.mPersistentSetsFree++;
+}
+
+VkDescriptorSet Flux::Gfx::AllocateFrameSet(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, VkDescriptorSetLayout aLayout)
+{
+	std::lock_guard<std::mutex> tLock(aAllocator.mMutex);
+	DescriptorAllocatorStats& tStats = aAllocator.mStats;
+
+	DescriptorAllocator::FramePools& tFrame = aAllocator.mFramePools[aAllocator.mCurrentFrame];
+
+	VkDescriptorSet tSet = VK_NULL_HANDLE;
+	VkResult tResult = VK_ERROR_OUT_OF_POOL_MEMORY;
+
+	// Pools chained in earlier frames are used before creating new ones, a fresh pool that is exhausted means the set can never fit
+	bool tCreatedPool = false;
+	while (!tCreatedPool)
+	{
+		if (tFrame.mActivePool == tFrame.mPools.size())
+		{
+			tFrame.mPools.push_back(aBackend.mCreatePool());
+			tStats.mTransientPools++;
+			tCreatedPool = true;
+		}
+
+		tResult = aBackend.mAllocateSet(tFrame.mPools[tFrame.mActivePool], aLayout, tSet);
+		if (!IsPoolExhausted(tResult, tStats))
+		{
+			break;
+		}
+
+		tFrame.mActivePool++;
+	}
+
+	if (tResult != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to allocate transient descriptor set!");
+	}
+
+	tStats.mTransientSetsThisFrame++;
+	return tSet;
+}
+
+void Flux::Gfx::ResetFramePools(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, uint32_t aFrameIndex)
+{
+	std::lock_guard<std::mutex> tLock(aAllocator.mMutex);
+
+	aAllocator.mCurrentFrame = aFrameIndex % aAllocator.mFramePools.size();
+	DescriptorAllocator::FramePools& tFrame = aAllocator.mFramePools[aAllocator.mCurrentFrame];
+
+	for (auto& pool : tFrame.mPools)
+	{
+		aBackend.mResetPool(pool);
+	}
+
+	tFrame.mActivePool = 0;
+	aAllocator.mStats.mTransientSetsThisFrame = 0;
+}
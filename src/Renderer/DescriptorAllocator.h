@@ -0,0 +1,73 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <functional>
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		struct DescriptorAllocatorCreateDesc
+		{
+			uint32_t mSetsPerPool = 256;
+			uint32_t mFrameCount = 2; // Every frame in flight gets its own chain of transient pools
+		};
+
+		struct DescriptorAllocatorStats
+		{
+			uint32_t mPersistentPools = 0;
+			uint32_t mTransientPools = 0;
+			uint32_t mPersistentSetsLive = 0;
+			uint32_t mPersistentSetsFree = 0; // Waiting in a free list to be handed out again
+			uint32_t mFreeListReuses = 0;
+			uint32_t mTransientSetsThisFrame = 0;
+			uint32_t mPoolExhaustions = 0; // Allocations that had to move on to the next pool in the chain
+			uint32_t mFragmentedPools = 0; // Exhaustions caused by fragmentation instead of running out of descriptors
+		};
+
+		// Grows by chaining pools instead of failing once a pool is full
+		// Persistent sets live until freed, freed sets are kept per layout and handed out again for the same layout
+		// Transient sets are only valid for one frame, their pools are reset wholesale when the frame comes around again
+		struct DescriptorAllocator
+		{
+			uint32_t mSetsPerPool = 0;
+
+			std::vector<VkDescriptorPool> mPersistentPools; // Only the last one is allocated from, the others are full
+			std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> mFreeSets;
+
+			struct FramePools
+			{
+				std::vector<VkDescriptorPool> mPools;
+				size_t mActivePool = 0;
+			};
+
+			std::vector<FramePools> mFramePools;
+			uint32_t mCurrentFrame = 0;
+
+			DescriptorAllocatorStats mStats;
+			std::mutex mMutex;
+		};
+
+		// Device side of the allocator, the pool bookkeeping below only goes through these
+		struct DescriptorPoolBackend
+		{
+			std::function<VkDescriptorPool()> mCreatePool;
+			std::function<VkResult(VkDescriptorPool, VkDescriptorSetLayout, VkDescriptorSet&)> mAllocateSet;
+			std::function<void(VkDescriptorPool)> mResetPool;
+			std::function<void(VkDescriptorPool)> mDestroyPool;
+		};
+
+		void InitializeDescriptorAllocator(DescriptorAllocator& aAllocator, const DescriptorAllocatorCreateDesc& aDesc);
+		void DestroyDescriptorAllocatorPools(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend);
+
+		VkDescriptorSet AllocatePersistentSet(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, VkDescriptorSetLayout aLayout);
+		void FreePersistentSet(DescriptorAllocator& aAllocator, VkDescriptorSetLayout aLayout, VkDescriptorSet aSet);
+
+		VkDescriptorSet AllocateFrameSet(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, VkDescriptorSetLayout aLayout);
+		void ResetFramePools(DescriptorAllocator& aAllocator, const DescriptorPoolBackend& aBackend, uint32_t aFrameIndex);
+	}
+}
@@ -7,6 +7,7 @@ namespace Gfx
 	struct DescriptorPoolCreateDesc
 	{
 		uint32_t maxDescriptorSets;
+		bool mUpdateAfterBind = false; // Required for sets with bindless (update after bind) bindings
 	};
 
 	struct DescriptorPool
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		// One descriptor in the packed data of a descriptor update template
+		// Entries are in binding order of the set, an array binding takes one entry per element and runtime sized arrays take none
+		union DescriptorInfo
+		{
+			DescriptorInfo() : mBuffer{} {}
+
+			DescriptorInfo(VkBuffer aBuffer, VkDeviceSize aOffset = 0, VkDeviceSize aRange = VK_WHOLE_SIZE)
+			{
+				mBuffer.buffer = aBuffer;
+				mBuffer.offset = aOffset;
+				mBuffer.range = aRange;
+			}
+
+			DescriptorInfo(VkImageView aView, VkImageLayout aLayout)
+			{
+				mImage.sampler = VK_NULL_HANDLE;
+				mImage.imageView = aView;
+				mImage.imageLayout = aLayout;
+			}
+
+			DescriptorInfo(VkSampler aSampler)
+			{
+				mImage.sampler = aSampler;
+				mImage.imageView = VK_NULL_HANDLE;
+				mImage.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+
+			VkDescriptorImageInfo mImage;
+			VkDescriptorBufferInfo mBuffer;
+		};
+
+		// Created from the reflected bindings of a set, shared through the layout cache like the set layout itself
+		struct DescriptorUpdateTemplate
+		{
+			VkDescriptorUpdateTemplate mTemplate = VK_NULL_HANDLE;
+			uint32_t mDescriptorCount = 0; // Amount of DescriptorInfo entries the template reads
+		};
+	}
+}
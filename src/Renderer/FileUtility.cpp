@@ -0,0 +1,20 @@
+#include "FileUtility.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <filesystem>
+#else
+#include <cstdio>
+#endif
+
+bool Flux::Gfx::AtomicReplaceFile(const std::string& aSource, const std::string& aDestination)
+{
+#ifdef _WIN32
+	// rename fails on Windows when the destination exists, removing it first would leave a window without any file
+	return MoveFileExW(std::filesystem::path(aSource).c_str(), std::filesystem::path(aDestination).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return std::rename(aSource.c_str(), aDestination.c_str()) == 0;
+#endif
+}
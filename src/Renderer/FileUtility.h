@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		// Moves aSource over aDestination in one step, readers see either the old or the new file, never a missing or partial one
+		// Returns false when the move failed, aDestination is left untouched then
+		bool AtomicReplaceFile(const std::string& aSource, const std::string& aDestination);
+	}
+}
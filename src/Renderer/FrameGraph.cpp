@@ -0,0 +1,369 @@
+#include "FrameGraph.h"
+
+#include "GraphicsDevice.h"
+
+#include <array>
+#include <cassert>
+#include <stdexcept>
+
+using namespace Flux::Gfx;
+
+const ResourceAccessInfo& Flux::Gfx::GetResourceAccessInfo(ResourceAccess aAccess)
+{
+	// Same order as ResourceAccess
+	static const std::array<ResourceAccessInfo, 10> tAccessInfos =
+	{ {
+		{ VK_PIPELINE_STAGE_2_NONE_KHR, 0, VK_IMAGE_LAYOUT_UNDEFINED, false },
+		{ VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, 0, VK_IMAGE_LAYOUT_UNDEFINED, true },
+		{ VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR, VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT_KHR | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT_KHR, VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT_KHR | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_READ_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL, false },
+		{ VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT_KHR, VK_ACCESS_2_SHADER_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_GENERAL, true },
+		{ VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_READ_BIT_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, false },
+		{ VK_PIPELINE_STAGE_2_TRANSFER_BIT_KHR, VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, true },
+		{ VK_PIPELINE_STAGE_2_NONE_KHR, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, false },
+	} };
+
+	return tAccessInfos[static_cast<size_t>(aAccess)];
+}
+
+Flux::Gfx::FrameGraph::Pass& Flux::Gfx::FrameGraph::Pass::Read(const std::string& aResource, ResourceAccess aAccess)
+{
+	mUsages.push_back({ mGraph->GetResourceIndex(aResource), aAccess, true, false });
+	return *this;
+}
+
+Flux::Gfx::FrameGraph::Pass& Flux::Gfx::FrameGraph::Pass::Write(const std::string& aResource, ResourceAccess aAccess)
+{
+	mUsages.push_back({ mGraph->GetResourceIndex(aResource), aAccess, false, true });
+	return *this;
+}
+
+Flux::Gfx::FrameGraph::Pass& Flux::Gfx::FrameGraph::Pass::Modify(const std::string& aResource, ResourceAccess aAccess)
+{
+	mUsages.push_back({ mGraph->GetResourceIndex(aResource), aAccess, true, true });
+	return *this;
+}
+
+void Flux::Gfx::FrameGraph::Reset()
+{
+	mResources.clear();
+	mResourceLookup.clear();
+	mPasses.clear();
+	mFinalBarriers.clear();
+	mStats = {};
+}
+
+void Flux::Gfx::FrameGraph::ImportImage(const std::string& aName, const FrameGraphImageDesc& aDesc)
+{
+	assert(aDesc.mImage != VK_NULL_HANDLE);
+	assert(mResourceLookup.find(aName) == mResourceLookup.end());
+
+	mResourceLookup[aName] = static_cast<uint32_t>(mResources.size());
+	mResources.push_back({ aName, aDesc });
+}
+
+Flux::Gfx::FrameGraph::Pass& Flux::Gfx::FrameGraph::AddPass(const std::string& aName, ExecuteFunction aExecute)
+{
+	mPasses.push_back(std::unique_ptr<Pass>(new Pass(this, aName, aExecute)));
+	return *mPasses.back();
+}
+
+uint32_t Flux::Gfx::FrameGraph::GetResourceIndex(const std::string& aName)
+{
+	const auto tResult = mResourceLookup.find(aName);
+	if (tResult == mResourceLookup.end())
+	{
+		throw std::runtime_error("failed to find frame graph resource " + aName + "!");
+	}
+
+	return tResult->second;
+}
+
+void Flux::Gfx::FrameGraph::Compile()
+{
+	mStats = {};
+	mStats.mPasses = static_cast<uint32_t>(mPasses.size());
+
+	// Walk back from the outputs, a pass is needed when it writes contents a later needed pass reads
+	// A write that discards the contents ends the chain, earlier writers of that image are not needed for it
+	std::vector<bool> tContentsNeeded(mResources.size(), false);
+	for (size_t i = 0; i < mResources.size(); ++i)
+	{
+		tContentsNeeded[i] = mResources[i].mDesc.mFinalAccess.has_value();
+	}
+
+	for (auto pass = mPasses.rbegin(); pass != mPasses.rend(); ++pass)
+	{
+		bool tNeeded = (*pass)->mSideEffects;
+		for (const auto& usage : (*pass)->mUsages)
+		{
+			tNeeded = tNeeded || (usage.mWrite && tContentsNeeded[usage.mResource]);
+		}
+
+		(*pass)->mCulled = !tNeeded;
+		if (!tNeeded)
+		{
+			mStats.mCulledPasses++;
+			continue;
+		}
+
+		for (const auto& usage : (*pass)->mUsages)
+		{
+			if (usage.mWrite && !usage.mRead)
+			{
+				tContentsNeeded[usage.mResource] = false;
+			}
+		}
+
+		for (const auto& usage : (*pass)->mUsages)
+		{
+			if (usage.mRead)
+			{
+				tContentsNeeded[usage.mResource] = true;
+			}
+		}
+	}
+
+	// The states carry over between frames, so the first access of a frame waits for the last access of the previous one
+	std::vector<ImageState*> tStates(mResources.size());
+	std::vector<bool> tFirstAccess(mResources.size(), true);
+	for (size_t i = 0; i < mResources.size(); ++i)
+	{
+		const FrameGraphImageDesc& tDesc = mResources[i].mDesc;
+		tStates[i] = &mImageStates[tDesc.mImage];
+
+		if (tDesc.mInitialAccess.has_value())
+		{
+			const ResourceAccessInfo& tInfo = GetResourceAccessInfo(tDesc.mInitialAccess.value());
+
+			ImageState tState{};
+			tState.mLayout = tInfo.mLayout;
+			tState.mWriteStages = tInfo.mWrite ? tInfo.mStages : 0;
+			tState.mWriteAccess = tInfo.mWrite ? tInfo.mAccess : 0;
+			tState.mReadStages = tInfo.mWrite ? 0 : tInfo.mStages;
+			*tStates[i] = tState;
+		}
+	}
+
+	for (auto& pass : mPasses)
+	{
+		pass->mBarriers.clear();
+
+		if (pass->mCulled)
+		{
+			continue;
+		}
+
+		for (const auto& usage : pass->mUsages)
+		{
+			const Resource& tResource = mResources[usage.mResource];
+			const bool tDiscard = tFirstAccess[usage.mResource] && !usage.mRead && !tResource.mDesc.mPreserveContents;
+
+			TakeOverMemory(tResource, *tStates[usage.mResource]);
+
+			AddAccess(*tStates[usage.mResource], tResource, usage.mAccess, tDiscard, pass->mBarriers);
+			tFirstAccess[usage.mResource] = false;
+		}
+
+		mStats.mBarrierBatches += pass->mBarriers.empty() ? 0 : 1;
+		mStats.mImageBarriers += static_cast<uint32_t>(pass->mBarriers.size());
+	}
+
+	mFinalBarriers.clear();
+	for (size_t i = 0; i < mResources.size(); ++i)
+	{
+		if (mResources[i].mDesc.mFinalAccess.has_value())
+		{
+			TakeOverMemory(mResources[i], *tStates[i]);
+			AddAccess(*tStates[i], mResources[i], mResources[i].mDesc.mFinalAccess.value(), false, mFinalBarriers);
+		}
+	}
+
+	mStats.mBarrierBatches += mFinalBarriers.empty() ? 0 : 1;
+	mStats.mImageBarriers += static_cast<uint32_t>(mFinalBarriers.size());
+}
+
+void Flux::Gfx::FrameGraph::TakeOverMemory(const Resource& aResource, ImageState& aState)
+{
+	if (aResource.mDesc.mMemory == nullptr)
+	{
+		return;
+	}
+
+	VkImage& tOwner = mMemoryOwners[aResource.mDesc.mMemory];
+	if (tOwner != VK_NULL_HANDLE && tOwner != aResource.mDesc.mImage)
+	{
+		// Everything the previous owner did counts as a read, the transition out of the undefined layout has to wait for it
+		const ImageState& tPrevious = mImageStates[tOwner];
+		aState.mLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		aState.mReadStages |= tPrevious.mWriteStages | tPrevious.mReadStages;
+		aState.mWriteAccess |= tPrevious.mWriteAccess;
+	}
+
+	tOwner = aResource.mDesc.mImage;
+}
+
+void Flux::Gfx::FrameGraph::AddAccess(ImageState& aState, const Resource& aResource, ResourceAccess aAccess, bool aDiscard, std::vector<VkImageMemoryBarrier2KHR>& aBarriers)
+{
+	const ResourceAccessInfo& tInfo = GetResourceAccessInfo(aAccess);
+
+	// Discarding only saves a transition, when the layout already matches there is nothing to gain
+	const VkImageLayout tOldLayout = (aDiscard && aState.mLayout != tInfo.mLayout) ? VK_IMAGE_LAYOUT_UNDEFINED : aState.mLayout;
+	const bool tLayoutChange = tOldLayout != tInfo.mLayout;
+
+	VkImageMemoryBarrier2KHR tBarrier{};
+	tBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+	tBarrier.dstStageMask = tInfo.mStages;
+	tBarrier.dstAccessMask = tInfo.mAccess;
+	tBarrier.oldLayout = tOldLayout;
+	tBarrier.newLayout = tInfo.mLayout;
+	tBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	tBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	tBarrier.image = aResource.mDesc.mImage;
+	tBarrier.subresourceRange.aspectMask = aResource.mDesc.mAspect;
+	tBarrier.subresourceRange.baseMipLevel = 0;
+	tBarrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+	tBarrier.subresourceRange.baseArrayLayer = 0;
+	tBarrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+	if (tInfo.mWrite || tLayoutChange)
+	{
+		// Writes and layout transitions wait for every access since the last write, only the write has memory to make available
+		tBarrier.srcStageMask = aState.mWriteStages | aState.mReadStages;
+		tBarrier.srcAccessMask = aState.mWriteAccess;
+
+		if (tLayoutChange || tBarrier.srcStageMask != 0)
+		{
+			aBarriers.push_back(tBarrier);
+		}
+
+		aState.mLayout = tInfo.mLayout;
+		aState.mWriteStages = tInfo.mWrite ? tInfo.mStages : tBarrier.dstStageMask;
+		aState.mWriteAccess = tInfo.mWrite ? tInfo.mAccess : 0;
+		aState.mReadStages = tInfo.mWrite ? 0 : tInfo.mStages;
+		aState.mVisibleStages = tInfo.mWrite ? 0 : tInfo.mStages;
+		aState.mVisibleAccess = tInfo.mWrite ? 0 : tInfo.mAccess;
+		return;
+	}
+
+	// A read in the same layout only waits when the last write is not visible to it yet
+	const bool tVisible = (tInfo.mStages & ~aState.mVisibleStages) == 0 && (tInfo.mAccess & ~aState.mVisibleAccess) == 0;
+	if (aState.mWriteStages != 0 && !tVisible)
+	{
+		tBarrier.srcStageMask = aState.mWriteStages;
+		tBarrier.srcAccessMask = aState.mWriteAccess;
+		aBarriers.push_back(tBarrier);
+
+		aState.mVisibleStages |= tInfo.mStages;
+		aState.mVisibleAccess |= tInfo.mAccess;
+	}
+
+	aState.mReadStages |= tInfo.mStages;
+}
+
+void Flux::Gfx::FrameGraph::Execute(const GraphicsDevice& aDevice, VkCommandBuffer aCommandBuffer)
+{
+	for (auto& pass : mPasses)
+	{
+		if (pass->mCulled)
+		{
+			continue;
+		}
+
+		RecordBarriers(aDevice, aCommandBuffer, pass->mBarriers);
+
+		if (mBeginPass)
+		{
+			mBeginPass(aCommandBuffer, pass->mName);
+		}
+
+		pass->mExecute(aCommandBuffer);
+
+		if (mEndPass)
+		{
+			mEndPass(aCommandBuffer, pass->mName);
+		}
+	}
+
+	RecordBarriers(aDevice, aCommandBuffer, mFinalBarriers);
+}
+
+void Flux::Gfx::FrameGraph::RecordBarriers(const GraphicsDevice& aDevice, VkCommandBuffer aCommandBuffer, const std::vector<VkImageMemoryBarrier2KHR>& aBarriers)
+{
+	if (aBarriers.empty())
+	{
+		return;
+	}
+
+	if (aDevice.mCmdPipelineBarrier2 != nullptr)
+	{
+		VkDependencyInfoKHR tDependencyInfo{};
+		tDependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		tDependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(aBarriers.size());
+		tDependencyInfo.pImageMemoryBarriers = aBarriers.data();
+
+		aDevice.mCmdPipelineBarrier2(aCommandBuffer, &tDependencyInfo);
+		return;
+	}
+
+	// Without synchronization2 the stages of the batch are merged into one legacy barrier
+	// Only stages and accesses that have the same bit in both versions are used, so they convert directly
+	VkPipelineStageFlags tSrcStages = 0;
+	VkPipelineStageFlags tDstStages = 0;
+	std::vector<VkImageMemoryBarrier> tBarriers;
+	tBarriers.reserve(aBarriers.size());
+
+	for (const auto& barrier : aBarriers)
+	{
+		tSrcStages |= static_cast<VkPipelineStageFlags>(barrier.srcStageMask);
+		tDstStages |= static_cast<VkPipelineStageFlags>(barrier.dstStageMask);
+
+		VkImageMemoryBarrier tBarrier{};
+		tBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		tBarrier.srcAccessMask = static_cast<VkAccessFlags>(barrier.srcAccessMask);
+		tBarrier.dstAccessMask = static_cast<VkAccessFlags>(barrier.dstAccessMask);
+		tBarrier.oldLayout = barrier.oldLayout;
+		tBarrier.newLayout = barrier.newLayout;
+		tBarrier.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+		tBarrier.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+		tBarrier.image = barrier.image;
+		tBarrier.subresourceRange = barrier.subresourceRange;
+		tBarriers.push_back(tBarrier);
+	}
+
+	vkCmdPipelineBarrier(aCommandBuffer,
+		tSrcStages != 0 ? tSrcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		tDstStages != 0 ? tDstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		0,
+		0, nullptr,
+		0, nullptr,
+		static_cast<uint32_t>(tBarriers.size()), tBarriers.data());
+}
+
+bool Flux::Gfx::FrameGraph::IsCulled(const std::string& aPass) const
+{
+	for (const auto& pass : mPasses)
+	{
+		if (pass->mName == aPass)
+		{
+			return pass->mCulled;
+		}
+	}
+
+	throw std::runtime_error("failed to find frame graph pass " + aPass + "!");
+}
+
+const std::vector<VkImageMemoryBarrier2KHR>& Flux::Gfx::FrameGraph::GetBarriers(const std::string& aPass) const
+{
+	for (const auto& pass : mPasses)
+	{
+		if (pass->mName == aPass)
+		{
+			return pass->mBarriers;
+		}
+	}
+
+	throw std::runtime_error("failed to find frame graph pass " + aPass + "!");
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+
+#include "vulkan/vulkan.h"
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		struct GraphicsDevice;
+
+		// How a pass uses an image, every access maps to one set of stages, access flags and a layout
+		enum class ResourceAccess
+		{
+			eUndefined,
+			eAcquire, // Swapchain image right after the acquire semaphore wait at color attachment output
+			eColorAttachment, // Render pass attachment, the layout is the final layout of the render pass
+			eDepthAttachment,
+			eFragmentShaderRead,
+			eComputeStorageRead,
+			eComputeStorageWrite,
+			eTransferRead,
+			eTransferWrite,
+			ePresent
+		};
+
+		struct ResourceAccessInfo
+		{
+			VkPipelineStageFlags2KHR mStages;
+			VkAccessFlags2KHR mAccess;
+			VkImageLayout mLayout;
+			bool mWrite;
+		};
+
+		const ResourceAccessInfo& GetResourceAccessInfo(ResourceAccess aAccess);
+
+		// An image owned outside the graph, imported again every frame
+		struct FrameGraphImageDesc
+		{
+			VkImage mImage = VK_NULL_HANDLE;
+			VkImageAspectFlags mAspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+			// Without an initial access the image continues from where the previous frame left it
+			std::optional<ResourceAccess> mInitialAccess;
+
+			// Images with a final access are outputs of the graph, passes that do not contribute to an output are culled
+			std::optional<ResourceAccess> mFinalAccess;
+
+			// The first access of the frame may discard the contents unless they are preserved
+			bool mPreserveContents = false;
+
+			// Images placed in the same memory share a key, an image that takes over the memory from another one
+			// waits for every access of the other image and starts with undefined contents
+			const void* mMemory = nullptr;
+		};
+
+		struct FrameGraphStats
+		{
+			uint32_t mPasses = 0;
+			uint32_t mCulledPasses = 0;
+			uint32_t mBarrierBatches = 0; // One pipeline barrier call each
+			uint32_t mImageBarriers = 0;
+		};
+
+		// Passes declare the images they read and write, the graph culls passes that contribute to no output
+		// and places batched barriers before each pass with the exact stages, accesses and layouts of the declared usage
+		// Passes execute in the order they were added, the graph is rebuilt every frame
+		class FrameGraph
+		{
+		public:
+			using ExecuteFunction = std::function<void(VkCommandBuffer aCommandBuffer)>;
+			using PassCallback = std::function<void(VkCommandBuffer aCommandBuffer, const std::string& aPass)>;
+
+			class Pass
+			{
+			public:
+				Pass& Read(const std::string& aResource, ResourceAccess aAccess);
+				Pass& Write(const std::string& aResource, ResourceAccess aAccess);
+
+				// Read and write, for writes that keep the previous contents like a render pass that loads
+				Pass& Modify(const std::string& aResource, ResourceAccess aAccess);
+
+				// Never culled
+				Pass& SetSideEffects() { mSideEffects = true; return *this; }
+
+			private:
+				friend class FrameGraph;
+
+				struct Usage
+				{
+					uint32_t mResource;
+					ResourceAccess mAccess;
+					bool mRead;
+					bool mWrite;
+				};
+
+				Pass(FrameGraph* aGraph, const std::string& aName, ExecuteFunction aExecute) : mGraph(aGraph), mName(aName), mExecute(aExecute) {}
+
+				FrameGraph* mGraph;
+				std::string mName;
+				ExecuteFunction mExecute;
+				std::vector<Usage> mUsages;
+				bool mSideEffects = false;
+				bool mCulled = false;
+				std::vector<VkImageMemoryBarrier2KHR> mBarriers; // Issued right before the pass
+			};
+
+			// Clears the passes and imports of the last frame, the state of every image is kept
+			void Reset();
+
+			void ImportImage(const std::string& aName, const FrameGraphImageDesc& aDesc);
+			Pass& AddPass(const std::string& aName, ExecuteFunction aExecute);
+
+			// Culls passes and computes the barriers
+			void Compile();
+
+			// Records the passes that were not culled with their barriers, then transitions the outputs to their final access
+			void Execute(const GraphicsDevice& aDevice, VkCommandBuffer aCommandBuffer);
+
+			// Called right before and after every pass that is not culled, its barriers are outside, kept over Reset
+			// For markers like GPU timestamps, the callbacks record outside render passes
+			void SetPassCallbacks(PassCallback aBegin, PassCallback aEnd) { mBeginPass = aBegin; mEndPass = aEnd; }
+
+			// Forget the state of all images, for when they were recreated
+			void ResetImageStates() { mImageStates.clear(); mMemoryOwners.clear(); }
+
+			const FrameGraphStats& GetStats() const { return mStats; }
+			bool IsCulled(const std::string& aPass) const;
+			const std::vector<VkImageMemoryBarrier2KHR>& GetBarriers(const std::string& aPass) const;
+			const std::vector<VkImageMemoryBarrier2KHR>& GetFinalBarriers() const { return mFinalBarriers; }
+
+		private:
+			struct Resource
+			{
+				std::string mName;
+				FrameGraphImageDesc mDesc;
+			};
+
+			// Synchronization state of an image between accesses
+			struct ImageState
+			{
+				VkImageLayout mLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				VkPipelineStageFlags2KHR mWriteStages = 0; // Last write or layout transition
+				VkAccessFlags2KHR mWriteAccess = 0; // Not made available yet
+				VkPipelineStageFlags2KHR mReadStages = 0; // Reads since the last write, a new write has to wait for them
+				VkPipelineStageFlags2KHR mVisibleStages = 0; // Stages the last write is visible to
+				VkAccessFlags2KHR mVisibleAccess = 0;
+			};
+
+			uint32_t GetResourceIndex(const std::string& aName);
+
+			// When another image used the memory of this one last, the image inherits its pending accesses and its contents are lost
+			void TakeOverMemory(const Resource& aResource, ImageState& aState);
+
+			// Adds a barrier to aBarriers when the access needs one and updates the state
+			static void AddAccess(ImageState& aState, const Resource& aResource, ResourceAccess aAccess, bool aDiscard, std::vector<VkImageMemoryBarrier2KHR>& aBarriers);
+			static void RecordBarriers(const GraphicsDevice& aDevice, VkCommandBuffer aCommandBuffer, const std::vector<VkImageMemoryBarrier2KHR>& aBarriers);
+
+			std::vector<Resource> mResources;
+			std::unordered_map<std::string, uint32_t> mResourceLookup;
+			std::vector<std::unique_ptr<Pass>> mPasses;
+			std::vector<VkImageMemoryBarrier2KHR> mFinalBarriers;
+
+			std::unordered_map<VkImage, ImageState> mImageStates;
+			std::unordered_map<const void*, VkImage> mMemoryOwners; // Image that accessed the memory last
+
+			FrameGraphStats mStats;
+			PassCallback mBeginPass;
+			PassCallback mEndPass;
+		};
+	}
+}
@@ -4,6 +4,7 @@
 
 #include <string>
 #include <optional>
+#include <set>
 #include <stdint.h>
 
 namespace Flux
@@ -30,9 +31,34 @@ namespace Flux
 			VkPhysicalDevice mPhysicalDevice;
 			VkPhysicalDeviceFeatures2 mPhysicalDeviceFeatures;
 			VkPhysicalDeviceMemoryProperties mPhysicalDeviceMemoryProperties;
+			VkPhysicalDeviceProperties mPhysicalDeviceProperties;
 			VkDevice mDevice;
 			std::string mDeviceName;
 			QueueFamilyIndices queueFamilies;
+
+			// Runtime sized, partially bound and update after bind sampled image arrays, needed for bindless materials
+			bool mDescriptorIndexingSupported = false;
+
+			// Indirect draws may use a first instance other than 0, enabled together with multi draw indirect
+			bool mDrawIndirectFirstInstanceSupported = false;
+
+			// Pipeline statistics queries can stay active while secondary command buffers execute
+			bool mInheritedQueriesSupported = false;
+
+			// Loaded when VK_KHR_synchronization2 is enabled, the frame graph falls back to vkCmdPipelineBarrier without it
+			PFN_vkCmdPipelineBarrier2KHR mCmdPipelineBarrier2 = nullptr;
+
+			// Indirect draws can come from a GPU written buffer with a GPU written count, each with its own first instance
+			// Loaded when VK_KHR_draw_indirect_count is enabled and multi draw indirect and first instance are supported
+			PFN_vkCmdDrawIndexedIndirectCountKHR mCmdDrawIndexedIndirectCount = nullptr;
+
+			// Required and supported optional extensions the logical device was created with
+			std::set<std::string> mEnabledExtensions;
+
+			bool IsExtensionEnabled(const std::string& aExtension) const
+			{
+				return mEnabledExtensions.find(aExtension) != mEnabledExtensions.end();
+			}
 		};
 	}
 
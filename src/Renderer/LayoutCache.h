@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+#include "Renderer/DescriptorUpdateTemplate.h"
+
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		// Descriptor set layouts and pipeline layouts keyed by a hash of their description
+		// Root signatures with identical bindings share the same handles, which makes their descriptor sets compatible
+		// Every entry keeps its description, a hit is only taken when it matches, a colliding description gets the next free key
+		struct LayoutCache
+		{
+			struct SetLayoutEntry
+			{
+				VkDescriptorSetLayout mLayout = VK_NULL_HANDLE;
+				std::vector<VkDescriptorSetLayoutBinding> mBindings; // Sorted by binding
+				std::vector<VkDescriptorBindingFlags> mBindingFlags;
+			};
+
+			struct PipelineLayoutEntry
+			{
+				VkPipelineLayout mLayout = VK_NULL_HANDLE;
+				std::vector<VkDescriptorSetLayout> mSetLayouts;
+				bool mHasPushConstants = false;
+				VkPushConstantRange mPushConstants{};
+			};
+
+			std::unordered_map<uint64_t, SetLayoutEntry> mSetLayouts;
+			std::unordered_map<uint64_t, PipelineLayoutEntry> mPipelineLayouts;
+			std::unordered_map<uint64_t, DescriptorUpdateTemplate> mUpdateTemplates; // Same key as the set layout
+			std::mutex mMutex;
+
+			std::atomic<uint32_t> mHits{ 0 };
+			std::atomic<uint32_t> mMisses{ 0 };
+		};
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vulkan/vulkan.h"
+
+#include <string>
+#include <atomic>
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		struct PipelineCacheCreateDesc
+		{
+			std::string mFilePath;
+		};
+
+		// Hits and misses are only known when VK_EXT_pipeline_creation_feedback is available, otherwise creations are counted as unknown
+		struct PipelineCacheStats
+		{
+			std::atomic<uint32_t> mHits{ 0 };
+			std::atomic<uint32_t> mMisses{ 0 };
+			std::atomic<uint32_t> mUnknown{ 0 };
+			std::atomic<uint64_t> mCreationTimeMicroSeconds{ 0 };
+		};
+
+		struct PipelineCache
+		{
+			VkPipelineCache mCache = VK_NULL_HANDLE;
+			std::string mFilePath;
+			size_t mLoadedSize = 0;
+
+			// Set when a pipeline was created that might not be in the data on disk yet
+			std::atomic<bool> mDirty{ false };
+			PipelineCacheStats mStats;
+		};
+	}
+}
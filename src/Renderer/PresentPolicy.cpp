@@ -0,0 +1,70 @@
+#include "PresentPolicy.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace Flux::Gfx;
+
+VkPresentModeKHR Flux::Gfx::ToVkPresentMode(PresentMode aMode)
+{
+	switch (aMode)
+	{
+	case PresentMode::eFifoRelaxed:
+		return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+	case PresentMode::eMailbox:
+		return VK_PRESENT_MODE_MAILBOX_KHR;
+	case PresentMode::eImmediate:
+		return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	default:
+		return VK_PRESENT_MODE_FIFO_KHR;
+	}
+}
+
+const char* Flux::Gfx::GetPresentModeName(VkPresentModeKHR aMode)
+{
+	switch (aMode)
+	{
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "FIFO relaxed";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "Mailbox";
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "Immediate";
+	default:
+		return "Unknown";
+	}
+}
+
+VkPresentModeKHR Flux::Gfx::ChoosePresentMode(const std::vector<VkPresentModeKHR>& aAvailable, PresentMode aRequested)
+{
+	// In order of preference, the last entry is always FIFO
+	std::array<PresentMode, 3> tCandidates;
+	switch (aRequested)
+	{
+	case PresentMode::eMailbox:
+		tCandidates = { PresentMode::eMailbox, PresentMode::eImmediate, PresentMode::eFifo };
+		break;
+	case PresentMode::eImmediate:
+		tCandidates = { PresentMode::eImmediate, PresentMode::eMailbox, PresentMode::eFifo };
+		break;
+	case PresentMode::eFifoRelaxed:
+		tCandidates = { PresentMode::eFifoRelaxed, PresentMode::eFifo, PresentMode::eFifo };
+		break;
+	default:
+		tCandidates = { PresentMode::eFifo, PresentMode::eFifo, PresentMode::eFifo };
+		break;
+	}
+
+	for (PresentMode candidate : tCandidates)
+	{
+		const VkPresentModeKHR tMode = ToVkPresentMode(candidate);
+		if (std::find(aAvailable.begin(), aAvailable.end(), tMode) != aAvailable.end())
+		{
+			return tMode;
+		}
+	}
+
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "vulkan/vulkan.h"
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		enum class PresentMode
+		{
+			eFifo, // Waits for vertical blank, always supported
+			eFifoRelaxed, // Like FIFO, but a late frame is shown right away and may tear
+			eMailbox, // Never blocks, the newest frame replaces the queued one at vertical blank
+			eImmediate // Never blocks, may tear
+		};
+
+		// How frames are handed to the display
+		struct PresentPolicy
+		{
+			PresentMode mMode = PresentMode::eFifo;
+			float mFrameRateLimit = 0.0f; // Frames per second, 0 for no limit
+			bool mLowLatency = false; // Waits for the previous frame before input is sampled
+		};
+
+		VkPresentModeKHR ToVkPresentMode(PresentMode aMode);
+		const char* GetPresentModeName(VkPresentModeKHR aMode);
+
+		// The requested mode when supported, otherwise the closest supported one with the same blocking behaviour
+		// Mailbox and immediate fall back on each other, everything ends at FIFO, which every device supports
+		VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& aAvailable, PresentMode aRequested);
+	}
+}
@@ -3,6 +3,12 @@
 #include "vulkan/vulkan.h"
 #include "VmaUsage.h"
 #include "GraphicsDevice.h"
+#include "PipelineCache.h"
+#include "ShaderReflection.h"
+#include "LayoutCache.h"
+#include "PresentPolicy.h"
+
+#include <memory>
 
 namespace Flux
 {
@@ -16,8 +22,13 @@ namespace Flux
 			std::shared_ptr<GraphicsDevice> mDevice;
 			bool debugMode = true;
 			VkDebugUtilsMessengerEXT debugMessenger;
-			VkSurfaceKHR surface;
-			bool vsync = true;
+			VkSurfaceKHR surface = VK_NULL_HANDLE;
+			bool mHeadless = false; // Created without a window, there is no surface to present to
+			PresentMode mPresentMode = PresentMode::eFifo; // Requested, the swapchain holds the mode it got
+
+			std::shared_ptr<PipelineCache> mPipelineCache;
+			std::shared_ptr<ShaderReflection::ReflectionCache> mReflectionCache;
+			std::shared_ptr<LayoutCache> mLayoutCache;
 
 			VkDebugReportCallbackEXT        pVkDebugReport;
 
@@ -22,6 +22,14 @@ namespace Flux
 			uint32_t mHeight;
 			std::vector<TargetDesc> mTargets;
 			std::optional<TargetDesc>	mDepthTarget;
+
+			// Images owned elsewhere, like a transient resource pool, used instead of creating images from mTargets and mDepthTarget
+			std::vector<std::shared_ptr<Gfx::Texture>> mExternalColorImages;
+			std::shared_ptr<Gfx::Texture> mExternalDepthImage;
+
+			// The render pass loads the images instead of clearing them, they have to be in the final layout of a target that clears
+			// Render passes only differ in load operations and layouts then, so pipelines work with both
+			bool mLoadContents = false;
 		};
 
 		struct RenderTarget
@@ -39,6 +47,8 @@ namespace Flux
 			VkFramebuffer mFramebuffer;
 			VkRenderPass mPass;
 
+			bool mOwnsImages = true; // Destroyed with the target
+
 			//,
 			//	VkFramebuffer aFrameBuffer, VkRenderPass aRenderPass,
 			//	std::shared_ptr<Gfx::Texture> aDepthImage = nullptr
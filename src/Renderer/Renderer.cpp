@@ -1,4 +1,7 @@
 #include "Renderer.h"
+#include "FileUtility.h"
+
+#include "Common/Hash/HashCombine.h"
 
 using namespace Flux;
 
@@ -7,6 +10,12 @@ using namespace Flux::Gfx::ShaderReflection;
 
 
 #include <map>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 
 
 static VkCullModeFlagBits ConvertCullModeToVkCullBit(Flux::Gfx::CullModes aType)
@@ -404,6 +413,165 @@ void Flux::Gfx::Renderer::CreateBuffer(VkDevice aDevice, VmaAllocator aAllocator
 	vmaCreateBuffer(aAllocator, &bufferInfo, &allocInfo, &buffer, &bufferMemory, nullptr);
 }
 
+static bool IsSameSetLayout(const LayoutCache::SetLayoutEntry& aEntry, const std::vector<VkDescriptorSetLayoutBinding>& aBindings, const std::vector<VkDescriptorBindingFlags>& aBindingFlags)
+{
+	if (aEntry.mBindings.size() != aBindings.size() || aEntry.mBindingFlags != aBindingFlags)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < aBindings.size(); ++i)
+	{
+		const VkDescriptorSetLayoutBinding& a = aEntry.mBindings[i];
+		const VkDescriptorSetLayoutBinding& b = aBindings[i];
+
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType || a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags || a.pImmutableSamplers != b.pImmutableSamplers)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Returns the shared layout for these bindings, the bindings are sorted so the order they were reflected in doesn't matter
+// aBindingFlags has one entry per binding
+static VkDescriptorSetLayout GetOrCreateDescriptorSetLayout(std::shared_ptr<RenderContext> aContext, std::vector<VkDescriptorSetLayoutBinding>& aBindings, std::vector<VkDescriptorBindingFlags>& aBindingFlags, uint64_t& aOutHash)
+{
+	assert(aBindings.size() == aBindingFlags.size());
+
+	std::vector<size_t> tOrder(aBindings.size());
+	for (size_t i = 0; i < tOrder.size(); ++i)
+	{
+		tOrder[i] = i;
+	}
+	std::sort(tOrder.begin(), tOrder.end(), [&aBindings](size_t a, size_t b) { return aBindings[a].binding < aBindings[b].binding; });
+
+	std::vector<VkDescriptorSetLayoutBinding> tBindings;
+	std::vector<VkDescriptorBindingFlags> tBindingFlags;
+	tBindings.reserve(aBindings.size());
+	tBindingFlags.reserve(aBindings.size());
+
+	bool tUpdateAfterBind = false;
+	uint64_t tHash = HashCombine(0, aBindings.size());
+	for (const size_t index : tOrder)
+	{
+		const auto& binding = aBindings[index];
+		tBindings.push_back(binding);
+		tBindingFlags.push_back(aBindingFlags[index]);
+
+		tHash = HashCombine(tHash, binding.binding);
+		tHash = HashCombine(tHash, binding.descriptorType);
+		tHash = HashCombine(tHash, binding.descriptorCount);
+		tHash = HashCombine(tHash, binding.stageFlags);
+		tHash = HashCombine(tHash, aBindingFlags[index]);
+
+		tUpdateAfterBind |= (aBindingFlags[index] & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0;
+	}
+
+	const std::shared_ptr<LayoutCache> tCache = aContext->mLayoutCache;
+	std::lock_guard<std::mutex> tLock(tCache->mMutex);
+
+	// A different description with the same hash moves on to the next key, so every key stands for one layout
+	for (auto tCachedLayout = tCache->mSetLayouts.find(tHash); tCachedLayout != tCache->mSetLayouts.end(); tCachedLayout = tCache->mSetLayouts.find(tHash))
+	{
+		if (IsSameSetLayout(tCachedLayout->second, tBindings, tBindingFlags))
+		{
+			tCache->mHits++;
+			aOutHash = tHash;
+			return tCachedLayout->second.mLayout;
+		}
+
+		tHash = HashCombine(tHash, 1);
+	}
+
+	aOutHash = tHash;
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(tBindingFlags.size());
+	bindingFlagsInfo.pBindingFlags = tBindingFlags.data();
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount = static_cast<uint32_t>(tBindings.size());
+	layoutInfo.pBindings = tBindings.data();
+
+	// Binding flags are only passed when used, so devices without descriptor indexing never see the struct
+	if (tUpdateAfterBind)
+	{
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.pNext = &bindingFlagsInfo;
+	}
+
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+
+	if (vkCreateDescriptorSetLayout(aContext->mDevice->mDevice, &layoutInfo, nullptr, &descriptorSetLayout))
+	{
+		throw std::runtime_error("failed to create descriptor set layout!");
+	}
+
+	tCache->mMisses++;
+	tCache->mSetLayouts[tHash] = { descriptorSetLayout, std::move(tBindings), std::move(tBindingFlags) };
+
+	return descriptorSetLayout;
+}
+
+// Update template for a set layout, cached with the same hash as the layout
+// Runtime sized arrays are partially bound and left out of the template, they are written one element at a time
+static DescriptorUpdateTemplate GetOrCreateUpdateTemplate(std::shared_ptr<RenderContext> aContext, VkDescriptorSetLayout aLayout, const std::vector<VkDescriptorSetLayoutBinding>& aBindings, const std::vector<VkDescriptorBindingFlags>& aBindingFlags, uint64_t aLayoutHash)
+{
+	const std::shared_ptr<LayoutCache> tCache = aContext->mLayoutCache;
+	std::lock_guard<std::mutex> tLock(tCache->mMutex);
+
+	auto tCachedTemplate = tCache->mUpdateTemplates.find(aLayoutHash);
+	if (tCachedTemplate != tCache->mUpdateTemplates.end())
+	{
+		return tCachedTemplate->second;
+	}
+
+	DescriptorUpdateTemplate tTemplate{};
+	std::vector<VkDescriptorUpdateTemplateEntry> tEntries;
+
+	for (size_t i = 0; i < aBindings.size(); ++i)
+	{
+		if ((aBindingFlags[i] & VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT) != 0)
+		{
+			continue;
+		}
+
+		VkDescriptorUpdateTemplateEntry tEntry{};
+		tEntry.dstBinding = aBindings[i].binding;
+		tEntry.dstArrayElement = 0;
+		tEntry.descriptorCount = aBindings[i].descriptorCount;
+		tEntry.descriptorType = aBindings[i].descriptorType;
+		tEntry.offset = tTemplate.mDescriptorCount * sizeof(DescriptorInfo);
+		tEntry.stride = sizeof(DescriptorInfo);
+
+		tEntries.push_back(tEntry);
+		tTemplate.mDescriptorCount += aBindings[i].descriptorCount;
+	}
+
+	if (!tEntries.empty())
+	{
+		VkDescriptorUpdateTemplateCreateInfo templateInfo{};
+		templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+		templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(tEntries.size());
+		templateInfo.pDescriptorUpdateEntries = tEntries.data();
+		templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+		templateInfo.descriptorSetLayout = aLayout;
+
+		if (vkCreateDescriptorUpdateTemplate(aContext->mDevice->mDevice, &templateInfo, nullptr, &tTemplate.mTemplate) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create descriptor update template!");
+		}
+	}
+
+	tCache->mUpdateTemplates[aLayoutHash] = tTemplate;
+
+	return tTemplate;
+}
+
 std::shared_ptr<RootSignature> Flux::Gfx::Renderer::CreateRootSignature(std::shared_ptr<RenderContext> aRendererContext, const RootSignatureCreateDesc* const aRootSignatureDesc)
 {
 	// Check if the shader that is given in the description is a valid shader
@@ -445,9 +613,14 @@ std::shared_ptr<RootSignature> Flux::Gfx::Renderer::CreateRootSignature(std::sha
 	}
 
 	// Go through every set, turn them into vk descriptor set layout bindings
+	std::vector<uint64_t> tSetLayoutHashes;
 	for (auto& set : descriptorMap)
 	{
+		// Binding order is also the order of the packed data of the update template
+		std::sort(set.second.begin(), set.second.end(), [](const ShaderResourceReflection& a, const ShaderResourceReflection& b) { return a.mBindingNumber < b.mBindingNumber; });
+
 		std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+		std::vector<VkDescriptorBindingFlags> descriptorBindingFlags;
 
 		for (auto& binding : set.second)
 		{
@@ -458,22 +631,28 @@ std::shared_ptr<RootSignature> Flux::Gfx::Renderer::CreateRootSignature(std::sha
 			descriptorBinding.stageFlags = ConvertShaderStageToVkStage(Flux::Gfx::ShaderTypes(binding.mShaderAccess));
 			descriptorBinding.pImmutableSamplers = nullptr;
 
-			descriptorSetLayoutBindings.push_back(descriptorBinding);
-		}
+			VkDescriptorBindingFlags tFlags = 0;
 
-		VkDescriptorSetLayoutCreateInfo layoutInfo{};
-		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size());
-		layoutInfo.pBindings = descriptorSetLayoutBindings.data();
+			// Runtime sized array, reflected with a size of 0
+			if (binding.mSize == 0)
+			{
+				if (!aRendererContext->mDevice->mDescriptorIndexingSupported)
+				{
+					return nullptr;
+				}
 
-		VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+				descriptorBinding.descriptorCount = MAX_BINDLESS_RESOURCES;
+				tFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+			}
 
-		if (vkCreateDescriptorSetLayout(aRendererContext->mDevice->mDevice, &layoutInfo, nullptr, &descriptorSetLayout))
-		{
-			throw std::runtime_error("failed to create descriptor set layout!");
+			descriptorSetLayoutBindings.push_back(descriptorBinding);
+			descriptorBindingFlags.push_back(tFlags);
 		}
 
-		tRootSignature->mDescriptorSetLayouts.push_back(descriptorSetLayout);
+		uint64_t tSetLayoutHash = 0;
+		tRootSignature->mDescriptorSetLayouts.push_back(GetOrCreateDescriptorSetLayout(aRendererContext, descriptorSetLayoutBindings, descriptorBindingFlags, tSetLayoutHash));
+		tRootSignature->mUpdateTemplates.push_back(GetOrCreateUpdateTemplate(aRendererContext, tRootSignature->mDescriptorSetLayouts.back(), descriptorSetLayoutBindings, descriptorBindingFlags, tSetLayoutHash));
+		tSetLayoutHashes.push_back(tSetLayoutHash);
 	}
 
 
@@ -491,6 +670,42 @@ std::shared_ptr<RootSignature> Flux::Gfx::Renderer::CreateRootSignature(std::sha
 		tContainsPushConstants = true;
 	}
 
+	// Pipeline layouts are equal when the set layouts, in order, and the push constant range are equal
+	uint64_t tLayoutHash = HashCombine(0, tSetLayoutHashes.size());
+	for (const uint64_t setLayoutHash : tSetLayoutHashes)
+	{
+		tLayoutHash = HashCombine(tLayoutHash, setLayoutHash);
+	}
+
+	if (tContainsPushConstants)
+	{
+		tLayoutHash = HashCombine(tLayoutHash, pushConstantRange.stageFlags);
+		tLayoutHash = HashCombine(tLayoutHash, pushConstantRange.size);
+	}
+
+	const std::shared_ptr<LayoutCache> tCache = aRendererContext->mLayoutCache;
+	std::lock_guard<std::mutex> tLock(tCache->mMutex);
+
+	// Set layouts are unique per description, so comparing their handles is enough
+	for (auto tCachedLayout = tCache->mPipelineLayouts.find(tLayoutHash); tCachedLayout != tCache->mPipelineLayouts.end(); tCachedLayout = tCache->mPipelineLayouts.find(tLayoutHash))
+	{
+		const LayoutCache::PipelineLayoutEntry& tEntry = tCachedLayout->second;
+		const bool tSamePushConstants = tEntry.mHasPushConstants == tContainsPushConstants
+			&& (!tContainsPushConstants || (tEntry.mPushConstants.stageFlags == pushConstantRange.stageFlags && tEntry.mPushConstants.offset == pushConstantRange.offset && tEntry.mPushConstants.size == pushConstantRange.size));
+
+		if (tSamePushConstants && tEntry.mSetLayouts == tRootSignature->mDescriptorSetLayouts)
+		{
+			tCache->mHits++;
+			tRootSignature->mLayoutHash = tLayoutHash;
+			tRootSignature->mPipelineLayout = tEntry.mLayout;
+			return tRootSignature;
+		}
+
+		tLayoutHash = HashCombine(tLayoutHash, 1);
+	}
+
+	tRootSignature->mLayoutHash = tLayoutHash;
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.pushConstantRangeCount = tContainsPushConstants ? 1 : 0; // TODO hardcoded for now, figure out if multiple push constants are supported yet.
@@ -502,29 +717,353 @@ std::shared_ptr<RootSignature> Flux::Gfx::Renderer::CreateRootSignature(std::sha
 		throw std::runtime_error("failed to create pipeline layout!");
 	}
 
+	tCache->mMisses++;
+	tCache->mPipelineLayouts[tLayoutHash] = { tRootSignature->mPipelineLayout, tRootSignature->mDescriptorSetLayouts, tContainsPushConstants, pushConstantRange };
+
 	return tRootSignature;
 }
 
 void Flux::Gfx::Renderer::DestroyRootSignature(std::shared_ptr<RenderContext> aRendererContext, std::shared_ptr<RootSignature> aRootSignature)
 {
 	assert(aRootSignature);
-	for (auto& descriptorLayouts : aRootSignature->mDescriptorSetLayouts)
+
+	// The layouts may be shared with other root signatures, they are destroyed together with the layout cache
+	aRootSignature->mDescriptorSetLayouts.clear();
+	aRootSignature->mUpdateTemplates.clear();
+	aRootSignature->mPipelineLayout = VK_NULL_HANDLE;
+}
+
+void Flux::Gfx::Renderer::UpdateDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<RootSignature> aRootSignature, uint32_t aSetIndex, VkDescriptorSet aSet, const DescriptorInfo* aDescriptors, uint32_t aDescriptorCount)
+{
+	assert(aSetIndex < aRootSignature->mUpdateTemplates.size());
+
+	const DescriptorUpdateTemplate& tTemplate = aRootSignature->mUpdateTemplates[aSetIndex];
+	assert(aDescriptorCount == tTemplate.mDescriptorCount);
+
+	if (tTemplate.mTemplate == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vkUpdateDescriptorSetWithTemplate(aContext->mDevice->mDevice, aSet, tTemplate.mTemplate, aDescriptors);
+}
+
+void Flux::Gfx::Renderer::DestroyLayoutCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<LayoutCache> aCache)
+{
+	assert(aCache);
+
+	for (auto& pipelineLayout : aCache->mPipelineLayouts)
+	{
+		vkDestroyPipelineLayout(aContext->mDevice->mDevice, pipelineLayout.second.mLayout, nullptr);
+	}
+
+	for (auto& updateTemplate : aCache->mUpdateTemplates)
+	{
+		if (updateTemplate.second.mTemplate != VK_NULL_HANDLE)
+		{
+			vkDestroyDescriptorUpdateTemplate(aContext->mDevice->mDevice, updateTemplate.second.mTemplate, nullptr);
+		}
+	}
+
+	for (auto& setLayout : aCache->mSetLayouts)
+	{
+		vkDestroyDescriptorSetLayout(aContext->mDevice->mDevice, setLayout.second.mLayout, nullptr);
+	}
+
+	aCache->mPipelineLayouts.clear();
+	aCache->mUpdateTemplates.clear();
+	aCache->mSetLayouts.clear();
+}
+
+static VkDescriptorPool CreateAllocatorPool(VkDevice aDevice, uint32_t aSetCount)
+{
+	// Descriptors per set, roughly what the scene, material and shadow sets use
+	const std::array<std::pair<VkDescriptorType, float>, 7> tDescriptorsPerSet =
+	{ {
+		{ VK_DESCRIPTOR_TYPE_SAMPLER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.5f },
+	} };
+
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
+	for (auto& descriptorType : tDescriptorsPerSet)
+	{
+		descriptorPoolSizes.push_back({ descriptorType.first, static_cast<uint32_t>(descriptorType.second * aSetCount) });
+	}
+
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo{};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
+	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
+	descriptorPoolCreateInfo.maxSets = aSetCount;
+
+	VkDescriptorPool tPool;
+	if (vkCreateDescriptorPool(aDevice, &descriptorPoolCreateInfo, nullptr, &tPool) != VK_SUCCESS)
+	{
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	return tPool;
+}
+
+static DescriptorPoolBackend GetPoolBackend(VkDevice aDevice, uint32_t aSetsPerPool)
+{
+	DescriptorPoolBackend tBackend;
+	tBackend.mCreatePool = [aDevice, aSetsPerPool]() { return CreateAllocatorPool(aDevice, aSetsPerPool); };
+	tBackend.mAllocateSet = [aDevice](VkDescriptorPool aPool, VkDescriptorSetLayout aLayout, VkDescriptorSet& aOutSet)
+	{
+		VkDescriptorSetAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = aPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &aLayout;
+
+		return vkAllocateDescriptorSets(aDevice, &allocInfo, &aOutSet);
+	};
+	tBackend.mResetPool = [aDevice](VkDescriptorPool aPool) { vkResetDescriptorPool(aDevice, aPool, 0); };
+	tBackend.mDestroyPool = [aDevice](VkDescriptorPool aPool) { vkDestroyDescriptorPool(aDevice, aPool, nullptr); };
+
+	return tBackend;
+}
+
+std::shared_ptr<DescriptorAllocator> Flux::Gfx::Renderer::CreateDescriptorAllocator(std::shared_ptr<RenderContext> aContext, const DescriptorAllocatorCreateDesc* const aAllocatorDesc)
+{
+	std::shared_ptr<DescriptorAllocator> tAllocator = std::make_shared<DescriptorAllocator>();
+	InitializeDescriptorAllocator(*tAllocator, *aAllocatorDesc);
+
+	return tAllocator;
+}
+
+void Flux::Gfx::Renderer::DestroyDescriptorAllocator(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator)
+{
+	assert(aAllocator);
+
+	DestroyDescriptorAllocatorPools(*aAllocator, GetPoolBackend(aContext->mDevice->mDevice, aAllocator->mSetsPerPool));
+}
+
+VkDescriptorSet Flux::Gfx::Renderer::AllocateDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout)
+{
+	return AllocatePersistentSet(*aAllocator, GetPoolBackend(aContext->mDevice->mDevice, aAllocator->mSetsPerPool), aLayout);
+}
+
+void Flux::Gfx::Renderer::FreeDescriptorSet(std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout, VkDescriptorSet aSet)
+{
+	FreePersistentSet(*aAllocator, aLayout, aSet);
+}
+
+VkDescriptorSet Flux::Gfx::Renderer::AllocateTransientDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout)
+{
+	return AllocateFrameSet(*aAllocator, GetPoolBackend(aContext->mDevice->mDevice, aAllocator->mSetsPerPool), aLayout);
+}
+
+void Flux::Gfx::Renderer::BeginDescriptorAllocatorFrame(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, uint32_t aFrameIndex)
+{
+	ResetFramePools(*aAllocator, GetPoolBackend(aContext->mDevice->mDevice, aAllocator->mSetsPerPool), aFrameIndex);
+}
+
+static void DestroyTransientImages(VkDevice aDevice, TransientResourcePool& aPool)
+{
+	for (auto& image : aPool.mImages)
+	{
+		vkDestroyImageView(aDevice, image->mView, nullptr);
+		vkDestroyImage(aDevice, image->mImage, nullptr);
+	}
+
+	aPool.mImages.clear();
+	aPool.mImageBlocks.clear();
+	aPool.mAllocatedRequests.clear();
+}
+
+std::shared_ptr<TransientResourcePool> Flux::Gfx::Renderer::CreateTransientResourcePool(std::shared_ptr<RenderContext> aContext)
+{
+	return std::make_shared<TransientResourcePool>();
+}
+
+void Flux::Gfx::Renderer::DestroyTransientResourcePool(std::shared_ptr<RenderContext> aContext, std::shared_ptr<TransientResourcePool> aPool)
+{
+	assert(aPool);
+
+	DestroyTransientImages(aContext->mDevice->mDevice, *aPool);
+
+	for (auto& block : aPool->mBlocks)
 	{
-		vkDestroyDescriptorSetLayout(aRendererContext->mDevice->mDevice, descriptorLayouts, nullptr);
+		vmaFreeMemory(aContext->memoryAllocator, block.mAllocation);
 	}
 
-	vkDestroyPipelineLayout(aRendererContext->mDevice->mDevice, aRootSignature->mPipelineLayout, nullptr);
+	aPool->mBlocks.clear();
+	aPool->mRequests.clear();
+	aPool->mStats = TransientResourcePoolStats{};
+}
+
+void Flux::Gfx::Renderer::BeginTransientResourceFrame(std::shared_ptr<TransientResourcePool> aPool)
+{
+	aPool->mRequests.clear();
+}
+
+uint32_t Flux::Gfx::Renderer::RequestTransientImage(std::shared_ptr<TransientResourcePool> aPool, const TransientImageDesc& aDesc, uint32_t aFirstPass, uint32_t aLastPass)
+{
+	assert(aFirstPass <= aLastPass);
+
+	aPool->mRequests.push_back({ aDesc, aFirstPass, aLastPass });
+	return static_cast<uint32_t>(aPool->mRequests.size() - 1);
+}
+
+bool Flux::Gfx::Renderer::TransientImagesChanged(std::shared_ptr<TransientResourcePool> aPool)
+{
+	return aPool->mRequests != aPool->mAllocatedRequests;
+}
+
+void Flux::Gfx::Renderer::AllocateTransientImages(std::shared_ptr<RenderContext> aContext, std::shared_ptr<TransientResourcePool> aPool)
+{
+	const VkDevice tDevice = aContext->mDevice->mDevice;
+	TransientResourcePoolStats& tStats = aPool->mStats;
+
+	DestroyTransientImages(tDevice, *aPool);
+
+	// The images are created first, their memory requirements decide how they can be placed
+	std::vector<AliasingRequest> tAliasingRequests;
+	tAliasingRequests.reserve(aPool->mRequests.size());
+	tStats.mDedicatedBytes = 0;
+
+	for (const auto& request : aPool->mRequests)
+	{
+		std::shared_ptr<Texture> tImage = std::make_shared<Texture>();
+
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = request.mDesc.mWidth;
+		imageInfo.extent.height = request.mDesc.mHeight;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = request.mDesc.mFormat;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = request.mDesc.mUsage;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateImage(tDevice, &imageInfo, nullptr, &tImage->mImage) != VK_SUCCESS) {
+			throw std::runtime_error("failed to create transient image!");
+		}
+
+		tImage->mFormat = request.mDesc.mFormat;
+		tImage->mView = VK_NULL_HANDLE;
+		tImage->mAllocation = VK_NULL_HANDLE;
+
+		VkMemoryRequirements tRequirements;
+		vkGetImageMemoryRequirements(tDevice, tImage->mImage, &tRequirements);
+
+		tAliasingRequests.push_back({ tRequirements.size, tRequirements.alignment, tRequirements.memoryTypeBits, request.mFirstPass, request.mLastPass });
+		tStats.mDedicatedBytes += tRequirements.size;
+
+		aPool->mImages.push_back(tImage);
+	}
+
+	const AliasingPlan tPlan = PlanResourceAliasing(tAliasingRequests);
+
+	// Blocks that are still large enough are kept, the smallest one that fits is taken so the large blocks stay available
+	std::vector<TransientResourcePool::Block> tOldBlocks = std::move(aPool->mBlocks);
+	aPool->mBlocks.clear();
+	tStats.mAliasedBytes = 0;
+
+	for (const AliasingBlock& block : tPlan.mBlocks)
+	{
+		auto tReused = tOldBlocks.end();
+		for (auto old = tOldBlocks.begin(); old != tOldBlocks.end(); ++old)
+		{
+			const bool tFits = old->mAllocation != VK_NULL_HANDLE && old->mSize >= block.mSize && old->mAlignment >= block.mAlignment && (block.mMemoryTypeBits & (1u << old->mMemoryTypeIndex)) != 0;
+			if (tFits && (tReused == tOldBlocks.end() || old->mSize < tReused->mSize))
+			{
+				tReused = old;
+			}
+		}
+
+		if (tReused != tOldBlocks.end())
+		{
+			aPool->mBlocks.push_back(*tReused);
+			tReused->mAllocation = VK_NULL_HANDLE;
+			tStats.mRecycledBlocks++;
+		}
+		else
+		{
+			VkMemoryRequirements tRequirements{};
+			tRequirements.size = block.mSize;
+			tRequirements.alignment = block.mAlignment;
+			tRequirements.memoryTypeBits = block.mMemoryTypeBits;
+
+			VmaAllocationCreateInfo tAllocInfo{};
+			tAllocInfo.usage = VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY;
+
+			TransientResourcePool::Block tBlock{};
+			VmaAllocationInfo tInfo{};
+			if (vmaAllocateMemory(aContext->memoryAllocator, &tRequirements, &tAllocInfo, &tBlock.mAllocation, &tInfo) != VK_SUCCESS) {
+				throw std::runtime_error("failed to allocate transient memory!");
+			}
+
+			tBlock.mSize = block.mSize;
+			tBlock.mAlignment = block.mAlignment;
+			tBlock.mMemoryTypeIndex = tInfo.memoryType;
+			aPool->mBlocks.push_back(tBlock);
+		}
+
+		tStats.mAliasedBytes += aPool->mBlocks.back().mSize;
+	}
+
+	for (auto& old : tOldBlocks)
+	{
+		if (old.mAllocation != VK_NULL_HANDLE)
+		{
+			vmaFreeMemory(aContext->memoryAllocator, old.mAllocation);
+		}
+	}
+
+	for (size_t i = 0; i < aPool->mImages.size(); ++i)
+	{
+		auto& tImage = aPool->mImages[i];
+
+		if (vmaBindImageMemory(aContext->memoryAllocator, aPool->mBlocks[tPlan.mRequestBlocks[i]].mAllocation, tImage->mImage) != VK_SUCCESS) {
+			throw std::runtime_error("failed to bind transient image memory!");
+		}
+
+		tImage->mView = CreateImageView(aContext, tImage->mImage, aPool->mRequests[i].mDesc.mFormat, aPool->mRequests[i].mDesc.mAspect, 1);
+	}
+
+	aPool->mImageBlocks = tPlan.mRequestBlocks;
+	aPool->mAllocatedRequests = aPool->mRequests;
+
+	tStats.mImages = static_cast<uint32_t>(aPool->mImages.size());
+	tStats.mBlocks = static_cast<uint32_t>(aPool->mBlocks.size());
+	tStats.mReallocations++;
+}
+
+std::shared_ptr<Texture> Flux::Gfx::Renderer::GetTransientImage(std::shared_ptr<TransientResourcePool> aPool, uint32_t aHandle)
+{
+	assert(!TransientImagesChanged(aPool));
+	return aPool->mImages[aHandle];
+}
+
+const void* Flux::Gfx::Renderer::GetTransientImageMemory(std::shared_ptr<TransientResourcePool> aPool, uint32_t aHandle)
+{
+	assert(!TransientImagesChanged(aPool));
+	return aPool->mBlocks[aPool->mImageBlocks[aHandle]].mAllocation;
 }
 
 std::shared_ptr<Gfx::Shader> Flux::Gfx::Renderer::CreateShader(std::shared_ptr<RenderContext> aContext, const ShaderCreateDesc* const aShaderDesc)
 {
 	std::shared_ptr<Gfx::Shader> tShader = std::make_shared<Gfx::Shader>();
 
+	tShader->mShaderModule = Renderer::CreateShaderModule(aContext->mDevice->mDevice, aShaderDesc->mCode);
+
 	// Only reflect after the shader module is guarenteed to have succeeded
-	tShader->mReflectionData = ShaderReflection::Reflect(aShaderDesc->mCode);
+	tShader->mReflectionData = aContext->mReflectionCache ? ShaderReflection::ReflectCached(*aContext->mReflectionCache, aShaderDesc->mCode) : ShaderReflection::Reflect(aShaderDesc->mCode);
 	tShader->mFilePath = aShaderDesc->mFilePath;
 	tShader->mShadertype = aShaderDesc->mType; // Could get the type from reflection, have to consider what is best..
-	tShader->mShaderModule = Renderer::CreateShaderModule(aContext->mDevice->mDevice, aShaderDesc->mCode);
 
 	return tShader;
 }
@@ -535,6 +1074,34 @@ void Flux::Gfx::Renderer::DestroyShader(std::shared_ptr<RenderContext> aContext,
 	vkDestroyShaderModule(aContext->mDevice->mDevice, aShader->mShaderModule, nullptr);
 }
 
+// Records if the driver served the pipeline from the cache, only known when creation feedback is enabled
+static void RecordPipelineCacheFeedback(std::shared_ptr<PipelineCache> aCache, bool aFeedbackEnabled, const VkPipelineCreationFeedbackEXT& aFeedback, std::chrono::microseconds aDuration)
+{
+	if (aCache == nullptr)
+	{
+		return;
+	}
+
+	aCache->mStats.mCreationTimeMicroSeconds += aDuration.count();
+
+	if (aFeedbackEnabled && (aFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+	{
+		if (aFeedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+		{
+			aCache->mStats.mHits++;
+			return;
+		}
+
+		aCache->mStats.mMisses++;
+	}
+	else
+	{
+		aCache->mStats.mUnknown++;
+	}
+
+	aCache->mDirty = true;
+}
+
 std::shared_ptr<Gfx::GraphicsPipeline> Flux::Gfx::Renderer::CreateGraphicsPipeline(std::shared_ptr<RenderContext> aContext, const GraphicsPipelineCreateDesc* const aPipelineDesc)
 {
 	assert(aPipelineDesc);
@@ -571,26 +1138,20 @@ std::shared_ptr<Gfx::GraphicsPipeline> Flux::Gfx::Renderer::CreateGraphicsPipeli
 	inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 	inputAssembly.primitiveRestartEnable = VK_FALSE;
 
-	VkExtent2D viewExtent = { aPipelineDesc->mRt.lock()->mWidth, aPipelineDesc->mRt.lock()->mHeight };
-
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = (float)aPipelineDesc->mRt.lock()->mWidth;
-	viewport.height = (float)aPipelineDesc->mRt.lock()->mHeight;
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-
-	VkRect2D scissor{};
-	scissor.offset = { 0, 0 };
-	scissor.extent = viewExtent;
-
+	// Viewport and scissor are set at record time so pipelines survive a resize
 	VkPipelineViewportStateCreateInfo viewportState{};
 	viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
 	viewportState.viewportCount = 1;
-	viewportState.pViewports = &viewport;
+	viewportState.pViewports = nullptr;
 	viewportState.scissorCount = 1;
-	viewportState.pScissors = &scissor;
+	viewportState.pScissors = nullptr;
+
+	std::array<VkDynamicState, 2> dynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+	VkPipelineDynamicStateCreateInfo dynamicState{};
+	dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
+	dynamicState.pDynamicStates = dynamicStates.data();
 
 	VkPipelineMultisampleStateCreateInfo multisampling{};
 	multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -627,15 +1188,39 @@ std::shared_ptr<Gfx::GraphicsPipeline> Flux::Gfx::Renderer::CreateGraphicsPipeli
 	pipelineInfo.pMultisampleState = &multisampling;
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDepthStencilState = &depthStencil;
+	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = tRootSig->mPipelineLayout;
 	pipelineInfo.renderPass = aPipelineDesc->mRt.lock()->mPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	if (vkCreateGraphicsPipelines(aContext->mDevice->mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &tGraphicsPipeline->pipeline) != VK_SUCCESS) {
+	const bool tFeedbackEnabled = aContext->mDevice->IsExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+	VkPipelineCreationFeedbackEXT pipelineFeedback{};
+	std::vector<VkPipelineCreationFeedbackEXT> stageFeedbacks(pipelineCreateInfo.size());
+
+	VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+	feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+	feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+	feedbackInfo.pipelineStageCreationFeedbackCount = static_cast<uint32_t>(stageFeedbacks.size());
+	feedbackInfo.pPipelineStageCreationFeedbacks = stageFeedbacks.data();
+
+	if (tFeedbackEnabled)
+	{
+		pipelineInfo.pNext = &feedbackInfo;
+	}
+
+	const VkPipelineCache tCache = aContext->mPipelineCache ? aContext->mPipelineCache->mCache : VK_NULL_HANDLE;
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+
+	if (vkCreateGraphicsPipelines(aContext->mDevice->mDevice, tCache, 1, &pipelineInfo, nullptr, &tGraphicsPipeline->pipeline) != VK_SUCCESS) {
 		throw std::runtime_error("failed to create graphics pipeline!");
 	}
 
+	RecordPipelineCacheFeedback(aContext->mPipelineCache, tFeedbackEnabled, pipelineFeedback,
+		std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - tStart));
+
 	return tGraphicsPipeline;
 }
 
@@ -668,7 +1253,32 @@ std::shared_ptr<Gfx::ComputePipeline> Flux::Gfx::Renderer::CreateComputePipeline
 	pipelineInfo.stage = shaderStageInfo;
 	pipelineInfo.layout = tRootSignature->mPipelineLayout;
 
-	vkCreateComputePipelines(aContext->mDevice->mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &tComputePipeline->computePipeline);
+	const bool tFeedbackEnabled = aContext->mDevice->IsExtensionEnabled(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+	VkPipelineCreationFeedbackEXT pipelineFeedback{};
+	VkPipelineCreationFeedbackEXT stageFeedback{};
+
+	VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+	feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+	feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+	feedbackInfo.pipelineStageCreationFeedbackCount = 1;
+	feedbackInfo.pPipelineStageCreationFeedbacks = &stageFeedback;
+
+	if (tFeedbackEnabled)
+	{
+		pipelineInfo.pNext = &feedbackInfo;
+	}
+
+	const VkPipelineCache tCache = aContext->mPipelineCache ? aContext->mPipelineCache->mCache : VK_NULL_HANDLE;
+
+	auto tStart = std::chrono::high_resolution_clock::now();
+
+	if (vkCreateComputePipelines(aContext->mDevice->mDevice, tCache, 1, &pipelineInfo, nullptr, &tComputePipeline->computePipeline) != VK_SUCCESS) {
+		throw std::runtime_error("failed to create compute pipeline!");
+	}
+
+	RecordPipelineCacheFeedback(aContext->mPipelineCache, tFeedbackEnabled, pipelineFeedback,
+		std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - tStart));
 
 	return tComputePipeline;
 }
@@ -676,4 +1286,136 @@ std::shared_ptr<Gfx::ComputePipeline> Flux::Gfx::Renderer::CreateComputePipeline
 void Flux::Gfx::Renderer::DestroyComputePipeline(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::ComputePipeline> aComputePipeline)
 {
 	vkDestroyPipeline(aContext->mDevice->mDevice, aComputePipeline->computePipeline, nullptr);
-}
\ No newline at end of file
+}
+
+// Checks if the blob on disk was written by this exact device and driver, a mismatching blob would be ignored or rejected by the driver anyway
+static bool IsPipelineCacheDataCompatible(const std::vector<char>& aData, const VkPhysicalDeviceProperties& aProperties)
+{
+	if (aData.size() < sizeof(VkPipelineCacheHeaderVersionOne))
+	{
+		return false;
+	}
+
+	VkPipelineCacheHeaderVersionOne tHeader{};
+	memcpy(&tHeader, aData.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+	return tHeader.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) &&
+		tHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		tHeader.vendorID == aProperties.vendorID &&
+		tHeader.deviceID == aProperties.deviceID &&
+		memcmp(tHeader.pipelineCacheUUID, aProperties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+std::shared_ptr<Gfx::PipelineCache> Flux::Gfx::Renderer::CreatePipelineCache(std::shared_ptr<RenderContext> aContext, const PipelineCacheCreateDesc* const aCacheDesc)
+{
+	assert(aContext);
+	assert(aCacheDesc);
+
+	std::shared_ptr<PipelineCache> tCache = std::make_shared<PipelineCache>();
+	tCache->mFilePath = aCacheDesc->mFilePath;
+
+	std::vector<char> tData;
+	{
+		std::ifstream file(aCacheDesc->mFilePath, std::ios::ate | std::ios::binary);
+
+		if (file.is_open())
+		{
+			tData.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(tData.data(), tData.size());
+		}
+	}
+
+	if (!tData.empty() && !IsPipelineCacheDataCompatible(tData, aContext->mDevice->mPhysicalDeviceProperties))
+	{
+		std::cout << "Pipeline cache " << aCacheDesc->mFilePath << " was created by a different device or driver, starting with an empty cache" << std::endl;
+		tData.clear();
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo{};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.initialDataSize = tData.size();
+	cacheInfo.pInitialData = tData.empty() ? nullptr : tData.data();
+
+	if (vkCreatePipelineCache(aContext->mDevice->mDevice, &cacheInfo, nullptr, &tCache->mCache) != VK_SUCCESS)
+	{
+		// The data passed all our checks but the driver still refused it, fall back to an empty cache
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = nullptr;
+		tData.clear();
+
+		if (vkCreatePipelineCache(aContext->mDevice->mDevice, &cacheInfo, nullptr, &tCache->mCache) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+
+	tCache->mLoadedSize = tData.size();
+
+	return tCache;
+}
+
+void Flux::Gfx::Renderer::SavePipelineCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::PipelineCache> aCache)
+{
+	assert(aCache);
+
+	// Cleared before the data is read so a pipeline created by a compiler thread during the save marks the cache dirty again
+	aCache->mDirty.exchange(false);
+
+	size_t tDataSize = 0;
+	if (vkGetPipelineCacheData(aContext->mDevice->mDevice, aCache->mCache, &tDataSize, nullptr) != VK_SUCCESS || tDataSize == 0)
+	{
+		aCache->mDirty = true;
+		return;
+	}
+
+	std::vector<char> tData(tDataSize);
+	if (vkGetPipelineCacheData(aContext->mDevice->mDevice, aCache->mCache, &tDataSize, tData.data()) != VK_SUCCESS)
+	{
+		aCache->mDirty = true;
+		return;
+	}
+
+	// Write to a temporary file first so a crash during the write never leaves a truncated cache behind
+	const std::string tTempPath = aCache->mFilePath + ".tmp";
+	{
+		std::ofstream file(tTempPath, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			std::cout << "Failed to write pipeline cache " << tTempPath << std::endl;
+			aCache->mDirty = true;
+			return;
+		}
+
+		file.write(tData.data(), tDataSize);
+		file.close();
+
+		if (!file)
+		{
+			std::cout << "Failed to write pipeline cache " << tTempPath << std::endl;
+			std::remove(tTempPath.c_str());
+			aCache->mDirty = true;
+			return;
+		}
+	}
+
+	if (!AtomicReplaceFile(tTempPath, aCache->mFilePath))
+	{
+		std::cout << "Failed to replace pipeline cache " << aCache->mFilePath << std::endl;
+		std::remove(tTempPath.c_str());
+		aCache->mDirty = true;
+		return;
+	}
+}
+
+void Flux::Gfx::Renderer::DestroyPipelineCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::PipelineCache> aCache)
+{
+	if (aCache == nullptr)
+	{
+		return;
+	}
+
+	SavePipelineCache(aContext, aCache);
+	vkDestroyPipelineCache(aContext->mDevice->mDevice, aCache->mCache, nullptr);
+}
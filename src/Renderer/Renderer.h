@@ -33,6 +33,8 @@
 
 #include "Renderer/Queue.h"
 #include "Renderer/DescriptorPool.h"
+#include "Renderer/DescriptorAllocator.h"
+#include "Renderer/TransientResourcePool.h"
 #include "Renderer/GraphicsDevice.h"
 #include "Renderer/RenderContext.h"
 #include "Renderer/RenderTarget.h"
@@ -142,6 +144,13 @@ namespace Flux
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME
 		};
 
+		// Only enabled when the device supports them, check GraphicsDevice::IsExtensionEnabled before use
+		const std::vector<const char*> optionalDeviceExtensions = {
+			VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME,
+			VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME,
+			VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME
+		};
+
 		class Texture;
 		class Renderer
 		{
@@ -338,28 +347,21 @@ namespace Flux
 				return availableFormats[0];
 			}
 
-			static VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes, bool vsync) {
-				for (const auto& availablePresentMode : availablePresentModes) {
-					if (availablePresentMode == VK_PRESENT_MODE_FIFO_KHR && !vsync) {
-						return availablePresentMode;
-					}
-					else
-					{
-						return VK_PRESENT_MODE_FIFO_KHR;
-					}
-				}
 
-				return VK_PRESENT_MODE_FIFO_KHR;
+			// Without a surface nothing is presented, the swapchain extension is not needed
+			static std::vector<const char*> GetRequiredDeviceExtensions(VkSurfaceKHR aSurface) {
+				return aSurface != VK_NULL_HANDLE ? deviceExtensions : std::vector<const char*>();
 			}
 
-			static bool CheckDeviceExtensionSupport(VkPhysicalDevice device) {
+			static bool CheckDeviceExtensionSupport(VkPhysicalDevice device, VkSurfaceKHR aSurface) {
 				uint32_t extensionCount;
 				vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
 				std::vector<VkExtensionProperties> availableExtensions(extensionCount);
 				vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-				std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+				const std::vector<const char*> tRequiredExtensions = GetRequiredDeviceExtensions(aSurface);
+				std::set<std::string> requiredExtensions(tRequiredExtensions.begin(), tRequiredExtensions.end());
 
 				for (const auto& extension : availableExtensions) {
 					requiredExtensions.erase(extension.extensionName);
@@ -370,10 +372,11 @@ namespace Flux
 
 			static bool IsDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR aSurface) {
 
-				bool extensionsSupported = CheckDeviceExtensionSupport(device);
+				bool extensionsSupported = CheckDeviceExtensionSupport(device, aSurface);
 
-				bool swapChainAdequate = false;
-				if (extensionsSupported) {
+				// Headless devices render to offscreen images only
+				bool swapChainAdequate = aSurface == VK_NULL_HANDLE;
+				if (extensionsSupported && !swapChainAdequate) {
 					SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(device, aSurface);
 					swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 				}
@@ -430,6 +433,10 @@ namespace Flux
 				if (aContext->mDevice->mPhysicalDevice == VK_NULL_HANDLE) {
 					throw std::runtime_error("failed to find a suitable GPU!");
 				}
+
+				vkGetPhysicalDeviceProperties(aContext->mDevice->mPhysicalDevice, &aContext->mDevice->mPhysicalDeviceProperties);
+				vkGetPhysicalDeviceMemoryProperties(aContext->mDevice->mPhysicalDevice, &aContext->mDevice->mPhysicalDeviceMemoryProperties);
+				aContext->mDevice->mDeviceName = aContext->mDevice->mPhysicalDeviceProperties.deviceName;
 			}
 
 			static void CreateLogicalDevice(std::shared_ptr<RenderContext> aContext, VkSurfaceKHR aSurface)
@@ -453,22 +460,60 @@ namespace Flux
 					queueCreateInfos.push_back(queueCreateInfo);
 				}
 
-				VkPhysicalDevicePerformanceQueryFeaturesKHR queryFeatures{};
-				queryFeatures.performanceCounterMultipleQueryPools = VK_TRUE;
-				queryFeatures.performanceCounterQueryPools = VK_TRUE;
-				queryFeatures.pNext = nullptr;
-				queryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PERFORMANCE_QUERY_FEATURES_KHR;
+				// Core in 1.2 but optional, only enable what the bindless path needs when all of it is there
+				VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+				indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+				{
+					VkPhysicalDeviceDescriptorIndexingFeatures supportedIndexingFeatures{};
+					supportedIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+					VkPhysicalDeviceFeatures2 supportedFeatures{};
+					supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+					supportedFeatures.pNext = &supportedIndexingFeatures;
+					vkGetPhysicalDeviceFeatures2(aContext->mDevice->mPhysicalDevice, &supportedFeatures);
+
+					aContext->mDevice->mDescriptorIndexingSupported =
+						supportedIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+						supportedIndexingFeatures.runtimeDescriptorArray &&
+						supportedIndexingFeatures.descriptorBindingPartiallyBound &&
+						supportedIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind;
+
+					if (aContext->mDevice->mDescriptorIndexingSupported)
+					{
+						indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+						indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+						indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+						indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+					}
+				}
+				indexingFeatures.pNext = nullptr;
+
+				VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+				synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+				synchronization2Features.pNext = &indexingFeatures;
 
 				VkPhysicalDeviceSeparateDepthStencilLayoutsFeatures stencilFeatures{};
 				stencilFeatures.separateDepthStencilLayouts = VK_TRUE;
 				stencilFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SEPARATE_DEPTH_STENCIL_LAYOUTS_FEATURES;
-				stencilFeatures.pNext = &queryFeatures;
+				stencilFeatures.pNext = &synchronization2Features;
+
+				bool tMultiDrawIndirectSupported = false;
+				{
+					VkPhysicalDeviceFeatures supportedFeatures;
+					vkGetPhysicalDeviceFeatures(aContext->mDevice->mPhysicalDevice, &supportedFeatures);
+					aContext->mDevice->mInheritedQueriesSupported = supportedFeatures.inheritedQueries == VK_TRUE;
+					tMultiDrawIndirectSupported = supportedFeatures.multiDrawIndirect == VK_TRUE && supportedFeatures.drawIndirectFirstInstance == VK_TRUE;
+					aContext->mDevice->mDrawIndirectFirstInstanceSupported = tMultiDrawIndirectSupported;
+				}
 
 				VkPhysicalDeviceFeatures2KHR features{};
 				features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
 				features.features.samplerAnisotropy = VK_TRUE;
 				features.features.pipelineStatisticsQuery = VK_TRUE;
 				features.features.occlusionQueryPrecise = VK_TRUE;
+				features.features.inheritedQueries = aContext->mDevice->mInheritedQueriesSupported ? VK_TRUE : VK_FALSE;
+				features.features.multiDrawIndirect = tMultiDrawIndirectSupported ? VK_TRUE : VK_FALSE;
+				features.features.drawIndirectFirstInstance = tMultiDrawIndirectSupported ? VK_TRUE : VK_FALSE;
 				features.pNext = &stencilFeatures;
 
 				VkDeviceCreateInfo createInfo{};
@@ -479,8 +524,45 @@ namespace Flux
 
 				createInfo.pEnabledFeatures = NULL;
 
-				createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-				createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+				std::vector<const char*> tEnabledExtensions = GetRequiredDeviceExtensions(aSurface);
+				{
+					uint32_t extensionCount;
+					vkEnumerateDeviceExtensionProperties(aContext->mDevice->mPhysicalDevice, nullptr, &extensionCount, nullptr);
+
+					std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+					vkEnumerateDeviceExtensionProperties(aContext->mDevice->mPhysicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+					for (const auto& optionalExtension : optionalDeviceExtensions)
+					{
+						for (const auto& extension : availableExtensions)
+						{
+							if (strcmp(optionalExtension, extension.extensionName) == 0)
+							{
+								tEnabledExtensions.push_back(optionalExtension);
+								break;
+							}
+						}
+					}
+				}
+
+				aContext->mDevice->mEnabledExtensions = std::set<std::string>(tEnabledExtensions.begin(), tEnabledExtensions.end());
+
+				// The extension can be there without the feature, only enable it when both are
+				if (aContext->mDevice->IsExtensionEnabled(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+				{
+					VkPhysicalDeviceSynchronization2FeaturesKHR supportedSynchronization2Features{};
+					supportedSynchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+					VkPhysicalDeviceFeatures2 supportedFeatures{};
+					supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+					supportedFeatures.pNext = &supportedSynchronization2Features;
+					vkGetPhysicalDeviceFeatures2(aContext->mDevice->mPhysicalDevice, &supportedFeatures);
+
+					synchronization2Features.synchronization2 = supportedSynchronization2Features.synchronization2;
+				}
+
+				createInfo.enabledExtensionCount = static_cast<uint32_t>(tEnabledExtensions.size());
+				createInfo.ppEnabledExtensionNames = tEnabledExtensions.data();
 
 				createInfo.pNext = &features;
 				if (aContext->debugMode) {
@@ -495,15 +577,27 @@ namespace Flux
 					throw std::runtime_error("failed to create logical device!");
 				}
 
+				if (synchronization2Features.synchronization2 == VK_TRUE)
+				{
+					aContext->mDevice->mCmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(aContext->mDevice->mDevice, "vkCmdPipelineBarrier2KHR"));
+				}
 
+				if (tMultiDrawIndirectSupported && aContext->mDevice->IsExtensionEnabled(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME))
+				{
+					aContext->mDevice->mCmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(vkGetDeviceProcAddr(aContext->mDevice->mDevice, "vkCmdDrawIndexedIndirectCountKHR"));
+				}
 			}
 
-			static std::vector<const char*> GetRequiredExtensions(bool aDebug) {
-				uint32_t glfwExtensionCount = 0;
-				const char** glfwExtensions;
-				glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			// Headless contexts need no surface extensions, so they do not need GLFW either
+			static std::vector<const char*> GetRequiredExtensions(bool aDebug, bool aHeadless) {
+				std::vector<const char*> extensions;
+				if (!aHeadless) {
+					uint32_t glfwExtensionCount = 0;
+					const char** glfwExtensions;
+					glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
 
-				std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+					extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+				}
 
 				if (aDebug) {
 					extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -556,9 +650,9 @@ namespace Flux
 				for (const auto& queueFamily : queueFamilies) {
 
 					VkQueueFlags tQueueFlags = queueFamily.queueFlags;
-					bool graphicsQueueFlag = (tQueueFlags & VK_QUEUE_GRAPHICS_BIT) ? TRUE : FALSE;
-					bool computeQueueFlag = (tQueueFlags & VK_QUEUE_COMPUTE_BIT) ? TRUE : FALSE;
-					bool transferQueueFlag = (tQueueFlags & VK_QUEUE_TRANSFER_BIT) ? TRUE : FALSE;
+					bool graphicsQueueFlag = (tQueueFlags & VK_QUEUE_GRAPHICS_BIT) ? true : false;
+					bool computeQueueFlag = (tQueueFlags & VK_QUEUE_COMPUTE_BIT) ? true : false;
+					bool transferQueueFlag = (tQueueFlags & VK_QUEUE_TRANSFER_BIT) ? true : false;
 
 					if (graphicsQueueFlag) {
 						indices.graphicsFamily = std::optional < std::pair<uint32_t, bool>>({ i, true});
@@ -575,7 +669,9 @@ namespace Flux
 
 
 					VkBool32 presentSupport = false;
-					vkGetPhysicalDeviceSurfaceSupportKHR(device, i, aSurface, &presentSupport);
+					if (aSurface != VK_NULL_HANDLE) {
+						vkGetPhysicalDeviceSurfaceSupportKHR(device, i, aSurface, &presentSupport);
+					}
 
 					if (presentSupport) {
 						indices.presentFamily = std::optional < std::pair<uint32_t, bool>>({ i, true });
@@ -588,6 +684,16 @@ namespace Flux
 					i++;
 				}
 
+				// Software rasterizers like lavapipe have one family for everything, share it when there is no dedicated one
+				if (indices.graphicsFamily.has_value()) {
+					if (!indices.computeFamily.has_value()) {
+						indices.computeFamily = indices.graphicsFamily;
+					}
+					if (!indices.transferFamily.has_value()) {
+						indices.transferFamily = indices.graphicsFamily;
+					}
+				}
+
 				return indices;
 			}
 
@@ -748,7 +854,8 @@ namespace Flux
 			}
 
 			// Swapchain
-			static std::shared_ptr<Swapchain> CreateSwapChain(std::shared_ptr<RenderContext> aContext, GLFWwindow* window)
+			// Pass the previous swapchain when recreating so the driver can hand over its resources
+			static std::shared_ptr<Swapchain> CreateSwapChain(std::shared_ptr<RenderContext> aContext, GLFWwindow* window, std::shared_ptr<Swapchain> aOldSwapchain = nullptr)
 			{
 				assert(aContext);
 
@@ -765,7 +872,7 @@ namespace Flux
 				SwapChainSupportDetails swapChainSupport = QuerySwapChainSupport(aContext->mDevice->mPhysicalDevice, aContext->surface);
 
 				VkSurfaceFormatKHR surfaceFormat = ChooseSwapSurfaceFormat(swapChainSupport.formats);
-				VkPresentModeKHR presentMode = ChooseSwapPresentMode(swapChainSupport.presentModes, aContext->vsync);
+				VkPresentModeKHR presentMode = ChoosePresentMode(swapChainSupport.presentModes, aContext->mPresentMode);
 				VkExtent2D extent = ChooseSwapExtent(swapChainSupport.capabilities, window);
 
 				uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -800,6 +907,7 @@ namespace Flux
 				createInfo.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 				createInfo.presentMode = presentMode;
 				createInfo.clipped = VK_TRUE;
+				createInfo.oldSwapchain = aOldSwapchain != nullptr ? aOldSwapchain->mSwapChain : VK_NULL_HANDLE;
 
 				if (vkCreateSwapchainKHR(aContext->mDevice->mDevice, &createInfo, nullptr, &tSwapChain->mSwapChain) != VK_SUCCESS) {
 					throw std::runtime_error("failed to create swap chain!");
@@ -811,18 +919,54 @@ namespace Flux
 
 				tSwapChain->mImageFormat = surfaceFormat.format;
 				tSwapChain->mExtent = extent;
+				tSwapChain->mPresentMode = presentMode;
+				tSwapChain->mSupportedPresentModes = swapChainSupport.presentModes;
 
-				tSwapChain->mImageViews.resize(tSwapChain->mImages.size());
+				CreateSwapchainAttachments(aContext, tSwapChain);
 
-				for (size_t i = 0; i < tSwapChain->mImages.size(); i++) {
-					tSwapChain->mImageViews[i] = Renderer::CreateImageView(aContext, tSwapChain->mImages[i], tSwapChain->mImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
+				return tSwapChain;
+			}
+
+			// Same images, views, depth and render pass as a swapchain but without a surface, for headless rendering
+			// The images are owned by the swapchain and are never presented, frames are read from them with transfers
+			static std::shared_ptr<Swapchain> CreateOffscreenSwapChain(std::shared_ptr<RenderContext> aContext, uint32_t aWidth, uint32_t aHeight, uint32_t aImageCount)
+			{
+				assert(aContext);
+				assert(aWidth > 0 && aHeight > 0 && aImageCount > 0);
+
+				std::shared_ptr<Swapchain> tSwapChain = std::make_shared<Swapchain>();
+				tSwapChain->mSwapChain = VK_NULL_HANDLE;
+				tSwapChain->mImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+				tSwapChain->mExtent = { aWidth, aHeight };
+				tSwapChain->mPresentMode = VK_PRESENT_MODE_IMMEDIATE_KHR;
+
+				tSwapChain->mImages.resize(aImageCount);
+				tSwapChain->mImageAllocations.resize(aImageCount);
+				for (uint32_t i = 0; i < aImageCount; i++) {
+					Renderer::CreateImage(aContext, aWidth, aHeight, tSwapChain->mImageFormat, VK_IMAGE_TILING_OPTIMAL,
+						VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY,
+						tSwapChain->mImages[i], tSwapChain->mImageAllocations[i], 1);
+				}
+
+				CreateSwapchainAttachments(aContext, tSwapChain);
+
+				return tSwapChain;
+			}
+
+			// Views, depth, render pass and framebuffers of the images of a swapchain
+			static void CreateSwapchainAttachments(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Swapchain> aSwapChain)
+			{
+				aSwapChain->mImageViews.resize(aSwapChain->mImages.size());
+
+				for (size_t i = 0; i < aSwapChain->mImages.size(); i++) {
+					aSwapChain->mImageViews[i] = Renderer::CreateImageView(aContext, aSwapChain->mImages[i], aSwapChain->mImageFormat, VK_IMAGE_ASPECT_COLOR_BIT, 1);
 				}
 
 				VkFormat depthFormat = FindDepthFormat(aContext);
-				Renderer::CreateImage(aContext, tSwapChain->mExtent.width, tSwapChain->mExtent.height, depthFormat,
+				Renderer::CreateImage(aContext, aSwapChain->mExtent.width, aSwapChain->mExtent.height, depthFormat,
 					VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VmaMemoryUsage::VMA_MEMORY_USAGE_GPU_ONLY,
-					tSwapChain->depthImage, tSwapChain->depthImageMemory, 1);
-				tSwapChain->depthImageView = Renderer::CreateImageView(aContext, tSwapChain->depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
+					aSwapChain->depthImage, aSwapChain->depthImageMemory, 1);
+				aSwapChain->depthImageView = Renderer::CreateImageView(aContext, aSwapChain->depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 
 
 
@@ -830,14 +974,15 @@ namespace Flux
 					std::vector<VkAttachmentDescription> tAttachments;
 
 					VkAttachmentDescription colorAttachment{};
-					colorAttachment.format = tSwapChain->mImageFormat;
+					colorAttachment.format = aSwapChain->mImageFormat;
 					colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-					colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+					// Draws on top of the copied frame, the transitions around the pass are done by the frame graph
+					colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
 					colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 					colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 					colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-					colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-					colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+					colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 					tAttachments.push_back(colorAttachment);
 
 
@@ -869,20 +1014,20 @@ namespace Flux
 					renderPassInfo.dependencyCount = 1;
 					renderPassInfo.pDependencies = &dependency;
 
-					if (vkCreateRenderPass(aContext->mDevice->mDevice, &renderPassInfo, nullptr, &tSwapChain->mRenderPass) != VK_SUCCESS) {
+					if (vkCreateRenderPass(aContext->mDevice->mDevice, &renderPassInfo, nullptr, &aSwapChain->mRenderPass) != VK_SUCCESS) {
 						throw std::runtime_error("failed to create render pass!");
 					}
 
 
-					for (auto& swapchainImage : tSwapChain->mImageViews)
+					for (auto& swapchainImage : aSwapChain->mImageViews)
 					{
 						VkFramebufferCreateInfo framebufferInfo{};
 						framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-						framebufferInfo.renderPass = tSwapChain->mRenderPass;
+						framebufferInfo.renderPass = aSwapChain->mRenderPass;
 						framebufferInfo.attachmentCount = 1;
 						framebufferInfo.pAttachments = &swapchainImage;
-						framebufferInfo.width = tSwapChain->mExtent.width;
-						framebufferInfo.height = tSwapChain->mExtent.height;
+						framebufferInfo.width = aSwapChain->mExtent.width;
+						framebufferInfo.height = aSwapChain->mExtent.height;
 						framebufferInfo.layers = 1;
 
 						VkFramebuffer fb;
@@ -890,13 +1035,11 @@ namespace Flux
 							throw std::runtime_error("failed to create framebuffer!");
 						}
 
-						tSwapChain->mFramebuffers.push_back(fb);
+						aSwapChain->mFramebuffers.push_back(fb);
 					}
 
 
 				}
-
-				return tSwapChain;
 			}
 			static void DestroySwapchain(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Swapchain> aSwapchain)
 			{
@@ -910,9 +1053,14 @@ namespace Flux
 					vkDestroyImageView(aContext->mDevice->mDevice, imageView, nullptr);
 				}
 
-				vkDestroySwapchainKHR(aContext->mDevice->mDevice, aSwapchain->mSwapChain, nullptr);
-				vkDestroySurfaceKHR(aContext->instance, aContext->surface, nullptr);
-				aContext->surface = VK_NULL_HANDLE;
+				if (aSwapchain->IsOffscreen()) {
+					for (size_t i = 0; i < aSwapchain->mImages.size(); i++) {
+						vmaDestroyImage(aContext->memoryAllocator, aSwapchain->mImages[i], aSwapchain->mImageAllocations[i]);
+					}
+				}
+				else {
+					vkDestroySwapchainKHR(aContext->mDevice->mDevice, aSwapchain->mSwapChain, nullptr);
+				}
 
 				for (auto& framebuffer : aSwapchain->mFramebuffers)
 				{
@@ -924,10 +1072,12 @@ namespace Flux
 			}
 
 			// Render context
+			// Without a window the context is headless: no surface and no swapchain support, use CreateOffscreenSwapChain
 			static std::shared_ptr<RenderContext> CreateRenderContext(std::string aName, bool aEnableDebug, GLFWwindow* aWindow)
 			{
 				std::shared_ptr<RenderContext> tRenderContext = std::make_shared<RenderContext>();
 				tRenderContext->debugMode = aEnableDebug;
+				tRenderContext->mHeadless = aWindow == nullptr;
 
 				tRenderContext->mDevice = std::make_shared<GraphicsDevice>();
 
@@ -950,7 +1100,7 @@ namespace Flux
 				createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 				createInfo.pApplicationInfo = &appInfo;
 
-				auto extensions = GetRequiredExtensions(tRenderContext->debugMode);
+				auto extensions = GetRequiredExtensions(tRenderContext->debugMode, tRenderContext->mHeadless);
 				createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 				createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -973,7 +1123,7 @@ namespace Flux
 					throw std::runtime_error("failed to create instance!");
 				}
 
-				if (glfwCreateWindowSurface(tRenderContext->instance, aWindow, nullptr, &tRenderContext->surface) != VK_SUCCESS) {
+				if (!tRenderContext->mHeadless && glfwCreateWindowSurface(tRenderContext->instance, aWindow, nullptr, &tRenderContext->surface) != VK_SUCCESS) {
 					throw std::runtime_error("failed to create window surface!");
 				}
 
@@ -989,8 +1139,16 @@ namespace Flux
 
 				vmaCreateAllocator(&allocatorInfo, &tRenderContext->memoryAllocator);
 
+				PipelineCacheCreateDesc pipelineCacheDesc{};
+				pipelineCacheDesc.mFilePath = aName + ".pipelinecache";
+				tRenderContext->mPipelineCache = CreatePipelineCache(tRenderContext, &pipelineCacheDesc);
+				tRenderContext->mReflectionCache = ShaderReflection::LoadReflectionCache(aName + ".reflectioncache");
+				tRenderContext->mLayoutCache = std::make_shared<LayoutCache>();
 
-				vks::debug::setupDebugging(tRenderContext->instance, VK_DEBUG_REPORT_INFORMATION_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT | VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_DEBUG_BIT_EXT, NULL);
+				// The messenger comes from the debug utils extension, which is only enabled in debug mode
+				if (tRenderContext->debugMode) {
+					vks::debug::setupDebugging(tRenderContext->instance, VK_DEBUG_REPORT_INFORMATION_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT | VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT | VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_DEBUG_BIT_EXT, NULL);
+				}
 				vks::debugmarker::setup(tRenderContext->mDevice->mDevice);
 				return tRenderContext;
 			}
@@ -999,8 +1157,25 @@ namespace Flux
 
 				vks::debug::freeDebugCallback(aRenderContext->instance);
 
+				DestroyPipelineCache(aRenderContext, aRenderContext->mPipelineCache);
+				aRenderContext->mPipelineCache = nullptr;
+
+				ShaderReflection::SaveReflectionCache(*aRenderContext->mReflectionCache);
+				aRenderContext->mReflectionCache = nullptr;
+
+				DestroyLayoutCache(aRenderContext, aRenderContext->mLayoutCache);
+				aRenderContext->mLayoutCache = nullptr;
+
 				vmaDestroyAllocator(aRenderContext->memoryAllocator);
 				vkDestroyDevice(aRenderContext->mDevice->mDevice, nullptr);
+
+				// The surface outlives swapchain recreation, so it is owned by the context
+				if (aRenderContext->surface != VK_NULL_HANDLE)
+				{
+					vkDestroySurfaceKHR(aRenderContext->instance, aRenderContext->surface, nullptr);
+					aRenderContext->surface = VK_NULL_HANDLE;
+				}
+
 				vkDestroyInstance(aRenderContext->instance, nullptr);
 			}
 
@@ -1100,6 +1275,11 @@ namespace Flux
 				descriptorPoolCreateInfo.maxSets = aPoolDesc->maxDescriptorSets;
 				descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 
+				if (aPoolDesc->mUpdateAfterBind)
+				{
+					descriptorPoolCreateInfo.flags |= VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+				}
+
 				if (vkCreateDescriptorPool(aRendererContext->mDevice->mDevice, &descriptorPoolCreateInfo, nullptr, &tDescriptorPool->mPool) != VK_SUCCESS)
 				{
 					throw std::runtime_error(" Failed to create descriptor pool");
@@ -1112,10 +1292,51 @@ namespace Flux
 				vkDestroyDescriptorPool(aContext->mDevice->mDevice, aPool->mPool, nullptr);
 			}
 
+			// Descriptor allocator
+			static std::shared_ptr<DescriptorAllocator> CreateDescriptorAllocator(std::shared_ptr<RenderContext> aContext, const DescriptorAllocatorCreateDesc* const aAllocatorDesc);
+			static void DestroyDescriptorAllocator(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator);
+
+			// Long lived set, the caller has to write every binding since a previously freed set of this layout may be returned
+			static VkDescriptorSet AllocateDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout);
+			static void FreeDescriptorSet(std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout, VkDescriptorSet aSet);
+
+			// Only valid for the current frame, never free these
+			static VkDescriptorSet AllocateTransientDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, VkDescriptorSetLayout aLayout);
+
+			// Resets the transient pools of this frame, only call once the GPU is done with the frame
+			static void BeginDescriptorAllocatorFrame(std::shared_ptr<RenderContext> aContext, std::shared_ptr<DescriptorAllocator> aAllocator, uint32_t aFrameIndex);
+
+			// Transient resource pool
+			static std::shared_ptr<TransientResourcePool> CreateTransientResourcePool(std::shared_ptr<RenderContext> aContext);
+			static void DestroyTransientResourcePool(std::shared_ptr<RenderContext> aContext, std::shared_ptr<TransientResourcePool> aPool);
+
+			// Clears the requests of the last frame
+			static void BeginTransientResourceFrame(std::shared_ptr<TransientResourcePool> aPool);
+
+			// The image is used from aFirstPass up to and including aLastPass, returns its handle for this frame
+			static uint32_t RequestTransientImage(std::shared_ptr<TransientResourcePool> aPool, const TransientImageDesc& aDesc, uint32_t aFirstPass, uint32_t aLastPass);
+
+			// True when the requests of this frame differ from the ones the current images were created for
+			static bool TransientImagesChanged(std::shared_ptr<TransientResourcePool> aPool);
+
+			// Recreates the images for the requests of this frame, none of the previous images may still be in use
+			static void AllocateTransientImages(std::shared_ptr<RenderContext> aContext, std::shared_ptr<TransientResourcePool> aPool);
+
+			static std::shared_ptr<Texture> GetTransientImage(std::shared_ptr<TransientResourcePool> aPool, uint32_t aHandle);
+
+			// Images that return the same memory alias each other
+			static const void* GetTransientImageMemory(std::shared_ptr<TransientResourcePool> aPool, uint32_t aHandle);
+
 			// Root signature
 			static std::shared_ptr<RootSignature> CreateRootSignature(std::shared_ptr<RenderContext> aRendererContext, const RootSignatureCreateDesc* const aRootSignatureDesc);
 			static void DestroyRootSignature(std::shared_ptr<RenderContext> aRendererContext, std::shared_ptr<RootSignature> aRootSignature);
 
+			// Writes every binding of the set except runtime sized arrays with one call, aDescriptors is packed as described at DescriptorInfo
+			static void UpdateDescriptorSet(std::shared_ptr<RenderContext> aContext, std::shared_ptr<RootSignature> aRootSignature, uint32_t aSetIndex, VkDescriptorSet aSet, const DescriptorInfo* aDescriptors, uint32_t aDescriptorCount);
+
+			// Destroys every shared descriptor set layout and pipeline layout, only call once no root signature is in use anymore
+			static void DestroyLayoutCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<LayoutCache> aCache);
+
 
 			static VkFormat FindSupportedFormat(std::shared_ptr<RenderContext> aContext, const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
 			{
@@ -1152,11 +1373,12 @@ namespace Flux
 				assert(aRendererContext != nullptr);
 				assert(aRenderTargetDesc != nullptr);
 
-				std::vector<std::shared_ptr<Gfx::Texture>> tTextures;
-				std::shared_ptr<Gfx::Texture> tDepthTexture;
+				std::vector<std::shared_ptr<Gfx::Texture>> tTextures = aRenderTargetDesc->mExternalColorImages;
+				std::shared_ptr<Gfx::Texture> tDepthTexture = aRenderTargetDesc->mExternalDepthImage;
+				const bool tExternalImages = !tTextures.empty() || tDepthTexture != nullptr;
 
 				// Prep colour texture
-				for (int i = 0; i < aRenderTargetDesc->mTargets.size(); ++i)
+				for (int i = 0; i < aRenderTargetDesc->mTargets.size() && !tExternalImages; ++i)
 				{
 					tTextures.push_back(
 						CreateTexture(aRendererContext, aDevice->mDevice, aQueue->mVkQueue, aPool, aAllocator, aRenderTargetDesc->mWidth, aRenderTargetDesc->mHeight, 1, aRenderTargetDesc->mTargets[i].format, VkImageLayout::VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
@@ -1171,7 +1393,7 @@ namespace Flux
 
 				VkFormat depthFormat = FindDepthFormat(aRendererContext);
 
-				if (aRenderTargetDesc->mDepthTarget.has_value())
+				if (aRenderTargetDesc->mDepthTarget.has_value() && !tExternalImages)
 				{
 					tDepthTexture = std::make_shared<Texture>();
 					/*tTextures.push_back(
@@ -1188,6 +1410,7 @@ namespace Flux
 
 				tRenderTarget->mColorImages = tTextures;
 				tRenderTarget->mDepthImage = tDepthTexture;
+				tRenderTarget->mOwnsImages = !tExternalImages;
 
 				std::vector<VkAttachmentDescription> tAttachments;
 
@@ -1196,11 +1419,11 @@ namespace Flux
 					VkAttachmentDescription colorAttachment{};
 					colorAttachment.format = eColAttachment->mFormat;
 					colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-					colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+					colorAttachment.loadOp = aRenderTargetDesc->mLoadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 					colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 					colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 					colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-					colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					colorAttachment.initialLayout = aRenderTargetDesc->mLoadContents ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
 					colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 					tAttachments.push_back(colorAttachment);
 				}
@@ -1210,13 +1433,13 @@ namespace Flux
 				{
 					const auto& tDepthImage = tRenderTarget->mDepthImage;
 					VkAttachmentDescription depthAttachment{};
-					depthAttachment.format = depthFormat;
+					depthAttachment.format = tDepthImage->mFormat;
 					depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-					depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+					depthAttachment.loadOp = aRenderTargetDesc->mLoadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 					depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-					depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+					depthAttachment.stencilLoadOp = aRenderTargetDesc->mLoadContents ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 					depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
-					depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+					depthAttachment.initialLayout = aRenderTargetDesc->mLoadContents ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
 					depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL; // FLUX_TODO add support dor depth stencil as final layout
 					tAttachments.push_back(depthAttachment);
 				}
@@ -1307,6 +1530,11 @@ namespace Flux
 				aRenderTarget->mWidth = 0;
 				aRenderTarget->mHeight = 0;
 
+				if (!aRenderTarget->mOwnsImages)
+				{
+					return;
+				}
+
 				for (auto& eColorImages : aRenderTarget->mColorImages)
 				{
 					vkDestroyImageView(aContext->mDevice->mDevice, eColorImages->mView, nullptr);
@@ -1331,6 +1559,11 @@ namespace Flux
 			static std::shared_ptr<Gfx::ComputePipeline> CreateComputePipeline(std::shared_ptr<RenderContext> aContext, const ComputePipelineCreatedesc* const aPipelineDesc);
 			static void DestroyComputePipeline(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::ComputePipeline> aComputePipeline);
 
+			// Pipeline cache, loaded from disk when the stored header matches the current device and driver
+			static std::shared_ptr<Gfx::PipelineCache> CreatePipelineCache(std::shared_ptr<RenderContext> aContext, const PipelineCacheCreateDesc* const aCacheDesc);
+			static void SavePipelineCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::PipelineCache> aCache);
+			static void DestroyPipelineCache(std::shared_ptr<RenderContext> aContext, std::shared_ptr<Gfx::PipelineCache> aCache);
+
 		};
 	}
 };
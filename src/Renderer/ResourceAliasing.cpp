@@ -0,0 +1,56 @@
+#include "ResourceAliasing.h"
+
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+Flux::Gfx::AliasingPlan Flux::Gfx::PlanResourceAliasing(const std::vector<AliasingRequest>& aRequests)
+{
+	AliasingPlan tPlan;
+	tPlan.mRequestBlocks.resize(aRequests.size());
+
+	std::vector<uint32_t> tOrder(aRequests.size());
+	std::iota(tOrder.begin(), tOrder.end(), 0);
+	std::stable_sort(tOrder.begin(), tOrder.end(), [&aRequests](uint32_t aLeft, uint32_t aRight) { return aRequests[aLeft].mSize > aRequests[aRight].mSize; });
+
+	std::vector<std::vector<uint32_t>> tBlockRequests;
+
+	for (const uint32_t request : tOrder)
+	{
+		const AliasingRequest& tRequest = aRequests[request];
+		assert(tRequest.mFirstPass <= tRequest.mLastPass);
+
+		bool tPlaced = false;
+		for (size_t block = 0; block < tPlan.mBlocks.size() && !tPlaced; ++block)
+		{
+			// Smaller requests only ever join a block, so it never has to grow
+			if (tRequest.mSize > tPlan.mBlocks[block].mSize || (tRequest.mMemoryTypeBits & tPlan.mBlocks[block].mMemoryTypeBits) == 0)
+			{
+				continue;
+			}
+
+			const bool tOverlaps = std::any_of(tBlockRequests[block].begin(), tBlockRequests[block].end(), [&](uint32_t aOther)
+			{
+				return tRequest.mFirstPass <= aRequests[aOther].mLastPass && aRequests[aOther].mFirstPass <= tRequest.mLastPass;
+			});
+
+			if (!tOverlaps)
+			{
+				tPlan.mBlocks[block].mAlignment = std::max(tPlan.mBlocks[block].mAlignment, tRequest.mAlignment);
+				tPlan.mBlocks[block].mMemoryTypeBits &= tRequest.mMemoryTypeBits;
+				tBlockRequests[block].push_back(request);
+				tPlan.mRequestBlocks[request] = static_cast<uint32_t>(block);
+				tPlaced = true;
+			}
+		}
+
+		if (!tPlaced)
+		{
+			tPlan.mRequestBlocks[request] = static_cast<uint32_t>(tPlan.mBlocks.size());
+			tPlan.mBlocks.push_back({ tRequest.mSize, tRequest.mAlignment, tRequest.mMemoryTypeBits });
+			tBlockRequests.push_back({ request });
+		}
+	}
+
+	return tPlan;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "vulkan/vulkan.h"
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		// A resource that only has to exist between two passes of the frame, both inclusive
+		struct AliasingRequest
+		{
+			VkDeviceSize mSize = 0;
+			VkDeviceSize mAlignment = 1;
+			uint32_t mMemoryTypeBits = 0;
+			uint32_t mFirstPass = 0;
+			uint32_t mLastPass = 0;
+		};
+
+		struct AliasingBlock
+		{
+			VkDeviceSize mSize = 0;
+			VkDeviceSize mAlignment = 1; // Largest of the resources placed in the block
+			uint32_t mMemoryTypeBits = 0; // Allowed for every resource placed in the block
+		};
+
+		struct AliasingPlan
+		{
+			std::vector<uint32_t> mRequestBlocks; // Block of every request, same order as the requests
+			std::vector<AliasingBlock> mBlocks;
+		};
+
+		// Resources whose lifetimes do not overlap share a block, every resource is placed at the start of its block
+		// Largest first, so the big resources define the blocks and the small ones fill the gaps in their lifetimes
+		AliasingPlan PlanResourceAliasing(const std::vector<AliasingRequest>& aRequests);
+	}
+}
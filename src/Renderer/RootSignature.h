@@ -5,11 +5,15 @@
 
 #include "Renderer/Shader.h"
 #include "Renderer/ShaderReflection.h"
+#include "Renderer/DescriptorUpdateTemplate.h"
 
 namespace Flux
 {
 	namespace Gfx
 	{
+		// Descriptor count used for runtime sized arrays (textures[]) in shaders, these become partially bound, update after bind bindings
+		constexpr uint32_t MAX_BINDLESS_RESOURCES = 4096;
+
 		struct RootSignatureCreateDesc
 		{
 			std::vector<std::shared_ptr<Shader>> mShaders;
@@ -21,9 +25,11 @@ namespace Flux
 			std::vector<Flux::Gfx::ShaderReflection::ShaderResourceReflection> mRootSignatureResources; // Collection of all the usable shader resources from all the shaders within this root signature
 			std::vector<Flux::Gfx::ShaderReflection::PushConstantReflection> mPushConstantBuffers;
 
-			// Vulkan
+			// Vulkan, both are owned by the layout cache of the render context
 			VkPipelineLayout mPipelineLayout;
 			std::vector<VkDescriptorSetLayout> mDescriptorSetLayouts;
+			std::vector<DescriptorUpdateTemplate> mUpdateTemplates; // Per set, owned by the layout cache as well
+			uint64_t mLayoutHash = 0; // Equal hashes mean the same pipeline layout
 		};
 	}
 }
\ No newline at end of file
@@ -2,9 +2,12 @@
 
 
 #include <algorithm>
+#include <fstream>
+#include <cstdio>
 
-#include "spirv_reflect.hpp"
+#include "spirv_cross.hpp"
 #include "Shader.h"
+#include "FileUtility.h"
 
 using namespace Flux::Gfx::ShaderReflection;
 using namespace Flux::Gfx;
@@ -83,9 +86,11 @@ ShaderTypes ConvertExecutionModelToShaderType(spv::ExecutionModel aExecutionMode
 	default:
 		break;
 	}
+
+	return ShaderTypes::eUnknownShaderType;
 }
 
-std::vector<ShaderResourceReflection> AddResourcesToList(const spirv_cross::CompilerGLSL& aCompiler, const spirv_cross::SmallVector<spirv_cross::Resource>& aResources, ShaderResourceType aType, ShaderTypes aShaderStage)
+std::vector<ShaderResourceReflection> AddResourcesToList(const spirv_cross::Compiler& aCompiler, const spirv_cross::SmallVector<spirv_cross::Resource>& aResources, ShaderResourceType aType, ShaderTypes aShaderStage)
 {
 	std::vector<ShaderResourceReflection> tResourceList;
 	tResourceList.reserve(aResources.size());
@@ -100,7 +105,7 @@ std::vector<ShaderResourceReflection> AddResourcesToList(const spirv_cross::Comp
 		tResource.mShaderAccess = aShaderStage;
 
 
-		spirv_cross::SPIRType type = aCompiler.get_type(resource.type_id);
+		const spirv_cross::SPIRType& type = aCompiler.get_type(resource.type_id);
 
 
 		// Check if the resource is an array
@@ -115,7 +120,7 @@ std::vector<ShaderResourceReflection> AddResourcesToList(const spirv_cross::Comp
 	return tResourceList;
 }
 
-std::vector<PushConstantReflection> AddPushConstant(const spirv_cross::CompilerGLSL& aCompiler, const spirv_cross::SmallVector<spirv_cross::Resource>& aResources, ShaderResourceType aType, ShaderTypes aShaderStage)
+std::vector<PushConstantReflection> AddPushConstant(const spirv_cross::Compiler& aCompiler, const spirv_cross::SmallVector<spirv_cross::Resource>& aResources, ShaderResourceType aType, ShaderTypes aShaderStage)
 {
 	std::vector<PushConstantReflection> tPushConstantsVector;
 
@@ -134,13 +139,15 @@ std::vector<PushConstantReflection> AddPushConstant(const spirv_cross::CompilerG
 
 
 
-ShaderReflectionData Flux::Gfx::ShaderReflection::Reflect(std::vector<char> aSpvbinary)
+ShaderReflectionData Flux::Gfx::ShaderReflection::Reflect(const std::vector<char>& aSpvbinary)
 {
 	ShaderReflectionData tReflection{};
 
-	spirv_cross::CompilerGLSL glsl((uint32_t*)(aSpvbinary.data()), (aSpvbinary.size() * sizeof(char)) / sizeof(uint32_t));
+	// Base compiler is enough for reflection, no need for the GLSL backend
+	spirv_cross::Compiler glsl(reinterpret_cast<const uint32_t*>(aSpvbinary.data()), aSpvbinary.size() / sizeof(uint32_t));
 
-	tReflection.mEntryPoint = glsl.get_entry_points_and_stages()[0].name;
+	const auto tEntryPoints = glsl.get_entry_points_and_stages();
+	tReflection.mEntryPoint = tEntryPoints[0].name;
 	spirv_cross::ShaderResources resources = glsl.get_shader_resources();
 
 	uint32_t tResourcesSize = 0;
@@ -161,7 +168,7 @@ ShaderReflectionData Flux::Gfx::ShaderReflection::Reflect(std::vector<char> aSpv
 	tReflection.mResources.reserve(tResourcesSize);
 
 	// Query the shader type from the spirv-cross binaries
-	ShaderTypes tShaderStage = ConvertExecutionModelToShaderType(glsl.get_entry_points_and_stages()[0].execution_model);
+	ShaderTypes tShaderStage = ConvertExecutionModelToShaderType(tEntryPoints[0].execution_model);
 
 	// Uniform buffers
 	{
@@ -237,6 +244,223 @@ ShaderReflectionData Flux::Gfx::ShaderReflection::Reflect(std::vector<char> aSpv
 	return tReflection;
 }
 
+uint64_t Flux::Gfx::ShaderReflection::HashSpirv(const std::vector<char>& aSpvbinary)
+{
+	// FNV-1a
+	uint64_t tHash = 14695981039346656037ull;
+	for (const char byte : aSpvbinary)
+	{
+		tHash ^= static_cast<uint8_t>(byte);
+		tHash *= 1099511628211ull;
+	}
+
+	return tHash;
+}
+
+ShaderReflectionData Flux::Gfx::ShaderReflection::ReflectCached(ReflectionCache& aCache, const std::vector<char>& aSpvbinary)
+{
+	const uint64_t tHash = HashSpirv(aSpvbinary);
+
+	{
+		std::lock_guard<std::mutex> tLock(aCache.mMutex);
+		auto tEntry = aCache.mEntries.find(tHash);
+		if (tEntry != aCache.mEntries.end())
+		{
+			aCache.mHits++;
+			return tEntry->second;
+		}
+	}
+
+	ShaderReflectionData tReflection = Reflect(aSpvbinary);
+
+	std::lock_guard<std::mutex> tLock(aCache.mMutex);
+	aCache.mEntries[tHash] = tReflection;
+	aCache.mDirty = true;
+	aCache.mMisses++;
+
+	return tReflection;
+}
+
+// Sidecar layout: header, then per entry the hash followed by the reflection data, all little endian as written by this machine
+static constexpr uint32_t REFLECTION_CACHE_MAGIC = 0x43524658; // "XFRC"
+static constexpr uint32_t REFLECTION_CACHE_VERSION = 1;
+
+template<typename T>
+static void WriteValue(std::ofstream& aStream, const T& aValue)
+{
+	aStream.write(reinterpret_cast<const char*>(&aValue), sizeof(T));
+}
+
+static void WriteString(std::ofstream& aStream, const std::string& aString)
+{
+	WriteValue(aStream, static_cast<uint32_t>(aString.size()));
+	aStream.write(aString.data(), aString.size());
+}
+
+template<typename T>
+static bool ReadValue(std::ifstream& aStream, T& aValue)
+{
+	return static_cast<bool>(aStream.read(reinterpret_cast<char*>(&aValue), sizeof(T)));
+}
+
+static bool ReadString(std::ifstream& aStream, std::string& aString)
+{
+	uint32_t tSize = 0;
+	if (!ReadValue(aStream, tSize) || tSize > 4096)
+	{
+		return false;
+	}
+
+	aString.resize(tSize);
+	return tSize == 0 || static_cast<bool>(aStream.read(&aString[0], tSize));
+}
+
+static bool ReadReflectionData(std::ifstream& aStream, ShaderReflectionData& aData)
+{
+	if (!ReadString(aStream, aData.mEntryPoint) || !ReadValue(aStream, aData.mThreadGroups))
+	{
+		return false;
+	}
+
+	uint32_t tResourceCount = 0;
+	if (!ReadValue(aStream, tResourceCount) || tResourceCount > 4096)
+	{
+		return false;
+	}
+
+	aData.mResources.resize(tResourceCount);
+	for (auto& resource : aData.mResources)
+	{
+		if (!ReadValue(aStream, resource.mBindingNumber) || !ReadValue(aStream, resource.mSetNumber) || !ReadValue(aStream, resource.mSize) ||
+			!ReadString(aStream, resource.mName) || !ReadValue(aStream, resource.mType) || !ReadValue(aStream, resource.mShaderAccess))
+		{
+			return false;
+		}
+	}
+
+	uint32_t tPushConstantCount = 0;
+	if (!ReadValue(aStream, tPushConstantCount) || tPushConstantCount > 64)
+	{
+		return false;
+	}
+
+	aData.mPushConstants.resize(tPushConstantCount);
+	for (auto& pushConstant : aData.mPushConstants)
+	{
+		if (!ReadValue(aStream, pushConstant.mSize) || !ReadValue(aStream, pushConstant.mShaderAccess))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void WriteReflectionData(std::ofstream& aStream, const ShaderReflectionData& aData)
+{
+	WriteString(aStream, aData.mEntryPoint);
+	WriteValue(aStream, aData.mThreadGroups);
+
+	WriteValue(aStream, static_cast<uint32_t>(aData.mResources.size()));
+	for (const auto& resource : aData.mResources)
+	{
+		WriteValue(aStream, resource.mBindingNumber);
+		WriteValue(aStream, resource.mSetNumber);
+		WriteValue(aStream, resource.mSize);
+		WriteString(aStream, resource.mName);
+		WriteValue(aStream, resource.mType);
+		WriteValue(aStream, resource.mShaderAccess);
+	}
+
+	WriteValue(aStream, static_cast<uint32_t>(aData.mPushConstants.size()));
+	for (const auto& pushConstant : aData.mPushConstants)
+	{
+		WriteValue(aStream, pushConstant.mSize);
+		WriteValue(aStream, pushConstant.mShaderAccess);
+	}
+}
+
+std::shared_ptr<ReflectionCache> Flux::Gfx::ShaderReflection::LoadReflectionCache(const std::string& aFilePath)
+{
+	std::shared_ptr<ReflectionCache> tCache = std::make_shared<ReflectionCache>();
+	tCache->mFilePath = aFilePath;
+
+	std::ifstream tFile(aFilePath, std::ios::binary);
+	if (!tFile.is_open())
+	{
+		return tCache;
+	}
+
+	uint32_t tMagic = 0;
+	uint32_t tVersion = 0;
+	uint32_t tEntryCount = 0;
+	if (!ReadValue(tFile, tMagic) || !ReadValue(tFile, tVersion) || !ReadValue(tFile, tEntryCount) ||
+		tMagic != REFLECTION_CACHE_MAGIC || tVersion != REFLECTION_CACHE_VERSION)
+	{
+		return tCache;
+	}
+
+	for (uint32_t i = 0; i < tEntryCount; ++i)
+	{
+		uint64_t tHash = 0;
+		ShaderReflectionData tData{};
+		if (!ReadValue(tFile, tHash) || !ReadReflectionData(tFile, tData))
+		{
+			// Don't trust anything from a truncated or corrupt file
+			tCache->mEntries.clear();
+			return tCache;
+		}
+
+		tCache->mEntries.emplace(tHash, std::move(tData));
+	}
+
+	return tCache;
+}
+
+bool Flux::Gfx::ShaderReflection::SaveReflectionCache(ReflectionCache& aCache)
+{
+	std::lock_guard<std::mutex> tLock(aCache.mMutex);
+
+	if (!aCache.mDirty)
+	{
+		return true;
+	}
+
+	// Same temp file and rename as the pipeline cache, an interrupted save keeps the old file intact
+	const std::string tTempPath = aCache.mFilePath + ".tmp";
+	{
+		std::ofstream tFile(tTempPath, std::ios::binary | std::ios::trunc);
+		if (!tFile.is_open())
+		{
+			return false;
+		}
+
+		WriteValue(tFile, REFLECTION_CACHE_MAGIC);
+		WriteValue(tFile, REFLECTION_CACHE_VERSION);
+		WriteValue(tFile, static_cast<uint32_t>(aCache.mEntries.size()));
+
+		for (const auto& entry : aCache.mEntries)
+		{
+			WriteValue(tFile, entry.first);
+			WriteReflectionData(tFile, entry.second);
+		}
+
+		if (!tFile.good())
+		{
+			return false;
+		}
+	}
+
+	if (!AtomicReplaceFile(tTempPath, aCache.mFilePath))
+	{
+		std::remove(tTempPath.c_str());
+		return false;
+	}
+
+	aCache.mDirty = false;
+	return true;
+}
+
 std::vector<ShaderResourceReflection> Flux::Gfx::ShaderReflection::ValidateAndMergeShaderResources(const std::vector<std::shared_ptr<Flux::Gfx::Shader>> aShaders)
 {
 	if (aShaders.size() == 0)
@@ -249,7 +473,6 @@ std::vector<ShaderResourceReflection> Flux::Gfx::ShaderReflection::ValidateAndMe
 	const std::vector<ShaderResourceType> exclusions = {
 		ShaderResourceType::eStage_input,
 		ShaderResourceType::eStage_output,
-		ShaderResourceType::eStorage_buffer,
 		ShaderResourceType::ePushConstantBuffer};
 
 	bool failure = false;
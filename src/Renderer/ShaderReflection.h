@@ -4,6 +4,9 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
 
 #include "vulkan/vulkan.h"
 
@@ -60,7 +63,28 @@ namespace Flux
 				uint32_t mThreadGroups[3]; // X Y Z
 			};
 
-			ShaderReflectionData Reflect(std::vector<char> aSpvbinary);
+			// Reflection results of previous runs keyed by SPIR-V hash, so unchanged shaders skip SPIRV-Cross entirely
+			struct ReflectionCache
+			{
+				std::string mFilePath;
+				std::unordered_map<uint64_t, ShaderReflectionData> mEntries;
+				std::mutex mMutex;
+				bool mDirty = false;
+
+				std::atomic<uint32_t> mHits{ 0 };
+				std::atomic<uint32_t> mMisses{ 0 };
+			};
+
+			ShaderReflectionData Reflect(const std::vector<char>& aSpvbinary);
+
+			uint64_t HashSpirv(const std::vector<char>& aSpvbinary);
+
+			// Returns the cached reflection for this binary, reflects and stores it on a miss
+			ShaderReflectionData ReflectCached(ReflectionCache& aCache, const std::vector<char>& aSpvbinary);
+
+			// A missing, outdated or corrupt file results in an empty cache
+			std::shared_ptr<ReflectionCache> LoadReflectionCache(const std::string& aFilePath);
+			bool SaveReflectionCache(ReflectionCache& aCache);
 
 			// Validates a bunch of shaders to see if their resources are overlapping and not causing conflicts
 			std::vector<ShaderResourceReflection> ValidateAndMergeShaderResources(const std::vector<std::shared_ptr<Flux::Gfx::Shader>> aShaders);
@@ -10,11 +10,14 @@ namespace Flux
 		class Swapchain
 		{
 		public:
-			VkSwapchainKHR mSwapChain;
+			VkSwapchainKHR mSwapChain; // Null for offscreen swapchains
 			std::vector<VkImage> mImages;
+			std::vector<VmaAllocation> mImageAllocations; // Offscreen only, swapchain images are owned by the presentation engine
 			std::vector<VkImageView> mImageViews;
 			VkFormat mImageFormat;
 			VkExtent2D mExtent;
+			VkPresentModeKHR mPresentMode;
+			std::vector<VkPresentModeKHR> mSupportedPresentModes;
 
 			VkImage depthImage;
 			VmaAllocation depthImageMemory;
@@ -22,6 +25,8 @@ namespace Flux
 
 			std::vector<VkFramebuffer> mFramebuffers;
 			VkRenderPass mRenderPass;
+
+			bool IsOffscreen() const { return mSwapChain == VK_NULL_HANDLE; }
 		};
 	}
 }
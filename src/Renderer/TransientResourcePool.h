@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <VmaUsage.h>
+#include <vector>
+#include <memory>
+
+#include "TextureVK.h"
+#include "ResourceAliasing.h"
+
+namespace Flux
+{
+	namespace Gfx
+	{
+		struct TransientImageDesc
+		{
+			uint32_t mWidth = 0;
+			uint32_t mHeight = 0;
+			VkFormat mFormat = VK_FORMAT_UNDEFINED;
+			VkImageUsageFlags mUsage = 0;
+			VkImageAspectFlags mAspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+			bool operator==(const TransientImageDesc& aOther) const
+			{
+				return mWidth == aOther.mWidth && mHeight == aOther.mHeight && mFormat == aOther.mFormat && mUsage == aOther.mUsage && mAspect == aOther.mAspect;
+			}
+		};
+
+		struct TransientResourcePoolStats
+		{
+			VkDeviceSize mDedicatedBytes = 0; // What the images would take with an allocation each
+			VkDeviceSize mAliasedBytes = 0; // What the memory blocks they are placed in take
+			uint32_t mImages = 0;
+			uint32_t mBlocks = 0;
+			uint32_t mReallocations = 0; // Times the requests changed, normally only on a resize
+			uint32_t mRecycledBlocks = 0; // Blocks kept through a reallocation because they were still large enough
+		};
+
+		// Render targets that only live for part of the frame, images with lifetimes that do not overlap share memory
+		// Images are requested every frame, as long as the requests stay the same the same images are handed out
+		struct TransientResourcePool
+		{
+			struct Request
+			{
+				TransientImageDesc mDesc;
+				uint32_t mFirstPass;
+				uint32_t mLastPass;
+
+				bool operator==(const Request& aOther) const { return mDesc == aOther.mDesc && mFirstPass == aOther.mFirstPass && mLastPass == aOther.mLastPass; }
+			};
+
+			struct Block
+			{
+				VmaAllocation mAllocation = VK_NULL_HANDLE;
+				VkDeviceSize mSize = 0;
+				VkDeviceSize mAlignment = 0;
+				uint32_t mMemoryTypeIndex = 0;
+			};
+
+			std::vector<Request> mRequests; // This frame
+			std::vector<Request> mAllocatedRequests; // The images were created for these
+
+			std::vector<std::shared_ptr<Texture>> mImages; // One per allocated request, the memory belongs to the pool
+			std::vector<uint32_t> mImageBlocks;
+			std::vector<Block> mBlocks;
+
+			TransientResourcePoolStats mStats;
+		};
+	}
+}